@@ -87,7 +87,7 @@ build_executable() {
     fi
     
     # Flexible library paths
-    LIBS="-framework OpenGL -framework Cocoa -framework IOKit"
+    LIBS="-framework OpenGL -framework Cocoa -framework IOKit -framework AudioToolbox -framework CoreAudio"
     if [ -d "/opt/homebrew/lib" ]; then
         LIBS="$LIBS -L/opt/homebrew/lib -lglfw"
     elif [ -d "/usr/local/lib" ]; then
@@ -96,7 +96,7 @@ build_executable() {
         LIBS="$LIBS -lglfw"
     fi
     
-    SOURCES="src/LidPong.cpp src/Sensor.cpp ../mac-angle/angle.cpp"
+    SOURCES="src/LidPong.cpp src/AllocTracker.cpp src/Sensor.cpp src/InputSampler.cpp src/InputEvents.cpp src/IdleGovernor.cpp src/LidGestures.cpp src/LatencyStats.cpp src/FramePacer.cpp src/Profiler.cpp src/BallSwarm.cpp src/Bench.cpp src/Collision.cpp src/BrickField.cpp src/Simulation.cpp src/GameParams.cpp src/Recording.cpp src/ScoreStore.cpp src/AngleTrace.cpp src/TraceAnalytics.cpp src/ThreadPool.cpp src/BatchEnv.cpp src/Controller.cpp src/NetTransport.cpp src/Rollback.cpp src/SoftwareCanvas.cpp src/Scene.cpp src/Particles.cpp src/RenderThread.cpp src/Audio.cpp ../mac-angle/angle.cpp"
     
     # Build with optimization
     clang++ $CXXFLAGS $INCLUDES $SOURCES -o "$BUILD_DIR/$APP_NAME" $LIBS
@@ -0,0 +1,106 @@
+#include "AllocTracker.h"
+
+#ifdef LIDPONG_ALLOC_TRACK
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+// Plain thread_local PODs: no constructor runs, so touching them from inside
+// operator new cannot recurse
+thread_local LidPong::AllocTracker::Counts t_counts;
+
+std::atomic<uint64_t> g_allocations(0);
+std::atomic<uint64_t> g_bytes(0);
+std::atomic<uint64_t> g_frees(0);
+
+void* countedAlloc(std::size_t size) {
+    t_counts.allocations++;
+    t_counts.bytes += size;
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    g_bytes.fetch_add(size, std::memory_order_relaxed);
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void countedFree(void* p) {
+    if (!p) {
+        return;
+    }
+    t_counts.frees++;
+    g_frees.fetch_add(1, std::memory_order_relaxed);
+    std::free(p);
+}
+
+} // namespace
+
+void* operator new(std::size_t size) {
+    void* p = countedAlloc(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](std::size_t size) {
+    void* p = countedAlloc(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return countedAlloc(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return countedAlloc(size);
+}
+
+void operator delete(void* p) noexcept { countedFree(p); }
+void operator delete[](void* p) noexcept { countedFree(p); }
+void operator delete(void* p, std::size_t) noexcept { countedFree(p); }
+void operator delete[](void* p, std::size_t) noexcept { countedFree(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { countedFree(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { countedFree(p); }
+
+namespace LidPong {
+namespace AllocTracker {
+
+bool enabled() {
+    return true;
+}
+
+Counts thisThread() {
+    return t_counts;
+}
+
+Counts allThreads() {
+    Counts counts = {g_allocations.load(std::memory_order_relaxed), g_bytes.load(std::memory_order_relaxed),
+                     g_frees.load(std::memory_order_relaxed)};
+    return counts;
+}
+
+} // namespace AllocTracker
+} // namespace LidPong
+
+#else
+
+namespace LidPong {
+namespace AllocTracker {
+
+bool enabled() {
+    return false;
+}
+
+Counts thisThread() {
+    Counts counts = {0, 0, 0};
+    return counts;
+}
+
+Counts allThreads() {
+    return thisThread();
+}
+
+} // namespace AllocTracker
+} // namespace LidPong
+
+#endif // LIDPONG_ALLOC_TRACK
@@ -0,0 +1,41 @@
+#pragma once
+
+// Heap allocation tracking.
+//
+// Build with -DLIDPONG_ALLOC_TRACK (make ALLOC_TRACK=1) to replace the global
+// operator new and delete with counting versions. Without it nothing is
+// hooked and every count reads zero.
+
+#include <cstdint>
+
+namespace LidPong {
+
+namespace AllocTracker {
+
+// operator new calls (and bytes asked for) and operator delete calls
+struct Counts {
+    uint64_t allocations;
+    uint64_t bytes;
+    uint64_t frees;
+};
+
+bool enabled();
+
+Counts thisThread(); // Since the calling thread started
+Counts allThreads(); // Since the process started
+
+} // namespace AllocTracker
+
+// The calling thread's heap activity since construction
+class AllocationScope {
+public:
+    AllocationScope() : m_begin(AllocTracker::thisThread()) {}
+
+    uint64_t allocations() const { return AllocTracker::thisThread().allocations - m_begin.allocations; }
+    uint64_t bytes() const { return AllocTracker::thisThread().bytes - m_begin.bytes; }
+
+private:
+    AllocTracker::Counts m_begin;
+};
+
+} // namespace LidPong
@@ -0,0 +1,105 @@
+#include "AngleTrace.h"
+#include "InputSampler.h"
+#include <cerrno>
+#include <cstring>
+
+namespace LidPong {
+
+namespace {
+    const size_t WRITE_BLOCK_RECORDS = 4096; // 64 KB per fwrite
+}
+
+bool readAngleTraceHeader(std::FILE* file, AngleTraceHeader& header, const std::string& name, std::string& error) {
+    if (std::fread(&header, sizeof(header), 1, file) != 1) {
+        error = name + ": too short for an angle trace";
+        return false;
+    }
+    if (std::memcmp(header.magic, ANGLE_TRACE_MAGIC, sizeof(header.magic)) != 0) {
+        error = name + ": not an angle trace";
+        return false;
+    }
+    if (header.version != ANGLE_TRACE_VERSION || header.recordBytes != sizeof(AngleTraceRecord)) {
+        error = name + ": unsupported angle trace version " + std::to_string(header.version);
+        return false;
+    }
+    return true;
+}
+
+AngleTraceWriter::AngleTraceWriter()
+    : m_file(nullptr)
+    , m_records(0)
+    , m_failed(false) {
+}
+
+AngleTraceWriter::~AngleTraceWriter() {
+    std::string error;
+    close(error);
+}
+
+bool AngleTraceWriter::open(const std::string& path, double rateHz, std::string& error) {
+    std::string ignored;
+    close(ignored);
+    m_file = std::fopen(path.c_str(), "wb");
+    if (!m_file) {
+        error = path + ": " + std::strerror(errno);
+        return false;
+    }
+    AngleTraceHeader header;
+    std::memcpy(header.magic, ANGLE_TRACE_MAGIC, sizeof(header.magic));
+    header.version = ANGLE_TRACE_VERSION;
+    header.recordBytes = sizeof(AngleTraceRecord);
+    header.rateHz = rateHz > 0.0 ? static_cast<float>(rateHz) : 0.0f;
+    header.reserved = 0;
+    m_failed = std::fwrite(&header, sizeof(header), 1, m_file) != 1;
+    m_records = 0;
+    m_buffer.clear();
+    m_buffer.reserve(WRITE_BLOCK_RECORDS);
+    return true;
+}
+
+void AngleTraceWriter::append(const InputSample& sample) {
+    AngleTraceRecord record;
+    record.timestampNs = sample.timestampNs;
+    record.angle = static_cast<float>(sample.angle);
+    record.status = static_cast<uint8_t>(sample.status);
+    record.flags = sample.idle ? ANGLE_TRACE_IDLE : 0;
+    record.reserved[0] = record.reserved[1] = 0;
+    append(record);
+}
+
+void AngleTraceWriter::append(const AngleTraceRecord& record) {
+    if (!m_file) {
+        return;
+    }
+    m_buffer.push_back(record);
+    m_records++;
+    if (m_buffer.size() == WRITE_BLOCK_RECORDS) {
+        flush();
+    }
+}
+
+bool AngleTraceWriter::flush() {
+    if (!m_buffer.empty() && std::fwrite(m_buffer.data(), sizeof(AngleTraceRecord), m_buffer.size(), m_file) != m_buffer.size()) {
+        m_failed = true;
+    }
+    m_buffer.clear();
+    return !m_failed;
+}
+
+bool AngleTraceWriter::close(std::string& error) {
+    if (!m_file) {
+        return true;
+    }
+    flush();
+    if (std::fclose(m_file) != 0) {
+        m_failed = true;
+    }
+    m_file = nullptr;
+    if (m_failed) {
+        error = std::string("writing the angle trace failed: ") + std::strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+} // namespace LidPong
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace LidPong {
+
+struct InputSample;
+
+// Raw lid sensor trace: every read the input thread makes, failed ones
+// included, for offline analysis of the sensor rather than of the game
+// (recordings keep only what the simulation saw, once per tick).
+//
+// A 16-byte header, then fixed 16-byte records in the native (little-endian)
+// byte order. Fixed records mean any byte range that starts on a record
+// boundary can be read on its own, which is what lets one big file be
+// analysed by many threads at once.
+const char ANGLE_TRACE_MAGIC[4] = {'L', 'P', 'A', 'T'};
+const uint16_t ANGLE_TRACE_VERSION = 1;
+const size_t ANGLE_TRACE_HEADER_BYTES = 16;
+const char* const ANGLE_TRACE_EXTENSION = ".lpat";
+
+struct AngleTraceHeader {
+    char magic[4];
+    uint16_t version;
+    uint16_t recordBytes;
+    float rateHz;      // Requested sampling rate, 0 = as fast as the sensor allows
+    uint32_t reserved;
+};
+
+struct AngleTraceRecord {
+    int64_t timestampNs; // Clock::nowNs() when the read completed
+    float angle;         // Degrees; a failed read repeats the last good angle
+    uint8_t status;      // MacBookLidAngle::ReadStatus, 0 = Ok
+    uint8_t flags;       // ANGLE_TRACE_IDLE
+    uint8_t reserved[2];
+};
+
+const uint8_t ANGLE_TRACE_IDLE = 1; // Taken at the slow idle sampling rate
+
+static_assert(sizeof(AngleTraceHeader) == ANGLE_TRACE_HEADER_BYTES, "Angle trace header must stay 16 bytes");
+static_assert(sizeof(AngleTraceRecord) == 16, "Angle trace records must stay 16 bytes");
+
+// Reads and checks the header; false with 'error' set if the file isn't a
+// trace this build understands
+bool readAngleTraceHeader(std::FILE* file, AngleTraceHeader& header, const std::string& name, std::string& error);
+
+// Appends samples to a trace file. Records are buffered and written in
+// blocks, so append() is cheap enough for the sampler thread.
+class AngleTraceWriter {
+public:
+    AngleTraceWriter();
+    ~AngleTraceWriter();
+
+    AngleTraceWriter(const AngleTraceWriter&) = delete;
+    AngleTraceWriter& operator=(const AngleTraceWriter&) = delete;
+
+    bool open(const std::string& path, double rateHz, std::string& error);
+    void append(const InputSample& sample);
+    void append(const AngleTraceRecord& record);
+    bool close(std::string& error); // Flushes; false if any write failed
+
+    bool isOpen() const { return m_file != nullptr; }
+    uint64_t recordsWritten() const { return m_records; }
+
+private:
+    bool flush();
+
+    std::FILE* m_file;
+    std::vector<AngleTraceRecord> m_buffer;
+    uint64_t m_records;
+    bool m_failed;
+};
+
+} // namespace LidPong
@@ -0,0 +1,478 @@
+#include "Audio.h"
+#include "Clock.h"
+#include "Random.h"
+#include "Simulation.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#ifdef __APPLE__
+#include <AudioToolbox/AudioToolbox.h>
+#include <CoreAudio/AudioHardware.h>
+#endif
+
+namespace LidPong {
+
+namespace {
+    const float TWO_PI = 6.28318531f;
+
+    // A tone gliding from 'startHz' to 'endHz' under an exponential decay, with
+    // some noise mixed in for a percussive edge. Short fades at both ends keep
+    // voices from clicking when they start or are cut short.
+    std::vector<float> tone(int sampleRate, float seconds, float startHz, float endHz, float decay, float noise,
+                            float level, Random& random) {
+        size_t count = static_cast<size_t>(seconds * sampleRate);
+        size_t fade = static_cast<size_t>(0.002f * sampleRate);
+        std::vector<float> samples(count);
+        float phase = 0.0f;
+        for (size_t i = 0; i < count; i++) {
+            float t = static_cast<float>(i) / sampleRate;
+            phase += TWO_PI * (startHz + (endHz - startHz) * t / seconds) / sampleRate;
+            if (phase > TWO_PI) phase -= TWO_PI;
+            float envelope = std::exp(-decay * t);
+            if (i < fade) envelope *= static_cast<float>(i) / fade;
+            if (count - i < fade) envelope *= static_cast<float>(count - i) / fade;
+            float noiseSample = random.unit() * 2.0f - 1.0f;
+            samples[i] = level * envelope * (std::sin(phase) * (1.0f - noise) + noiseSample * noise);
+        }
+        return samples;
+    }
+
+    float clampPan(float x) {
+        return std::max(-1.0f, std::min(1.0f, x));
+    }
+
+    void putLE32(uint8_t* out, uint32_t value) {
+        for (int i = 0; i < 4; i++) out[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+
+    void putLE16(uint8_t* out, uint16_t value) {
+        out[0] = static_cast<uint8_t>(value);
+        out[1] = static_cast<uint8_t>(value >> 8);
+    }
+
+    // Canonical 44-byte header for 16-bit stereo PCM
+    void wavHeader(uint8_t* header, int sampleRate, uint64_t frames) {
+        uint32_t dataBytes = static_cast<uint32_t>(std::min<uint64_t>(frames * 4, 0xFFFFFFFFu - 36));
+        std::memcpy(header, "RIFF", 4);
+        putLE32(header + 4, 36 + dataBytes);
+        std::memcpy(header + 8, "WAVEfmt ", 8);
+        putLE32(header + 16, 16);
+        putLE16(header + 20, 1); // PCM
+        putLE16(header + 22, 2);
+        putLE32(header + 24, static_cast<uint32_t>(sampleRate));
+        putLE32(header + 28, static_cast<uint32_t>(sampleRate) * 4);
+        putLE16(header + 32, 4);
+        putLE16(header + 34, 16);
+        std::memcpy(header + 36, "data", 4);
+        putLE32(header + 40, dataBytes);
+    }
+}
+
+SoundBank::SoundBank(int sampleRate)
+    : m_sampleRate(sampleRate) {
+    Random random(0x5eed);
+    m_samples[static_cast<size_t>(Sound::PaddleHit)] = tone(sampleRate, 0.08f, 660.0f, 620.0f, 40.0f, 0.15f, 0.6f, random);
+    m_samples[static_cast<size_t>(Sound::WallBounce)] = tone(sampleRate, 0.05f, 330.0f, 320.0f, 60.0f, 0.05f, 0.35f, random);
+    m_samples[static_cast<size_t>(Sound::Miss)] = tone(sampleRate, 0.45f, 320.0f, 90.0f, 5.0f, 0.0f, 0.5f, random);
+    m_samples[static_cast<size_t>(Sound::Brick)] = tone(sampleRate, 0.06f, 1320.0f, 1250.0f, 50.0f, 0.3f, 0.4f, random);
+}
+
+AudioMixer::AudioMixer(const SoundBank& bank)
+    : m_bank(bank)
+    , m_dropped(0)
+    , m_buffers(0)
+    , m_started(0)
+    , m_stolen(0) {
+    for (Voice& voice : m_voices) {
+        voice.data = nullptr;
+        voice.length = 0;
+        voice.position = 0;
+        voice.left = voice.right = 0.0f;
+    }
+}
+
+bool AudioMixer::post(Sound sound, float gain, float pan) {
+    AudioCommand command;
+    command.sound = sound;
+    command.gain = gain;
+    command.pan = pan;
+    command.postedNs = Clock::nowNs();
+    if (!m_queue.push(command)) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+void AudioMixer::start(const AudioCommand& command, int64_t outputNs) {
+    const std::vector<float>& samples = m_bank.samples(command.sound);
+    if (samples.empty()) {
+        return;
+    }
+
+    // A free voice, or else the one with the least left to play
+    Voice* voice = nullptr;
+    uint32_t leastLeft = UINT32_MAX;
+    for (Voice& candidate : m_voices) {
+        if (candidate.length == 0) {
+            voice = &candidate;
+            break;
+        }
+        if (candidate.length - candidate.position < leastLeft) {
+            leastLeft = candidate.length - candidate.position;
+            voice = &candidate;
+        }
+    }
+    if (voice->length != 0) {
+        m_stolen++;
+    }
+
+    // Equal-power pan
+    float angle = (clampPan(command.pan) + 1.0f) * (TWO_PI / 8.0f);
+    voice->data = samples.data();
+    voice->length = static_cast<uint32_t>(samples.size());
+    voice->position = 0;
+    voice->left = command.gain * std::cos(angle);
+    voice->right = command.gain * std::sin(angle);
+    m_started++;
+    m_commandLatency.record(Clock::nsToMs(outputNs - command.postedNs));
+}
+
+void AudioMixer::mix(float* out, size_t frames, int64_t outputNs) {
+    int64_t startNs = Clock::nowNs();
+
+    AudioCommand command;
+    while (m_queue.pop(command)) {
+        start(command, outputNs);
+    }
+
+    std::fill(out, out + frames * 2, 0.0f);
+    for (Voice& voice : m_voices) {
+        if (voice.length == 0) {
+            continue;
+        }
+        size_t count = std::min<size_t>(frames, voice.length - voice.position);
+        const float* source = voice.data + voice.position;
+        for (size_t i = 0; i < count; i++) {
+            out[2 * i] += source[i] * voice.left;
+            out[2 * i + 1] += source[i] * voice.right;
+        }
+        voice.position += static_cast<uint32_t>(count);
+        if (voice.position == voice.length) {
+            voice.length = 0;
+        }
+    }
+
+    // Many voices at once may sum past full scale
+    for (size_t i = 0; i < frames * 2; i++) {
+        out[i] = std::max(-1.0f, std::min(1.0f, out[i]));
+    }
+
+    m_buffers++;
+    m_mixCost.record(Clock::nsToMs(Clock::nowNs() - startNs));
+}
+
+size_t AudioMixer::activeVoices() const {
+    size_t count = 0;
+    for (const Voice& voice : m_voices) {
+        if (voice.length != 0) count++;
+    }
+    return count;
+}
+
+void AudioMixer::report(std::ostream& out, const char* backend, double bufferMs) const {
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+
+    out << "Audio: " << backend << " output, " << std::fixed << std::setprecision(2) << bufferMs << " ms buffers, "
+        << m_buffers << " mixed, " << m_started << " sounds (" << m_stolen << " cut short, " << commandsDropped()
+        << " dropped)" << std::endl;
+    out.flags(flags);
+    out.precision(precision);
+    if (m_buffers > 0) {
+        m_mixCost.report(out, "Audio mix per buffer");
+    }
+    if (m_started > 0) {
+        m_commandLatency.report(out, "Audio post to output");
+    }
+}
+
+PacedAudioBackend::PacedAudioBackend(int sampleRate, size_t bufferFrames)
+    : m_sampleRate(sampleRate)
+    , m_bufferFrames(bufferFrames)
+    , m_mixer(nullptr)
+    , m_running(false)
+    , m_paused(false)
+    , m_buffer(bufferFrames * 2) {
+}
+
+PacedAudioBackend::~PacedAudioBackend() {
+    stop();
+}
+
+bool PacedAudioBackend::start(AudioMixer& mixer, std::string& error) {
+    if (m_running.load() || !open(error)) {
+        return false;
+    }
+    m_mixer = &mixer;
+    m_running.store(true);
+    m_thread = std::thread(&PacedAudioBackend::threadMain, this);
+    return true;
+}
+
+void PacedAudioBackend::stop() {
+    if (!m_running.exchange(false)) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_pauseMutex);
+        m_unpaused.notify_one();
+    }
+    m_thread.join();
+    close();
+}
+
+void PacedAudioBackend::setPaused(bool paused) {
+    std::lock_guard<std::mutex> lock(m_pauseMutex);
+    m_paused = paused;
+    m_unpaused.notify_one();
+}
+
+void PacedAudioBackend::threadMain() {
+    const int64_t periodNs = static_cast<int64_t>(m_bufferFrames * 1.0e9 / m_sampleRate);
+    int64_t dueNs = Clock::nowNs();
+    while (m_running.load(std::memory_order_relaxed)) {
+        {
+            std::unique_lock<std::mutex> lock(m_pauseMutex);
+            if (m_paused) {
+                m_unpaused.wait(lock, [this] { return !m_paused || !m_running.load(); });
+                dueNs = Clock::nowNs();
+                continue;
+            }
+        }
+
+        // A device asks for each buffer one period before it starts playing
+        m_mixer->mix(m_buffer.data(), m_bufferFrames, dueNs + periodNs);
+        deliver(m_buffer.data(), m_bufferFrames);
+
+        dueNs += periodNs;
+        int64_t nowNs = Clock::nowNs();
+        if (nowNs - dueNs > 4 * periodNs) {
+            dueNs = nowNs; // Fell well behind (suspended, debugger): don't burst to catch up
+        } else if (dueNs > nowNs) {
+            std::this_thread::sleep_for(std::chrono::nanoseconds(dueNs - nowNs));
+        }
+    }
+}
+
+WavAudioBackend::WavAudioBackend(const std::string& path, int sampleRate, size_t bufferFrames)
+    : PacedAudioBackend(sampleRate, bufferFrames)
+    , m_path(path)
+    , m_file(nullptr)
+    , m_pcm(bufferFrames * 2)
+    , m_frames(0) {
+}
+
+bool WavAudioBackend::open(std::string& error) {
+    m_file = std::fopen(m_path.c_str(), "wb");
+    if (!m_file) {
+        error = "cannot create " + m_path;
+        return false;
+    }
+    uint8_t header[44];
+    wavHeader(header, m_sampleRate, 0); // Sizes filled in by close()
+    std::fwrite(header, 1, sizeof(header), m_file);
+    m_frames = 0;
+    return true;
+}
+
+void WavAudioBackend::deliver(const float* stereo, size_t frames) {
+    for (size_t i = 0; i < frames * 2; i++) {
+        m_pcm[i] = static_cast<int16_t>(std::lround(stereo[i] * 32767.0f));
+    }
+    m_frames += std::fwrite(m_pcm.data(), 4, frames, m_file);
+}
+
+void WavAudioBackend::close() {
+    if (!m_file) {
+        return;
+    }
+    uint8_t header[44];
+    wavHeader(header, m_sampleRate, m_frames);
+    std::fseek(m_file, 0, SEEK_SET);
+    std::fwrite(header, 1, sizeof(header), m_file);
+    std::fclose(m_file);
+    m_file = nullptr;
+}
+
+#ifdef __APPLE__
+namespace {
+    // The default output device through an AudioUnit; mix() runs in its render callback
+    class SystemAudioBackend : public AudioBackend {
+    public:
+        SystemAudioBackend(int sampleRate, size_t bufferFrames)
+            : m_sampleRate(sampleRate)
+            , m_bufferFrames(bufferFrames)
+            , m_unit(nullptr)
+            , m_mixer(nullptr) {
+        }
+
+        ~SystemAudioBackend() override { stop(); }
+
+        const char* name() const override { return "system"; }
+        double bufferMs() const override { return m_bufferFrames * 1000.0 / m_sampleRate; }
+
+        bool start(AudioMixer& mixer, std::string& error) override {
+            AudioComponentDescription description;
+            std::memset(&description, 0, sizeof(description));
+            description.componentType = kAudioUnitType_Output;
+            description.componentSubType = kAudioUnitSubType_DefaultOutput;
+            description.componentManufacturer = kAudioUnitManufacturer_Apple;
+            AudioComponent component = AudioComponentFindNext(nullptr, &description);
+            if (!component || AudioComponentInstanceNew(component, &m_unit) != noErr) {
+                m_unit = nullptr;
+                error = "no default audio output device";
+                return false;
+            }
+
+            AudioStreamBasicDescription format;
+            std::memset(&format, 0, sizeof(format));
+            format.mSampleRate = m_sampleRate;
+            format.mFormatID = kAudioFormatLinearPCM;
+            format.mFormatFlags = kAudioFormatFlagIsFloat | kAudioFormatFlagIsPacked;
+            format.mFramesPerPacket = 1;
+            format.mChannelsPerFrame = 2;
+            format.mBitsPerChannel = 32;
+            format.mBytesPerFrame = 8;
+            format.mBytesPerPacket = 8;
+
+            AURenderCallbackStruct callback;
+            callback.inputProc = render;
+            callback.inputProcRefCon = this;
+
+            // The device may round this; bufferMs() only reports what was asked for
+            UInt32 frames = static_cast<UInt32>(m_bufferFrames);
+            AudioUnitSetProperty(m_unit, kAudioDevicePropertyBufferFrameSize, kAudioUnitScope_Global, 0, &frames,
+                                 sizeof(frames));
+
+            m_mixer = &mixer;
+            if (AudioUnitSetProperty(m_unit, kAudioUnitProperty_StreamFormat, kAudioUnitScope_Input, 0, &format,
+                                     sizeof(format)) != noErr ||
+                AudioUnitSetProperty(m_unit, kAudioUnitProperty_SetRenderCallback, kAudioUnitScope_Input, 0, &callback,
+                                     sizeof(callback)) != noErr ||
+                AudioUnitInitialize(m_unit) != noErr || AudioOutputUnitStart(m_unit) != noErr) {
+                AudioComponentInstanceDispose(m_unit);
+                m_unit = nullptr;
+                error = "cannot start the default audio output";
+                return false;
+            }
+            return true;
+        }
+
+        void setPaused(bool paused) override {
+            if (m_unit) {
+                paused ? AudioOutputUnitStop(m_unit) : AudioOutputUnitStart(m_unit);
+            }
+        }
+
+        void stop() override {
+            if (!m_unit) {
+                return;
+            }
+            AudioOutputUnitStop(m_unit);
+            AudioUnitUninitialize(m_unit);
+            AudioComponentInstanceDispose(m_unit);
+            m_unit = nullptr;
+        }
+
+    private:
+        static OSStatus render(void* context, AudioUnitRenderActionFlags*, const AudioTimeStamp*, UInt32, UInt32 frames,
+                               AudioBufferList* data) {
+            SystemAudioBackend* self = static_cast<SystemAudioBackend*>(context);
+            float* out = static_cast<float*>(data->mBuffers[0].mData);
+            self->m_mixer->mix(out, frames, Clock::nowNs() + static_cast<int64_t>(frames * 1.0e9 / self->m_sampleRate));
+            return noErr;
+        }
+
+        int m_sampleRate;
+        size_t m_bufferFrames;
+        AudioComponentInstance m_unit;
+        AudioMixer* m_mixer;
+    };
+}
+#endif
+
+std::unique_ptr<AudioBackend> createAudioBackend(const std::string& output, int sampleRate, size_t bufferFrames,
+                                                 std::string& error) {
+    if (output == "null") {
+        return std::unique_ptr<AudioBackend>(new NullAudioBackend(sampleRate, bufferFrames));
+    }
+    if (output.size() > 4 && output.compare(output.size() - 4, 4, ".wav") == 0) {
+        return std::unique_ptr<AudioBackend>(new WavAudioBackend(output, sampleRate, bufferFrames));
+    }
+    if (output == "system") {
+#ifdef __APPLE__
+        return std::unique_ptr<AudioBackend>(new SystemAudioBackend(sampleRate, bufferFrames));
+#else
+        error = "no system audio output on this platform (use null or FILE.wav)";
+        return nullptr;
+#endif
+    }
+    error = "unknown audio output '" + output + "' (system, null, off or FILE.wav)";
+    return nullptr;
+}
+
+AudioCues::AudioCues()
+    : m_primed(false)
+    , m_generation(0)
+    , m_tick(0)
+    , m_totalHits(0)
+    , m_lives(0)
+    , m_score(0)
+    , m_rightScore(0)
+    , m_ballVy(0.0f) {
+}
+
+void AudioCues::update(const Simulation& sim, uint64_t generation, AudioMixer& mixer) {
+    const GameState& state = sim.state();
+    const Ball& ball = state.ball;
+    bool classicBall = !sim.isMultiBall() && !sim.isBrickMode();
+    bool jumped = !m_primed || generation != m_generation || state.tick < m_tick;
+
+    if (!jumped && state.tick != m_tick) {
+        int hits = state.totalHits - m_totalHits;
+        bool leftMiss = state.lives < m_lives || state.rightScore > m_rightScore;
+        bool rightMiss = sim.isVersus() && state.score > m_score;
+        if (hits > 0) {
+            // One sound per frame however many balls hit, a little louder for more
+            mixer.post(Sound::PaddleHit, std::min(1.0f, 0.6f + 0.1f * hits), classicBall ? clampPan(ball.x) : -0.8f);
+        }
+        if (sim.isBrickMode() && state.score > m_score) {
+            mixer.post(Sound::Brick, std::min(1.0f, 0.5f + 0.1f * (state.score - m_score)), 0.3f);
+        }
+        if (leftMiss) {
+            mixer.post(Sound::Miss, 1.0f, -0.8f);
+        }
+        if (rightMiss) {
+            mixer.post(Sound::Miss, 1.0f, 0.8f);
+        }
+        // Walls flip the vertical direction; paddles and re-serves are heard already
+        bool turned = (ball.vy > 0.0f) != (m_ballVy > 0.0f);
+        if (classicBall && ball.active && turned && hits == 0 && !leftMiss && !rightMiss) {
+            mixer.post(Sound::WallBounce, 0.8f, clampPan(ball.x));
+        }
+    }
+
+    m_primed = true;
+    m_generation = generation;
+    m_tick = state.tick;
+    m_totalHits = state.totalHits;
+    m_lives = state.lives;
+    m_score = state.score;
+    m_rightScore = state.rightScore;
+    m_ballVy = state.ball.vy;
+}
+
+} // namespace LidPong
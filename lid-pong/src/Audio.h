@@ -0,0 +1,210 @@
+#pragma once
+
+#include "LatencyStats.h"
+#include "SpscQueue.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace LidPong {
+
+class Simulation;
+
+const int AUDIO_SAMPLE_RATE = 48000; // Sounds are made, mixed and output at this rate
+
+enum class Sound : uint8_t {
+    PaddleHit,
+    WallBounce,
+    Miss,
+    Brick,
+    Count
+};
+
+// Mono float PCM for every Sound, synthesised once at the output sample rate
+// so nothing is loaded or resampled while playing.
+class SoundBank {
+public:
+    explicit SoundBank(int sampleRate);
+
+    int sampleRate() const { return m_sampleRate; }
+    const std::vector<float>& samples(Sound sound) const { return m_samples[static_cast<size_t>(sound)]; }
+
+private:
+    int m_sampleRate;
+    std::vector<float> m_samples[static_cast<size_t>(Sound::Count)];
+};
+
+struct AudioCommand {
+    Sound sound;
+    float gain;
+    float pan;          // -1 = left, 0 = centre, 1 = right
+    int64_t postedNs;   // Clock::nowNs() at post()
+};
+
+// Mixes up to MAX_VOICES preloaded sounds into interleaved stereo float.
+//
+// The game thread post()s play commands into a lock-free queue; mix() runs on
+// the audio thread, starts whatever was queued and adds every playing voice
+// into the output buffer. mix() takes no locks, makes no system calls and
+// never allocates (voices and stats are fixed-size), so it can run inside a
+// real-time audio callback. When every voice is busy the one closest to its
+// end is cut short.
+class AudioMixer {
+public:
+    static const size_t MAX_VOICES = 32;
+    static const size_t QUEUE_CAPACITY = 256;
+
+    explicit AudioMixer(const SoundBank& bank);
+
+    // Game thread. False (and counted) if the queue is full.
+    bool post(Sound sound, float gain, float pan);
+
+    // Audio thread: fills 'frames' stereo frames. 'outputNs' is when the
+    // first frame is due at the speaker, as well as the backend knows.
+    void mix(float* out, size_t frames, int64_t outputNs);
+
+    // Read these once the backend has stopped
+    const LatencyStats& mixCost() const { return m_mixCost; }             // Per buffer, ms
+    const LatencyStats& commandLatency() const { return m_commandLatency; } // post() to output, ms
+    uint64_t buffersMixed() const { return m_buffers; }
+    uint64_t voicesStarted() const { return m_started; }
+    uint64_t voicesStolen() const { return m_stolen; }
+    uint64_t commandsDropped() const { return m_dropped.load(std::memory_order_relaxed); }
+    size_t activeVoices() const;
+
+    void report(std::ostream& out, const char* backend, double bufferMs) const;
+
+private:
+    struct Voice {
+        const float* data;
+        uint32_t length;   // 0 = free
+        uint32_t position;
+        float left, right;
+    };
+
+    void start(const AudioCommand& command, int64_t outputNs);
+
+    const SoundBank& m_bank;
+    SpscQueue<AudioCommand, QUEUE_CAPACITY> m_queue;
+    std::atomic<uint64_t> m_dropped;
+
+    // Audio thread only
+    Voice m_voices[MAX_VOICES];
+    LatencyStats m_mixCost;
+    LatencyStats m_commandLatency;
+    uint64_t m_buffers;
+    uint64_t m_started;
+    uint64_t m_stolen;
+};
+
+// Where mixed audio goes. start() begins calling mixer.mix() from the
+// backend's own thread (or the OS audio callback) every buffer until stop().
+class AudioBackend {
+public:
+    virtual ~AudioBackend() {}
+
+    virtual const char* name() const = 0;
+    virtual bool start(AudioMixer& mixer, std::string& error) = 0;
+    virtual void stop() = 0;
+
+    // While paused nothing is mixed and the output wakes nobody (game idle)
+    virtual void setPaused(bool paused) = 0;
+
+    // How long one buffer lasts: the delay the backend adds after a mix
+    virtual double bufferMs() const = 0;
+};
+
+// A thread that mixes one buffer per buffer period, like a sound card would
+// ask for them, and hands each to deliver()
+class PacedAudioBackend : public AudioBackend {
+public:
+    PacedAudioBackend(int sampleRate, size_t bufferFrames);
+    ~PacedAudioBackend() override;
+
+    bool start(AudioMixer& mixer, std::string& error) override;
+    void stop() override;
+    void setPaused(bool paused) override;
+    double bufferMs() const override { return m_bufferFrames * 1000.0 / m_sampleRate; }
+
+protected:
+    virtual bool open(std::string& error) { (void)error; return true; }
+    virtual void deliver(const float* stereo, size_t frames) = 0;
+    virtual void close() {}
+
+    int m_sampleRate;
+    size_t m_bufferFrames;
+
+private:
+    void threadMain();
+
+    AudioMixer* m_mixer;
+    std::thread m_thread;
+    std::atomic<bool> m_running;
+    std::mutex m_pauseMutex;
+    std::condition_variable m_unpaused;
+    bool m_paused;
+    std::vector<float> m_buffer;
+};
+
+// Mixes in real time and throws the result away (headless machines, timing)
+class NullAudioBackend : public PacedAudioBackend {
+public:
+    NullAudioBackend(int sampleRate, size_t bufferFrames) : PacedAudioBackend(sampleRate, bufferFrames) {}
+    const char* name() const override { return "null"; }
+
+protected:
+    void deliver(const float*, size_t) override {}
+};
+
+// Mixes in real time into a 16-bit stereo WAV file
+class WavAudioBackend : public PacedAudioBackend {
+public:
+    WavAudioBackend(const std::string& path, int sampleRate, size_t bufferFrames);
+    ~WavAudioBackend() override { stop(); } // Finishes the header while close() is still ours
+    const char* name() const override { return "wav"; }
+
+    uint64_t framesWritten() const { return m_frames; }
+
+protected:
+    bool open(std::string& error) override;
+    void deliver(const float* stereo, size_t frames) override;
+    void close() override;
+
+private:
+    std::string m_path;
+    std::FILE* m_file;
+    std::vector<int16_t> m_pcm;
+    uint64_t m_frames;
+};
+
+// "system" (the default output device, macOS only), "null", or a path ending
+// in .wav; nullptr and 'error' set for anything else
+std::unique_ptr<AudioBackend> createAudioBackend(const std::string& output, int sampleRate, size_t bufferFrames,
+                                                 std::string& error);
+
+// Turns game events into sounds, the way ParticleEffects turns them into
+// particles: it compares consecutive game states, so the simulation never
+// knows about audio. Pans each sound to where it happened.
+class AudioCues {
+public:
+    AudioCues();
+
+    // Once per frame; after a jump to another 'generation' nothing plays
+    void update(const Simulation& sim, uint64_t generation, AudioMixer& mixer);
+
+private:
+    bool m_primed;
+    uint64_t m_generation;
+    uint64_t m_tick;
+    int m_totalHits, m_lives, m_score, m_rightScore;
+    float m_ballVy;
+};
+
+} // namespace LidPong
@@ -0,0 +1,184 @@
+#include "BallSwarm.h"
+#include "Collision.h"
+#include "Simd.h"
+#include <cmath>
+
+// Keep the compiler from fusing multiply-adds in the scalar kernel only,
+// which would make it round differently from the SIMD one
+#if defined(__clang__)
+#pragma clang fp contract(off)
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+namespace LidPong {
+
+namespace {
+    uint32_t xorshift32(uint32_t& state) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    float unitFloat(uint32_t& state) {
+        return (xorshift32(state) >> 8) * (1.0f / 16777216.0f);
+    }
+}
+
+BallSwarm::BallSwarm()
+    : m_count(0)
+    , m_radius(0.01f) {
+}
+
+void BallSwarm::reset(size_t count, uint32_t seed, float radius) {
+    m_count = count;
+    m_radius = radius;
+
+    size_t padded = (count + 3) & ~static_cast<size_t>(3);
+    m_x.assign(padded, 0.5f);
+    m_y.assign(padded, 0.0f);
+    m_vx.assign(padded, 0.0f);
+    m_vy.assign(padded, 0.0f);
+
+    uint32_t state = seed ? seed : 0x9E3779B9u;
+    for (size_t i = 0; i < count; i++) {
+        m_x[i] = -0.5f + 1.4f * unitFloat(state);
+        m_y[i] = -0.9f + 1.8f * unitFloat(state);
+        float sign = unitFloat(state) < 0.5f ? -1.0f : 1.0f;
+        m_vx[i] = sign * 0.8f * (0.6f + 0.4f * unitFloat(state));
+        m_vy[i] = 0.6f * (2.0f * unitFloat(state) - 1.0f);
+    }
+}
+
+SwarmStepResult BallSwarm::stepScalar(float deltaTime, float speedMultiplier, const PaddleBox& paddle) {
+    SwarmStepResult result = {0, 0};
+    const float step = deltaTime * speedMultiplier;
+    const float r = m_radius;
+    const Playfield field = Playfield::standard();
+
+    for (size_t i = 0; i < m_count; i++) {
+        float x = m_x[i] + m_vx[i] * step;
+        float y = m_y[i] + m_vy[i] * step;
+        float vx = m_vx[i];
+        float vy = m_vy[i];
+
+        // Top/bottom walls
+        bool top = y + r > field.top;
+        bool bottom = y - r < field.bottom;
+        if (top || bottom) {
+            vy = -vy;
+            if (top) y = field.top - r;
+            if (bottom) y = field.bottom + r;
+        }
+
+        // Right wall
+        if (x + r > field.right) {
+            vx = -vx;
+            x = field.right - r;
+        }
+
+        // Missed: respawn at the centre heading right
+        if (x + r < field.missX) {
+            x = 0.0f;
+            y = 0.0f;
+            vx = std::abs(vx);
+            result.misses++;
+        }
+
+        // Paddle, only when moving towards it
+        if (vx < 0.0f &&
+            x - r <= paddle.x + paddle.halfWidth && x + r >= paddle.x - paddle.halfWidth &&
+            y - r <= paddle.y + paddle.halfHeight && y + r >= paddle.y - paddle.halfHeight) {
+            vx = std::abs(vx);
+            float hitPos = (y - paddle.y) / paddle.halfHeight;
+            vy = vy + hitPos * PADDLE_SPIN;
+            if (vy > MAX_BALL_VY) vy = MAX_BALL_VY;
+            if (vy < -MAX_BALL_VY) vy = -MAX_BALL_VY;
+            result.hits++;
+        }
+
+        m_x[i] = x;
+        m_y[i] = y;
+        m_vx[i] = vx;
+        m_vy[i] = vy;
+    }
+    return result;
+}
+
+SwarmStepResult BallSwarm::stepSimd(float deltaTime, float speedMultiplier, const PaddleBox& paddle) {
+    using namespace simd;
+
+    SwarmStepResult result = {0, 0};
+    const Playfield field = Playfield::standard();
+    const f32x4 step = splat(deltaTime * speedMultiplier);
+    const f32x4 r = splat(m_radius);
+    const f32x4 zero = splat(0.0f);
+    const f32x4 wallTop = splat(field.top);
+    const f32x4 wallBottom = splat(field.bottom);
+    const f32x4 wallRight = splat(field.right);
+    const f32x4 missX = splat(field.missX);
+    const f32x4 spin = splat(PADDLE_SPIN);
+    const f32x4 maxVy = splat(MAX_BALL_VY);
+    const f32x4 minVy = splat(-MAX_BALL_VY);
+    const f32x4 padY = splat(paddle.y);
+    const f32x4 padRight = splat(paddle.x + paddle.halfWidth);
+    const f32x4 padLeft = splat(paddle.x - paddle.halfWidth);
+    const f32x4 padTop = splat(paddle.y + paddle.halfHeight);
+    const f32x4 padBottom = splat(paddle.y - paddle.halfHeight);
+    const f32x4 padHalfHeight = splat(paddle.halfHeight);
+
+    const size_t padded = m_x.size();
+    for (size_t i = 0; i < padded; i += 4) {
+        f32x4 vx = load(&m_vx[i]);
+        f32x4 vy = load(&m_vy[i]);
+        f32x4 x = load(&m_x[i]) + vx * step;
+        f32x4 y = load(&m_y[i]) + vy * step;
+
+        mask4 top = (y + r) > wallTop;
+        mask4 bottom = (y - r) < wallBottom;
+        vy = select(top | bottom, -vy, vy);
+        y = select(top, wallTop - r, y);
+        y = select(bottom, wallBottom + r, y);
+
+        mask4 right = (x + r) > wallRight;
+        vx = select(right, -vx, vx);
+        x = select(right, wallRight - r, x);
+
+        mask4 miss = (x + r) < missX;
+        x = select(miss, zero, x);
+        y = select(miss, zero, y);
+        vx = select(miss, abs(vx), vx);
+
+        mask4 hit = (vx < zero) &
+                    ((x - r) <= padRight) & ((x + r) >= padLeft) &
+                    ((y - r) <= padTop) & ((y + r) >= padBottom);
+        if (any(hit)) {
+            f32x4 hitPos = (y - padY) / padHalfHeight;
+            f32x4 spun = min(max(vy + hitPos * spin, minVy), maxVy);
+            vx = select(hit, abs(vx), vx);
+            vy = select(hit, spun, vy);
+            result.hits += count(hit);
+        }
+        result.misses += count(miss);
+
+        store(&m_x[i], x);
+        store(&m_y[i], y);
+        store(&m_vx[i], vx);
+        store(&m_vy[i], vy);
+    }
+    return result;
+}
+
+void BallSwarm::writePositions(float* xy) const {
+    for (size_t i = 0; i < m_count; i++) {
+        xy[2 * i] = m_x[i];
+        xy[2 * i + 1] = m_y[i];
+    }
+}
+
+const char* BallSwarm::simdName() {
+    return simd::name();
+}
+
+} // namespace LidPong
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace LidPong {
+
+// Axis-aligned paddle as seen by the swarm kernels
+struct PaddleBox {
+    float x, y;
+    float halfWidth, halfHeight;
+};
+
+struct SwarmStepResult {
+    int hits;   // Balls bounced off the paddle this step
+    int misses; // Balls that left the left edge (respawned at the centre)
+};
+
+// Many balls stored as structure-of-arrays for the multi-ball party mode.
+//
+// Both step kernels implement the same rules as the single Ball plus the
+// paddle collision in LidPongGame::update(): integrate, bounce off the
+// top/bottom/right walls, respawn balls that leave on the left and bounce
+// balls off the paddle with spin. stepSimd() does it 4 balls at a time with
+// branch-free selects and must match stepScalar() (see the balls benchmark).
+class BallSwarm {
+public:
+    BallSwarm();
+
+    // Spawn 'count' balls spread over the field with pseudo-random velocities
+    void reset(size_t count, uint32_t seed, float radius = 0.01f);
+
+    size_t size() const { return m_count; }
+    float radius() const { return m_radius; }
+    const float* x() const { return m_x.data(); }
+    const float* y() const { return m_y.data(); }
+    const float* vx() const { return m_vx.data(); }
+    const float* vy() const { return m_vy.data(); }
+
+    SwarmStepResult stepScalar(float deltaTime, float speedMultiplier, const PaddleBox& paddle);
+    SwarmStepResult stepSimd(float deltaTime, float speedMultiplier, const PaddleBox& paddle);
+
+    // Interleaved x,y pairs (2 * size() floats) for a single glDrawArrays call
+    void writePositions(float* xy) const;
+
+    static const char* simdName();
+
+private:
+    size_t m_count;
+    float m_radius;
+
+    // Padded to a multiple of 4; padding lanes are parked balls with zero velocity
+    std::vector<float> m_x, m_y, m_vx, m_vy;
+};
+
+} // namespace LidPong
@@ -0,0 +1,61 @@
+#include "BatchEnv.h"
+
+namespace LidPong {
+
+BatchEnv::BatchEnv(size_t count, uint64_t seed, float tickSeconds)
+    : m_tickSeconds(tickSeconds)
+    , m_steps(0) {
+    m_games.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        SimulationConfig config;
+        config.seed = seed + i * 0x9E3779B97F4A7C15ULL; // Spread seeds so games diverge
+        m_games.emplace_back(config);
+    }
+}
+
+void BatchEnv::observe(ThreadPool& pool, float* observations) const {
+    pool.parallelFor(m_games.size(), GRAIN, [this, observations](size_t begin, size_t end) {
+        observeRange(begin, end, observations);
+    });
+}
+
+void BatchEnv::step(ThreadPool& pool, const float* actions, float* observations) {
+    stepAsync(pool, actions, observations);
+    pool.wait();
+}
+
+void BatchEnv::stepAsync(ThreadPool& pool, const float* actions, float* observations) {
+    m_steps += m_games.size();
+    pool.parallelForAsync(m_games.size(), GRAIN, [this, actions, observations](size_t begin, size_t end) {
+        stepRange(begin, end, actions, observations);
+    });
+}
+
+void BatchEnv::stepRange(size_t begin, size_t end, const float* actions, float* observations) {
+    TickInput input;
+    input.deltaTime = m_tickSeconds;
+    for (size_t i = begin; i < end; i++) {
+        Simulation& game = m_games[i];
+        input.lidPosition = TickInput::quantiseLid(actions[i]);
+        input.buttons = game.isGameOver() ? BUTTON_SERVE : 0;
+        game.step(input);
+    }
+    observeRange(begin, end, observations);
+}
+
+void BatchEnv::observeRange(size_t begin, size_t end, float* observations) const {
+    for (size_t i = begin; i < end; i++) {
+        const Simulation& game = m_games[i];
+        float* o = observations + i * OBSERVATION_SIZE;
+        o[OBS_BALL_X] = game.ball().x;
+        o[OBS_BALL_Y] = game.ball().y;
+        o[OBS_BALL_VX] = game.ball().vx;
+        o[OBS_BALL_VY] = game.ball().vy;
+        o[OBS_SLIDER_Y] = game.slider().y;
+        o[OBS_SCORE] = static_cast<float>(game.score());
+        o[OBS_LIVES] = static_cast<float>(game.lives());
+        o[OBS_GAME_OVER] = game.isGameOver() ? 1.0f : 0.0f;
+    }
+}
+
+} // namespace LidPong
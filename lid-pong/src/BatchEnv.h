@@ -0,0 +1,58 @@
+#pragma once
+
+#include "Simulation.h"
+#include "ThreadPool.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace LidPong {
+
+// Many independent classic-mode games stepped together, for bots and
+// automated play-testing. Observations are written straight into a
+// caller-owned buffer (OBSERVATION_SIZE floats per game, games back to back)
+// and actions are read from a matching buffer of one lid position per game.
+// A game that ends restarts on its next step.
+class BatchEnv {
+public:
+    enum ObservationField {
+        OBS_BALL_X,
+        OBS_BALL_Y,
+        OBS_BALL_VX,
+        OBS_BALL_VY,
+        OBS_SLIDER_Y,
+        OBS_SCORE,
+        OBS_LIVES,
+        OBS_GAME_OVER, // 1 on the tick the game ended
+        OBSERVATION_SIZE
+    };
+
+    BatchEnv(size_t count, uint64_t seed, float tickSeconds = 1.0f / 120.0f);
+
+    size_t size() const { return m_games.size(); }
+    uint64_t totalSteps() const { return m_steps; }
+    const Simulation& game(size_t index) const { return m_games[index]; }
+
+    // Write every game's current observation
+    void observe(ThreadPool& pool, float* observations) const;
+
+    // Lock-step: advance every game one tick and return when all are done
+    void step(ThreadPool& pool, const float* actions, float* observations);
+
+    // Start the same step and return at once; call pool.wait() before
+    // touching the buffers or stepping again
+    void stepAsync(ThreadPool& pool, const float* actions, float* observations);
+
+    // Games per pool chunk; small enough to balance, big enough to amortise
+    static const size_t GRAIN = 64;
+
+private:
+    void stepRange(size_t begin, size_t end, const float* actions, float* observations);
+    void observeRange(size_t begin, size_t end, float* observations) const;
+
+    std::vector<Simulation> m_games;
+    float m_tickSeconds;
+    uint64_t m_steps;
+};
+
+} // namespace LidPong
@@ -0,0 +1,2464 @@
+#include "Bench.h"
+#include "AllocTracker.h"
+#include "AngleTrace.h"
+#include "Audio.h"
+#include "BallSwarm.h"
+#include "BatchEnv.h"
+#include "BrickField.h"
+#include "Clock.h"
+#include "Collision.h"
+#include "GameParams.h"
+#include "IdleGovernor.h"
+#include "InputEvents.h"
+#include "InputSampler.h"
+#include "LatencyStats.h"
+#include "LidGestures.h"
+#include "NetTransport.h"
+#include "Particles.h"
+#include "Random.h"
+#include "Recording.h"
+#include "RenderThread.h"
+#include "Rollback.h"
+#include "Sensor.h"
+#include "Scene.h"
+#include "ScoreStore.h"
+#include "SoftwareCanvas.h"
+#include "SpscQueue.h"
+#include "SnapshotRing.h"
+#include "TraceAnalytics.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <thread>
+#include <vector>
+#ifdef __APPLE__
+#include <mach/mach.h>
+#endif
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace LidPong {
+namespace Bench {
+
+namespace {
+    // Field layout of LidPongGame's paddle
+    PaddleBox benchPaddle(int stepIndex) {
+        PaddleBox paddle = {-0.95f, 0.0f, 0.01f, 0.3f};
+        paddle.y = 0.6f * std::sin(stepIndex * 0.01f); // Keep it moving so hits vary
+        return paddle;
+    }
+
+    float maxDifference(const float* a, const float* b, size_t n) {
+        float worst = 0.0f;
+        for (size_t i = 0; i < n; i++) {
+            float d = std::abs(a[i] - b[i]);
+            if (d > worst) worst = d;
+        }
+        return worst;
+    }
+}
+
+int balls(size_t maxBalls) {
+    const float deltaTime = 1.0f / 120.0f;
+    const float speed = 1.0f;
+    const float tolerance = 1e-5f;
+    int failures = 0;
+
+    std::cout << "Multi-ball kernels (" << BallSwarm::simdName() << ")" << std::endl;
+    std::cout << std::setw(8) << "balls" << std::setw(8) << "steps"
+              << std::setw(14) << "scalar b/ms" << std::setw(14) << "simd b/ms"
+              << std::setw(10) << "speedup" << std::setw(12) << "max diff"
+              << "  hits/misses" << std::endl;
+
+    for (size_t count = 256; count <= maxBalls; count *= 4) {
+        // Roughly constant work per row
+        int steps = static_cast<int>(std::max<size_t>(50, 4000000 / count));
+
+        BallSwarm scalar, vectorised;
+        scalar.reset(count, 1234);
+        vectorised.reset(count, 1234);
+
+        long scalarHits = 0, scalarMisses = 0, simdHits = 0, simdMisses = 0;
+
+        int64_t start = Clock::nowNs();
+        for (int s = 0; s < steps; s++) {
+            SwarmStepResult r = scalar.stepScalar(deltaTime, speed, benchPaddle(s));
+            scalarHits += r.hits;
+            scalarMisses += r.misses;
+        }
+        double scalarMs = Clock::nsToMs(Clock::nowNs() - start);
+
+        start = Clock::nowNs();
+        for (int s = 0; s < steps; s++) {
+            SwarmStepResult r = vectorised.stepSimd(deltaTime, speed, benchPaddle(s));
+            simdHits += r.hits;
+            simdMisses += r.misses;
+        }
+        double simdMs = Clock::nsToMs(Clock::nowNs() - start);
+
+        float diff = std::max(std::max(maxDifference(scalar.x(), vectorised.x(), count),
+                                       maxDifference(scalar.y(), vectorised.y(), count)),
+                              std::max(maxDifference(scalar.vx(), vectorised.vx(), count),
+                                       maxDifference(scalar.vy(), vectorised.vy(), count)));
+        bool match = diff <= tolerance && scalarHits == simdHits && scalarMisses == simdMisses;
+        if (!match) failures++;
+
+        double ballSteps = static_cast<double>(count) * steps;
+        std::cout << std::setw(8) << count << std::setw(8) << steps
+                  << std::fixed << std::setprecision(0)
+                  << std::setw(14) << ballSteps / scalarMs
+                  << std::setw(14) << ballSteps / simdMs
+                  << std::setprecision(2) << std::setw(9) << scalarMs / simdMs << "x"
+                  << std::scientific << std::setprecision(1) << std::setw(12) << diff
+                  << "  " << simdHits << "/" << simdMisses
+                  << (match ? "" : "  MISMATCH (scalar " + std::to_string(scalarHits) + "/" +
+                                   std::to_string(scalarMisses) + ")")
+                  << std::defaultfloat << std::endl;
+    }
+
+    std::cout << (failures ? "FAILED: scalar and SIMD results differ" : "OK: scalar and SIMD results match") << std::endl;
+    return failures ? 1 : 0;
+}
+
+namespace {
+    // The pre-swept rules: move, bounce off walls, then test paddle overlap
+    bool discreteStep(SweptBall& ball, float duration, const SweptPaddle& paddle, const Playfield& field, bool& hit) {
+        ball.x += ball.vx * duration;
+        ball.y += ball.vy * duration;
+        if (ball.y + ball.radius > field.top || ball.y - ball.radius < field.bottom) {
+            ball.vy = -ball.vy;
+        }
+        if (ball.x + ball.radius > field.right) {
+            ball.vx = -ball.vx;
+        }
+        if (ball.vx < 0.0f &&
+            ball.x - ball.radius <= paddle.x + paddle.halfWidth && ball.x + ball.radius >= paddle.x - paddle.halfWidth &&
+            ball.y - ball.radius <= paddle.endY + paddle.halfHeight && ball.y + ball.radius >= paddle.endY - paddle.halfHeight) {
+            ball.vx = -ball.vx;
+            hit = true;
+        }
+        return ball.x + ball.radius < field.missX;
+    }
+}
+
+int ccd() {
+    const float speeds[] = {0.6f, 1.0f, 3.0f, 10.0f, 30.0f};
+    const float steps[] = {1.0f / 1000.0f, 1.0f / 240.0f, 1.0f / 60.0f, 1.0f / 20.0f, 1.0f / 5.0f};
+    const int trials = 500;
+    const Playfield field = Playfield::standard();
+    long sweptTunnels = 0;
+
+    std::cout << "Paddle collision, " << trials << " aimed shots per cell (tunnelled shots: swept / discrete)" << std::endl;
+    std::cout << std::setw(10) << "speed";
+    for (float step : steps) {
+        std::cout << std::setw(14) << ("1/" + std::to_string(static_cast<int>(std::lround(1.0f / step))) + " s");
+    }
+    std::cout << std::endl;
+
+    uint32_t state = 42;
+    for (float speed : speeds) {
+        std::cout << std::setw(9) << std::fixed << std::setprecision(1) << speed << "x";
+        for (float step : steps) {
+            int swept = 0, discrete = 0;
+            for (int t = 0; t < trials; t++) {
+                // Aim from the right half at a point on the paddle face; the paddle
+                // drifts a little each step so the moving-paddle sweep is exercised too
+                state = state * 1664525u + 1013904223u;
+                float startY = ((state >> 8) / 16777216.0f - 0.5f) * 0.5f;
+                state = state * 1664525u + 1013904223u;
+                float targetY = ((state >> 8) / 16777216.0f - 0.5f) * 0.4f;
+                float dx = -0.94f - 0.5f, dy = targetY - startY;
+                float length = std::sqrt(dx * dx + dy * dy);
+
+                SweptBall a = {0.5f, startY, dx / length, dy / length, 0.02f};
+                SweptBall b = a;
+                bool sweptHit = false, discreteHit = false, sweptMiss = false, discreteMiss = false;
+                float paddleY = 0.0f;
+
+                for (int i = 0; i < 100000 && !(sweptHit || sweptMiss); i++) {
+                    float nextY = paddleY + 0.02f * std::sin(i * 0.7f) * step;
+                    SweptPaddle paddle = {-0.95f, paddleY, nextY, 0.01f, 0.3f};
+                    SweepResult r = sweepBall(a, step * speed, paddle, field);
+                    sweptHit = r.paddleHits > 0;
+                    sweptMiss = r.missed;
+                    paddleY = nextY;
+                }
+                for (int i = 0; i < 100000 && !(discreteHit || discreteMiss); i++) {
+                    SweptPaddle paddle = {-0.95f, 0.0f, 0.0f, 0.01f, 0.3f};
+                    discreteMiss = discreteStep(b, step * speed, paddle, field, discreteHit);
+                }
+                if (!sweptHit) swept++;
+                if (!discreteHit) discrete++;
+            }
+            sweptTunnels += swept;
+            std::cout << std::setw(14) << (std::to_string(swept) + " / " + std::to_string(discrete));
+        }
+        std::cout << std::endl;
+    }
+
+    std::cout << (sweptTunnels ? "FAILED: swept collision tunnelled" : "OK: no tunnelling with swept collision") << std::endl;
+    return sweptTunnels ? 1 : 0;
+}
+
+namespace {
+    // Average ns per tick for 'ballCount' balls bouncing in a fresh brick field
+    double brickTickNs(int rows, int columns, int ballCount, bool bruteForce, int ticks, long& broken) {
+        BrickField field;
+        field.build(rows, columns, -0.1f, -0.9f, 0.9f, 0.9f);
+        const Playfield bounds = Playfield::standard();
+        const SweptPaddle paddle = {-0.95f, 0.0f, 0.0f, 0.01f, 0.95f}; // Full-height wall: no misses
+
+        std::vector<SweptBall> balls(ballCount);
+        uint32_t state = 7;
+        for (SweptBall& b : balls) {
+            state = state * 1664525u + 1013904223u;
+            float angle = (state >> 8) / 16777216.0f * 6.2831853f;
+            b.x = -0.5f;
+            b.y = -0.8f + 1.6f * ((state >> 4) & 0xFFFF) / 65535.0f;
+            b.vx = 1.0f * std::cos(angle);
+            b.vy = 1.0f * std::sin(angle);
+            b.radius = 0.01f;
+        }
+
+        broken = 0;
+        int64_t start = Clock::nowNs();
+        for (int t = 0; t < ticks; t++) {
+            for (SweptBall& b : balls) {
+                broken += field.stepBall(b, 1.0f / 120.0f, paddle, bounds, bruteForce).bricksBroken;
+            }
+        }
+        return static_cast<double>(Clock::nowNs() - start) / ticks;
+    }
+}
+
+int bricks() {
+    const int brickCounts[][2] = {{25, 40}, {50, 80}, {100, 160}}; // rows x columns
+    const int ballCounts[] = {1, 16, 256};
+    const int ticks = 600;
+    int failures = 0;
+
+    std::cout << "Brick mode cost per tick (" << ticks << " ticks at 120 Hz)" << std::endl;
+    std::cout << std::setw(8) << "bricks" << std::setw(7) << "balls"
+              << std::setw(14) << "grid us" << std::setw(14) << "brute us"
+              << std::setw(14) << "grid ns/ball" << std::setw(10) << "speedup" << std::endl;
+
+    for (const auto& size : brickCounts) {
+        for (int ballCount : ballCounts) {
+            long gridBroken = 0, bruteBroken = 0;
+            double grid = brickTickNs(size[0], size[1], ballCount, false, ticks, gridBroken);
+            double brute = brickTickNs(size[0], size[1], ballCount, true, ticks, bruteBroken);
+            if (gridBroken != bruteBroken) failures++;
+
+            std::cout << std::setw(8) << size[0] * size[1] << std::setw(7) << ballCount
+                      << std::fixed << std::setprecision(2)
+                      << std::setw(14) << grid / 1000.0 << std::setw(14) << brute / 1000.0
+                      << std::setprecision(0) << std::setw(14) << grid / ballCount
+                      << std::setprecision(1) << std::setw(9) << brute / grid << "x"
+                      << (gridBroken != bruteBroken ? "  MISMATCH" : "") << std::endl;
+        }
+    }
+
+    // One long step that only reaches the brick after bouncing off the right wall
+    for (bool bruteForce : {false, true}) {
+        BrickField field;
+        field.build(1, 1, 0.6f, 0.2f, 0.8f, 0.4f);
+        const SweptPaddle paddle = {-0.95f, 0.0f, 0.0f, 0.01f, 0.95f};
+        SweptBall b = {0.7f, -0.3f, 1.0f, 1.0f, 0.01f};
+        int broken = field.stepBall(b, 1.0f, paddle, Playfield::standard(), bruteForce).bricksBroken;
+        bool ok = broken == 1 && field.aliveCount() == 0;
+        if (!ok) failures++;
+        std::cout << "Brick after a wall bounce in one step (" << (bruteForce ? "brute force" : "grid")
+                  << "): " << (ok ? "OK" : "WRONG") << std::endl;
+    }
+
+    std::cout << (failures ? "FAILED: bricks missed or grid and brute force disagree"
+                           : "OK: grid and brute force agree, no bricks missed after bounces") << std::endl;
+    return failures ? 1 : 0;
+}
+
+namespace {
+    // Simple tracking policy: put the paddle where the ball is
+    void trackBall(const float* observations, float* actions, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            float lid = observations[i * BatchEnv::OBSERVATION_SIZE + BatchEnv::OBS_BALL_Y] / 3.4f + 0.5f;
+            actions[i] = std::min(1.0f, std::max(0.0f, lid));
+        }
+    }
+
+    // Steps per second of 'ticks' lock-step ticks; fills 'checksum' with a hash of all final states
+    double envStepsPerSecond(size_t envCount, size_t threads, int ticks, uint64_t& checksum, uint64_t& stolen) {
+        ThreadPool pool(threads);
+        BatchEnv envs(envCount, 1234);
+        std::vector<float> observations(envCount * BatchEnv::OBSERVATION_SIZE);
+        std::vector<float> actions(envCount);
+        envs.observe(pool, observations.data());
+
+        int64_t start = Clock::nowNs();
+        for (int t = 0; t < ticks; t++) {
+            trackBall(observations.data(), actions.data(), envCount);
+            envs.step(pool, actions.data(), observations.data());
+        }
+        double seconds = (Clock::nowNs() - start) / 1e9;
+
+        checksum = 0;
+        for (size_t i = 0; i < envCount; i++) {
+            checksum = checksum * 31 + envs.game(i).checksum();
+        }
+        stolen = pool.chunksStolen();
+        return envs.totalSteps() / seconds;
+    }
+}
+
+int envs(size_t envCount) {
+    const int ticks = static_cast<int>(std::max<size_t>(100, 8000000 / envCount));
+    size_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    int failures = 0;
+
+    std::cout << "Batch environments: " << envCount << " games, " << ticks << " lock-step ticks, "
+              << maxThreads << " hardware threads" << std::endl;
+    std::cout << std::setw(8) << "threads" << std::setw(16) << "steps/s"
+              << std::setw(10) << "speedup" << std::setw(12) << "efficiency"
+              << std::setw(10) << "stolen" << std::endl;
+
+    double baseline = 0.0;
+    uint64_t baselineChecksum = 0;
+    for (size_t threads = 1; ; threads = std::min(threads * 2, maxThreads)) {
+        uint64_t checksum = 0, stolen = 0;
+        double rate = envStepsPerSecond(envCount, threads, ticks, checksum, stolen);
+        if (threads == 1) {
+            baseline = rate;
+            baselineChecksum = checksum;
+        }
+        bool match = checksum == baselineChecksum;
+        if (!match) failures++;
+
+        std::cout << std::setw(8) << threads
+                  << std::fixed << std::setprecision(0) << std::setw(16) << rate
+                  << std::setprecision(2) << std::setw(9) << rate / baseline << "x"
+                  << std::setprecision(0) << std::setw(11) << 100.0 * rate / (baseline * threads) << "%"
+                  << std::setw(10) << stolen
+                  << (match ? "" : "  MISMATCH") << std::endl;
+
+        if (threads == maxThreads) break;
+    }
+
+    std::cout << (failures ? "FAILED: results depend on the thread count"
+                           : "OK: identical results on every thread count") << std::endl;
+    return failures ? 1 : 0;
+}
+
+namespace {
+    // Deterministic paddle motion for driving benchmark games
+    TickInput benchTick(uint64_t tick) {
+        TickInput input;
+        input.deltaTime = 1.0f / 120.0f;
+        input.lidPosition = TickInput::quantiseLid(0.5 + 0.2 * std::sin(tick * 0.02));
+        return input;
+    }
+
+    // Save, play on, restore, replay the same ticks: must land on the same state
+    bool restoreReproduces(Simulation& sim, uint64_t ticks) {
+        Simulation::Snapshot snapshot;
+        sim.save(snapshot);
+        uint64_t first = sim.tickCount();
+        for (uint64_t t = 0; t < ticks; t++) sim.step(benchTick(first + t));
+        uint64_t expected = sim.checksum();
+
+        if (!sim.restore(snapshot)) return false;
+        for (uint64_t t = 0; t < ticks; t++) sim.step(benchTick(first + t));
+        return sim.checksum() == expected;
+    }
+}
+
+int snapshots() {
+    struct Mode {
+        const char* name;
+        size_t balls, bricks;
+    };
+    const Mode modes[] = {
+        {"classic", 0, 0},
+        {"party 1k", 1024, 0},
+        {"party 64k", 65536, 0},
+        {"bricks 4k", 4, 4000}
+    };
+    int failures = 0;
+
+    // The flat GameState on its own: a memcpy
+    {
+        Simulation sim;
+        for (uint64_t t = 0; t < 100; t++) sim.step(benchTick(t));
+        GameState saved[2] = {sim.state(), sim.state()};
+        const int iterations = 10000000;
+        int64_t start = Clock::nowNs();
+        for (int i = 0; i < iterations; i++) {
+            saved[i & 1] = sim.state();
+            sim.restore(saved[(i + 1) & 1]);
+        }
+        double ns = static_cast<double>(Clock::nowNs() - start) / iterations;
+        std::cout << "GameState (" << sizeof(GameState) << " bytes, v" << GameState::VERSION << "): save+restore "
+                  << std::fixed << std::setprecision(1) << ns << " ns" << std::endl << std::endl;
+    }
+
+    std::cout << std::setw(12) << "mode" << std::setw(12) << "save ns" << std::setw(14) << "restore ns"
+              << std::setw(14) << "ring push ns" << "  reproduces" << std::endl;
+
+    for (const Mode& mode : modes) {
+        SimulationConfig config;
+        config.multiBallCount = mode.balls;
+        config.brickCount = mode.bricks;
+        Simulation sim(config);
+        for (uint64_t t = 0; t < 120; t++) sim.step(benchTick(t));
+
+        // Aim for a few hundred milliseconds per row whatever the snapshot size
+        size_t bytes = 64 + mode.balls * 16 + sim.brickField().copyBytes();
+        int iterations = static_cast<int>(std::max<size_t>(200, 200000000 / bytes));
+
+        Simulation::Snapshot snapshot;
+        sim.save(snapshot); // Warm: later saves reuse this storage
+        int64_t start = Clock::nowNs();
+        for (int i = 0; i < iterations; i++) sim.save(snapshot);
+        double saveNs = static_cast<double>(Clock::nowNs() - start) / iterations;
+
+        start = Clock::nowNs();
+        for (int i = 0; i < iterations; i++) sim.restore(snapshot);
+        double restoreNs = static_cast<double>(Clock::nowNs() - start) / iterations;
+
+        SnapshotRing ring(64);
+        for (size_t i = 0; i < ring.capacity(); i++) ring.push(sim);
+        start = Clock::nowNs();
+        for (int i = 0; i < iterations; i++) ring.push(sim);
+        double pushNs = static_cast<double>(Clock::nowNs() - start) / iterations;
+
+        bool reproduces = restoreReproduces(sim, 600);
+        if (!reproduces) failures++;
+
+        std::cout << std::setw(12) << mode.name << std::fixed << std::setprecision(1)
+                  << std::setw(12) << saveNs << std::setw(14) << restoreNs << std::setw(14) << pushNs
+                  << (reproduces ? "  yes" : "  NO") << std::endl;
+    }
+
+    std::cout << (failures ? "FAILED: a restored game diverged" : "OK: restored games replay identically") << std::endl;
+    return failures ? 1 : 0;
+}
+
+namespace {
+    // Scripted player: sweeping lid, a serve now and then, one speed change
+    PlayerInput scriptedInput(int player, uint64_t tick) {
+        PlayerInput input;
+        double phase = tick * (0.013 + 0.007 * player) + player;
+        input.lid = TickInput::lidToFixed(0.5 + 0.45 * std::sin(phase));
+        input.buttons = 0;
+        if ((tick + 37 * player) % 300 == 0) input.buttons |= BUTTON_SERVE;
+        if (player == 1 && tick == 500) input.buttons |= BUTTON_SPEED_UP;
+        return input;
+    }
+
+    struct NetScenario {
+        const char* name;
+        NetImpairment impairment;
+    };
+
+    NetScenario netScenario(const char* name, double latencyMs, double jitterMs, double lossRate) {
+        NetScenario scenario;
+        scenario.name = name;
+        scenario.impairment.latencyMs = latencyMs;
+        scenario.impairment.jitterMs = jitterMs;
+        scenario.impairment.lossRate = lossRate;
+        return scenario;
+    }
+}
+
+int netplay() {
+    const uint64_t ticks = 3000;
+    const double tickHz = 60.0;
+    const int64_t tickNs = static_cast<int64_t>(1e9 / tickHz);
+    const NetScenario scenarios[] = {
+        netScenario("clean", 0.0, 0.0, 0.0),
+        netScenario("lan", 5.0, 2.0, 0.01),
+        netScenario("wifi", 40.0, 15.0, 0.05),
+        netScenario("bad", 120.0, 40.0, 0.2)
+    };
+    int failures = 0;
+
+    SimulationConfig config;
+    config.versus = true;
+    config.seed = 99;
+
+    // What both peers must end up with: one simulation fed the true inputs
+    Simulation reference(config);
+    for (uint64_t t = 0; t < ticks; t++) {
+        PlayerInput left = scriptedInput(0, t), right = scriptedInput(1, t);
+        TickInput input;
+        input.deltaTime = static_cast<float>(1.0 / tickHz);
+        input.lidPosition = TickInput::lidFromFixed(left.lid);
+        input.rightLidPosition = TickInput::lidFromFixed(right.lid);
+        input.buttons = left.buttons | right.buttons;
+        reference.step(input);
+    }
+    uint64_t expected = reference.checksum();
+
+    std::cout << "Rollback netplay over loopback UDP: " << ticks << " ticks at " << tickHz << " Hz, final score "
+              << reference.score() << ":" << reference.rightScore() << std::endl;
+    std::cout << std::setw(8) << "network" << std::setw(16) << "rollbacks"
+              << std::setw(12) << "resim" << std::setw(10) << "max" << std::setw(9) << "stalls"
+              << std::setw(9) << "lost" << std::setw(10) << "checked" << std::setw(9) << "desync"
+              << std::setw(10) << "wall ms" << "  converged" << std::endl;
+
+    for (const NetScenario& scenario : scenarios) {
+        UdpTransport socketA, socketB;
+        std::string error;
+        if (!socketA.open(0, error) || !socketB.open(0, error) ||
+            !socketA.setPeer("127.0.0.1", socketB.localPort(), error) ||
+            !socketB.setPeer("127.0.0.1", socketA.localPort(), error)) {
+            std::cout << "FAILED: " << error << std::endl;
+            return 1;
+        }
+        ImpairedTransport linkA(socketA, scenario.impairment, 1), linkB(socketB, scenario.impairment, 2);
+
+        Simulation simA(config), simB(config);
+        RollbackSession peerA(simA, 0, static_cast<float>(1.0 / tickHz), linkA);
+        RollbackSession peerB(simB, 1, static_cast<float>(1.0 / tickHz), linkB);
+        RollbackSession* peers[2] = {&peerA, &peerB};
+
+        // Simulated clock: each iteration is one tick of wall time. Peers that
+        // stalled catch up by running a few ticks at once.
+        int64_t start = Clock::nowNs();
+        uint64_t iteration = 0;
+        const uint64_t maxIterations = ticks * 4;
+        for (; iteration < maxIterations; iteration++) {
+            int64_t now = static_cast<int64_t>(iteration) * tickNs;
+            linkA.pump(now);
+            linkB.pump(now);
+
+            for (int p = 0; p < 2; p++) {
+                RollbackSession& peer = *peers[p];
+                uint64_t target = std::min<uint64_t>(iteration + 1, ticks);
+                int steps = 0;
+                while (peer.currentTick() < target && steps < 4 && peer.advance(scriptedInput(p, peer.currentTick()))) {
+                    steps++;
+                }
+                if (steps == 0) {
+                    peer.update();
+                }
+            }
+
+            if (peerA.currentTick() == ticks && peerB.currentTick() == ticks && peerA.isSettled() && peerB.isSettled()) {
+                break;
+            }
+        }
+        double wallMs = Clock::nsToMs(Clock::nowNs() - start);
+
+        bool converged = peerA.isSettled() && peerB.isSettled() &&
+                         simA.checksum() == expected && simB.checksum() == expected;
+        const RollbackStats& a = peerA.stats();
+        const RollbackStats& b = peerB.stats();
+        // Every packet repeats the latest checksum; each tick is compared once
+        const uint64_t checksumTicks = ticks / RollbackSession::CHECKSUM_INTERVAL + 1;
+        bool countedOnce = a.checksumsCompared <= checksumTicks && b.checksumsCompared <= checksumTicks;
+        if (!converged || a.desyncs || b.desyncs || !countedOnce) failures++;
+
+        std::cout << std::setw(8) << scenario.name
+                  << std::setw(16) << a.rollbacks + b.rollbacks
+                  << std::setw(12) << a.resimulatedTicks + b.resimulatedTicks
+                  << std::setw(10) << std::max(a.maxRollbackDepth, b.maxRollbackDepth)
+                  << std::setw(9) << a.stalls + b.stalls
+                  << std::setw(9) << linkA.dropped() + linkB.dropped()
+                  << std::setw(10) << a.checksumsCompared + b.checksumsCompared
+                  << std::setw(9) << a.desyncs + b.desyncs
+                  << std::fixed << std::setprecision(1) << std::setw(10) << wallMs
+                  << (converged ? "  yes" : "  NO") << (countedOnce ? "" : "  CHECKSUMS OVERCOUNTED") << std::endl;
+    }
+
+    // Once the peer is set, datagrams from any other address are dropped
+    {
+        UdpTransport socket, peer, stranger;
+        std::string error;
+        if (!socket.open(0, error) || !peer.open(0, error) || !stranger.open(0, error) ||
+            !socket.setPeer("127.0.0.1", peer.localPort(), error) ||
+            !stranger.setPeer("127.0.0.1", socket.localPort(), error) ||
+            !peer.setPeer("127.0.0.1", socket.localPort(), error)) {
+            std::cout << "FAILED: " << error << std::endl;
+            return 1;
+        }
+        const uint8_t junk[4] = {1, 2, 3, 4}, real[2] = {5, 6};
+        stranger.send(junk, sizeof(junk));
+        peer.send(real, sizeof(real));
+        uint8_t buffer[16];
+        int size = -1;
+        for (int i = 0; i < 1000 && (size = socket.receive(buffer, sizeof(buffer))) < 0; i++) {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+        bool ok = size == static_cast<int>(sizeof(real)) && buffer[0] == real[0];
+        if (!ok) failures++;
+        std::cout << "Datagrams from other senders ignored: " << (ok ? "OK" : "WRONG") << std::endl;
+    }
+
+    // Cost of the worst case: restoring and re-running a full prediction window
+    {
+        Simulation sim(config);
+        for (uint64_t t = 0; t < 100; t++) sim.step(benchTick(t));
+        GameState saved = sim.state();
+        const int iterations = 20000;
+        int64_t start = Clock::nowNs();
+        for (int i = 0; i < iterations; i++) {
+            sim.restore(saved);
+            for (uint32_t t = 0; t < RollbackSession::MAX_PREDICTION; t++) sim.step(benchTick(t));
+        }
+        double ns = static_cast<double>(Clock::nowNs() - start) / iterations;
+        std::cout << "Full " << RollbackSession::MAX_PREDICTION << "-tick rollback: " << std::setprecision(2)
+                  << ns / 1000.0 << " us" << std::endl;
+    }
+
+    std::cout << (failures ? "FAILED: peers did not converge, or a transport or checksum check failed"
+                           : "OK: both peers converged on the reference state every time") << std::endl;
+    return failures ? 1 : 0;
+}
+
+namespace {
+    // Current resident set size in bytes (0 if unknown)
+    size_t residentBytes() {
+#ifdef __APPLE__
+        mach_task_basic_info_data_t info;
+        mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+        if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) != KERN_SUCCESS) {
+            return 0;
+        }
+        return info.resident_size;
+#else
+        std::ifstream statm("/proc/self/statm");
+        size_t pages = 0, resident = 0;
+        if (!(statm >> pages >> resident)) {
+            return 0;
+        }
+        return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+    }
+}
+
+int soak(const SimulationConfig& config, size_t games, const BotOptions& botOptions) {
+    const float tickSeconds = 1.0f / 120.0f;
+    const uint64_t maxTicksPerGame = 120 * 60 * 5; // Five minutes of play; party mode never ends
+    const double outlierUs = 1000.0;                // A tick that would show up as a dropped frame
+    const double allowedGrowthMb = 8.0;
+
+    BotController bot(botOptions);
+    LatencyStats hitsPerGame(games > 0 ? games : 1);
+    LatencyStats ticksPerGame(games > 0 ? games : 1);
+    LatencyStats tickUs(1 << 16);
+    uint64_t totalTicks = 0, outliers = 0;
+    long totalHits = 0, livesLost = 0;
+    size_t cappedGames = 0;
+    size_t warmupGames = std::max<size_t>(1, games / 10);
+    size_t baselineBytes = 0;
+
+    std::cout << "Soak: " << games << " games, bot delay " << botOptions.reactionDelay * 1000.0
+              << " ms, noise " << botOptions.noise << std::endl;
+
+    int64_t start = Clock::nowNs();
+    for (size_t g = 0; g < games; g++) {
+        SimulationConfig gameConfig = config;
+        gameConfig.seed = config.seed + g;
+        Simulation sim(gameConfig);
+        bot.reset();
+
+        TickInput input;
+        input.deltaTime = tickSeconds;
+        uint64_t ticks = 0;
+        while (!sim.isGameOver() && ticks < maxTicksPerGame) {
+            input.lidPosition = TickInput::quantiseLid(bot.lidPosition(sim, tickSeconds));
+            int64_t tickStart = Clock::nowNs();
+            sim.step(input);
+            double us = (Clock::nowNs() - tickStart) / 1000.0;
+            tickUs.record(us);
+            if (us > outlierUs) outliers++;
+            ticks++;
+        }
+
+        if (!sim.isGameOver()) cappedGames++;
+        totalTicks += ticks;
+        totalHits += sim.totalHits();
+        livesLost += 3 - sim.lives();
+        hitsPerGame.record(sim.totalHits());
+        ticksPerGame.record(static_cast<double>(ticks));
+
+        if (g + 1 == warmupGames) {
+            baselineBytes = residentBytes();
+        }
+        if ((g + 1) % std::max<size_t>(1, games / 20) == 0) {
+            std::cout << "\r  " << g + 1 << "/" << games << " games" << std::flush;
+        }
+    }
+    double seconds = (Clock::nowNs() - start) / 1e9;
+    size_t finalBytes = residentBytes();
+    double growthMb = (static_cast<double>(finalBytes) - static_cast<double>(baselineBytes)) / (1024.0 * 1024.0);
+
+    std::cout << std::endl << std::fixed << std::setprecision(1);
+    std::cout << "Hits per game: mean=" << hitsPerGame.mean() << " p50=" << hitsPerGame.percentile(50.0)
+              << " p99=" << hitsPerGame.percentile(99.0) << " max=" << hitsPerGame.max()
+              << " | total hits " << totalHits << ", lives lost " << livesLost << std::endl;
+    std::cout << "Ticks per game: mean=" << ticksPerGame.mean() << " max=" << ticksPerGame.max()
+              << " | " << cappedGames << " games hit the " << maxTicksPerGame << "-tick cap" << std::endl;
+    std::cout << std::setprecision(0) << "Throughput: " << totalTicks << " ticks in " << std::setprecision(2)
+              << seconds << " s = " << std::setprecision(0) << totalTicks / seconds << " ticks/s" << std::endl;
+    std::cout << std::setprecision(3) << "Tick time (last " << tickUs.count() << "): p50=" << tickUs.percentile(50.0)
+              << " p99=" << tickUs.percentile(99.0) << " p99.9=" << tickUs.percentile(99.9)
+              << " max=" << tickUs.max() << " us | " << outliers << " ticks over " << std::setprecision(0)
+              << outlierUs << " us" << std::endl;
+    std::cout << std::setprecision(1) << "Resident memory: " << baselineBytes / (1024.0 * 1024.0) << " MB after warm-up, "
+              << finalBytes / (1024.0 * 1024.0) << " MB at end (" << std::showpos << growthMb << std::noshowpos
+              << " MB)" << std::endl;
+
+    bool leaked = baselineBytes != 0 && growthMb > allowedGrowthMb;
+    std::cout << (leaked ? "FAILED: memory kept growing after warm-up" : "OK") << std::endl;
+    return leaked ? 1 : 0;
+}
+
+namespace {
+    struct RenderScene {
+        const char* name;
+        SimulationConfig config;
+        bool playToGameOver;
+    };
+
+    // Deterministic game states to draw: a fixed seed, scripted lid and ticks
+    void setUpScene(Simulation& sim, const RenderScene& scene) {
+        for (uint64_t t = 0; t < 240; t++) {
+            TickInput input = benchTick(t);
+            input.rightLidPosition = TickInput::quantiseLid(0.5 - 0.3 * std::sin(t * 0.015));
+            sim.step(input);
+        }
+        // Park the paddle at the top at full speed until the lives run out
+        for (uint64_t t = 0; scene.playToGameOver && !sim.isGameOver() && t < 1000000; t++) {
+            TickInput input;
+            input.deltaTime = 1.0f / 120.0f;
+            input.lidPosition = 1.0;
+            input.buttons = BUTTON_SPEED_SET;
+            input.speedSetting = Simulation::MAX_SPEED;
+            sim.step(input);
+        }
+    }
+
+    size_t differingPixels(const uint32_t* a, const uint32_t* b, size_t count) {
+        size_t differing = 0;
+        for (size_t i = 0; i < count; i++) {
+            if (a[i] != b[i]) differing++;
+        }
+        return differing;
+    }
+}
+
+int render(const std::string& goldenDirectory, int width, int height) {
+    std::vector<RenderScene> scenes;
+    SimulationConfig config;
+    config.seed = 1;
+    scenes.push_back({"classic", config, false});
+    scenes.push_back({"gameover", config, true});
+    config.versus = true;
+    scenes.push_back({"versus", config, false});
+    config.versus = false;
+    config.multiBallCount = 2000;
+    scenes.push_back({"party", config, false});
+    config.multiBallCount = 8;
+    config.brickCount = 2000;
+    scenes.push_back({"bricks", config, false});
+
+    const HudInfo hud = {true, 100.0};
+    int failures = 0;
+
+    std::cout << "Software rasteriser at " << width << "x" << height << " (spans: "
+              << SoftwareCanvas::simdName() << ")" << std::endl;
+    std::cout << std::setw(10) << "scene" << std::setw(12) << "simd fps" << std::setw(12) << "scalar fps"
+              << std::setw(10) << "ms/frame" << "  golden" << std::endl;
+
+    for (const RenderScene& scene : scenes) {
+        Simulation sim(scene.config);
+        setUpScene(sim, scene);
+
+        SoftwareCanvas simdCanvas(width, height), scalarCanvas(width, height);
+        scalarCanvas.setSimd(false);
+        SceneRenderer renderer;
+        RenderSnapshot frame;
+        frame.capture(sim, 0);
+        frame.hud = hud;
+
+        // Frames per second: redraw the same state for about a quarter of a second
+        double fps[2];
+        SoftwareCanvas* canvases[2] = {&simdCanvas, &scalarCanvas};
+        for (int c = 0; c < 2; c++) {
+            int frames = 0;
+            int64_t start = Clock::nowNs();
+            int64_t elapsed = 0;
+            while (elapsed < 250000000 || frames < 3) {
+                renderer.draw(*canvases[c], frame);
+                frames++;
+                elapsed = Clock::nowNs() - start;
+            }
+            fps[c] = frames / (elapsed / 1e9);
+        }
+
+        std::cout << std::setw(10) << scene.name << std::fixed << std::setprecision(0)
+                  << std::setw(12) << fps[0] << std::setw(12) << fps[1]
+                  << std::setprecision(3) << std::setw(10) << 1000.0 / fps[0] << "  ";
+
+        // The two span paths must agree bit for bit
+        const size_t pixelCount = static_cast<size_t>(width) * height;
+        size_t mismatch = differingPixels(simdCanvas.pixels(), scalarCanvas.pixels(), pixelCount);
+        if (mismatch > 0) {
+            std::cout << "FAIL: SIMD and scalar differ in " << mismatch << " pixels" << std::endl;
+            failures++;
+            continue;
+        }
+
+        if (goldenDirectory.empty()) {
+            std::cout << "-" << std::endl;
+            continue;
+        }
+        std::string path = goldenDirectory + "/" + scene.name + ".ppm";
+        std::vector<uint32_t> golden;
+        int goldenWidth = 0, goldenHeight = 0;
+        std::string error;
+        if (!std::ifstream(path.c_str())) {
+            // First run blesses the current output
+            if (!writePpm(path, simdCanvas.pixels(), width, height, error)) {
+                std::cout << "FAIL: " << error << std::endl;
+                failures++;
+            } else {
+                std::cout << "wrote " << path << std::endl;
+            }
+        } else if (!readPpm(path, golden, goldenWidth, goldenHeight, error)) {
+            std::cout << "FAIL: " << error << std::endl;
+            failures++;
+        } else if (goldenWidth != width || goldenHeight != height) {
+            std::cout << "FAIL: golden image is " << goldenWidth << "x" << goldenHeight << std::endl;
+            failures++;
+        } else if ((mismatch = differingPixels(simdCanvas.pixels(), golden.data(), pixelCount)) > 0) {
+            std::cout << "FAIL: " << mismatch << " pixels differ from " << path << std::endl;
+            failures++;
+        } else {
+            std::cout << "match" << std::endl;
+        }
+    }
+
+    std::cout << (failures == 0 ? "OK: every scene rendered identically on both span paths"
+                                : "FAIL: rendering mismatches") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
+
+int input(size_t frames) {
+    // Any codes do; these are GLFW's SPACE, '=', '-', UP and DOWN
+    const int keys[] = {32, 61, 45, 265, 264};
+    const size_t keyCount = sizeof(keys) / sizeof(keys[0]);
+    const int64_t frameNs = 16666667;
+
+    Random random(39);
+    InputQueue queue;
+    InputState state;
+    bool down[keyCount] = {};
+    bool polledLatch[keyCount] = {};
+    uint64_t events = 0, presses = 0, queuedPresses = 0, polledPresses = 0, taps = 0;
+    uint64_t clicks = 0, queuedClicks = 0, polledClicks = 0;
+    bool buttonDown = false, polledButtonLatch = false;
+    size_t mismatches = 0;
+
+    // A synthetic stream of 60 Hz frames: holds that span frames, taps that
+    // are pressed and released within one, and clicks between cursor moves
+    for (size_t frame = 0; frame < frames; frame++) {
+        int64_t t = static_cast<int64_t>(frame) * frameNs;
+        uint32_t pressesThisFrame[keyCount] = {};
+        uint32_t clicksThisFrame = 0;
+        double clickX = -1.0, clickY = -1.0;
+        uint32_t actions = random.next() % 6;
+        for (uint32_t a = 0; a < actions; a++) {
+            t += frameNs / 8;
+            uint32_t roll = random.next() % 8;
+            size_t k = random.next() % keyCount;
+            if (roll < 3) {
+                // Toggle: press or release a held key
+                down[k] = !down[k];
+                if (down[k]) pressesThisFrame[k]++;
+                queue.push(InputEvent::key(keys[k], down[k], t));
+                events++;
+            } else if (roll < 6) {
+                // Tap: down and up again before the frame ends
+                if (down[k]) continue;
+                pressesThisFrame[k]++;
+                taps++;
+                queue.push(InputEvent::key(keys[k], true, t));
+                queue.push(InputEvent::key(keys[k], false, t + 1000000));
+                events += 2;
+            } else {
+                double x = random.unit() * 800.0, y = random.unit() * 600.0;
+                queue.push(InputEvent::cursor(x, y, t));
+                events++;
+                if (!buttonDown) {
+                    clicksThisFrame++;
+                    clickX = x;
+                    clickY = y;
+                }
+                buttonDown = !buttonDown;
+                queue.push(InputEvent::mouseButton(0, buttonDown, t + 1000));
+                queue.push(InputEvent::cursor(random.unit() * 800.0, random.unit() * 600.0, t + 2000));
+                events += 2;
+            }
+        }
+
+        state.clearEdges();
+        state.drain(queue);
+
+        for (size_t k = 0; k < keyCount; k++) {
+            presses += pressesThisFrame[k];
+            queuedPresses += state.keyPresses(keys[k]);
+            if (static_cast<uint32_t>(state.keyPresses(keys[k])) != pressesThisFrame[k] || state.keyDown(keys[k]) != down[k]) {
+                mismatches++;
+            }
+            // What the old per-frame glfwGetKey poll with a latch would have seen
+            if (down[k] && !polledLatch[k]) polledPresses++;
+            polledLatch[k] = down[k];
+        }
+        clicks += clicksThisFrame;
+        queuedClicks += state.buttonPresses(0);
+        if (static_cast<uint32_t>(state.buttonPresses(0)) != clicksThisFrame || state.buttonDown(0) != buttonDown ||
+            (clicksThisFrame > 0 && (state.pressX(0) != clickX || state.pressY(0) != clickY))) {
+            mismatches++;
+        }
+        if (buttonDown && !polledButtonLatch) polledClicks++;
+        polledButtonLatch = buttonDown;
+    }
+
+    std::cout << "Synthetic input: " << frames << " frames at 60 Hz, " << events << " events ("
+              << taps << " taps released within their frame)" << std::endl;
+    std::cout << "  key presses:  " << presses << " sent, " << queuedPresses << " seen through the event queue, "
+              << polledPresses << " by polling once per frame" << std::endl;
+    std::cout << "  mouse clicks: " << clicks << " sent, " << queuedClicks << " seen through the event queue, "
+              << polledClicks << " by polling once per frame" << std::endl;
+
+    // Overflow drops (and counts) the newest events; a run of cursor moves takes one slot
+    InputQueue full;
+    for (size_t i = 0; i < InputQueue::CAPACITY + 44; i++) full.push(InputEvent::key(keys[0], (i & 1) == 0, 0));
+    bool overflowOk = full.size() == InputQueue::CAPACITY && full.dropped() == 44;
+    InputQueue moves;
+    for (int i = 0; i < 1000; i++) moves.push(InputEvent::cursor(i, i, i));
+    InputEvent last;
+    bool collapseOk = moves.size() == 1 && moves.pop(last) && last.x == 999.0;
+
+    // Cost of an event from callback to game state
+    const int iterations = 2000000;
+    int64_t start = Clock::nowNs();
+    for (int i = 0; i < iterations; i += 64) {
+        for (int j = 0; j < 64; j++) queue.push(InputEvent::key(keys[j % keyCount], (j & 2) == 0, j));
+        state.clearEdges();
+        state.drain(queue);
+    }
+    double ns = static_cast<double>(Clock::nowNs() - start) / iterations;
+    std::cout << "  queue: " << InputQueue::CAPACITY << " slots, push + drain " << std::fixed << std::setprecision(1)
+              << ns << " ns/event; overflow " << (overflowOk ? "counted" : "WRONG") << ", cursor moves "
+              << (collapseOk ? "collapsed" : "NOT collapsed") << std::endl;
+
+    bool ok = mismatches == 0 && queuedPresses == presses && queuedClicks == clicks && overflowOk && collapseOk;
+    std::cout << (ok ? "OK: every press and click reached the game" : "FAIL: input state differs from the event stream")
+              << std::endl;
+    return ok ? 0 : 1;
+}
+
+int particles(size_t count) {
+    const float frameSeconds = 1.0f / 60.0f;
+    const double budgetMs = 1000.0 / 60.0;
+    const int frames = 600;
+    Random random(40);
+    int failures = 0;
+
+    // Killing is swap-with-last: half the pool expiring must leave exactly the other half
+    {
+        ParticlePool pool(1000);
+        for (int i = 0; i < 1000; i++) pool.spawn(0.0f, 0.0f, 0.0f, 0.0f, (i & 1) ? 1.0f : 0.01f, 0xFFFFFFFFu);
+        pool.update(0.02f);
+        bool ok = pool.size() == 500;
+        for (int i = 0; i < 500; i++) ok = ok && pool.spawn(0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0);
+        ok = ok && !pool.spawn(0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0) && pool.size() == pool.capacity();
+        if (!ok) failures++;
+        std::cout << "Spawn/kill bookkeeping: " << (ok ? "OK" : "WRONG") << std::endl;
+    }
+
+    ParticlePool pool(count);
+    RenderSnapshot frame;
+    auto spawnOne = [&]() {
+        float angle = random.unit() * 6.2831853f, speed = 0.2f + random.unit();
+        return pool.spawn(random.unit() * 2.0f - 1.0f, random.unit() * 2.0f - 1.0f, speed * std::cos(angle),
+                          speed * std::sin(angle), 0.5f + 1.5f * random.unit(), 0xC0FFFFFFu ^ (random.next() & 0xFFFFFFu));
+    };
+
+    int64_t start = Clock::nowNs();
+    while (spawnOne()) {}
+    double spawnNs = static_cast<double>(Clock::nowNs() - start) / count;
+
+    // Warm the snapshot once; from here on nothing may reallocate
+    frame.captureParticles(pool);
+    const float* positions = frame.particlePositions.data();
+    const uint32_t* colors = frame.particleColors.data();
+
+    LatencyStats updateMs, captureMs;
+    uint64_t expired = 0;
+    for (int f = 0; f < frames; f++) {
+        int64_t t0 = Clock::nowNs();
+        pool.update(frameSeconds);
+        size_t live = pool.size();
+        while (spawnOne()) {}  // Top the pool back up, as a busy game would
+        expired += count - live;
+        int64_t t1 = Clock::nowNs();
+        frame.captureParticles(pool);
+        int64_t t2 = Clock::nowNs();
+        updateMs.record(Clock::nsToMs(t1 - t0));
+        captureMs.record(Clock::nsToMs(t2 - t1));
+    }
+    bool stable = frame.particlePositions.data() == positions && frame.particleColors.data() == colors &&
+                  pool.size() == count && frame.particleColors.size() == count;
+    if (!stable) failures++;
+
+    // The software rasteriser draws them all from one call (the GL canvas hands the arrays to the GPU)
+    SoftwareCanvas canvas(800, 600);
+    start = Clock::nowNs();
+    canvas.setBlending(true);
+    canvas.drawColoredPoints(frame.particlePositions.data(), frame.particleColors.data(), count, 3.6f);
+    double rasterMs = Clock::nsToMs(Clock::nowNs() - start);
+
+    double updateP99 = updateMs.percentile(99.0), captureP99 = captureMs.percentile(99.0);
+    std::cout << count << " live particles, " << frames << " frames at 60 Hz, " << expired << " expired and respawned"
+              << std::endl << std::fixed << std::setprecision(3);
+    std::cout << "  spawn " << std::setprecision(1) << spawnNs << " ns each" << std::endl << std::setprecision(3);
+    std::cout << "  update + respawn: mean " << updateMs.mean() << " ms, p99 " << updateP99 << " ms" << std::endl;
+    std::cout << "  capture for draw: mean " << captureMs.mean() << " ms, p99 " << captureP99 << " ms" << std::endl;
+    std::cout << "  software raster of all of them (800x600, one call): " << rasterMs << " ms" << std::endl;
+    std::cout << "  storage reused every frame: " << (stable ? "yes" : "NO") << std::endl;
+    std::cout << "  CPU side p99 " << updateP99 + captureP99 << " ms of a " << budgetMs << " ms frame: "
+              << (updateP99 + captureP99 <= budgetMs ? "within budget" : "OVER budget") << std::endl;
+
+    std::cout << (failures ? "FAIL: particle pool bookkeeping" : "OK: fixed pool, no reallocation") << std::endl;
+    return failures ? 1 : 0;
+}
+
+int allocations() {
+    if (!AllocTracker::enabled()) {
+        std::cout << "Allocation tracking not built in; rebuild with 'make ALLOC_TRACK=1'" << std::endl;
+        return 1;
+    }
+
+    std::vector<RenderScene> scenes;
+    SimulationConfig config;
+    config.seed = 1;
+    scenes.push_back({"classic", config, false});
+    scenes.push_back({"gameover", config, true});
+    config.versus = true;
+    scenes.push_back({"versus", config, false});
+    config.versus = false;
+    config.multiBallCount = 2000;
+    scenes.push_back({"party", config, false});
+    config.multiBallCount = 8;
+    config.brickCount = 2000;
+    scenes.push_back({"bricks", config, false});
+
+    const int warmUpFrames = 120, frames = 600;
+    const HudInfo hud = {true, 100.0};
+    int failures = 0;
+
+    // A whole frame's worth of work per iteration, as the game loop does it:
+    // input events, ticks, history, effects, snapshot capture and drawing
+    std::cout << "Heap allocations over " << frames << " steady-state frames after " << warmUpFrames << " warm-up frames"
+              << std::endl;
+    std::cout << std::setw(10) << "scene" << std::setw(8) << "input" << std::setw(8) << "tick" << std::setw(10)
+              << "history" << std::setw(10) << "capture" << std::setw(8) << "draw" << std::endl;
+    for (const RenderScene& scene : scenes) {
+        Simulation sim(scene.config);
+        setUpScene(sim, scene);
+        InputQueue queue;
+        InputState input;
+        SnapshotRing history(16);
+        ParticleEffects effects;
+        RenderSnapshot frame;
+        SoftwareCanvas canvas(320, 240);
+        SceneRenderer renderer;
+
+        uint64_t counts[5] = {0, 0, 0, 0, 0};
+        uint64_t tick = 0;
+        for (int f = 0; f < warmUpFrames + frames; f++) {
+            bool measured = f >= warmUpFrames;
+            {
+                AllocationScope scope;
+                queue.push(InputEvent::key(32, (f & 1) == 0, f));
+                queue.push(InputEvent::cursor(f, f, f));
+                input.clearEdges();
+                input.drain(queue);
+                if (measured) counts[0] += scope.allocations();
+            }
+            {
+                AllocationScope scope;
+                for (int t = 0; t < 2; t++) {
+                    TickInput in = benchTick(tick++);
+                    in.buttons = (tick % 600 == 0) ? BUTTON_SERVE : 0;
+                    sim.step(in);
+                }
+                if (measured) counts[1] += scope.allocations();
+            }
+            {
+                AllocationScope scope;
+                history.push(sim);
+                if (measured) counts[2] += scope.allocations();
+            }
+            {
+                AllocationScope scope;
+                effects.update(sim, 0, 1.0f / 60.0f);
+                frame.capture(sim, 0);
+                frame.captureParticles(effects.particles());
+                frame.hud = hud;
+                if (measured) counts[3] += scope.allocations();
+            }
+            {
+                AllocationScope scope;
+                renderer.draw(canvas, frame);
+                if (measured) counts[4] += scope.allocations();
+            }
+        }
+
+        std::cout << std::setw(10) << scene.name << std::setw(8) << counts[0] << std::setw(8) << counts[1]
+                  << std::setw(10) << counts[2] << std::setw(10) << counts[3] << std::setw(8) << counts[4] << std::endl;
+        for (uint64_t count : counts) {
+            if (count != 0) failures++;
+        }
+    }
+
+    std::cout << (failures ? "FAIL: steady-state frames allocate" : "OK: no heap allocation after warm-up") << std::endl;
+    return failures ? 1 : 0;
+}
+
+namespace {
+
+// Presents instantly but remembers what it drew, for the pause checks
+class CountingTarget : public RenderTarget {
+public:
+    CountingTarget() : presented(0), lastSequence(0) {}
+
+    void draw(const RenderSnapshot& frame) override { lastSequence.store(frame.sequence); }
+    void present() override {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1)); // Stand-in for a vsync wait
+        presented.fetch_add(1);
+    }
+
+    std::atomic<uint64_t> presented;
+    std::atomic<uint64_t> lastSequence;
+};
+
+} // namespace
+
+int idle() {
+    int failures = 0;
+    const IdleOptions options;
+    const int64_t frameNs = 1000000000 / 60;
+    const int graceFrames = static_cast<int>(options.graceSeconds * 60.0 + 0.5);
+
+    // Scripted 60 Hz session: activity, a drifting lid, then a still, quiet game
+    {
+        IdleGovernor governor(options);
+        int64_t now = 0;
+        int idleFrame = -1;
+        bool early = false;
+        for (int f = 0; f < 60; f++, now += frameNs) {
+            early |= governor.afterFrame(now, false, false, 90.0);
+        }
+        for (int f = 0; f < 120; f++, now += frameNs) {
+            early |= governor.afterFrame(now, true, false, 90.0 + 0.5 * f); // Lid still moving
+        }
+        for (int f = 0; f < 120 && idleFrame < 0; f++, now += frameNs) {
+            if (governor.afterFrame(now, true, false, 150.0)) idleFrame = f;
+        }
+        bool onTime = !early && idleFrame >= graceFrames - 1 && idleFrame <= graceFrames + 1;
+        if (!onTime) failures++;
+        std::cout << "Goes idle " << idleFrame << " frames into a still, quiet game (grace " << graceFrames
+                  << "): " << (onTime ? "OK" : "WRONG") << std::endl;
+
+        bool stays = true;
+        for (int w = 0; w < 20; w++) {
+            stays &= !governor.shouldWake(now += frameNs, false, 150.0 + options.wakeDegrees * 0.5);
+        }
+        bool inputWakes = governor.shouldWake(now += frameNs, true, 150.0) && !governor.isIdle();
+        for (int f = 0; f <= graceFrames + 1; f++, now += frameNs) {
+            governor.afterFrame(now, true, false, 150.0);
+        }
+        bool lidWakes = governor.isIdle() && governor.shouldWake(now += frameNs, false, 150.0 + options.wakeDegrees * 2.0) &&
+                        governor.stats().lidWakes == 1 && governor.stats().periods == 2;
+        if (!stays || !inputWakes || !lidWakes) failures++;
+        std::cout << "Timeouts and sensor noise keep it idle: " << (stays ? "OK" : "WRONG")
+                  << ", input wakes it: " << (inputWakes ? "OK" : "WRONG")
+                  << ", lid motion wakes it: " << (lidWakes ? "OK" : "WRONG") << std::endl;
+
+        IdleOptions disabled = options;
+        disabled.enabled = false;
+        IdleGovernor off(disabled);
+        bool never = true;
+        for (int f = 0; f < 600; f++) never &= !off.afterFrame(f * frameNs, true, false, 90.0);
+        if (!never) failures++;
+        std::cout << "Disabled never idles: " << (never ? "OK" : "WRONG") << std::endl;
+    }
+
+    // Render thread: the frame published right before the pause is shown, then nothing is presented
+    {
+        CountingTarget target;
+        RenderThread thread;
+        thread.start(target, true);
+        for (int i = 0; i < 5; i++) {
+            thread.publish();
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        thread.publish();
+        thread.setPaused(true);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        uint64_t shown = target.lastSequence.load();
+        uint64_t before = target.presented.load();
+        std::this_thread::sleep_for(std::chrono::milliseconds(250));
+        uint64_t during = target.presented.load() - before;
+
+        int64_t resumeStart = Clock::nowNs();
+        thread.setPaused(false);
+        uint64_t paused = target.presented.load();
+        while (target.presented.load() == paused && Clock::nowNs() - resumeStart < 1000000000) {
+            std::this_thread::yield();
+        }
+        double resumeMs = Clock::nsToMs(Clock::nowNs() - resumeStart);
+        thread.stop();
+
+        bool ok = shown == 6 && during == 0 && resumeMs < 20.0;
+        if (!ok) failures++;
+        std::cout << "Render thread paused: last frame shown " << (shown == 6 ? "yes" : "NO") << ", " << during
+                  << " presents in 250 ms, first present " << std::fixed << std::setprecision(2) << resumeMs
+                  << " ms after resuming: " << (ok ? "OK" : "WRONG") << std::endl;
+    }
+
+    // Input sampler: slow while idle, a fresh sample as soon as idling ends
+    LidSensor sensor;
+    if (!sensor.isAvailable()) {
+        std::cout << "Lid sensor not available; skipping the sampler check" << std::endl;
+    } else {
+        InputSampler sampler(sensor, 500.0);
+        sampler.setIdleSampling(options.sampleRateHz, options.wakeDegrees, nullptr);
+        sampler.start();
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        uint64_t count = sampler.samplesTaken();
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        double activeHz = (sampler.samplesTaken() - count) / 0.5;
+
+        sampler.setIdle(true);
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        count = sampler.samplesTaken();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+        double idleHz = static_cast<double>(sampler.samplesTaken() - count);
+
+        count = sampler.samplesTaken();
+        int64_t wakeStart = Clock::nowNs();
+        sampler.setIdle(false);
+        while (sampler.samplesTaken() == count && Clock::nowNs() - wakeStart < 1000000000) {
+            std::this_thread::yield();
+        }
+        double wakeMs = Clock::nsToMs(Clock::nowNs() - wakeStart);
+        sampler.stop();
+
+        bool ok = idleHz <= options.sampleRateHz * 1.5 + 1.0 && wakeMs < 20.0;
+        if (!ok) failures++;
+        std::cout << "Sampler: " << std::setprecision(0) << activeHz << " Hz playing, " << idleHz << " Hz idle, "
+                  << std::setprecision(2) << "next sample " << wakeMs << " ms after idling ends: "
+                  << (ok ? "OK" : "WRONG") << std::endl;
+    }
+
+    std::cout << (failures ? "FAIL: idle mode" : "OK: idle mode sleeps and wakes on time") << std::endl;
+    return failures ? 1 : 0;
+}
+
+int audio() {
+    int failures = 0;
+    std::cout << std::fixed;
+
+    // Lock-free queue: a producer thread against a consumer, nothing lost or reordered
+    {
+        const uint64_t count = 2000000;
+        SpscQueue<uint64_t, 1024> queue;
+        int64_t start = Clock::nowNs();
+        std::thread producer([&queue, count] {
+            for (uint64_t i = 0; i < count; i++) {
+                while (!queue.push(i)) std::this_thread::yield();
+            }
+        });
+        uint64_t expected = 0;
+        bool inOrder = true;
+        while (expected < count) {
+            uint64_t value;
+            if (!queue.pop(value)) {
+                std::this_thread::yield();
+                continue;
+            }
+            inOrder &= value == expected++;
+        }
+        producer.join();
+        double ms = Clock::nsToMs(Clock::nowNs() - start);
+        if (!inOrder) failures++;
+        std::cout << "Queue: " << count << " items across threads in " << std::setprecision(1) << ms << " ms ("
+                  << std::setprecision(0) << count / ms * 1000.0 << " per second): " << (inOrder ? "OK" : "WRONG")
+                  << std::endl;
+    }
+
+    const SoundBank bank(AUDIO_SAMPLE_RATE);
+    const size_t frames = 256;
+    const double bufferMs = frames * 1000.0 / AUDIO_SAMPLE_RATE;
+    std::vector<float> out(frames * 2);
+
+    // One centred voice comes out sample for sample, then frees its voice
+    {
+        AudioMixer mixer(bank);
+        const std::vector<float>& hit = bank.samples(Sound::PaddleHit);
+        mixer.post(Sound::PaddleHit, 1.0f, 0.0f);
+        const float centre = std::cos(6.28318531f / 8.0f);
+        bool exact = true;
+        for (size_t offset = 0; offset < hit.size() + frames; offset += frames) {
+            mixer.mix(out.data(), frames, Clock::nowNs());
+            for (size_t i = 0; i < frames; i++) {
+                float expected = offset + i < hit.size() ? hit[offset + i] * centre : 0.0f;
+                exact &= out[2 * i] == expected && out[2 * i + 1] == out[2 * i];
+            }
+        }
+        bool freed = mixer.activeVoices() == 0;
+
+        // More sounds than voices cut the shortest-lived short; more than the queue holds are dropped
+        for (size_t i = 0; i < AudioMixer::MAX_VOICES + 8; i++) mixer.post(Sound::Miss, 0.5f, 0.0f);
+        mixer.mix(out.data(), frames, Clock::nowNs());
+        bool stolen = mixer.voicesStolen() == 8 && mixer.activeVoices() == AudioMixer::MAX_VOICES;
+        size_t accepted = 0;
+        for (size_t i = 0; i < AudioMixer::QUEUE_CAPACITY + 44; i++) accepted += mixer.post(Sound::WallBounce, 0.5f, 0.0f);
+        bool dropped = accepted == AudioMixer::QUEUE_CAPACITY && mixer.commandsDropped() == 44;
+        bool clipped = true;
+        mixer.mix(out.data(), frames, Clock::nowNs());
+        for (float sample : out) clipped &= sample >= -1.0f && sample <= 1.0f;
+
+        bool ok = exact && freed && stolen && dropped && clipped;
+        if (!ok) failures++;
+        std::cout << "Mixer: single voice exact " << (exact && freed ? "OK" : "WRONG") << ", voice stealing "
+                  << (stolen ? "OK" : "WRONG") << ", full queue drops " << (dropped ? "OK" : "WRONG")
+                  << ", output in range " << (clipped ? "OK" : "WRONG") << std::endl;
+    }
+
+    // Worst case cost: every voice busy in every buffer
+    {
+        AudioMixer mixer(bank);
+        AllocationScope allocations;
+        for (int b = 0; b < 20000; b++) {
+            while (mixer.activeVoices() < AudioMixer::MAX_VOICES) {
+                for (size_t v = mixer.activeVoices(); v < AudioMixer::MAX_VOICES; v++) {
+                    mixer.post(Sound::Miss, 0.1f, (v % 5) * 0.5f - 1.0f);
+                }
+                mixer.mix(out.data(), 0, Clock::nowNs());
+            }
+            mixer.mix(out.data(), frames, Clock::nowNs());
+        }
+        const LatencyStats& cost = mixer.mixCost();
+        double p99 = cost.percentile(99.0);
+        bool ok = p99 < bufferMs * 0.1 && (!AllocTracker::enabled() || allocations.allocations() == 0);
+        if (!ok) failures++;
+        std::cout << "Mix cost, " << AudioMixer::MAX_VOICES << " voices x " << frames << " frames: p50="
+                  << std::setprecision(2) << cost.percentile(50.0) * 1000.0 << " p99=" << p99 * 1000.0
+                  << " us per buffer (" << std::setprecision(3) << p99 / bufferMs * 100.0 << "% of its "
+                  << std::setprecision(2) << bufferMs << " ms)";
+        if (AllocTracker::enabled()) {
+            std::cout << ", " << allocations.allocations() << " allocations";
+        }
+        std::cout << ": " << (ok ? "OK" : "TOO SLOW") << std::endl;
+    }
+
+    // Post to output through a paced backend, posts landing anywhere in a buffer period
+    {
+        AudioMixer mixer(bank);
+        NullAudioBackend backend(AUDIO_SAMPLE_RATE, frames);
+        std::string error;
+        if (!backend.start(mixer, error)) {
+            std::cout << "Null backend failed: " << error << std::endl;
+            return 1;
+        }
+        Random random(44);
+        for (int i = 0; i < 300; i++) {
+            mixer.post(Sound::PaddleHit, 0.5f, 0.0f);
+            std::this_thread::sleep_for(std::chrono::microseconds(2000 + random.next() % 5000));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(static_cast<int>(bufferMs * 2.0) + 1)); // Last one mixed
+        backend.stop();
+        const LatencyStats& latency = mixer.commandLatency();
+        bool ok = latency.totalCount() == 300 && latency.percentile(50.0) <= 2.0 * bufferMs;
+        if (!ok) failures++;
+        std::cout << "Null output (" << std::setprecision(2) << bufferMs << " ms buffers): " << mixer.buffersMixed()
+                  << " buffers, post to output p50=" << latency.percentile(50.0) << " p99=" << latency.percentile(99.0)
+                  << " max=" << latency.max() << " ms: " << (ok ? "OK" : "WRONG") << std::endl;
+    }
+
+    // WAV output: a valid file holding every frame mixed, with the sound in it
+    {
+        char path[] = "/tmp/lidpong-audio-XXXXXX.wav";
+        int fd = mkstemps(path, 4);
+        if (fd < 0) {
+            std::cout << "Can't create a temporary file" << std::endl;
+            return 1;
+        }
+        ::close(fd);
+        AudioMixer mixer(bank);
+        uint64_t framesWritten = 0;
+        std::string error;
+        {
+            WavAudioBackend backend(path, AUDIO_SAMPLE_RATE, frames);
+            bool started = backend.start(mixer, error);
+            mixer.post(Sound::Miss, 1.0f, -1.0f);
+            std::this_thread::sleep_for(std::chrono::milliseconds(300));
+            backend.stop();
+            framesWritten = started ? backend.framesWritten() : 0;
+        }
+        std::ifstream file(path, std::ios::binary);
+        std::vector<char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        std::remove(path);
+
+        uint32_t dataBytes = 0;
+        int peakLeft = 0, peakRight = 0;
+        if (bytes.size() >= 44) {
+            std::memcpy(&dataBytes, bytes.data() + 40, 4);
+            for (size_t i = 44; i + 4 <= bytes.size(); i += 4) {
+                int16_t left, right;
+                std::memcpy(&left, bytes.data() + i, 2);
+                std::memcpy(&right, bytes.data() + i + 2, 2);
+                peakLeft = std::max(peakLeft, std::abs(static_cast<int>(left)));
+                peakRight = std::max(peakRight, std::abs(static_cast<int>(right)));
+            }
+        }
+        bool ok = framesWritten == mixer.buffersMixed() * frames && framesWritten > 0 &&
+                  bytes.size() == 44 + framesWritten * 4 && dataBytes == framesWritten * 4 && std::memcmp(bytes.data(), "RIFF", 4) == 0 &&
+                  peakLeft > 8000 && peakRight == 0;
+        if (!ok) failures++;
+        std::cout << "WAV output: " << framesWritten << " frames, header " << (dataBytes == framesWritten * 4 ? "matches" : "WRONG")
+                  << ", hard-left sound peaks at " << peakLeft << " / " << peakRight << ": " << (ok ? "OK" : "WRONG") << std::endl;
+    }
+
+    std::cout << (failures ? "FAIL: audio" : "OK: audio mixes in place, within budget and on time") << std::endl;
+    return failures ? 1 : 0;
+}
+
+namespace {
+    // Synthetic lid traces with the gestures they contain
+    struct ExpectedGesture {
+        LidGesture gesture;
+        int64_t fromNs, toNs; // Window the event must land in
+        bool matched;
+    };
+
+    struct GestureTrace {
+        std::vector<int64_t> timestampNs;
+        std::vector<double> angle;
+        std::vector<ExpectedGesture> expected;
+    };
+
+    struct TraceSettings {
+        double rateHz;
+        double jitter;       // Fraction of the sample period
+        double noiseDegrees; // Uniform, before quantising
+        bool wholeDegrees;   // The sensor reports integer angles
+    };
+
+    class TraceBuilder {
+    public:
+        TraceBuilder(const TraceSettings& settings, const GestureOptions& gestures, uint64_t seed)
+            : m_settings(settings), m_gestures(gestures), m_random(seed), m_nowNs(0), m_base(90.0), m_lastHold(90.0) {}
+
+        // 'shape' gives the angle relative to the segment's start for u in [0, 1]
+        template<class Shape>
+        void segment(double seconds, const Shape& shape) {
+            int64_t startNs = m_nowNs;
+            int64_t endNs = startNs + static_cast<int64_t>(seconds * 1.0e9);
+            double base = m_base;
+            while (m_nowNs < endNs) {
+                double u = static_cast<double>(m_nowNs - startNs) / (endNs - startNs);
+                sample(base + shape(u));
+            }
+            m_base = base + shape(1.0);
+        }
+
+        void rest(double seconds) {
+            segment(seconds, [](double) { return 0.0; });
+        }
+
+        // Rest long enough for any hold, expecting one if the lid settled somewhere new
+        void settle() {
+            int64_t settledNs = m_nowNs;
+            rest(m_gestures.holdSeconds + 0.5 + m_random.unit());
+            double moved = std::fabs(m_base - m_lastHold);
+            if (moved >= m_gestures.holdMoveDegrees + 1.0) {
+                expect(LidGesture::Hold, settledNs + static_cast<int64_t>((m_gestures.holdSeconds - 0.2) * 1.0e9),
+                       settledNs + static_cast<int64_t>((m_gestures.holdSeconds + 0.4) * 1.0e9));
+                m_lastHold = m_base;
+            } else if (moved > m_gestures.holdMoveDegrees - 1.0) {
+                m_lastHold = m_base; // Too close to the threshold to call; build() avoids this
+            }
+        }
+
+        void expect(LidGesture gesture, int64_t fromNs, int64_t toNs) {
+            m_trace.expected.push_back({gesture, fromNs, toNs, false});
+        }
+
+        void build(size_t segments) {
+            const double PI = 3.14159265358979;
+            rest(1.0);
+            for (size_t s = 0; s < segments; s++) {
+                int64_t startNs = m_nowNs;
+                double sign = m_random.coin() ? 1.0 : -1.0;
+                switch (m_random.next() % 5) {
+                case 0: { // Flick
+                    double size = sign * (13.0 + 12.0 * m_random.unit());
+                    double seconds = 0.15 + 0.25 * m_random.unit();
+                    segment(seconds, [size, PI](double u) { return size * std::sin(PI * u); });
+                    expect(LidGesture::Flick, startNs, m_nowNs + 200000000);
+                    break;
+                }
+                case 1: { // Double nudge
+                    for (int n = 0; n < 2; n++) {
+                        double size = sign * (3.0 + 3.0 * m_random.unit());
+                        segment(0.12 + 0.15 * m_random.unit(), [size, PI](double u) { return size * std::sin(PI * u); });
+                        if (n == 0) rest(0.05 + 0.25 * m_random.unit());
+                    }
+                    expect(LidGesture::DoubleNudge, startNs, m_nowNs + 200000000);
+                    break;
+                }
+                case 2: { // Move somewhere else and keep the lid there
+                    double target = 30.0 + 120.0 * m_random.unit();
+                    while (std::fabs(target - m_lastHold) < m_gestures.holdMoveDegrees + 3.0) target = 30.0 + 120.0 * m_random.unit();
+                    double delta = target - m_base;
+                    segment(0.3 + 0.5 * m_random.unit(), [delta](double u) { return delta * u * u * (3.0 - 2.0 * u); });
+                    break;
+                }
+                case 3: { // Playing: slow swings that end where they began
+                    double size = 10.0 + 20.0 * m_random.unit();
+                    double cycles = 1.0 + (m_random.next() % 3);
+                    double seconds = cycles / (0.25 + 0.35 * m_random.unit());
+                    segment(seconds, [size, cycles, PI](double u) { return size * std::sin(2.0 * PI * cycles * u); });
+                    break;
+                }
+                default: { // A single nudge, then nothing
+                    double size = sign * (3.0 + 3.0 * m_random.unit());
+                    segment(0.12 + 0.15 * m_random.unit(), [size, PI](double u) { return size * std::sin(PI * u); });
+                    break;
+                }
+                }
+                settle();
+            }
+        }
+
+        GestureTrace& trace() { return m_trace; }
+
+    private:
+        void sample(double angle) {
+            angle += (m_random.unit() * 2.0 - 1.0) * m_settings.noiseDegrees;
+            if (m_settings.wholeDegrees) angle = std::floor(angle + 0.5);
+            m_trace.timestampNs.push_back(m_nowNs);
+            m_trace.angle.push_back(angle);
+            double period = 1.0 / m_settings.rateHz;
+            m_nowNs += static_cast<int64_t>(period * (1.0 + (m_random.unit() * 2.0 - 1.0) * m_settings.jitter) * 1.0e9);
+        }
+
+        TraceSettings m_settings;
+        GestureOptions m_gestures;
+        Random m_random;
+        GestureTrace m_trace;
+        int64_t m_nowNs;
+        double m_base;
+        double m_lastHold;
+    };
+}
+
+int gestures(const std::string& recordingFile) {
+    int failures = 0;
+    const GestureOptions options;
+    std::cout << std::fixed;
+
+    struct Scenario {
+        const char* name;
+        TraceSettings settings;
+        bool mustPass;
+    };
+    const Scenario scenarios[] = {
+        {"500 Hz, clean", {500.0, 0.0, 0.0, false}, true},
+        {"500 Hz, sensor-like", {500.0, 0.2, 0.3, true}, true},
+        {"60 Hz, sensor-like", {60.0, 0.2, 0.3, true}, true},
+        {"20 Hz (idle rate)", {20.0, 0.2, 0.3, true}, false},
+    };
+    for (const Scenario& scenario : scenarios) {
+        TraceBuilder builder(scenario.settings, options, 45);
+        builder.build(600);
+        GestureTrace& trace = builder.trace();
+
+        size_t expectedCount[3] = {0, 0, 0}, found[3] = {0, 0, 0};
+        size_t falsePositives = 0;
+        LidGestureRecognizer recognizer(options, [&trace, &found, &falsePositives](const LidGestureEvent& event) {
+            for (ExpectedGesture& expected : trace.expected) {
+                if (!expected.matched && expected.gesture == event.gesture && event.timestampNs >= expected.fromNs &&
+                    event.timestampNs <= expected.toNs) {
+                    expected.matched = true;
+                    found[static_cast<int>(event.gesture)]++;
+                    return;
+                }
+            }
+            falsePositives++;
+        });
+        for (const ExpectedGesture& expected : trace.expected) expectedCount[static_cast<int>(expected.gesture)]++;
+        for (size_t i = 0; i < trace.angle.size(); i++) {
+            recognizer.addSample(trace.timestampNs[i], trace.angle[i]);
+        }
+
+        size_t totalExpected = trace.expected.size();
+        size_t totalFound = found[0] + found[1] + found[2];
+        double recall = totalExpected ? 100.0 * totalFound / totalExpected : 100.0;
+        double falseRate = 100.0 * falsePositives / std::max<size_t>(1, recognizer.events());
+        bool ok = recall >= 95.0 && falseRate <= 3.0;
+        if (scenario.mustPass && !ok) failures++;
+        std::cout << scenario.name << ": " << std::setprecision(1) << trace.timestampNs.back() / 6.0e10 << " min, flicks "
+                  << found[0] << "/" << expectedCount[0] << ", double nudges " << found[1] << "/" << expectedCount[1]
+                  << ", holds " << found[2] << "/" << expectedCount[2] << " (" << recall << "%), " << falsePositives
+                  << " false: " << (ok ? "OK" : (scenario.mustPass ? "WRONG" : "poor, as expected")) << std::endl;
+    }
+
+    // Throughput: one long sensor-rate trace, replayed until it adds up to millions of samples
+    {
+        TraceBuilder builder({500.0, 0.2, 0.3, true}, options, 46);
+        builder.build(200);
+        const GestureTrace& trace = builder.trace();
+        uint64_t events = 0;
+        LidGestureRecognizer recognizer(options, [&events](const LidGestureEvent&) { events++; });
+        const int passes = 20;
+        int64_t start = Clock::nowNs();
+        for (int pass = 0; pass < passes; pass++) {
+            int64_t offset = pass * (trace.timestampNs.back() + 1000000);
+            for (size_t i = 0; i < trace.angle.size(); i++) {
+                recognizer.addSample(trace.timestampNs[i] + offset, trace.angle[i]);
+            }
+        }
+        double seconds = (Clock::nowNs() - start) / 1.0e9;
+        std::cout << "Throughput: " << recognizer.samples() << " samples in " << std::setprecision(1)
+                  << seconds * 1000.0 << " ms = " << std::setprecision(1) << recognizer.samples() / seconds / 1.0e6
+                  << " M samples/s (" << std::setprecision(1) << seconds * 1.0e9 / recognizer.samples()
+                  << " ns each, " << events << " events)" << std::endl;
+    }
+
+    // A recorded session: ordinary play should trigger (almost) nothing
+    if (!recordingFile.empty()) {
+        InputRecording recording;
+        std::string error;
+        if (!recording.load(recordingFile, error)) {
+            std::cout << "Failed to load recording: " << error << std::endl;
+            return 1;
+        }
+        size_t counts[3] = {0, 0, 0};
+        LidGestureRecognizer recognizer(options, [&counts](const LidGestureEvent& event) {
+            counts[static_cast<int>(event.gesture)]++;
+        });
+        InputRecording::Reader reader(recording);
+        TickInput input;
+        bool frameStart;
+        double seconds = 0.0;
+        int64_t start = Clock::nowNs();
+        while (reader.next(input, frameStart)) {
+            seconds += input.deltaTime;
+            recognizer.addSample(static_cast<int64_t>(seconds * 1.0e9), input.lidPosition * 180.0); // Slider back to degrees
+        }
+        double elapsedMs = Clock::nsToMs(Clock::nowNs() - start);
+        std::cout << recordingFile << ": " << std::setprecision(1) << seconds << " s of play, " << recognizer.samples()
+                  << " ticks in " << std::setprecision(2) << elapsedMs << " ms: " << counts[0] << " flicks, " << counts[1]
+                  << " double nudges, " << counts[2] << " holds" << std::endl;
+    }
+
+    std::cout << (failures ? "FAIL: lid gestures" : "OK: lid gestures recognised at sensor and frame rates") << std::endl;
+    return failures ? 1 : 0;
+}
+
+namespace {
+    // What the store must return, worked out the slow way
+    struct SavedScore {
+        int32_t score;
+        int64_t timestampMs;
+        uint64_t order; // Append order, the same as log order
+        uint64_t player;
+        ScoreMode mode;
+    };
+
+    std::vector<SavedScore> bruteForceTop(const std::vector<SavedScore>& saved, ScoreMode mode, const uint64_t* player,
+                                          size_t count) {
+        std::vector<SavedScore> matches;
+        for (const SavedScore& s : saved) {
+            if ((mode == ScoreMode::Any || s.mode == mode) && (!player || s.player == *player)) matches.push_back(s);
+        }
+        size_t n = std::min(count, matches.size());
+        std::partial_sort(matches.begin(), matches.begin() + n, matches.end(), [](const SavedScore& a, const SavedScore& b) {
+            if (a.score != b.score) return a.score > b.score;
+            if (a.timestampMs != b.timestampMs) return a.timestampMs < b.timestampMs;
+            return a.order < b.order;
+        });
+        matches.resize(n);
+        return matches;
+    }
+
+    bool sameRanking(const std::vector<ScoreEntry>& got, const std::vector<SavedScore>& expected) {
+        if (got.size() != expected.size()) return false;
+        for (size_t i = 0; i < got.size(); i++) {
+            if (got[i].score != expected[i].score || got[i].timestampMs != expected[i].timestampMs ||
+                got[i].player != expected[i].player || got[i].mode != expected[i].mode) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    ScoreRecord benchRecord(Random& rng, uint64_t index, std::string& player) {
+        ScoreRecord record;
+        record.timestampMs = 1700000000000LL + static_cast<int64_t>(index) * 1000 + rng.next() % 1000;
+        record.score = static_cast<int32_t>(rng.next() % 100000);
+        record.totalHits = static_cast<int32_t>(rng.next() % 5000);
+        record.seed = rng.next();
+        record.ticks = rng.next() % 100000;
+        record.mode = static_cast<ScoreMode>(rng.next() % 4);
+        record.player = player = "player" + std::to_string(rng.next() % 64);
+        return record;
+    }
+}
+
+int scores(size_t count) {
+    int failures = 0;
+    char directoryTemplate[] = "/tmp/lidpong-scores-XXXXXX";
+    if (!mkdtemp(directoryTemplate)) {
+        std::cout << "Can't create a temporary directory" << std::endl;
+        return 1;
+    }
+    const std::string directory = directoryTemplate;
+    std::vector<SavedScore> saved;
+    saved.reserve(count + 1000);
+    Random rng(43);
+    std::string error;
+    std::cout << std::fixed;
+
+    // Bulk load without fsync, then fold everything into the index on close
+    {
+        ScoreStoreOptions options;
+        options.syncEachAppend = false;
+        ScoreStore store(options);
+        if (!store.open(directory, error)) {
+            std::cout << "Open failed: " << error << std::endl;
+            return 1;
+        }
+        std::vector<uint8_t> replay;
+        std::string player;
+        int64_t start = Clock::nowNs();
+        for (size_t i = 0; i < count; i++) {
+            ScoreRecord record = benchRecord(rng, i, player);
+            replay.assign(i % 1000 == 0 ? 1024 : 0, static_cast<uint8_t>(i));
+            if (!store.append(record, replay, error)) {
+                std::cout << "Append failed: " << error << std::endl;
+                return 1;
+            }
+            saved.push_back({record.score, record.timestampMs, saved.size(), ScoreStore::playerHash(player), record.mode});
+        }
+        double appendMs = Clock::nsToMs(Clock::nowNs() - start);
+        start = Clock::nowNs();
+        store.close();
+        double closeMs = Clock::nsToMs(Clock::nowNs() - start);
+        std::cout << "Appended " << count << " games in " << std::setprecision(0) << appendMs << " ms ("
+                  << count / (appendMs / 1000.0) << " per second, index rewritten every " << options.foldTailAt
+                  << "), final index write " << std::setprecision(1) << closeMs << " ms" << std::endl;
+    }
+
+    // Reopen: maps the index, reads no records
+    ScoreStore store;
+    int64_t start = Clock::nowNs();
+    if (!store.open(directory, error)) {
+        std::cout << "Reopen failed: " << error << std::endl;
+        return 1;
+    }
+    double openMs = Clock::nsToMs(Clock::nowNs() - start);
+    bool complete = store.size() == count && store.unindexed() == 0;
+    if (!complete) failures++;
+    std::cout << "Reopened " << store.size() << " games in " << std::setprecision(2) << openMs << " ms: "
+              << (complete ? "OK" : "WRONG") << std::endl;
+
+    // Queries against brute force, before and after a tail builds up outside the index
+    const uint64_t player = ScoreStore::playerHash("player7");
+    for (int pass = 0; pass < 2; pass++) {
+        if (pass == 1) {
+            std::string name;
+            for (size_t i = 0; i < 500; i++) {
+                ScoreRecord record = benchRecord(rng, count + i, name);
+                record.score += 50000; // Many of these make the top ten
+                if (!store.append(record, std::vector<uint8_t>(), error)) {
+                    std::cout << "Append failed: " << error << std::endl;
+                    return 1;
+                }
+                saved.push_back({record.score, record.timestampMs, saved.size(), ScoreStore::playerHash(name), record.mode});
+            }
+        }
+        const int runs = 100;
+        bool match = true;
+        start = Clock::nowNs();
+        for (int r = 0; r < runs; r++) {
+            match &= store.top(ScoreMode::Any, 10).size() == 10;
+        }
+        double topUs = Clock::nsToMs(Clock::nowNs() - start) * 1000.0 / runs;
+        start = Clock::nowNs();
+        for (int r = 0; r < runs; r++) {
+            match &= !store.topForPlayer("player7", ScoreMode::Bricks, 10).empty();
+        }
+        double playerUs = Clock::nsToMs(Clock::nowNs() - start) * 1000.0 / runs;
+
+        match &= sameRanking(store.top(ScoreMode::Any, 10), bruteForceTop(saved, ScoreMode::Any, nullptr, 10));
+        match &= sameRanking(store.top(ScoreMode::Party, 25), bruteForceTop(saved, ScoreMode::Party, nullptr, 25));
+        match &= sameRanking(store.topForPlayer("player7", ScoreMode::Bricks, 10),
+                             bruteForceTop(saved, ScoreMode::Bricks, &player, 10));
+        if (!match) failures++;
+        std::cout << (pass == 0 ? "Indexed: " : "With 500 in the tail: ") << "top 10 in " << std::setprecision(1) << topUs
+                  << " us, one player's top 10 in " << playerUs << " us, rankings "
+                  << (match ? "match brute force: OK" : "DIFFER: WRONG") << std::endl;
+    }
+
+    // Full record and replay read back through an entry
+    {
+        ScoreRecord record;
+        std::vector<uint8_t> replay;
+        std::vector<ScoreEntry> withReplay;
+        for (const ScoreEntry& entry : store.top(ScoreMode::Any, 5000)) {
+            if (entry.hasReplay) withReplay.push_back(entry);
+        }
+        bool ok = !withReplay.empty() && store.read(withReplay[0], record, &replay, error) && replay.size() == 1024 &&
+                  record.score == withReplay[0].score && ScoreStore::playerHash(record.player) == withReplay[0].player;
+        if (!ok) failures++;
+        std::cout << "Record and replay read back: " << (ok ? "OK" : "WRONG") << std::endl;
+    }
+    store.close();
+
+    // A crash mid-append leaves a torn record; reopening cuts it off and keeps the rest
+    {
+        const std::string logPath = directory + "/scores.log";
+        std::ofstream log(logPath, std::ios::binary | std::ios::app);
+        log.write("LPSR\x40\x00\x00\x00garbage", 15);
+        log.close();
+        ScoreStore reopened;
+        bool ok = reopened.open(directory, error) && reopened.size() == saved.size() && reopened.recoveredBytes() == 15;
+        std::string name;
+        ok = ok && reopened.append(benchRecord(rng, saved.size(), name), std::vector<uint8_t>(), error) &&
+             reopened.size() == saved.size() + 1;
+        reopened.close();
+        ScoreStore again;
+        ok = ok && again.open(directory, error) && again.size() == saved.size() + 1 && again.recoveredBytes() == 0;
+        if (!ok) failures++;
+        std::cout << "Torn record recovered (" << saved.size() << " games kept): " << (ok ? "OK" : "WRONG") << std::endl;
+    }
+
+    // The frame thread's side of a save: submit() never waits for the fsync
+    {
+        ScoreStore synced;
+        ScoreWriter writer(synced);
+        bool ok = synced.open(directory, error);
+        writer.start();
+        std::vector<uint8_t> replay(4096, 1);
+        std::string name;
+        int64_t worstNs = 0;
+        const int games = 200;
+        for (int i = 0; i < games && ok; i++) {
+            ScoreRecord record = benchRecord(rng, saved.size() + 1 + i, name);
+            std::vector<uint8_t> bytes(replay);
+            int64_t before = Clock::nowNs();
+            writer.submit(record, std::move(bytes));
+            worstNs = std::max(worstNs, Clock::nowNs() - before);
+        }
+        start = Clock::nowNs();
+        writer.stop();
+        double drainMs = Clock::nsToMs(Clock::nowNs() - start);
+        ok = ok && writer.written() == games && writer.failed() == 0 && synced.size() == saved.size() + 1 + games;
+        synced.close();
+        if (!ok) failures++;
+        std::cout << "Writer: " << games << " fsynced saves, slowest submit " << std::setprecision(1)
+                  << worstNs / 1000.0 << " us, queue drained " << drainMs << " ms after the last: " << (ok ? "OK" : "WRONG")
+                  << std::endl;
+    }
+
+    // A flipped byte mid-log: read() refuses that record, and a rescan skips
+    // it alone, keeping every game after it and the file's length
+    {
+        const std::string logPath = directory + "/scores.log";
+        ScoreStore indexed;
+        bool ok = indexed.open(directory, error);
+        std::vector<ScoreEntry> best = indexed.top(ScoreMode::Any, 1);
+        size_t total = indexed.size();
+        ok = ok && !best.empty();
+        indexed.close();
+        struct stat before;
+        ok = ok && stat(logPath.c_str(), &before) == 0;
+        if (ok) {
+            std::fstream log(logPath, std::ios::binary | std::ios::in | std::ios::out);
+            log.seekg(static_cast<std::streamoff>(best[0].logOffset + 24)); // Past the 16-byte header, into the score
+            char byte = 0;
+            log.read(&byte, 1);
+            byte ^= 0x40;
+            log.seekp(static_cast<std::streamoff>(best[0].logOffset + 24));
+            log.write(&byte, 1);
+            ok = static_cast<bool>(log);
+        }
+        ScoreStore damaged;
+        ScoreRecord record;
+        ok = ok && damaged.open(directory, error) && !damaged.read(best[0], record, nullptr, error);
+        damaged.close();
+        std::remove((directory + "/scores.idx").c_str()); // Force a scan of the whole log
+        ScoreStore rescanned;
+        struct stat after;
+        ok = ok && rescanned.open(directory, error) && rescanned.size() == total - 1 &&
+             rescanned.corruptBytes() > 0 && rescanned.recoveredBytes() == 0 &&
+             stat(logPath.c_str(), &after) == 0 && after.st_size == before.st_size;
+        rescanned.close();
+        if (!ok) failures++;
+        std::cout << "Damaged record mid-log skipped, the rest kept: " << (ok ? "OK" : "WRONG") << std::endl;
+    }
+
+    std::remove((directory + "/scores.log").c_str());
+    std::remove((directory + "/scores.idx").c_str());
+    rmdir(directory.c_str());
+
+    std::cout << (failures ? "FAIL: score store" : "OK: score store ranks, recovers and saves off the frame thread")
+              << std::endl;
+    return failures ? 1 : 0;
+}
+
+namespace {
+    // What a synthetic trace was made with, for checking the analysis
+    struct MadeTrace {
+        uint64_t samples, failedReads, failureRuns, gaps, idleSamples;
+    };
+
+    // Roughly normal, unit variance
+    double benchGaussian(Random& rng) {
+        return (rng.unit() + rng.unit() + rng.unit() + rng.unit() - 2.0) * std::sqrt(3.0);
+    }
+
+    // A lid session sampled at rateHz with scheduling jitter: mostly still
+    // with sensor noise, with smooth moves, bursts of failed reads, stalls
+    // past the gap threshold and idle spells at 10 Hz
+    MadeTrace writeSyntheticTrace(const std::string& path, uint64_t records, double rateHz, double noiseDegrees, uint64_t seed) {
+        MadeTrace made = {records, 0, 0, 0, 0};
+        AngleTraceWriter writer;
+        std::string error;
+        if (!writer.open(path, rateHz, error)) {
+            std::cout << "Can't write " << error << std::endl;
+            return MadeTrace{0, 0, 0, 0, 0};
+        }
+        Random rng(seed);
+        const int64_t periodNs = static_cast<int64_t>(1.0e9 / rateHz);
+        int64_t ns = 1000000000;
+        double from = 90.0, to = 90.0, moveSeconds = 0.0, moveAt = 0.0;
+        double lastGood = 90.0;
+        uint64_t failing = 0, idling = 0;
+        bool previousIdle = false, previousGood = true;
+        for (uint64_t i = 0; i < records; i++) {
+            if (i > 0) {
+                int64_t interval = periodNs + static_cast<int64_t>((rng.unit() - 0.5) * 0.1 * periodNs);
+                if (rng.next() % 5000 == 0) {
+                    interval = 10000000 + rng.next() % 40000000; // Stall
+                }
+                if (previousIdle) {
+                    interval = 100000000;
+                } else if (interval > 4 * periodNs) {
+                    made.gaps++;
+                }
+                ns += interval;
+            }
+
+            double seconds = ns / 1.0e9;
+            if (moveSeconds == 0.0 && rng.next() % 2000 == 0) {
+                from = to;
+                to = 20.0 + rng.unit() * 140.0;
+                moveAt = seconds;
+                moveSeconds = 0.3 + rng.unit() * 0.7;
+            }
+            double angle = to;
+            if (moveSeconds > 0.0) {
+                double phase = (seconds - moveAt) / moveSeconds;
+                if (phase >= 1.0) {
+                    moveSeconds = 0.0;
+                } else {
+                    angle = from + (to - from) * 0.5 * (1.0 - std::cos(3.14159265358979 * phase));
+                }
+            }
+            angle += noiseDegrees * benchGaussian(rng);
+
+            // A burst starts only after a good read, so every burst is its own run
+            if (failing == 0 && i > 0 && previousGood && rng.next() % 4000 == 0) {
+                failing = 1 + rng.next() % 20;
+                made.failureRuns++;
+            }
+            if (idling == 0 && failing == 0 && rng.next() % 20000 == 0) {
+                idling = 50 + rng.next() % 150;
+            }
+
+            AngleTraceRecord record;
+            record.timestampNs = ns;
+            record.angle = static_cast<float>(failing > 0 ? lastGood : angle);
+            record.status = failing > 0 ? 2 : 0;
+            record.flags = idling > 0 ? ANGLE_TRACE_IDLE : 0;
+            record.reserved[0] = record.reserved[1] = 0;
+            writer.append(record);
+
+            previousGood = failing == 0;
+            if (failing > 0) {
+                failing--;
+                made.failedReads++;
+            } else {
+                lastGood = record.angle;
+            }
+            previousIdle = idling > 0;
+            if (idling > 0) {
+                idling--;
+                made.idleSamples++;
+            }
+        }
+        if (!writer.close(error)) {
+            std::cout << error << std::endl;
+        }
+        return made;
+    }
+
+    bool sameStats(const TraceStats& a, const TraceStats& b) {
+        double noise = std::fabs(a.noiseSumSquares - b.noiseSumSquares);
+        return a.bytes == b.bytes && a.samples == b.samples && a.failedReads == b.failedReads &&
+               a.failureRuns == b.failureRuns && a.gaps == b.gaps && a.idleSamples == b.idleSamples &&
+               a.backwardSteps == b.backwardSteps && a.firstNs == b.firstNs && a.lastNs == b.lastNs &&
+               a.longestIntervalNs == b.longestIntervalNs && a.intervalSumNs == b.intervalSumNs &&
+               a.intervals == b.intervals && a.noiseCount == b.noiseCount &&
+               noise <= 1e-9 * std::max(1.0, a.noiseSumSquares) && a.intervalUs.counts() == b.intervalUs.counts() &&
+               a.velocity.counts() == b.velocity.counts() && a.jerk.counts() == b.jerk.counts();
+    }
+}
+
+int traces(const std::vector<std::string>& paths) {
+    int failures = 0;
+    std::cout << std::fixed;
+    std::vector<std::string> roots(paths);
+    std::string directory;
+    MadeTrace expected = {0, 0, 0, 0, 0};
+    std::vector<std::string> made;
+    const double noiseDegrees = 0.25;
+
+    // Without a corpus: four long sessions and sixty short ones in nested
+    // directories, a torn file and one that isn't a trace
+    if (roots.empty()) {
+        char directoryTemplate[] = "/tmp/lidpong-traces-XXXXXX";
+        if (!mkdtemp(directoryTemplate)) {
+            std::cout << "Can't create a temporary directory" << std::endl;
+            return 1;
+        }
+        directory = directoryTemplate;
+        roots.push_back(directory);
+        mkdir((directory + "/short").c_str(), 0755);
+        mkdir((directory + "/short/more").c_str(), 0755);
+        Random sizes(46);
+        int64_t start = Clock::nowNs();
+        for (int i = 0; i < 64; i++) {
+            std::string path = i < 4 ? directory + "/long" + std::to_string(i) + ANGLE_TRACE_EXTENSION
+                                     : directory + (i % 2 ? "/short/" : "/short/more/") + "s" + std::to_string(i) + ANGLE_TRACE_EXTENSION;
+            uint64_t records = i < 4 ? 2000000 : 50000 + sizes.next() % 250000;
+            MadeTrace trace = writeSyntheticTrace(path, records, 500.0, noiseDegrees, 1000 + i);
+            expected.samples += trace.samples;
+            expected.failedReads += trace.failedReads;
+            expected.failureRuns += trace.failureRuns;
+            expected.gaps += trace.gaps;
+            expected.idleSamples += trace.idleSamples;
+            made.push_back(path);
+        }
+        std::ofstream(made[5], std::ios::binary | std::ios::app).write("torn!!!", 7);
+        std::ofstream(directory + "/short/junk" + ANGLE_TRACE_EXTENSION, std::ios::binary) << "not an angle trace at all";
+        made.push_back(directory + "/short/junk" + ANGLE_TRACE_EXTENSION);
+        std::cout << "Wrote " << made.size() << " synthetic traces, " << expected.samples << " samples, in "
+                  << std::setprecision(2) << Clock::nsToMs(Clock::nowNs() - start) / 1000.0 << " s" << std::endl;
+    }
+
+    std::vector<std::string> files;
+    std::string error;
+    if (!findAngleTraces(roots, files, error) || files.empty()) {
+        std::cout << (files.empty() ? "No angle traces found" : error) << std::endl;
+        return 1;
+    }
+
+    // Reference: one thread, every file in one piece (this also warms the page cache)
+    TraceAnalyzeOptions whole;
+    whole.threads = 1;
+    whole.chunkBytes = SIZE_MAX;
+    TraceAnalysis reference;
+    analyzeAngleTraces(files, whole, reference);
+    printTraceReport(reference, std::cout, false);
+    std::cout << std::fixed;
+
+    if (!directory.empty()) {
+        const TraceStats& total = reference.total;
+        bool counted = files.size() == made.size() && reference.failedFiles() == 1 && total.samples == expected.samples &&
+                       total.failedReads == expected.failedReads && total.failureRuns == expected.failureRuns &&
+                       total.gaps == expected.gaps && total.idleSamples == expected.idleSamples;
+        if (!counted) failures++;
+        std::cout << "Samples, failed reads, runs, gaps and idle samples as generated, junk file refused: "
+                  << (counted ? "OK" : "WRONG") << std::endl;
+        bool torn = false;
+        for (const TraceFileResult& file : reference.files) {
+            torn = torn || (file.path == made[5] && file.strayBytes == 7 && file.error.empty());
+        }
+        if (!torn) failures++;
+        std::cout << "Torn last record skipped: " << (torn ? "OK" : "WRONG") << std::endl;
+        bool measured = std::fabs(total.noiseDegrees() - noiseDegrees) < 0.1 * noiseDegrees &&
+                        std::fabs(total.rateHz() - 500.0) < 5.0;
+        if (!measured) failures++;
+        std::cout << "Noise floor " << std::setprecision(3) << total.noiseDegrees() << " deg (made with " << noiseDegrees
+                  << "), rate " << std::setprecision(1) << total.rateHz() << " Hz (made at 500): "
+                  << (measured ? "OK" : "WRONG") << std::endl;
+    }
+
+    // Small odd-sized pieces on every thread must add up to exactly the same
+    TraceAnalyzeOptions cut;
+    cut.chunkBytes = 100003 * sizeof(AngleTraceRecord);
+    TraceAnalysis pieces;
+    analyzeAngleTraces(files, cut, pieces);
+    bool same = sameStats(reference.total, pieces.total);
+    for (size_t i = 0; same && i < files.size(); i++) {
+        const TraceFileResult& a = reference.files[i];
+        const TraceFileResult& b = pieces.files[i];
+        same = a.samples == b.samples && a.gaps == b.gaps && a.failureRuns == b.failureRuns &&
+               a.intervalP99Ms == b.intervalP99Ms && a.velocityP99 == b.velocityP99 && a.jerkP99 == b.jerkP99;
+    }
+    if (!same) failures++;
+    std::cout << "Cut into " << pieces.chunks << " pieces on " << pieces.threads << " threads, same stats as whole files: "
+              << (same ? "OK" : "WRONG") << std::endl;
+
+    // Scaling: best of three at each thread count
+    size_t hardware = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<size_t> counts;
+    for (size_t threads = 1; threads < hardware; threads *= 2) {
+        counts.push_back(threads);
+    }
+    counts.push_back(hardware);
+    double single = 0.0;
+    std::cout << "Threads    GB/s  samples/s  speedup  efficiency" << std::endl;
+    for (size_t threads : counts) {
+        TraceAnalyzeOptions options;
+        options.threads = threads;
+        double best = 0.0;
+        uint64_t samples = 0;
+        for (int run = 0; run < 3; run++) {
+            TraceAnalysis analysis;
+            analyzeAngleTraces(files, options, analysis);
+            best = std::max(best, analysis.gigabytesPerSecond());
+            samples = analysis.total.samples;
+        }
+        if (threads == 1) {
+            single = best;
+        }
+        double speedup = single > 0.0 ? best / single : 0.0;
+        double rate = reference.total.bytes > 0 ? best * 1.0e9 * samples / reference.total.bytes : 0.0;
+        std::cout << std::setw(7) << threads << std::setprecision(2) << std::setw(8) << best << std::setprecision(0)
+                  << std::setw(10) << rate / 1.0e6 << "M" << std::setprecision(2) << std::setw(8) << speedup << "x"
+                  << std::setprecision(0) << std::setw(11) << 100.0 * speedup / threads << "%" << std::endl;
+    }
+    if (hardware == 1) {
+        std::cout << "(one hardware thread: no scaling to show)" << std::endl;
+    }
+
+    if (!directory.empty()) {
+        for (const std::string& path : made) {
+            std::remove(path.c_str());
+        }
+        rmdir((directory + "/short/more").c_str());
+        rmdir((directory + "/short").c_str());
+        rmdir(directory.c_str());
+    }
+
+    std::cout << (failures ? "FAIL: trace analysis" : "OK: trace analysis counts exactly, whole or in pieces") << std::endl;
+    return failures ? 1 : 0;
+}
+
+namespace {
+    // Every field set to 'value', so a reader can tell a torn set from a whole one
+    GameParams uniformParams(float value) {
+        GameParams params;
+        params.sliderSensitivity = params.sliderReach = params.sliderSpeed = value;
+        params.ballSpeedX = params.ballSpeedY = params.minAngle = params.maxAngle = value;
+        return params;
+    }
+
+    bool isUniform(const GameParams& params) {
+        return params == uniformParams(params.sliderSpeed);
+    }
+
+    std::atomic<uint64_t> paramsWakeups(0);
+    void countParamsWakeup() { paramsWakeups.fetch_add(1); }
+
+    // A save the way editors do it: rewritten in place, or a new file renamed over the old one
+    bool saveParams(const std::string& path, const std::string& text, bool rename) {
+        std::string target = rename ? path + ".tmp" : path;
+        {
+            std::ofstream out(target, std::ios::trunc);
+            out << text;
+            if (!out.flush()) return false;
+        }
+        return !rename || std::rename(target.c_str(), path.c_str()) == 0;
+    }
+
+    // Milliseconds until the store's slider speed is 'speed', or -1 after a second
+    double waitForSpeed(const ParamStore& store, float speed, int64_t startNs) {
+        while (store.current().sliderSpeed != speed) {
+            if (Clock::nowNs() - startNs > 1000000000) return -1.0;
+            std::this_thread::yield();
+        }
+        return Clock::nsToMs(Clock::nowNs() - startNs);
+    }
+}
+
+int params() {
+    int failures = 0;
+    std::cout << std::fixed;
+
+    // The parser: defaults round-trip, bad files are rejected whole
+    {
+        GameParams tuned;
+        tuned.sliderSpeed = 20.0f;
+        tuned.maxAngle = 135.0f;
+        GameParams parsed, roundTrip;
+        std::string error;
+        bool ok = parseGameParams(formatGameParams(GameParams()), parsed, error) && parsed == GameParams::defaults() &&
+                  parseGameParams(formatGameParams(tuned), roundTrip, error) && roundTrip == tuned &&
+                  parseGameParams("# nothing\n\n", parsed, error) && parsed == GameParams::defaults();
+        const char* bad[] = {"slider_speed 12", "slider_sped = 12", "slider_speed = 12x", "slider_speed = nan",
+                             "slider_reach = 1.5", "min_angle = 90\nmax_angle = 90", "ball_speed_x = -1"};
+        for (const char* text : bad) {
+            GameParams untouched = tuned;
+            ok = ok && !parseGameParams(text, untouched, error) && untouched == tuned;
+        }
+        if (!ok) failures++;
+        std::cout << "Parser: round trips and " << sizeof(bad) / sizeof(bad[0]) << " bad files: " << (ok ? "OK" : "WRONG")
+                  << std::endl;
+    }
+
+    // Per-tick cost while another thread publishes 10k sets a second, far more than anyone saves a file
+    {
+        ParamStore store;
+        std::atomic<bool> done(false);
+        std::thread writer([&]() {
+            while (!done.load()) {
+                store.publish(GameParams::defaults());
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+        });
+
+        const int reads = 20000000;
+        int matches = 0;
+        int64_t start = Clock::nowNs();
+        for (int i = 0; i < reads; i++) {
+            matches += store.current().sliderSpeed == 12.0f;
+        }
+        double readNs = static_cast<double>(Clock::nowNs() - start) / reads;
+
+        // Classic game ticks as LidPongGame steps them, with and without taking
+        // the current params; interleaved rounds, the best of each
+        const uint64_t ticks = 500000;
+        Simulation plain, withParams;
+        double plainNs = 1e30, paramsNs = 1e30;
+        for (int round = 0; round < 5; round++) {
+            uint64_t first = round * ticks;
+            start = Clock::nowNs();
+            for (uint64_t t = first; t < first + ticks; t++) plain.step(benchTick(t));
+            plainNs = std::min(plainNs, static_cast<double>(Clock::nowNs() - start) / ticks);
+            start = Clock::nowNs();
+            for (uint64_t t = first; t < first + ticks; t++) {
+                withParams.setParams(store.current());
+                withParams.step(benchTick(t));
+            }
+            paramsNs = std::min(paramsNs, static_cast<double>(Clock::nowNs() - start) / ticks);
+        }
+        done.store(true);
+        writer.join();
+
+        bool same = plain.checksum() == withParams.checksum();
+        bool cheap = readNs < 0.1 * plainNs && matches == reads;
+        if (!same || !cheap) failures++;
+        std::cout << "Read: " << std::setprecision(2) << readNs << " ns; a classic tick " << plainNs << " ns, "
+                  << paramsNs << " ns taking the params (" << std::showpos << std::setprecision(1)
+                  << 100.0 * (paramsNs - plainNs) / plainNs << std::noshowpos << "%) over " << store.version()
+                  << " publishes: " << (cheap ? "OK" : "TOO SLOW") << std::endl;
+        std::cout << "Default params reproduce the built-in game: " << (same ? "OK" : "WRONG") << std::endl;
+
+        // And a retuned serve does change it
+        Simulation fast;
+        GameParams quick;
+        quick.ballSpeedX = 1.2f;
+        fast.setParams(quick);
+        Simulation reference;
+        for (uint64_t t = 0; t < 12000; t++) {
+            fast.step(benchTick(t));
+            reference.step(benchTick(t));
+        }
+        bool differs = fast.checksum() != reference.checksum() && fast.ball().vx != reference.ball().vx;
+        if (!differs) failures++;
+        std::cout << "Retuned serve changes the game: " << (differs ? "OK" : "WRONG") << std::endl;
+    }
+
+    // Concurrent readers never see a torn set or go back to an older one
+    {
+        ParamStore store;
+        store.publish(uniformParams(1.0f));
+        std::atomic<bool> done(false);
+        std::atomic<uint64_t> torn(0), backwards(0), seen(0);
+        std::vector<std::thread> readers;
+        for (int r = 0; r < 2; r++) {
+            readers.emplace_back([&]() {
+                float last = 0.0f;
+                uint64_t lastVersion = 0, count = 0;
+                while (!done.load(std::memory_order_relaxed)) {
+                    uint64_t version = store.version();
+                    const GameParams& params = store.current();
+                    if (!isUniform(params)) torn.fetch_add(1);
+                    if (params.sliderSpeed < last || version < lastVersion) backwards.fetch_add(1);
+                    last = params.sliderSpeed;
+                    lastVersion = version;
+                    count++;
+                }
+                seen.fetch_add(count);
+            });
+        }
+        for (int v = 2; v <= 10000; v++) {
+            store.publish(uniformParams(static_cast<float>(v)));
+            if (v % 100 == 0) std::this_thread::sleep_for(std::chrono::microseconds(500));
+        }
+        done.store(true);
+        for (std::thread& t : readers) t.join();
+
+        bool ok = torn.load() == 0 && backwards.load() == 0;
+        if (!ok) failures++;
+        std::cout << "Consistency: " << seen.load() << " reads across " << store.version() << " publishes, " << torn.load()
+                  << " torn, " << backwards.load() << " out of order: " << (ok ? "OK" : "WRONG") << std::endl;
+    }
+
+    // The angle range reaches the input thread's slider mapping
+    {
+        LidSensor sensor;
+        if (!sensor.isAvailable()) {
+            std::cout << "Lid sensor not available; skipping the angle range check" << std::endl;
+        } else {
+            ParamStore store;
+            sensor.setParams(&store);
+            sensor.update();
+            double angle = sensor.getCurrentAngle();
+            bool ok = std::abs(sensor.getSliderPosition() - std::min(std::max(angle / 180.0, 0.0), 1.0)) < 1e-9;
+            GameParams narrow;
+            narrow.minAngle = static_cast<float>(angle) - 20.0f;
+            narrow.maxAngle = static_cast<float>(angle) + 60.0f;
+            store.publish(narrow);
+            sensor.update();
+            double expected = (sensor.getCurrentAngle() - narrow.minAngle) / (narrow.maxAngle - narrow.minAngle);
+            ok = ok && std::abs(sensor.getSliderPosition() - std::min(std::max(expected, 0.0), 1.0)) < 1e-6;
+            if (!ok) failures++;
+            std::cout << "Sensor maps " << std::setprecision(1) << sensor.getCurrentAngle() << " degrees over the new range: "
+                      << (ok ? "OK" : "WRONG") << std::endl;
+        }
+    }
+
+    // Saves to a watched file, in place and renamed over, until the new values are live
+    char directoryTemplate[] = "/tmp/lidpong-params-XXXXXX";
+    if (!mkdtemp(directoryTemplate)) {
+        std::cout << "Can't create a temporary directory" << std::endl;
+        return 1;
+    }
+    const std::string directory = directoryTemplate;
+    const std::string path = directory + "/game.params";
+    {
+        ParamStore store;
+        std::string error;
+        if (!saveParams(path, formatGameParams(GameParams()), false) || !store.load(path, error) ||
+            !store.watch(countParamsWakeup, error)) {
+            std::cout << "Can't watch " << path << ": " << error << std::endl;
+            return 1;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20)); // Let the watcher settle in
+
+        const int saves = 20;
+        std::vector<double> latencies;
+        int lost = 0;
+        for (int i = 0; i < saves; i++) {
+            float speed = 13.0f + i;
+            int64_t start = Clock::nowNs();
+            double ms = -1.0;
+            if (saveParams(path, "slider_speed = " + std::to_string(static_cast<int>(speed)) + "\n", i % 2 == 1)) {
+                ms = waitForSpeed(store, speed, start);
+            }
+            if (ms < 0.0) {
+                lost++;
+            } else {
+                latencies.push_back(ms);
+            }
+        }
+        std::sort(latencies.begin(), latencies.end());
+        double median = latencies.empty() ? 0.0 : latencies[latencies.size() / 2];
+        double worst = latencies.empty() ? 0.0 : latencies.back();
+        bool ok = lost == 0 && median < 1000.0 / 60.0 && paramsWakeups.load() > 0;
+        if (!ok) failures++;
+        std::cout << "Reload: " << saves << " saves (half renamed over), median " << std::setprecision(2) << median
+                  << " ms, worst " << worst << " ms, " << lost << " lost, " << paramsWakeups.load()
+                  << " main loop wake-ups: " << (ok ? "OK" : "WRONG") << std::endl;
+
+        // A broken save is reported and changes nothing; the next good one still applies
+        uint64_t rejectedBefore = store.rejected();
+        float speed = store.current().sliderSpeed;
+        saveParams(path, "slider_speed = fast\n", false);
+        int64_t start = Clock::nowNs();
+        while (store.rejected() == rejectedBefore && Clock::nowNs() - start < 1000000000) {
+            std::this_thread::yield();
+        }
+        bool kept = store.rejected() > rejectedBefore && store.current().sliderSpeed == speed;
+        std::string message, lastMessage;
+        while (store.takeReport(message)) lastMessage = message;
+        bool reported = lastMessage.find("keeping the current values") != std::string::npos;
+        bool recovers = saveParams(path, "slider_speed = 50\n", true) && waitForSpeed(store, 50.0f, Clock::nowNs()) >= 0.0;
+        store.stopWatching();
+        ok = kept && reported && recovers;
+        if (!ok) failures++;
+        std::cout << "Broken save: values kept " << (kept ? "yes" : "NO") << ", reported " << (reported ? "yes" : "NO")
+                  << ", next save applies " << (recovers ? "yes" : "NO") << ": " << (ok ? "OK" : "WRONG") << std::endl;
+    }
+    std::remove(path.c_str());
+    std::remove((path + ".tmp").c_str());
+    rmdir(directory.c_str());
+
+    std::cout << (failures ? "FAIL: live params" : "OK: live params read lock-free and reload within a frame") << std::endl;
+    return failures ? 1 : 0;
+}
+
+int run(const std::string& name, const Options& options) {
+    if (name == "balls") return balls(options.count > 0 ? options.count : 65536);
+    if (name == "ccd") return ccd();
+    if (name == "bricks") return bricks();
+    if (name == "netplay") return netplay();
+    if (name == "snapshot") return snapshots();
+    if (name == "render") return render(options.goldenDirectory, options.frameWidth, options.frameHeight);
+    if (name == "alloc") return allocations();
+    if (name == "particles") return particles(options.count > 0 ? options.count : 100000);
+    if (name == "idle") return idle();
+    if (name == "gestures") return gestures(options.recordingFile);
+    if (name == "traces") return traces(options.tracePaths);
+    if (name == "params") return params();
+    if (name == "audio") return audio();
+    if (name == "scores") return scores(options.count > 0 ? options.count : 1000000);
+    if (name == "input") return input(100000);
+    if (name == "envs") return envs(options.count > 0 ? options.count : 4096);
+    std::cerr << "Unknown benchmark: " << name << std::endl;
+    return -1;
+}
+
+} // namespace Bench
+} // namespace LidPong
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "Controller.h"
+#include "Simulation.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace LidPong {
+
+// Headless benchmarks, run with "lid-pong --bench <name>" (or the
+// GPU-less lid-pong-headless build). Each returns 0 on success and non-zero
+// if a correctness check failed.
+namespace Bench {
+
+// What the command line hands the benchmarks
+struct Options {
+    size_t count;                        // --balls N: balls, games or particles (0: each one's default)
+    std::string goldenDirectory;         // render
+    int frameWidth, frameHeight;         // render
+    std::string recordingFile;           // gestures
+    std::vector<std::string> tracePaths; // traces
+
+    Options() : count(0), frameWidth(800), frameHeight(600) {}
+};
+
+// The benchmark called 'name' (see --help); -1 if there is none
+int run(const std::string& name, const Options& options);
+
+// Scalar vs SIMD multi-ball kernels: balls per millisecond and equivalence
+int balls(size_t maxBalls);
+
+// Swept vs discrete paddle collision over speeds and step sizes; fails on any tunnelling
+int ccd();
+
+// Brick mode per-tick cost, uniform grid vs brute force, over brick and ball counts;
+// also checks a brick reached only after a wall bounce within one step is broken
+int bricks();
+
+// Batch environment throughput from one thread to all cores; fails if results depend on threads
+int envs(size_t envCount);
+
+// Snapshot save/restore cost in nanoseconds per mode; fails if a restored game diverges
+int snapshots();
+
+// Two rollback peers over loopback UDP with injected latency, jitter and loss;
+// fails unless both converge on the state of a reference run with the true inputs
+int netplay();
+
+// Software rasteriser frames per second over a set of fixed game scenes, SIMD
+// and scalar spans (which must match exactly). With a golden directory each
+// frame must also match <dir>/<scene>.ppm pixel for pixel; missing files are written.
+int render(const std::string& goldenDirectory, int width, int height);
+
+// Synthetic window event streams through InputQueue and InputState, headless;
+// fails if any press or click (even one released within its frame) is lost
+int input(size_t frames);
+
+// 'count' effect particles kept alive for 600 frames: update, respawn and
+// capture cost against a 60 Hz frame; fails if the pool miscounts or reallocates
+int particles(size_t count);
+
+// Heap allocations in steady-state frames (input, ticks, history, effects,
+// capture, software draw) for each game mode; fails if any allocate after
+// warm-up. Needs an ALLOC_TRACK build.
+int allocations();
+
+// Idle mode: the governor's state machine over a scripted session, the
+// render thread's pause (last frame shown, then no presents) and the input
+// sampler's idle rate and resume latency; fails if any of them is off
+int idle();
+
+// Audio: the lock-free command queue across threads, mixer output exactness,
+// voice stealing and queue overflow, mix cost with every voice busy, post to
+// output latency through the null backend and a WAV file's contents
+int audio();
+
+// Lid gesture recogniser over synthetic traces at sensor, frame and idle
+// sample rates (recall and false events against the gestures put in),
+// samples per second, and the events a recorded session would have fired
+int gestures(const std::string& recordingFile);
+
+// Leaderboard store with 'count' games in a temporary directory: bulk append,
+// reopen, ranked queries (checked against brute force, with and without an
+// unindexed tail), torn-record recovery, a damaged record mid-log skipped
+// without losing later games, and ScoreWriter submit latency
+int scores(size_t count);
+
+// Angle trace analysis over the traces under 'paths' or, without any, a
+// synthetic corpus in a temporary directory (checked against what was put
+// in): whole files vs small pieces on every thread, which must agree
+// exactly, and GB/s from one thread to all cores
+int traces(const std::vector<std::string>& paths);
+
+// Live params: parser round trips and rejects, ns per lock-free read against
+// a game tick while another thread publishes, torn or out-of-order sets seen
+// by concurrent readers, and save-to-live latency through the file watcher
+// (in place and renamed over); fails if a read costs over 10% of a tick or
+// a median save takes longer than a 60 Hz frame
+int params();
+
+// Soak test: 'games' bot-played games back to back; hit/lives stats, tick rate,
+// tick-time outliers and resident memory growth (fails if memory keeps growing)
+int soak(const SimulationConfig& config, size_t games, const BotOptions& bot);
+
+} // namespace Bench
+
+} // namespace LidPong
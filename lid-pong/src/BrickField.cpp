@@ -0,0 +1,266 @@
+#include "BrickField.h"
+#include <algorithm>
+#include <cmath>
+
+namespace LidPong {
+
+namespace {
+    const int MAX_BRICK_CONTACTS = 8; // Bricks broken by one ball in one step
+    const int MAX_BOUNCE_CONTACTS = 16; // Wall and paddle bounces tested against bricks in one step
+    const float BRICK_GAP = 0.1f;     // Fraction of a grid slot left empty around a brick
+}
+
+BrickField::BrickField()
+    : m_alive(0)
+    , m_revision(0)
+    , m_gridMinX(0.0f)
+    , m_gridMinY(0.0f)
+    , m_cellWidth(1.0f)
+    , m_cellHeight(1.0f)
+    , m_gridColumns(0)
+    , m_gridRows(0)
+    , m_queryStamp(0) {
+}
+
+void BrickField::build(int rows, int columns, float minX, float minY, float maxX, float maxY) {
+    m_bricks.clear();
+    m_bricks.reserve(static_cast<size_t>(rows) * columns);
+
+    float slotWidth = (maxX - minX) / columns;
+    float slotHeight = (maxY - minY) / rows;
+    float gapX = slotWidth * BRICK_GAP * 0.5f;
+    float gapY = slotHeight * BRICK_GAP * 0.5f;
+
+    for (int row = 0; row < rows; row++) {
+        for (int column = 0; column < columns; column++) {
+            Brick brick;
+            brick.minX = minX + column * slotWidth + gapX;
+            brick.maxX = minX + (column + 1) * slotWidth - gapX;
+            brick.minY = minY + row * slotHeight + gapY;
+            brick.maxY = minY + (row + 1) * slotHeight - gapY;
+            brick.alive = true;
+            m_bricks.push_back(brick);
+        }
+    }
+    m_alive = m_bricks.size();
+    m_stamps.assign(m_bricks.size(), 0);
+    m_queryStamp = 0;
+
+    // Cells about two bricks across keep per-cell lists short
+    m_gridMinX = minX;
+    m_gridMinY = minY;
+    m_gridColumns = std::max(1, (columns + 1) / 2);
+    m_gridRows = std::max(1, (rows + 1) / 2);
+    m_cellWidth = (maxX - minX) / m_gridColumns;
+    m_cellHeight = (maxY - minY) / m_gridRows;
+    size_t cellCount = static_cast<size_t>(m_gridColumns) * m_gridRows;
+    m_cellStart.assign(cellCount, 0);
+    m_cellCount.assign(cellCount, 0);
+
+    // Two passes: count each cell's bricks, then fill the packed ranges
+    for (const Brick& brick : m_bricks) {
+        for (int cy = cellY(brick.minY); cy <= cellY(brick.maxY); cy++) {
+            for (int cx = cellX(brick.minX); cx <= cellX(brick.maxX); cx++) {
+                m_cellCount[static_cast<size_t>(cy) * m_gridColumns + cx]++;
+            }
+        }
+    }
+    uint32_t total = 0;
+    for (size_t c = 0; c < cellCount; c++) {
+        m_cellStart[c] = total;
+        total += m_cellCount[c];
+        m_cellCount[c] = 0;
+    }
+    m_cellIndices.assign(total, 0);
+    for (uint32_t i = 0; i < m_bricks.size(); i++) {
+        const Brick& brick = m_bricks[i];
+        for (int cy = cellY(brick.minY); cy <= cellY(brick.maxY); cy++) {
+            for (int cx = cellX(brick.minX); cx <= cellX(brick.maxX); cx++) {
+                size_t c = static_cast<size_t>(cy) * m_gridColumns + cx;
+                m_cellIndices[m_cellStart[c] + m_cellCount[c]++] = i;
+            }
+        }
+    }
+    m_revision++;
+}
+
+size_t BrickField::copyBytes() const {
+    return m_bricks.size() * sizeof(Brick) + m_stamps.size() * sizeof(uint32_t) +
+           (m_cellStart.size() + m_cellCount.size() + m_cellIndices.size()) * sizeof(uint32_t);
+}
+
+int BrickField::cellX(float x) const {
+    int cell = static_cast<int>(std::floor((x - m_gridMinX) / m_cellWidth));
+    return std::min(std::max(cell, 0), m_gridColumns - 1);
+}
+
+int BrickField::cellY(float y) const {
+    int cell = static_cast<int>(std::floor((y - m_gridMinY) / m_cellHeight));
+    return std::min(std::max(cell, 0), m_gridRows - 1);
+}
+
+bool BrickField::testBrick(uint32_t index, const SweptBall& ball, float duration, Hit& best) const {
+    const Brick& brick = m_bricks[index];
+    if (!brick.alive) {
+        return false;
+    }
+
+    // Slab test of the ball centre against the brick grown by the radius
+    const float r = ball.radius;
+    const float lo[2] = {brick.minX - r, brick.minY - r};
+    const float hi[2] = {brick.maxX + r, brick.maxY + r};
+    const float p[2] = {ball.x, ball.y};
+    const float d[2] = {ball.vx, ball.vy};
+
+    float tEnter = -1.0f;
+    float tExit = duration;
+    int axis = 0;
+    for (int a = 0; a < 2; a++) {
+        if (d[a] == 0.0f) {
+            if (p[a] < lo[a] || p[a] > hi[a]) return false;
+            continue;
+        }
+        float t0 = (lo[a] - p[a]) / d[a];
+        float t1 = (hi[a] - p[a]) / d[a];
+        if (t0 > t1) std::swap(t0, t1);
+        if (t0 > tEnter) { tEnter = t0; axis = a; }
+        if (t1 < tExit) tExit = t1;
+    }
+    if (tEnter > tExit || tExit < 0.0f) {
+        return false;
+    }
+    if (tEnter < 0.0f) {
+        tEnter = 0.0f; // Already touching: bounce straight away
+    }
+    // Ties go to the lower index so grid and brute-force queries agree exactly
+    if (tEnter < best.t || (tEnter == best.t && index < best.brick)) {
+        best.t = tEnter;
+        best.brick = index;
+        best.axis = axis;
+        return true;
+    }
+    return false;
+}
+
+bool BrickField::firstHit(const SweptBall& ball, float duration, bool bruteForce, Hit& hit) {
+    hit.t = duration;
+    hit.brick = UINT32_MAX;
+    hit.axis = 0;
+    bool found = false;
+
+    if (bruteForce) {
+        for (uint32_t i = 0; i < m_bricks.size(); i++) {
+            found |= testBrick(i, ball, duration, hit);
+        }
+        return found;
+    }
+
+    // Cells touched by the ball's swept bounds this step
+    float endX = ball.x + ball.vx * duration;
+    float endY = ball.y + ball.vy * duration;
+    float minX = std::min(ball.x, endX) - ball.radius;
+    float maxX = std::max(ball.x, endX) + ball.radius;
+    float minY = std::min(ball.y, endY) - ball.radius;
+    float maxY = std::max(ball.y, endY) + ball.radius;
+
+    if (maxX < m_gridMinX || minX > m_gridMinX + m_cellWidth * m_gridColumns ||
+        maxY < m_gridMinY || minY > m_gridMinY + m_cellHeight * m_gridRows) {
+        return false;
+    }
+
+    if (++m_queryStamp == 0) {
+        std::fill(m_stamps.begin(), m_stamps.end(), 0);
+        m_queryStamp = 1;
+    }
+
+    int x0 = cellX(minX), x1 = cellX(maxX);
+    int y0 = cellY(minY), y1 = cellY(maxY);
+    for (int cy = y0; cy <= y1; cy++) {
+        for (int cx = x0; cx <= x1; cx++) {
+            size_t c = static_cast<size_t>(cy) * m_gridColumns + cx;
+            const uint32_t* cell = m_cellIndices.data() + m_cellStart[c];
+            for (uint32_t k = 0; k < m_cellCount[c]; k++) {
+                uint32_t index = cell[k];
+                if (m_stamps[index] == m_queryStamp) continue;
+                m_stamps[index] = m_queryStamp;
+                found |= testBrick(index, ball, duration, hit);
+            }
+        }
+    }
+    return found;
+}
+
+void BrickField::breakBrick(uint32_t index) {
+    Brick& brick = m_bricks[index];
+    if (!brick.alive) {
+        return;
+    }
+    brick.alive = false;
+    m_alive--;
+    m_revision++;
+
+    // Incremental index update: drop the brick from the cells it occupied
+    for (int cy = cellY(brick.minY); cy <= cellY(brick.maxY); cy++) {
+        for (int cx = cellX(brick.minX); cx <= cellX(brick.maxX); cx++) {
+            size_t c = static_cast<size_t>(cy) * m_gridColumns + cx;
+            uint32_t* cell = m_cellIndices.data() + m_cellStart[c];
+            for (uint32_t i = 0; i < m_cellCount[c]; i++) {
+                if (cell[i] == index) {
+                    cell[i] = cell[--m_cellCount[c]];
+                    break;
+                }
+            }
+        }
+    }
+}
+
+BrickStepResult BrickField::stepBall(SweptBall& ball, float duration, const SweptPaddle& paddle,
+                                     const Playfield& field, bool bruteForce) {
+    BrickStepResult result = {0, 0, false};
+    float elapsed = 0.0f;
+    int bricks = 0, bounces = 0;
+    const float paddleVy = duration > 0.0f ? (paddle.endY - paddle.startY) / duration : 0.0f;
+
+    while (elapsed < duration) {
+        float remaining = duration - elapsed;
+        Hit hit;
+        bool testBricks = bricks < MAX_BRICK_CONTACTS && bounces < MAX_BOUNCE_CONTACTS;
+        bool brickAhead = testBricks && firstHit(ball, remaining, bruteForce, hit);
+        float span = brickAhead ? hit.t : remaining;
+
+        // Walls and paddle up to the brick contact (or the end of the step),
+        // stopping at the first bounce: the new path is tested for bricks again.
+        // Past the bounce limit the rest of the step ignores bricks.
+        SweptPaddle part = paddle;
+        part.startY = paddle.startY + paddleVy * elapsed;
+        part.endY = paddle.startY + paddleVy * (elapsed + span);
+        SweepResult sweep = bounces < MAX_BOUNCE_CONTACTS ? sweepBallToContact(ball, span, part, field)
+                                                          : sweepBall(ball, span, part, field);
+        result.paddleHits += sweep.paddleHits;
+        elapsed += sweep.elapsed;
+
+        if (sweep.missed) {
+            result.missed = true;
+            break;
+        }
+        if (sweep.paddleHits > 0 || sweep.wallBounces > 0) {
+            bounces++;
+            continue;
+        }
+        if (!brickAhead) {
+            break;
+        }
+
+        breakBrick(hit.brick);
+        bricks++;
+        result.bricksBroken++;
+        if (hit.axis == 0) {
+            ball.vx = -ball.vx;
+        } else {
+            ball.vy = -ball.vy;
+        }
+    }
+    return result;
+}
+
+} // namespace LidPong
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "Collision.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace LidPong {
+
+struct Brick {
+    float minX, minY, maxX, maxY;
+    bool alive;
+};
+
+struct BrickStepResult {
+    int paddleHits;
+    int bricksBroken;
+    bool missed;
+};
+
+// Destructible brick wall with a uniform-grid broadphase.
+//
+// Every brick is registered in the grid cells it overlaps. A ball's swept
+// bounds for a step select a handful of cells, so a query costs roughly the
+// number of bricks near the ball rather than the number of bricks in the
+// field. Breaking a brick removes it from its cells in place (swap-pop), so
+// the index never has to be rebuilt while playing.
+class BrickField {
+public:
+    BrickField();
+
+    // Lay out 'rows' x 'columns' bricks inside the given rectangle
+    void build(int rows, int columns, float minX, float minY, float maxX, float maxY);
+
+    size_t brickCount() const { return m_bricks.size(); }
+    size_t aliveCount() const { return m_alive; }
+    const std::vector<Brick>& bricks() const { return m_bricks; }
+
+    // Heap bytes a copy of the field holds: bricks, stamps and the grid's cell lists
+    size_t copyBytes() const;
+
+    // Advance a ball through one step against bricks, walls and paddle.
+    // bruteForce skips the grid and tests every brick (benchmark baseline).
+    BrickStepResult stepBall(SweptBall& ball, float duration, const SweptPaddle& paddle,
+                             const Playfield& field, bool bruteForce = false);
+
+    // Bumped whenever a brick breaks, so renderers know to rebuild vertex data
+    uint64_t revision() const { return m_revision; }
+
+private:
+    struct Hit {
+        float t;
+        uint32_t brick;
+        int axis; // 0 = entered through a vertical face (flip vx), 1 = horizontal (flip vy)
+    };
+
+    bool firstHit(const SweptBall& ball, float duration, bool bruteForce, Hit& hit);
+    bool testBrick(uint32_t index, const SweptBall& ball, float duration, Hit& best) const;
+    void breakBrick(uint32_t index);
+
+    int cellX(float x) const;
+    int cellY(float y) const;
+
+    std::vector<Brick> m_bricks;
+    size_t m_alive;
+    uint64_t m_revision;
+
+    // Uniform grid over the brick area
+    float m_gridMinX, m_gridMinY;
+    float m_cellWidth, m_cellHeight;
+    int m_gridColumns, m_gridRows;
+    // Cell lists packed into one buffer sized at build(): cell c owns
+    // m_cellIndices[m_cellStart[c]..] with m_cellCount[c] live entries. Breaks
+    // only shrink counts, so copying a field (history snapshots) never reallocates.
+    std::vector<uint32_t> m_cellStart;
+    std::vector<uint32_t> m_cellCount;
+    std::vector<uint32_t> m_cellIndices;
+
+    // Per-brick query stamp so bricks spanning several cells are tested once
+    std::vector<uint32_t> m_stamps;
+    uint32_t m_queryStamp;
+};
+
+} // namespace LidPong
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace LidPong {
+
+enum class Primitive {
+    Quads,       // Every four vertices are one convex quad
+    TriangleFan, // One convex polygon (the game only draws convex fans)
+    LineLoop     // One-pixel outline through all vertices, closed
+};
+
+// The small immediate-mode subset of OpenGL the game draws with, so the same
+// scene code can target the GL window or the software rasteriser.
+// Coordinates run from -1 to 1 across the canvas, y up.
+class Canvas {
+public:
+    virtual ~Canvas() {}
+
+    virtual int width() const = 0;  // Pixels
+    virtual int height() const = 0;
+
+    virtual void clear(float r, float g, float b) = 0;
+    virtual void setColor(float r, float g, float b, float a = 1.0f) = 0;
+    virtual void setBlending(bool enabled) = 0; // Source-alpha over
+
+    virtual void begin(Primitive primitive) = 0;
+    virtual void vertex(float x, float y) = 0;
+    virtual void end() = 0;
+
+    // Batched paths over interleaved xy pairs
+    virtual void drawQuads(const float* xy, size_t vertexCount) = 0;
+    virtual void drawPoints(const float* xy, size_t count, float diameterPixels) = 0;
+
+    // One colour per point, packed RGBA bytes in memory order; with blending
+    // on, each point's alpha applies
+    virtual void drawColoredPoints(const float* xy, const uint32_t* rgba, size_t count, float diameterPixels) = 0;
+};
+
+} // namespace LidPong
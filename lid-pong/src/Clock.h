@@ -0,0 +1,22 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace LidPong {
+
+// Monotonic timestamps shared by the input, timing and latency code
+namespace Clock {
+
+inline int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+inline double nsToMs(int64_t ns) {
+    return ns / 1.0e6;
+}
+
+} // namespace Clock
+
+} // namespace LidPong
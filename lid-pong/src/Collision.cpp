@@ -0,0 +1,200 @@
+#include "Collision.h"
+#include <cmath>
+
+namespace LidPong {
+
+namespace {
+    const int MAX_BOUNCES = 16;
+    const float EPSILON = 1e-6f;
+
+    enum class Contact { None, Top, Bottom, Right, Paddle, RightPaddle };
+
+    // Time until a coordinate moving at 'velocity' reaches 'boundary', if ever
+    float timeToReach(float position, float velocity, float boundary) {
+        if (velocity == 0.0f) {
+            return -1.0f;
+        }
+        float t = (boundary - position) / velocity;
+        return t >= 0.0f ? t : -1.0f;
+    }
+}
+
+float rayBoxTimeOfImpact(float px, float py, float dx, float dy,
+                         float minX, float minY, float maxX, float maxY, float maxT) {
+    if (px >= minX && px <= maxX && py >= minY && py <= maxY) {
+        return 0.0f;
+    }
+
+    // Slab test
+    float tEnter = 0.0f;
+    float tExit = maxT;
+    const float p[2] = {px, py};
+    const float d[2] = {dx, dy};
+    const float lo[2] = {minX, minY};
+    const float hi[2] = {maxX, maxY};
+
+    for (int axis = 0; axis < 2; axis++) {
+        if (std::abs(d[axis]) < EPSILON) {
+            if (p[axis] < lo[axis] || p[axis] > hi[axis]) {
+                return -1.0f;
+            }
+            continue;
+        }
+        float t0 = (lo[axis] - p[axis]) / d[axis];
+        float t1 = (hi[axis] - p[axis]) / d[axis];
+        if (t0 > t1) {
+            float tmp = t0; t0 = t1; t1 = tmp;
+        }
+        if (t0 > tEnter) tEnter = t0;
+        if (t1 < tExit) tExit = t1;
+        if (tEnter > tExit) {
+            return -1.0f;
+        }
+    }
+    return tEnter;
+}
+
+namespace {
+
+// Shared sweep; 'right' is null for the single-player field with a right wall
+SweepResult sweep(SweptBall& ball, float duration, const SweptPaddle& paddle,
+                  const SweptPaddle* right, const Playfield& field, bool stopAtContact) {
+    SweepResult result = {0, 0, false, false, 0, false, 0.0f};
+    const float r = ball.radius;
+    const float paddleVy = duration > 0.0f ? (paddle.endY - paddle.startY) / duration : 0.0f;
+    const float rightVy = right && duration > 0.0f ? (right->endY - right->startY) / duration : 0.0f;
+
+    float elapsed = 0.0f;
+    int bounces = 0;
+    Contact lastContact = Contact::None;
+
+    while (elapsed < duration) {
+        float remaining = duration - elapsed;
+        float firstT = remaining;
+        Contact contact = Contact::None;
+
+        // Walls (never the same wall twice in a row - we're sitting on it)
+        if (ball.vy > 0.0f && lastContact != Contact::Top) {
+            float t = timeToReach(ball.y + r, ball.vy, field.top);
+            if (t >= 0.0f && t < firstT) { firstT = t; contact = Contact::Top; }
+        }
+        if (ball.vy < 0.0f && lastContact != Contact::Bottom) {
+            float t = timeToReach(ball.y - r, ball.vy, field.bottom);
+            if (t >= 0.0f && t < firstT) { firstT = t; contact = Contact::Bottom; }
+        }
+        if (!right && ball.vx > 0.0f && lastContact != Contact::Right) {
+            float t = timeToReach(ball.x + r, ball.vx, field.right);
+            if (t >= 0.0f && t < firstT) { firstT = t; contact = Contact::Right; }
+        }
+
+        // Paddle, in its own (moving) frame, expanded by the ball radius
+        if (ball.vx < 0.0f) {
+            float paddleY = paddle.startY + paddleVy * elapsed;
+            float t = rayBoxTimeOfImpact(ball.x - paddle.x, ball.y - paddleY,
+                                         ball.vx, ball.vy - paddleVy,
+                                         -paddle.halfWidth - r, -paddle.halfHeight - r,
+                                         paddle.halfWidth + r, paddle.halfHeight + r,
+                                         remaining);
+            if (t >= 0.0f && t <= firstT) { firstT = t; contact = Contact::Paddle; }
+        }
+        if (right && ball.vx > 0.0f) {
+            float paddleY = right->startY + rightVy * elapsed;
+            float t = rayBoxTimeOfImpact(ball.x - right->x, ball.y - paddleY,
+                                         ball.vx, ball.vy - rightVy,
+                                         -right->halfWidth - r, -right->halfHeight - r,
+                                         right->halfWidth + r, right->halfHeight + r,
+                                         remaining);
+            if (t >= 0.0f && t <= firstT) { firstT = t; contact = Contact::RightPaddle; }
+        }
+
+        // Advance to the contact (or the end of the step)
+        ball.x += ball.vx * firstT;
+        ball.y += ball.vy * firstT;
+        elapsed += firstT;
+
+        if (contact == Contact::None) {
+            break;
+        }
+
+        switch (contact) {
+            case Contact::Top:
+                ball.vy = -ball.vy;
+                ball.y = field.top - r;
+                result.wallBounces++;
+                break;
+            case Contact::Bottom:
+                ball.vy = -ball.vy;
+                ball.y = field.bottom + r;
+                result.wallBounces++;
+                break;
+            case Contact::Right:
+                ball.vx = -ball.vx;
+                ball.x = field.right - r;
+                result.wallBounces++;
+                break;
+            case Contact::Paddle: {
+                float paddleY = paddle.startY + paddleVy * elapsed;
+                ball.vx = std::abs(ball.vx);
+                float hitPos = (ball.y - paddleY) / paddle.halfHeight;
+                ball.vy += hitPos * PADDLE_SPIN;
+                if (ball.vy > MAX_BALL_VY) ball.vy = MAX_BALL_VY;
+                if (ball.vy < -MAX_BALL_VY) ball.vy = -MAX_BALL_VY;
+                result.paddleHits++;
+                break;
+            }
+            case Contact::RightPaddle: {
+                float paddleY = right->startY + rightVy * elapsed;
+                ball.vx = -std::abs(ball.vx);
+                float hitPos = (ball.y - paddleY) / right->halfHeight;
+                ball.vy += hitPos * PADDLE_SPIN;
+                if (ball.vy > MAX_BALL_VY) ball.vy = MAX_BALL_VY;
+                if (ball.vy < -MAX_BALL_VY) ball.vy = -MAX_BALL_VY;
+                result.rightPaddleHits++;
+                break;
+            }
+            case Contact::None:
+                break;
+        }
+        lastContact = contact;
+
+        if (stopAtContact) {
+            break;
+        }
+        if (++bounces >= MAX_BOUNCES) {
+            // Pathological step: finish it without further contacts
+            float rest = duration - elapsed;
+            ball.x += ball.vx * rest;
+            ball.y += ball.vy * rest;
+            elapsed = duration;
+            result.bounceLimited = true;
+            break;
+        }
+    }
+
+    // Safety net for the corner cases the sweep can't see (e.g. starting outside the field)
+    if (ball.y + r > field.top) ball.y = field.top - r;
+    if (ball.y - r < field.bottom) ball.y = field.bottom + r;
+    if (!right && ball.x + r > field.right) ball.x = field.right - r;
+
+    result.elapsed = elapsed < duration ? elapsed : duration;
+    result.missed = ball.x + r < field.missX;
+    result.missedRight = right && ball.x - r > -field.missX;
+    return result;
+}
+
+} // namespace
+
+SweepResult sweepBall(SweptBall& ball, float duration, const SweptPaddle& paddle, const Playfield& field) {
+    return sweep(ball, duration, paddle, nullptr, field, false);
+}
+
+SweepResult sweepBallToContact(SweptBall& ball, float duration, const SweptPaddle& paddle, const Playfield& field) {
+    return sweep(ball, duration, paddle, nullptr, field, true);
+}
+
+SweepResult sweepBallVersus(SweptBall& ball, float duration, const SweptPaddle& left,
+                            const SweptPaddle& right, const Playfield& field) {
+    return sweep(ball, duration, left, &right, field, false);
+}
+
+} // namespace LidPong
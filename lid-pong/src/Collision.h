@@ -0,0 +1,74 @@
+#pragma once
+
+namespace LidPong {
+
+// Playfield edges as used by the game (normalised device coordinates)
+struct Playfield {
+    float top;    // Ball bounces when y + r reaches this
+    float bottom; // ... or y - r reaches this
+    float right;  // ... or x + r reaches this
+    float missX;  // Ball is lost once x + r is left of this
+
+    static Playfield standard() {
+        Playfield field = {0.95f, -0.95f, 0.98f, -1.0f};
+        return field;
+    }
+};
+
+// Paddle spin: a hit adds this much vy per unit of offset from the paddle
+// centre, then vy is clamped to +/- MAX_BALL_VY
+const float PADDLE_SPIN = 1.5f;
+const float MAX_BALL_VY = 1.2f;
+
+// Paddle for one step; it moves linearly from startY to endY during the step
+struct SweptPaddle {
+    float x;
+    float startY, endY;
+    float halfWidth, halfHeight;
+};
+
+struct SweptBall {
+    float x, y;
+    float vx, vy;
+    float radius;
+};
+
+struct SweepResult {
+    int paddleHits;
+    int wallBounces;
+    bool missed;        // Ball ended the step past missX
+    bool bounceLimited; // Ran out of bounces before the step was consumed
+    int rightPaddleHits; // Versus only
+    bool missedRight;    // Versus only: ball ended the step past -missX
+    float elapsed;       // Time swept: all of 'duration' unless it stopped at a contact
+};
+
+// Continuous collision for one simulation step of 'duration' (already scaled
+// by the speed multiplier). The ball is swept against the walls and the
+// moving paddle; at each time of impact it is advanced to the contact,
+// the bounce is applied and the rest of the step continues from there, so
+// nothing is tunnelled through however large the step is.
+//
+// The paddle response matches the original discrete rules: it only reacts
+// while the ball moves towards it (vx < 0), sends it right and adds spin
+// from the hit position, clamped to +-1.2.
+SweepResult sweepBall(SweptBall& ball, float duration, const SweptPaddle& paddle, const Playfield& field);
+
+// The same, but stops right after the first wall or paddle bounce, with
+// result.elapsed the time of that contact. For callers with more to test
+// along the new path (e.g. bricks), which then sweep the rest of the step.
+SweepResult sweepBallToContact(SweptBall& ball, float duration, const SweptPaddle& paddle, const Playfield& field);
+
+// Two-player variant: a second paddle on the right replaces the right wall
+// and mirrors the left paddle's response, and the ball can be lost on
+// either side (field.missX on the left, -field.missX on the right).
+SweepResult sweepBallVersus(SweptBall& ball, float duration, const SweptPaddle& left,
+                            const SweptPaddle& right, const Playfield& field);
+
+// Time of first contact in [0, maxT] between a moving point and an axis
+// aligned box given as min/max corners, or a negative value if none.
+// Returns 0 when the point starts inside the box.
+float rayBoxTimeOfImpact(float px, float py, float dx, float dy,
+                         float minX, float minY, float maxX, float maxY, float maxT);
+
+} // namespace LidPong
@@ -0,0 +1,104 @@
+#include "Controller.h"
+#include "Collision.h"
+#include <cmath>
+
+namespace LidPong {
+
+BotController::BotController(const BotOptions& options)
+    : m_options(options)
+    , m_random(options.seed)
+    , m_seenFront(0)
+    , m_time(0.0)
+    , m_aimError(0.0f)
+    , m_wasApproaching(false) {
+    m_seen.reserve(256); // Enough for the default delay at well over 1000 Hz
+}
+
+void BotController::reset() {
+    m_seen.clear();
+    m_seenFront = 0;
+    m_time = 0.0;
+    m_aimError = 0.0f;
+    m_wasApproaching = false;
+}
+
+double BotController::lidPosition(const Simulation& sim, float deltaTime) {
+    m_time += deltaTime;
+    m_seen.push_back(look(sim));
+
+    // Act on the newest sighting that is at least reactionDelay old
+    while (m_seen.size() - m_seenFront > 1 && m_seen[m_seenFront + 1].time <= m_time - m_options.reactionDelay) {
+        m_seenFront++;
+    }
+    if (m_seenFront * 2 >= m_seen.size()) {
+        m_seen.erase(m_seen.begin(), m_seen.begin() + m_seenFront);
+        m_seenFront = 0;
+    }
+    const Sighting& ball = m_seen[m_seenFront];
+
+    float targetY = 0.0f; // Nothing coming: wait in the middle
+    bool approaching = ball.valid && ball.vx < 0.0f;
+    if (approaching) {
+        // New aiming error for every approach, up to 'noise' paddle heights
+        if (!m_wasApproaching) {
+            float spread = static_cast<float>(m_options.noise) * sim.slider().height;
+            m_aimError = (m_random.unit() + m_random.unit() - 1.0f) * spread;
+        }
+        targetY = interceptY(ball, sim) + m_aimError;
+    }
+    m_wasApproaching = approaching;
+
+    // Inverse of Slider::update's lid-to-screen mapping
+    const GameParams& params = sim.params();
+    double lid = targetY / (static_cast<double>(params.sliderSensitivity) * params.sliderReach) + 0.5;
+    return lid < 0.0 ? 0.0 : (lid > 1.0 ? 1.0 : lid);
+}
+
+// The ball reaching the paddle line first
+BotController::Sighting BotController::look(const Simulation& sim) const {
+    Sighting best = {m_time, 0.0f, 0.0f, 0.0f, 0.0f, false};
+    float bestTime = 1e30f;
+    float paddleX = sim.slider().x;
+
+    auto consider = [&](float x, float y, float vx, float vy) {
+        float time = vx < 0.0f ? (x - paddleX) / -vx : 1e20f + x; // Receding balls last
+        if (time < bestTime) {
+            bestTime = time;
+            best.x = x;
+            best.y = y;
+            best.vx = vx;
+            best.vy = vy;
+            best.valid = true;
+        }
+    };
+
+    if (sim.isBrickMode()) {
+        for (const SweptBall& b : sim.brickBalls()) {
+            consider(b.x, b.y, b.vx, b.vy);
+        }
+    } else if (sim.isMultiBall()) {
+        const BallSwarm& swarm = sim.swarm();
+        for (size_t i = 0; i < swarm.size(); i++) {
+            consider(swarm.x()[i], swarm.y()[i], swarm.vx()[i], swarm.vy()[i]);
+        }
+    } else if (sim.ball().active) {
+        const Ball& b = sim.ball();
+        consider(b.x, b.y, b.vx, b.vy);
+    }
+    return best;
+}
+
+// Where the ball crosses the paddle line, folding wall bounces back in
+float BotController::interceptY(const Sighting& ball, const Simulation& sim) const {
+    const Playfield field = Playfield::standard();
+    float time = (ball.x - sim.slider().x) / -ball.vx;
+    float y = ball.y + ball.vy * time;
+
+    float low = field.bottom, high = field.top;
+    float span = high - low;
+    float offset = std::fmod(y - low, 2.0f * span);
+    if (offset < 0.0f) offset += 2.0f * span;
+    return offset <= span ? low + offset : high - (offset - span);
+}
+
+} // namespace LidPong
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "Random.h"
+#include "Simulation.h"
+#include <cstdint>
+#include <vector>
+
+namespace LidPong {
+
+// Source of the paddle's lid position, polled before each simulation step
+class Controller {
+public:
+    virtual ~Controller() {}
+
+    virtual const char* name() const = 0;
+
+    // Lid position (0..1) to play on the coming step of 'sim'
+    virtual double lidPosition(const Simulation& sim, float deltaTime) = 0;
+
+    // Called when 'sim' starts a new game
+    virtual void reset() {}
+};
+
+struct BotOptions {
+    double reactionDelay; // Seconds between the bot seeing the ball and acting on it
+    double noise;         // Largest aiming error, in paddle heights (above 0.5 it can miss)
+    uint64_t seed;
+
+    BotOptions() : reactionDelay(0.08), noise(1.0), seed(7) {}
+};
+
+// Tracking AI: predicts where the most urgent ball crosses the paddle line,
+// bouncing off the walls, and moves there. It acts on what it saw
+// reactionDelay seconds ago and aims with some random error, so it does miss.
+class BotController : public Controller {
+public:
+    explicit BotController(const BotOptions& options = BotOptions());
+
+    const char* name() const override { return "bot"; }
+    double lidPosition(const Simulation& sim, float deltaTime) override;
+    void reset() override;
+
+private:
+    struct Sighting {
+        double time;
+        float x, y, vx, vy;
+        bool valid;
+    };
+
+    Sighting look(const Simulation& sim) const;
+    float interceptY(const Sighting& ball, const Simulation& sim) const;
+
+    BotOptions m_options;
+    Random m_random;
+    // Sightings younger than the reaction delay, from m_seenFront on. Dropped
+    // ones are erased in batches so the storage settles and stops reallocating.
+    std::vector<Sighting> m_seen;
+    size_t m_seenFront;
+    double m_time;
+    float m_aimError;
+    bool m_wasApproaching;
+};
+
+} // namespace LidPong
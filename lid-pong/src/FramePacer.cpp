@@ -0,0 +1,153 @@
+#include "FramePacer.h"
+#include "Clock.h"
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <thread>
+
+namespace LidPong {
+
+namespace {
+    const double EMA_ALPHA = 0.1;
+    const double WORK_DEVIATIONS = 3.0;      // Safety margin on the work estimate
+    const int64_t MIN_WORK_NS = 500000;      // Never plan for less than 0.5 ms of work
+    const double MISS_TOLERANCE = 0.5;       // Fraction of a period before a frame counts as late
+}
+
+FramePacer::FramePacer(const FramePacingOptions& options)
+    : m_options(options)
+    , m_fixedPeriodNs(options.targetFps > 0.0 ? static_cast<int64_t>(1.0e9 / options.targetFps) : 0)
+    , m_spinMarginNs(static_cast<int64_t>(options.spinMarginMs * 1.0e6))
+    , m_nextDeadlineNs(0)
+    , m_frameStartNs(0)
+    , m_submitNs(0)
+    , m_lastFrameEndNs(0)
+    , m_measuredPeriodNs(0.0)
+    , m_workMeanNs(0.0)
+    , m_workDevNs(0.0)
+    , m_frames(0)
+    , m_missedDeadlines(0) {
+}
+
+int64_t FramePacer::periodNs() const {
+    if (m_fixedPeriodNs > 0) {
+        return m_fixedPeriodNs;
+    }
+    return m_options.vsync ? static_cast<int64_t>(m_measuredPeriodNs) : 0;
+}
+
+int64_t FramePacer::workEstimateNs() const {
+    int64_t estimate = static_cast<int64_t>(m_workMeanNs + WORK_DEVIATIONS * m_workDevNs);
+    return estimate < MIN_WORK_NS ? MIN_WORK_NS : estimate;
+}
+
+void FramePacer::waitUntil(int64_t deadlineNs, int64_t spinMarginNs) {
+    int64_t now = Clock::nowNs();
+    if (deadlineNs - now > spinMarginNs) {
+        std::this_thread::sleep_for(std::chrono::nanoseconds(deadlineNs - now - spinMarginNs));
+    }
+    while (Clock::nowNs() < deadlineNs) {
+        std::this_thread::yield();
+    }
+}
+
+void FramePacer::beginFrame() {
+    int64_t period = periodNs();
+
+    // Late input: start as late as we dare so the sample is fresh at render time
+    if (m_options.lateInput && period > 0 && m_lastFrameEndNs != 0) {
+        int64_t deadline = m_fixedPeriodNs > 0 ? m_nextDeadlineNs : m_lastFrameEndNs + period;
+        int64_t start = deadline - workEstimateNs();
+        int64_t before = Clock::nowNs();
+        if (start > before) {
+            waitUntil(start, m_spinMarginNs);
+            m_waitTimes.record(Clock::nsToMs(Clock::nowNs() - before));
+        }
+    }
+
+    m_frameStartNs = Clock::nowNs();
+}
+
+void FramePacer::markSubmit() {
+    m_submitNs = Clock::nowNs();
+
+    double work = static_cast<double>(m_submitNs - m_frameStartNs);
+    if (m_frames == 0) {
+        m_workMeanNs = work;
+    } else {
+        m_workDevNs += EMA_ALPHA * (std::abs(work - m_workMeanNs) - m_workDevNs);
+        m_workMeanNs += EMA_ALPHA * (work - m_workMeanNs);
+    }
+}
+
+void FramePacer::endFrame() {
+    int64_t now = Clock::nowNs();
+
+    // Frame limiter without late input: wait out the rest of the period here
+    if (m_fixedPeriodNs > 0 && !m_options.lateInput && m_nextDeadlineNs != 0 && now < m_nextDeadlineNs) {
+        waitUntil(m_nextDeadlineNs, m_spinMarginNs);
+        m_waitTimes.record(Clock::nsToMs(Clock::nowNs() - now));
+        now = Clock::nowNs();
+    }
+
+    if (m_lastFrameEndNs != 0) {
+        int64_t interval = now - m_lastFrameEndNs;
+        m_frameTimes.record(Clock::nsToMs(interval));
+
+        if (m_measuredPeriodNs == 0.0) {
+            m_measuredPeriodNs = static_cast<double>(interval);
+        } else {
+            m_measuredPeriodNs += EMA_ALPHA * (interval - m_measuredPeriodNs);
+        }
+
+        int64_t period = periodNs();
+        if (m_fixedPeriodNs > 0 && m_nextDeadlineNs != 0) {
+            if (now > m_nextDeadlineNs + static_cast<int64_t>(period * MISS_TOLERANCE)) {
+                m_missedDeadlines++;
+            }
+        } else if (period > 0 && interval > period + static_cast<int64_t>(period * MISS_TOLERANCE)) {
+            m_missedDeadlines++;
+        }
+    }
+
+    // Advance the deadline; if we fell more than a frame behind, re-anchor instead of bursting
+    if (m_fixedPeriodNs > 0) {
+        if (m_nextDeadlineNs == 0 || now - m_nextDeadlineNs > m_fixedPeriodNs) {
+            m_nextDeadlineNs = now + m_fixedPeriodNs;
+        } else {
+            m_nextDeadlineNs += m_fixedPeriodNs;
+        }
+    }
+
+    m_lastFrameEndNs = now;
+    m_frames++;
+}
+
+void FramePacer::resume() {
+    m_lastFrameEndNs = 0;
+    m_nextDeadlineNs = 0;
+}
+
+void FramePacer::report(std::ostream& out) const {
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+
+    out << "Frame pacing: " << (m_options.vsync ? "vsync" : "no vsync");
+    if (m_fixedPeriodNs > 0) {
+        out << ", target " << std::fixed << std::setprecision(1) << m_options.targetFps << " FPS";
+    }
+    out << (m_options.lateInput ? ", late input" : "") << std::endl;
+
+    m_frameTimes.report(out, "Frame time");
+    out << "Frame time mean=" << std::fixed << std::setprecision(3) << m_frameTimes.mean()
+        << " stddev=" << m_frameTimes.stddev() << " ms"
+        << " | missed deadlines: " << m_missedDeadlines << "/" << m_frames << std::endl;
+    if (m_waitTimes.totalCount() > 0) {
+        m_waitTimes.report(out, "Pacing wait");
+    }
+
+    out.flags(flags);
+    out.precision(precision);
+}
+
+} // namespace LidPong
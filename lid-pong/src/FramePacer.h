@@ -0,0 +1,67 @@
+#pragma once
+
+#include "LatencyStats.h"
+#include <cstdint>
+#include <ostream>
+
+namespace LidPong {
+
+struct FramePacingOptions {
+    double targetFps;    // Frame limiter rate, 0 = no limiter
+    bool vsync;          // glfwSwapInterval(1) vs (0)
+    bool lateInput;      // Delay the start of each frame so input is sampled just before render
+    double spinMarginMs; // Sleep until this close to a deadline, then spin
+
+    FramePacingOptions() : targetFps(0.0), vsync(true), lateInput(false), spinMarginMs(1.5) {}
+};
+
+// Frame limiter and just-in-time scheduler for the main loop.
+//
+// Per frame the loop calls beginFrame() before polling input, markSubmit()
+// right before glfwSwapBuffers() and endFrame() after it returns. Without
+// late input the pacer waits after the swap for the next deadline; with late
+// input it instead waits at the start of the frame until "deadline minus
+// expected work", so the input is as fresh as possible when the frame is drawn.
+class FramePacer {
+public:
+    explicit FramePacer(const FramePacingOptions& options);
+
+    void beginFrame();
+    void markSubmit();
+    void endFrame();
+
+    // After the loop has slept (idle): forget the last frame's timing so the
+    // gap is neither a slow frame nor a missed deadline
+    void resume();
+
+    // Frame period in ns, either from targetFps or measured from vsync (0 if unknown)
+    int64_t periodNs() const;
+
+    void report(std::ostream& out) const;
+
+    // Hybrid wait: coarse sleep until spinMarginNs before the deadline, then spin
+    static void waitUntil(int64_t deadlineNs, int64_t spinMarginNs);
+
+private:
+    int64_t workEstimateNs() const;
+
+    FramePacingOptions m_options;
+    int64_t m_fixedPeriodNs;
+    int64_t m_spinMarginNs;
+
+    int64_t m_nextDeadlineNs;  // When the current frame should finish
+    int64_t m_frameStartNs;
+    int64_t m_submitNs;
+    int64_t m_lastFrameEndNs;
+
+    double m_measuredPeriodNs; // EMA of frame intervals, used when vsync sets the pace
+    double m_workMeanNs;       // EMA of begin -> submit time
+    double m_workDevNs;        // EMA of its absolute deviation
+
+    uint64_t m_frames;
+    uint64_t m_missedDeadlines;
+    LatencyStats m_frameTimes;
+    LatencyStats m_waitTimes;
+};
+
+} // namespace LidPong
@@ -0,0 +1,379 @@
+#include "GameParams.h"
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#else
+#include <sys/event.h>
+#endif
+
+namespace LidPong {
+
+namespace {
+
+struct ParamField {
+    const char* name;
+    float GameParams::*member;
+    float low, high; // Inclusive
+    const char* help;
+};
+
+const ParamField FIELDS[] = {
+    {"slider_sensitivity", &GameParams::sliderSensitivity, 0.1f, 100.0f, "Lid travel to slider travel"},
+    {"slider_reach", &GameParams::sliderReach, 0.05f, 1.0f, "Furthest the slider goes from the middle, 1 = the screen edge"},
+    {"slider_speed", &GameParams::sliderSpeed, 0.1f, 1000.0f, "How fast the slider catches up with the lid, per second"},
+    {"ball_speed_x", &GameParams::ballSpeedX, 0.05f, 10.0f, "Serve velocity across, before the speed multiplier"},
+    {"ball_speed_y", &GameParams::ballSpeedY, 0.0f, 10.0f, "Serve velocity up or down"},
+    {"min_angle", &GameParams::minAngle, 0.0f, 360.0f, "Lid angle (degrees) for the slider at the bottom"},
+    {"max_angle", &GameParams::maxAngle, 0.0f, 360.0f, "Lid angle (degrees) for the slider at the top"},
+};
+
+const size_t MAX_REPORTS = 16; // Unread reports beyond this drop the oldest
+
+std::string trim(const std::string& s) {
+    size_t first = s.find_first_not_of(" \t\r");
+    if (first == std::string::npos) return std::string();
+    size_t last = s.find_last_not_of(" \t\r");
+    return s.substr(first, last - first + 1);
+}
+
+std::string formatValue(float value) {
+    std::ostringstream out;
+    out << value;
+    return out.str();
+}
+
+std::string systemError(const std::string& what) {
+    return what + ": " + std::strerror(errno);
+}
+
+} // namespace
+
+const GameParams& GameParams::defaults() {
+    static const GameParams params;
+    return params;
+}
+
+bool GameParams::operator==(const GameParams& other) const {
+    for (const ParamField& field : FIELDS) {
+        if (this->*field.member != other.*field.member) return false;
+    }
+    return true;
+}
+
+bool parseGameParams(const std::string& text, GameParams& out, std::string& error) {
+    GameParams params;
+    std::istringstream in(text);
+    std::string line;
+    for (int lineNumber = 1; std::getline(in, line); lineNumber++) {
+        line = trim(line.substr(0, line.find('#')));
+        if (line.empty()) continue;
+
+        size_t equals = line.find('=');
+        if (equals == std::string::npos) {
+            error = "line " + std::to_string(lineNumber) + ": expected name = value";
+            return false;
+        }
+        std::string name = trim(line.substr(0, equals));
+        std::string value = trim(line.substr(equals + 1));
+        const ParamField* field = nullptr;
+        for (const ParamField& f : FIELDS) {
+            if (name == f.name) field = &f;
+        }
+        if (!field) {
+            error = "line " + std::to_string(lineNumber) + ": unknown parameter '" + name + "'";
+            return false;
+        }
+
+        char* end = nullptr;
+        float number = std::strtof(value.c_str(), &end);
+        if (value.empty() || *end != '\0' || !std::isfinite(number)) {
+            error = "line " + std::to_string(lineNumber) + ": " + name + " needs a number, not '" + value + "'";
+            return false;
+        }
+        if (number < field->low || number > field->high) {
+            error = "line " + std::to_string(lineNumber) + ": " + name + " must be " + formatValue(field->low) +
+                    " to " + formatValue(field->high);
+            return false;
+        }
+        params.*field->member = number;
+    }
+    if (params.minAngle >= params.maxAngle) {
+        error = "min_angle must be below max_angle";
+        return false;
+    }
+    out = params;
+    return true;
+}
+
+bool loadGameParams(const std::string& path, GameParams& out, std::string& error) {
+    std::ifstream in(path);
+    if (!in) {
+        error = "cannot open " + path;
+        return false;
+    }
+    std::ostringstream text;
+    text << in.rdbuf();
+    if (!parseGameParams(text.str(), out, error)) {
+        error = path + ": " + error;
+        return false;
+    }
+    return true;
+}
+
+std::string formatGameParams(const GameParams& params) {
+    std::ostringstream out;
+    out << "# Lid Pong params: edit while the game runs (--params FILE), saves apply at once" << std::endl;
+    for (const ParamField& field : FIELDS) {
+        out << std::endl << "# " << field.help << " (" << formatValue(field.low) << " to " << formatValue(field.high) << ")"
+            << std::endl << field.name << " = " << formatValue(params.*field.member) << std::endl;
+    }
+    return out.str();
+}
+
+std::string describeParamChanges(const GameParams& from, const GameParams& to) {
+    std::string changes;
+    for (const ParamField& field : FIELDS) {
+        if (from.*field.member != to.*field.member) {
+            changes += (changes.empty() ? "" : ", ") + std::string(field.name) + " " + formatValue(from.*field.member) +
+                       " -> " + formatValue(to.*field.member);
+        }
+    }
+    return changes;
+}
+
+ParamStore::ParamStore()
+    : m_current(&GameParams::defaults())
+    , m_version(0)
+    , m_changed(nullptr)
+    , m_watchFd(-1)
+    , m_directoryFd(-1)
+    , m_stopPipe{-1, -1}
+    , m_reloads(0)
+    , m_rejected(0) {
+}
+
+ParamStore::~ParamStore() {
+    stopWatching();
+}
+
+bool ParamStore::load(const std::string& path, std::string& error) {
+    GameParams params;
+    if (!loadGameParams(path, params, error)) {
+        return false;
+    }
+    m_path = path;
+    publish(params);
+    return true;
+}
+
+void ParamStore::publish(const GameParams& params) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_snapshots.emplace_back(new GameParams(params));
+    m_current.store(m_snapshots.back().get(), std::memory_order_release);
+    m_version.fetch_add(1, std::memory_order_release);
+}
+
+bool ParamStore::takeReport(std::string& message) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_reports.empty()) {
+        return false;
+    }
+    message = m_reports.front();
+    m_reports.pop_front();
+    return true;
+}
+
+void ParamStore::report(const std::string& message) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_reports.size() >= MAX_REPORTS) {
+            m_reports.pop_front();
+        }
+        m_reports.push_back(message);
+    }
+    if (m_changed) {
+        m_changed();
+    }
+}
+
+// Unchanged saves (and events for a save already read) publish nothing
+void ParamStore::reload() {
+    GameParams params;
+    std::string error;
+    if (!loadGameParams(m_path, params, error)) {
+        report("Params: " + error + ", keeping the current values");
+        m_rejected.fetch_add(1, std::memory_order_release); // After the report, for anyone waiting on the count
+        return;
+    }
+    std::string changes = describeParamChanges(current(), params);
+    if (changes.empty()) {
+        return;
+    }
+    publish(params);
+    report("Params v" + std::to_string(version()) + ": " + changes);
+    m_reloads.fetch_add(1, std::memory_order_release);
+}
+
+// The directory is watched rather than the file, so editors that save by
+// renaming a new file over the old one are seen too
+bool ParamStore::watch(void (*changed)(), std::string& error) {
+    if (m_path.empty()) {
+        error = "no params file loaded";
+        return false;
+    }
+    if (m_thread.joinable()) {
+        error = "already watching " + m_path;
+        return false;
+    }
+    size_t slash = m_path.rfind('/');
+    std::string directory = slash == std::string::npos ? "." : (slash == 0 ? "/" : m_path.substr(0, slash));
+    if (pipe(m_stopPipe) != 0) {
+        m_stopPipe[0] = m_stopPipe[1] = -1;
+        error = systemError("cannot create a pipe");
+        return false;
+    }
+#ifdef __linux__
+    m_watchFd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+    if (m_watchFd < 0 || inotify_add_watch(m_watchFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_ONLYDIR) < 0) {
+        error = systemError("cannot watch " + directory);
+        closeWatch();
+        return false;
+    }
+#else
+#ifdef O_EVTONLY
+    m_directoryFd = open(directory.c_str(), O_EVTONLY | O_CLOEXEC);
+#else
+    m_directoryFd = open(directory.c_str(), O_RDONLY | O_CLOEXEC);
+#endif
+    m_watchFd = kqueue();
+    struct kevent changes[2];
+    EV_SET(&changes[0], m_directoryFd, EVFILT_VNODE, EV_ADD | EV_CLEAR, NOTE_WRITE, 0, nullptr);
+    EV_SET(&changes[1], m_stopPipe[0], EVFILT_READ, EV_ADD, 0, 0, nullptr);
+    if (m_directoryFd < 0 || m_watchFd < 0 || kevent(m_watchFd, changes, 2, nullptr, 0, nullptr) < 0) {
+        error = systemError("cannot watch " + directory);
+        closeWatch();
+        return false;
+    }
+#endif
+    m_changed = changed;
+    m_thread = std::thread(&ParamStore::threadMain, this);
+    return true;
+}
+
+void ParamStore::stopWatching() {
+    if (m_thread.joinable()) {
+        char byte = 0;
+        while (write(m_stopPipe[1], &byte, 1) < 0 && errno == EINTR) {
+        }
+        m_thread.join();
+    }
+    closeWatch();
+}
+
+void ParamStore::closeWatch() {
+    for (int* fd : {&m_watchFd, &m_directoryFd, &m_stopPipe[0], &m_stopPipe[1]}) {
+        if (*fd >= 0) {
+            close(*fd);
+            *fd = -1;
+        }
+    }
+}
+
+#ifdef __linux__
+
+void ParamStore::threadMain() {
+    const std::string name = m_path.substr(m_path.rfind('/') + 1);
+    reload(); // Catch a save made between load() and the watch starting
+
+    pollfd fds[2] = {{m_watchFd, POLLIN, 0}, {m_stopPipe[0], POLLIN, 0}};
+    for (;;) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (fds[1].revents != 0) {
+            break;
+        }
+        // A save shows up as IN_CLOSE_WRITE (written in place) or IN_MOVED_TO
+        // (renamed over); either way the file is complete by then
+        alignas(inotify_event) char buffer[4096];
+        bool saved = false;
+        ssize_t bytes;
+        while ((bytes = read(m_watchFd, buffer, sizeof(buffer))) > 0) {
+            for (char* p = buffer; p < buffer + bytes;) {
+                const inotify_event* event = reinterpret_cast<const inotify_event*>(p);
+                if (event->len > 0 && name == event->name) {
+                    saved = true;
+                }
+                p += sizeof(inotify_event) + event->len;
+            }
+        }
+        if (saved) {
+            reload();
+        }
+    }
+}
+
+#else
+
+// kqueue has no close-after-write event: changes are reported as the bytes
+// land, so wait for the writes to settle before reading the file
+void ParamStore::threadMain() {
+    int fileFd = -1;
+    auto watchFile = [&]() {
+        if (fileFd >= 0) {
+            close(fileFd); // Drops its event too
+        }
+#ifdef O_EVTONLY
+        fileFd = open(m_path.c_str(), O_EVTONLY | O_CLOEXEC);
+#else
+        fileFd = open(m_path.c_str(), O_RDONLY | O_CLOEXEC);
+#endif
+        if (fileFd >= 0) {
+            struct kevent change;
+            EV_SET(&change, fileFd, EVFILT_VNODE, EV_ADD | EV_CLEAR,
+                   NOTE_WRITE | NOTE_EXTEND | NOTE_ATTRIB | NOTE_DELETE | NOTE_RENAME, 0, nullptr);
+            kevent(m_watchFd, &change, 1, nullptr, 0, nullptr);
+        }
+    };
+    watchFile();
+    reload();
+
+    const struct timespec settle = {0, 5000000};
+    const struct timespec noWait = {0, 0};
+    for (bool stop = false; !stop;) {
+        struct kevent events[8];
+        int count = kevent(m_watchFd, nullptr, 0, events, 8, nullptr);
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        // Fold everything that arrives within the settle time into one reload
+        while (count > 0 && !stop) {
+            for (int i = 0; i < count; i++) {
+                stop = stop || static_cast<int>(events[i].ident) == m_stopPipe[0];
+            }
+            nanosleep(&settle, nullptr);
+            count = kevent(m_watchFd, nullptr, 0, events, 8, &noWait);
+        }
+        if (!stop) {
+            watchFile(); // A rename may have put a new file at the path
+            reload();
+        }
+    }
+    if (fileFd >= 0) {
+        close(fileFd);
+    }
+}
+
+#endif
+
+} // namespace LidPong
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace LidPong {
+
+// Gameplay numbers that can be tuned from a params file while the game runs.
+// The defaults are the values the game has always played with.
+struct GameParams {
+    float sliderSensitivity; // Lid travel from the middle is scaled by this...
+    float sliderReach;       // ...and by this, then clamped to +/- sliderReach
+    float sliderSpeed;       // How fast the slider closes in on its target, per second
+    float ballSpeedX;        // Serve velocity, before the speed multiplier
+    float ballSpeedY;
+    float minAngle;          // Lid angle (degrees) for the slider at the bottom
+    float maxAngle;          // Lid angle (degrees) for the slider at the top
+
+    GameParams() : sliderSensitivity(4.0f), sliderReach(0.85f), sliderSpeed(12.0f), ballSpeedX(0.8f), ballSpeedY(0.6f), minAngle(0.0f), maxAngle(180.0f) {}
+
+    static const GameParams& defaults();
+
+    bool operator==(const GameParams& other) const;
+    bool operator!=(const GameParams& other) const { return !(*this == other); }
+};
+
+// "name = value" lines, '#' starts a comment. Names left out keep their
+// default; unknown names and out-of-range values are errors.
+bool parseGameParams(const std::string& text, GameParams& out, std::string& error);
+bool loadGameParams(const std::string& path, GameParams& out, std::string& error);
+
+// A params file holding 'params', every name with its range
+std::string formatGameParams(const GameParams& params);
+
+// "slider_speed 12 -> 20, ball_speed_x 0.8 -> 1" (empty if nothing differs)
+std::string describeParamChanges(const GameParams& from, const GameParams& to);
+
+// The current GameParams as an immutable snapshot behind an atomic pointer.
+// Readers (the simulation every tick, the input thread every sample) take no
+// lock; a publish swaps in a new snapshot. Replaced snapshots are kept until
+// the store goes, so a reference from current() stays valid.
+class ParamStore {
+public:
+    ParamStore();
+    ~ParamStore();
+
+    ParamStore(const ParamStore&) = delete;
+    ParamStore& operator=(const ParamStore&) = delete;
+
+    // Parses the file and publishes it; on error nothing changes
+    bool load(const std::string& path, std::string& error);
+
+    // Reloads the loaded file on a thread of its own each time it is saved,
+    // in place or renamed over, and calls 'changed' on that thread after
+    // each reload or rejected file (e.g. glfwPostEmptyEvent to wake the main
+    // loop). A file that doesn't parse is reported and the current
+    // params stay.
+    bool watch(void (*changed)(), std::string& error);
+    void stopWatching();
+
+    void publish(const GameParams& params);
+
+    const GameParams& current() const { return *m_current.load(std::memory_order_acquire); }
+    uint64_t version() const { return m_version.load(std::memory_order_acquire); } // 1 after the first publish
+
+    // Next message about a reload or a rejected file, for the main thread to print
+    bool takeReport(std::string& message);
+
+    // Counted once the report is queued
+    uint64_t reloads() const { return m_reloads.load(std::memory_order_acquire); }
+    uint64_t rejected() const { return m_rejected.load(std::memory_order_acquire); }
+
+private:
+    void threadMain();
+    void reload();
+    void report(const std::string& message);
+    void closeWatch();
+
+    std::atomic<const GameParams*> m_current;
+    std::atomic<uint64_t> m_version;
+    std::mutex m_mutex; // Publishers and reports; readers never take it
+    std::vector<std::unique_ptr<const GameParams>> m_snapshots; // A few bytes per edit
+    std::deque<std::string> m_reports;
+    std::string m_path;
+    void (*m_changed)();
+    std::thread m_thread;
+    int m_watchFd;     // inotify instance (Linux) or kqueue
+    int m_directoryFd; // kqueue only: the file's directory, for renames into it
+    int m_stopPipe[2]; // Written to end the watcher's wait
+    std::atomic<uint64_t> m_reloads;
+    std::atomic<uint64_t> m_rejected;
+};
+
+} // namespace LidPong
@@ -0,0 +1,106 @@
+// Entry point of lid-pong-headless ("make headless"): the benchmarks, replay
+// verification, frame dumps and trace analysis without a window, GL or the
+// lid sensor, for CI machines with no GPU or display. The game itself is
+// LidPong.cpp's main().
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include "Bench.h"
+#include "Recording.h"
+#include "Scene.h"
+#include "TraceAnalytics.h"
+
+static void printUsage(const char* program) {
+    std::cout << "Usage: " << program << " [options]" << std::endl;
+    std::cout << "  --bench NAME   Run a benchmark and exit (the names are as in lid-pong --help)" << std::endl;
+    std::cout << "                 --balls N sets the ball count for 'balls', the game count for 'envs' and 'scores'" << std::endl;
+    std::cout << "                 and the particle count for 'particles'" << std::endl;
+    std::cout << "                 --replay FILE gives 'gestures' a recorded session" << std::endl;
+    std::cout << "                 --analyze PATH runs 'traces' on those traces instead of a synthetic corpus" << std::endl;
+    std::cout << "                 --golden DIR compares 'render' frames with DIR/<scene>.ppm" << std::endl;
+    std::cout << "  --replay FILE  Run a recording as fast as possible and verify its final state" << std::endl;
+    std::cout << "  --dump-frames DIR  With --replay: render every frame in software to DIR" << std::endl;
+    std::cout << "  --dump-format F    png (default) or ppm" << std::endl;
+    std::cout << "  --frame-size WxH   Software-rendered frame size (default 800x600)" << std::endl;
+    std::cout << "  --analyze PATH Report on the angle traces in PATH (a file or a directory, searched" << std::endl;
+    std::cout << "                 recursively; may be repeated) and exit" << std::endl;
+    std::cout << "  --threads N    Threads for --analyze (default: one per core)" << std::endl;
+    std::cout << "  --gap-ms MS    --analyze: longer sample intervals are dropouts (default 4 sample periods)" << std::endl;
+    std::cout << "  --help         Show this help message" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    std::string benchmark, replayFile, frameDumpDir;
+    LidPong::Bench::Options bench;
+    LidPong::ImageFormat frameDumpFormat = LidPong::ImageFormat::Png;
+    LidPong::TraceAnalyzeOptions analyze;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--bench" && i + 1 < argc) {
+            benchmark = argv[++i];
+        } else if (arg == "--balls" && i + 1 < argc) {
+            bench.count = static_cast<size_t>(std::atol(argv[++i]));
+        } else if (arg == "--golden" && i + 1 < argc) {
+            bench.goldenDirectory = argv[++i];
+        } else if (arg == "--replay" && i + 1 < argc) {
+            replayFile = argv[++i];
+        } else if (arg == "--headless") {
+            // Always; accepted so lid-pong command lines work unchanged
+        } else if (arg == "--dump-frames" && i + 1 < argc) {
+            frameDumpDir = argv[++i];
+        } else if (arg == "--dump-format" && i + 1 < argc) {
+            std::string format = argv[++i];
+            if (format != "png" && format != "ppm") {
+                std::cerr << "--dump-format must be png or ppm" << std::endl;
+                return -1;
+            }
+            frameDumpFormat = format == "png" ? LidPong::ImageFormat::Png : LidPong::ImageFormat::Ppm;
+        } else if (arg == "--frame-size" && i + 1 < argc) {
+            if (std::sscanf(argv[++i], "%dx%d", &bench.frameWidth, &bench.frameHeight) != 2 ||
+                bench.frameWidth <= 0 || bench.frameHeight <= 0) {
+                std::cerr << "--frame-size needs WIDTHxHEIGHT" << std::endl;
+                return -1;
+            }
+        } else if (arg == "--analyze" && i + 1 < argc) {
+            bench.tracePaths.push_back(argv[++i]);
+        } else if (arg == "--threads" && i + 1 < argc) {
+            analyze.threads = static_cast<size_t>(std::max(0, std::atoi(argv[++i])));
+        } else if (arg == "--gap-ms" && i + 1 < argc) {
+            analyze.gapMs = std::atof(argv[++i]);
+        } else if (arg == "--help" || arg == "-h") {
+            printUsage(argv[0]);
+            return 0;
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            printUsage(argv[0]);
+            return -1;
+        }
+    }
+
+    if (!benchmark.empty()) {
+        bench.recordingFile = replayFile;
+        return LidPong::Bench::run(benchmark, bench);
+    }
+
+    if (!bench.tracePaths.empty()) {
+        return LidPong::runTraceAnalysis(bench.tracePaths, analyze);
+    }
+
+    if (!replayFile.empty()) {
+        LidPong::InputRecording replay;
+        std::string error;
+        if (!replay.load(replayFile, error)) {
+            std::cerr << "Failed to load recording: " << error << std::endl;
+            return -1;
+        }
+        if (!frameDumpDir.empty()) {
+            return LidPong::replayToFrames(replay, frameDumpDir, frameDumpFormat, bench.frameWidth, bench.frameHeight);
+        }
+        return LidPong::replayHeadless(replay);
+    }
+
+    printUsage(argv[0]);
+    return -1;
+}
@@ -0,0 +1,90 @@
+#include "IdleGovernor.h"
+#include <cmath>
+#include <iomanip>
+
+namespace LidPong {
+
+IdleGovernor::IdleGovernor(const IdleOptions& options)
+    : m_options(options)
+    , m_idle(false)
+    , m_quietSinceNs(0)
+    , m_anchorAngle(0.0)
+    , m_idleSinceNs(0)
+    , m_idleSinceCpu(0) {
+    m_stats.periods = 0;
+    m_stats.waits = 0;
+    m_stats.lidWakes = 0;
+    m_stats.idleSeconds = 0.0;
+    m_stats.busySeconds = 0.0;
+}
+
+bool IdleGovernor::afterFrame(int64_t nowNs, bool quiet, bool hadInput, double lidAngle) {
+    if (!m_options.enabled || m_idle) {
+        return false;
+    }
+
+    // Any activity starts the quiet spell over, anchored at the current lid angle
+    bool lidMoved = std::fabs(lidAngle - m_anchorAngle) > m_options.wakeDegrees;
+    if (!quiet || hadInput || lidMoved || m_quietSinceNs == 0) {
+        m_quietSinceNs = quiet ? nowNs : 0;
+        m_anchorAngle = lidAngle;
+        return false;
+    }
+
+    if (nowNs - m_quietSinceNs < static_cast<int64_t>(m_options.graceSeconds * 1.0e9)) {
+        return false;
+    }
+    m_idle = true;
+    m_idleSinceNs = nowNs;
+    m_idleSinceCpu = std::clock();
+    m_stats.periods++;
+    return true;
+}
+
+bool IdleGovernor::shouldWake(int64_t nowNs, bool hadInput, double lidAngle) {
+    if (!m_idle) {
+        return true;
+    }
+    m_stats.waits++;
+
+    bool lidMoved = std::fabs(lidAngle - m_anchorAngle) > m_options.wakeDegrees;
+    if (!hadInput && !lidMoved) {
+        return false;
+    }
+    if (lidMoved && !hadInput) {
+        m_stats.lidWakes++;
+    }
+    wake(nowNs);
+    return true;
+}
+
+void IdleGovernor::finish(int64_t nowNs) {
+    if (m_idle) {
+        wake(nowNs);
+    }
+}
+
+void IdleGovernor::wake(int64_t nowNs) {
+    m_stats.idleSeconds += (nowNs - m_idleSinceNs) / 1.0e9;
+    m_stats.busySeconds += static_cast<double>(std::clock() - m_idleSinceCpu) / CLOCKS_PER_SEC;
+    m_idle = false;
+    m_quietSinceNs = 0;
+}
+
+void IdleGovernor::report(std::ostream& out) const {
+    if (m_stats.periods == 0) {
+        return;
+    }
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+
+    double perSecond = m_stats.idleSeconds > 0.0 ? m_stats.waits / m_stats.idleSeconds : 0.0;
+    out << "Idle: " << m_stats.periods << " periods, " << std::fixed << std::setprecision(1) << m_stats.idleSeconds
+        << " s (" << m_stats.lidWakes << " ended by the lid), " << perSecond << " loop wakeups/s, "
+        << std::setprecision(3) << m_stats.busySeconds * 1000.0 << " ms CPU" << std::endl;
+
+    out.flags(flags);
+    out.precision(precision);
+}
+
+} // namespace LidPong
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <ctime>
+#include <ostream>
+
+namespace LidPong {
+
+struct IdleOptions {
+    bool enabled;
+    double graceSeconds;   // Quiet this long before idling, so a short lull never costs a frame
+    double wakeDegrees;    // Lid motion that counts as activity (well above sensor noise)
+    double sampleRateHz;   // Lid sensor reads per second while idle
+    double maxWaitSeconds; // Longest single event wait; the lid is checked after each
+
+    IdleOptions() : enabled(true), graceSeconds(0.5), wakeDegrees(1.0), sampleRateHz(20.0), maxWaitSeconds(0.25) {}
+};
+
+struct IdleStats {
+    uint64_t periods;   // Times the game went idle
+    uint64_t waits;     // Event waits while idle, timeouts included
+    uint64_t lidWakes;  // Idle periods ended by lid motion rather than window input
+    double idleSeconds; // Wall time spent idle
+    double busySeconds; // Process CPU time (all threads) used while idle
+};
+
+// Decides when the main loop may stop drawing and block on window events.
+//
+// After every active frame the loop says whether the game is quiet: nothing
+// on screen can change on its own (game over or window out of focus, and
+// no particles left). Once it has been quiet for
+// graceSeconds with no window input and the lid held still, the game goes
+// idle. The idle loop then blocks in glfwWaitEventsTimeout(waitSeconds())
+// and asks shouldWake() after each wait; any window event or lid motion past
+// wakeDegrees ends idling at once.
+class IdleGovernor {
+public:
+    explicit IdleGovernor(const IdleOptions& options);
+
+    const IdleOptions& options() const { return m_options; }
+    bool isIdle() const { return m_idle; }
+    double waitSeconds() const { return m_options.maxWaitSeconds; }
+
+    // After each active frame; true when the game has just gone idle
+    bool afterFrame(int64_t nowNs, bool quiet, bool hadInput, double lidAngle);
+
+    // After each idle wait; true (and active again) on input or lid motion
+    bool shouldWake(int64_t nowNs, bool hadInput, double lidAngle);
+
+    // Closes an idle period still open at exit, so stats() covers it
+    void finish(int64_t nowNs);
+
+    const IdleStats& stats() const { return m_stats; }
+    void report(std::ostream& out) const;
+
+private:
+    void wake(int64_t nowNs);
+
+    IdleOptions m_options;
+    bool m_idle;
+    int64_t m_quietSinceNs; // 0 while not quiet
+    double m_anchorAngle;   // Lid angle when the quiet spell began
+    int64_t m_idleSinceNs;
+    std::clock_t m_idleSinceCpu;
+    IdleStats m_stats;
+};
+
+} // namespace LidPong
@@ -0,0 +1,184 @@
+#include "InputEvents.h"
+#include <cstring>
+
+namespace LidPong {
+
+namespace {
+
+InputEvent makeEvent(InputEventType type, int code, bool pressed, double x, double y, int64_t timestampNs) {
+    InputEvent event;
+    event.timestampNs = timestampNs;
+    event.type = type;
+    event.pressed = pressed;
+    event.code = code;
+    event.x = x;
+    event.y = y;
+    return event;
+}
+
+} // namespace
+
+InputEvent InputEvent::key(int code, bool pressed, int64_t timestampNs) {
+    return makeEvent(InputEventType::Key, code, pressed, 0.0, 0.0, timestampNs);
+}
+
+InputEvent InputEvent::mouseButton(int button, bool pressed, int64_t timestampNs) {
+    return makeEvent(InputEventType::MouseButton, button, pressed, 0.0, 0.0, timestampNs);
+}
+
+InputEvent InputEvent::cursor(double x, double y, int64_t timestampNs) {
+    return makeEvent(InputEventType::CursorMove, 0, false, x, y, timestampNs);
+}
+
+InputEvent InputEvent::windowSize(int width, int height, int64_t timestampNs) {
+    return makeEvent(InputEventType::WindowResize, 0, false, width, height, timestampNs);
+}
+
+InputEvent InputEvent::framebufferSize(int width, int height, int64_t timestampNs) {
+    return makeEvent(InputEventType::FramebufferResize, 0, false, width, height, timestampNs);
+}
+
+InputEvent InputEvent::focus(bool focused, int64_t timestampNs) {
+    return makeEvent(InputEventType::WindowFocus, 0, focused, 0.0, 0.0, timestampNs);
+}
+
+InputEvent InputEvent::refresh(int64_t timestampNs) {
+    return makeEvent(InputEventType::WindowRefresh, 0, false, 0.0, 0.0, timestampNs);
+}
+
+InputQueue::InputQueue()
+    : m_head(0)
+    , m_count(0)
+    , m_pushed(0)
+    , m_dropped(0) {
+}
+
+bool InputQueue::push(const InputEvent& event) {
+    // Only the newest of a run of cursor moves matters
+    if (event.type == InputEventType::CursorMove && m_count > 0) {
+        InputEvent& newest = m_events[(m_head + m_count - 1) % CAPACITY];
+        if (newest.type == InputEventType::CursorMove) {
+            newest = event;
+            m_pushed++;
+            return true;
+        }
+    }
+    if (m_count == CAPACITY) {
+        m_dropped++;
+        return false;
+    }
+    m_events[(m_head + m_count) % CAPACITY] = event;
+    m_count++;
+    m_pushed++;
+    return true;
+}
+
+bool InputQueue::pop(InputEvent& event) {
+    if (m_count == 0) {
+        return false;
+    }
+    event = m_events[m_head];
+    m_head = (m_head + 1) % CAPACITY;
+    m_count--;
+    return true;
+}
+
+InputState::InputState()
+    : m_cursorX(0.0)
+    , m_cursorY(0.0)
+    , m_windowWidth(0)
+    , m_windowHeight(0)
+    , m_framebufferWidth(0)
+    , m_framebufferHeight(0)
+    , m_focused(true)
+    , m_lastEventNs(0) {
+    std::memset(m_keyDown, 0, sizeof(m_keyDown));
+    std::memset(m_buttonDown, 0, sizeof(m_buttonDown));
+    std::memset(m_pressX, 0, sizeof(m_pressX));
+    std::memset(m_pressY, 0, sizeof(m_pressY));
+    clearEdges();
+}
+
+void InputState::apply(const InputEvent& event) {
+    m_lastEventNs = event.timestampNs;
+    switch (event.type) {
+    case InputEventType::Key:
+        if (event.code < 0 || event.code >= KEY_SLOTS) {
+            return; // GLFW_KEY_UNKNOWN
+        }
+        if (event.pressed && !m_keyDown[event.code] && m_keyPresses[event.code] < UINT16_MAX) {
+            m_keyPresses[event.code]++;
+        }
+        m_keyDown[event.code] = event.pressed;
+        break;
+    case InputEventType::MouseButton:
+        if (event.code < 0 || event.code >= BUTTON_SLOTS) {
+            return;
+        }
+        if (event.pressed && !m_buttonDown[event.code]) {
+            if (m_buttonPresses[event.code] < UINT16_MAX) m_buttonPresses[event.code]++;
+            m_pressX[event.code] = m_cursorX;
+            m_pressY[event.code] = m_cursorY;
+        }
+        m_buttonDown[event.code] = event.pressed;
+        break;
+    case InputEventType::CursorMove:
+        m_cursorX = event.x;
+        m_cursorY = event.y;
+        break;
+    case InputEventType::WindowResize:
+        m_windowWidth = static_cast<int>(event.x);
+        m_windowHeight = static_cast<int>(event.y);
+        break;
+    case InputEventType::FramebufferResize:
+        m_framebufferWidth = static_cast<int>(event.x);
+        m_framebufferHeight = static_cast<int>(event.y);
+        break;
+    case InputEventType::WindowFocus:
+        m_focused = event.pressed;
+        break;
+    case InputEventType::WindowRefresh:
+        break; // Only wakes the loop; nothing to remember
+    }
+}
+
+size_t InputState::drain(InputQueue& queue) {
+    InputEvent event;
+    size_t count = 0;
+    while (queue.pop(event)) {
+        apply(event);
+        count++;
+    }
+    return count;
+}
+
+void InputState::clearEdges() {
+    std::memset(m_keyPresses, 0, sizeof(m_keyPresses));
+    std::memset(m_buttonPresses, 0, sizeof(m_buttonPresses));
+}
+
+bool InputState::keyDown(int key) const {
+    return key >= 0 && key < KEY_SLOTS && m_keyDown[key];
+}
+
+int InputState::keyPresses(int key) const {
+    return key >= 0 && key < KEY_SLOTS ? m_keyPresses[key] : 0;
+}
+
+bool InputState::buttonDown(int button) const {
+    return button >= 0 && button < BUTTON_SLOTS && m_buttonDown[button];
+}
+
+int InputState::buttonPresses(int button) const {
+    return button >= 0 && button < BUTTON_SLOTS ? m_buttonPresses[button] : 0;
+}
+
+double InputState::pressX(int button) const {
+    return button >= 0 && button < BUTTON_SLOTS ? m_pressX[button] : m_cursorX;
+}
+
+double InputState::pressY(int button) const {
+    return button >= 0 && button < BUTTON_SLOTS ? m_pressY[button] : m_cursorY;
+}
+
+} // namespace LidPong
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace LidPong {
+
+enum class InputEventType : uint8_t {
+    Key,               // code = key, pressed = down or up
+    MouseButton,       // code = button, pressed = down or up
+    CursorMove,        // x, y = cursor in window coordinates
+    WindowResize,      // x, y = window size in screen coordinates
+    FramebufferResize, // x, y = framebuffer size in pixels
+    WindowFocus,       // pressed = gained focus
+    WindowRefresh      // Contents damaged (exposed, uncovered) and need drawing again
+};
+
+// One window event, stamped when it was delivered. Key and button codes are
+// GLFW's, passed through unchanged, so this header needs no GLFW.
+struct InputEvent {
+    int64_t timestampNs; // Clock::nowNs() when the callback ran
+    InputEventType type;
+    bool pressed;
+    int code;
+    double x, y;
+
+    static InputEvent key(int code, bool pressed, int64_t timestampNs);
+    static InputEvent mouseButton(int button, bool pressed, int64_t timestampNs);
+    static InputEvent cursor(double x, double y, int64_t timestampNs);
+    static InputEvent windowSize(int width, int height, int64_t timestampNs);
+    static InputEvent framebufferSize(int width, int height, int64_t timestampNs);
+    static InputEvent focus(bool focused, int64_t timestampNs);
+    static InputEvent refresh(int64_t timestampNs);
+};
+
+// Fixed-capacity FIFO between the window callbacks and the game loop. Both
+// run on the main thread (callbacks fire inside glfwPollEvents), so there is
+// no locking. A run of cursor moves collapses into the newest; when full, new
+// events are dropped and counted.
+class InputQueue {
+public:
+    static const size_t CAPACITY = 256;
+
+    InputQueue();
+
+    bool push(const InputEvent& event);
+    bool pop(InputEvent& event);
+
+    size_t size() const { return m_count; }
+    bool empty() const { return m_count == 0; }
+    uint64_t pushed() const { return m_pushed; }   // Including collapsed cursor moves
+    uint64_t dropped() const { return m_dropped; }
+
+private:
+    InputEvent m_events[CAPACITY];
+    size_t m_head;  // Oldest event
+    size_t m_count;
+    uint64_t m_pushed;
+    uint64_t m_dropped;
+};
+
+// Keys, buttons, cursor and window sizes as of the last event applied, plus
+// the presses since clearEdges(). A key tapped and released between two
+// frames still counts as pressed, which polling the current state would miss.
+class InputState {
+public:
+    static const int KEY_SLOTS = 512;   // Above GLFW_KEY_LAST
+    static const int BUTTON_SLOTS = 8;  // GLFW_MOUSE_BUTTON_LAST + 1
+
+    InputState();
+
+    void apply(const InputEvent& event);
+    size_t drain(InputQueue& queue); // Applies every queued event; returns how many
+    void clearEdges();
+
+    bool keyDown(int key) const;
+    int keyPresses(int key) const;   // Since clearEdges()
+    bool keyPressed(int key) const { return keyPresses(key) > 0; }
+
+    bool buttonDown(int button) const;
+    int buttonPresses(int button) const;
+    bool buttonPressed(int button) const { return buttonPresses(button) > 0; }
+
+    // Cursor where 'button' last went down, for clicks released within a frame
+    double pressX(int button) const;
+    double pressY(int button) const;
+
+    double cursorX() const { return m_cursorX; }
+    double cursorY() const { return m_cursorY; }
+    int windowWidth() const { return m_windowWidth; }
+    int windowHeight() const { return m_windowHeight; }
+    int framebufferWidth() const { return m_framebufferWidth; }
+    int framebufferHeight() const { return m_framebufferHeight; }
+    bool focused() const { return m_focused; }
+
+    int64_t lastEventNs() const { return m_lastEventNs; }
+
+private:
+    bool m_keyDown[KEY_SLOTS];
+    uint16_t m_keyPresses[KEY_SLOTS];
+    bool m_buttonDown[BUTTON_SLOTS];
+    uint16_t m_buttonPresses[BUTTON_SLOTS];
+    double m_pressX[BUTTON_SLOTS];
+    double m_pressY[BUTTON_SLOTS];
+
+    double m_cursorX, m_cursorY;
+    int m_windowWidth, m_windowHeight;
+    int m_framebufferWidth, m_framebufferHeight;
+    bool m_focused;
+    int64_t m_lastEventNs;
+};
+
+} // namespace LidPong
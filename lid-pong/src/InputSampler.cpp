@@ -0,0 +1,151 @@
+#include "InputSampler.h"
+#include "Clock.h"
+#include <cmath>
+
+namespace LidPong {
+
+InputSampler::InputSampler(LidSensor& sensor, double rateHz)
+    : m_sensor(sensor)
+    , m_rateHz(rateHz)
+    , m_idleRateHz(10.0)
+    , m_wakeDegrees(1.0)
+    , m_wake(nullptr)
+    , m_running(false)
+    , m_idle(false)
+    , m_samplesTaken(0)
+    , m_startNs(0)
+    , m_stopNs(0) {
+}
+
+InputSampler::~InputSampler() {
+    stop();
+}
+
+void InputSampler::start() {
+    if (m_running.load() || !m_sensor.isAvailable()) {
+        return;
+    }
+    m_running.store(true);
+    m_startNs = Clock::nowNs();
+    m_stopNs = 0;
+    m_thread = std::thread(&InputSampler::threadMain, this);
+}
+
+void InputSampler::stop() {
+    if (!m_running.exchange(false)) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_idleMutex);
+    }
+    m_idleChanged.notify_all(); // Out of any idle sleep
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+    m_stopNs = Clock::nowNs();
+}
+
+bool InputSampler::isRunning() const {
+    return m_running.load(std::memory_order_relaxed);
+}
+
+const InputSample& InputSampler::latest() {
+    m_mailbox.consume(m_latest);
+    return m_latest;
+}
+
+void InputSampler::setIdleSampling(double rateHz, double wakeDegrees, void (*wake)()) {
+    m_idleRateHz = rateHz > 0.0 ? rateHz : 10.0;
+    m_wakeDegrees = wakeDegrees;
+    m_wake = wake;
+}
+
+void InputSampler::setSampleObserver(const std::function<void(const InputSample&)>& observer) {
+    m_observer = observer;
+}
+
+void InputSampler::setIdle(bool idle) {
+    {
+        std::lock_guard<std::mutex> lock(m_idleMutex);
+        m_idle.store(idle);
+    }
+    if (!idle) {
+        m_idleChanged.notify_all();
+    }
+}
+
+uint64_t InputSampler::samplesTaken() const {
+    return m_samplesTaken.load(std::memory_order_relaxed);
+}
+
+double InputSampler::achievedRateHz() const {
+    int64_t end = m_stopNs ? m_stopNs : Clock::nowNs();
+    if (m_startNs == 0 || end <= m_startNs) {
+        return 0.0;
+    }
+    return samplesTaken() / ((end - m_startNs) / 1.0e9);
+}
+
+void InputSampler::threadMain() {
+    using clock = std::chrono::steady_clock;
+    const bool paced = m_rateHz > 0.0;
+    const auto period = std::chrono::duration_cast<clock::duration>(
+        std::chrono::duration<double>(paced ? 1.0 / m_rateHz : 0.0));
+    const auto idlePeriod = std::chrono::duration_cast<clock::duration>(
+        std::chrono::duration<double>(1.0 / m_idleRateHz));
+
+    auto nextDeadline = clock::now();
+    uint64_t sequence = 0;
+    bool anchored = false; // Idle: the angle where idling began has been taken
+    bool woken = false;    // Idle: 'wake' has already been called
+    double anchorAngle = 0.0;
+
+    while (m_running.load(std::memory_order_relaxed)) {
+        m_sensor.update();
+
+        InputSample sample;
+        sample.angle = m_sensor.getCurrentAngle();
+        sample.sliderPosition = m_sensor.getSliderPosition();
+        sample.timestampNs = Clock::nowNs();
+        sample.sequence = ++sequence;
+        sample.status = m_sensor.lastStatus();
+        sample.idle = m_idle.load(std::memory_order_relaxed);
+        m_mailbox.publish(sample);
+        m_samplesTaken.fetch_add(1, std::memory_order_relaxed);
+        if (m_observer) {
+            m_observer(sample);
+        }
+
+        if (m_idle.load(std::memory_order_relaxed)) {
+            if (!anchored) {
+                anchorAngle = sample.angle;
+                anchored = true;
+                woken = false;
+            } else if (!woken && m_wake && std::fabs(sample.angle - anchorAngle) > m_wakeDegrees) {
+                m_wake();
+                woken = true;
+            }
+            idleWait(idlePeriod);
+            nextDeadline = clock::now();
+            continue;
+        }
+        anchored = false;
+
+        if (paced) {
+            nextDeadline += period;
+            auto now = clock::now();
+            if (nextDeadline < now) {
+                nextDeadline = now; // Fell behind - don't try to catch up with a burst
+            }
+            std::this_thread::sleep_until(nextDeadline);
+        }
+    }
+}
+
+// Sleeps for one idle period, or less if idling ends or the sampler stops
+void InputSampler::idleWait(std::chrono::steady_clock::duration period) {
+    std::unique_lock<std::mutex> lock(m_idleMutex);
+    m_idleChanged.wait_for(lock, period, [this] { return !m_idle.load() || !m_running.load(); });
+}
+
+} // namespace LidPong
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "Mailbox.h"
+#include "Sensor.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace LidPong {
+
+// One timestamped reading of the lid sensor
+struct InputSample {
+    double angle;
+    double sliderPosition;
+    int64_t timestampNs; // Clock::nowNs() when the read completed
+    uint64_t sequence;   // 0 means "no sample yet"
+    MacBookLidAngle::ReadStatus status; // Of this read; on failure angle repeats the last good one
+    bool idle;           // Taken at the idle sampling rate
+
+    InputSample() : angle(0.0), sliderPosition(0.5), timestampNs(0), sequence(0), status(MacBookLidAngle::ReadStatus::Ok), idle(false) {}
+};
+
+// Samples the lid sensor on its own thread so a slow HID read never stalls
+// a frame. The freshest sample is handed over through a lock-free mailbox.
+class InputSampler {
+public:
+    // rateHz <= 0 samples as fast as the sensor allows
+    InputSampler(LidSensor& sensor, double rateHz);
+    ~InputSampler();
+
+    InputSampler(const InputSampler&) = delete;
+    InputSampler& operator=(const InputSampler&) = delete;
+
+    void start();
+    void stop();
+    bool isRunning() const;
+
+    // Returns the newest sample (the previous one again if nothing new arrived)
+    const InputSample& latest();
+
+    // Low-power sampling while the game idles: read only rateHz times a second,
+    // and call 'wake' (on the sampler thread) once the lid has moved more than
+    // wakeDegrees from where idling began, e.g. glfwPostEmptyEvent to end the
+    // main loop's event wait. Call before start().
+    void setIdleSampling(double rateHz, double wakeDegrees, void (*wake)());
+
+    // Called on the sampler thread with every sample, e.g. to run a gesture
+    // recogniser at the full sensor rate. Call before start().
+    void setSampleObserver(const std::function<void(const InputSample&)>& observer);
+
+    // Leaving idle cuts the current idle sleep short, so the next sample is immediate
+    void setIdle(bool idle);
+
+    uint64_t samplesTaken() const;
+    double achievedRateHz() const;
+
+private:
+    void threadMain();
+    void idleWait(std::chrono::steady_clock::duration period);
+
+    LidSensor& m_sensor;
+    double m_rateHz;
+    double m_idleRateHz;
+    double m_wakeDegrees;
+    void (*m_wake)();
+    std::function<void(const InputSample&)> m_observer;
+    std::thread m_thread;
+    std::atomic<bool> m_running;
+    std::atomic<bool> m_idle;
+    std::mutex m_idleMutex;
+    std::condition_variable m_idleChanged;
+    std::atomic<uint64_t> m_samplesTaken;
+    int64_t m_startNs;
+    int64_t m_stopNs;
+
+    LatestValueMailbox<InputSample> m_mailbox;
+    InputSample m_latest; // Reader-side copy of the last consumed sample
+};
+
+} // namespace LidPong
@@ -0,0 +1,105 @@
+#include "LatencyStats.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+namespace LidPong {
+
+LatencyStats::LatencyStats(size_t capacity)
+    : m_scratchValid(false)
+    , m_next(0)
+    , m_total(0) {
+    m_samples.reserve(capacity > 0 ? capacity : 1);
+    m_scratch.reserve(m_samples.capacity());
+}
+
+void LatencyStats::record(double ms) {
+    if (m_samples.size() < m_samples.capacity()) {
+        m_samples.push_back(ms);
+    } else {
+        m_samples[m_next] = ms;
+    }
+    m_next = (m_next + 1) % m_samples.capacity();
+    m_total++;
+    m_scratchValid = false;
+}
+
+void LatencyStats::clear() {
+    m_samples.clear();
+    m_next = 0;
+    m_total = 0;
+    m_scratchValid = false;
+}
+
+size_t LatencyStats::count() const {
+    return m_samples.size();
+}
+
+size_t LatencyStats::totalCount() const {
+    return m_total;
+}
+
+void LatencyStats::sortScratch() const {
+    if (m_scratchValid) {
+        return;
+    }
+    m_scratch.assign(m_samples.begin(), m_samples.end());
+    std::sort(m_scratch.begin(), m_scratch.end());
+    m_scratchValid = true;
+}
+
+double LatencyStats::percentile(double p) const {
+    if (m_samples.empty()) {
+        return 0.0;
+    }
+    sortScratch();
+
+    // Nearest-rank percentile
+    double rank = (p / 100.0) * (m_scratch.size() - 1);
+    size_t index = static_cast<size_t>(std::lround(rank));
+    if (index >= m_scratch.size()) index = m_scratch.size() - 1;
+    return m_scratch[index];
+}
+
+double LatencyStats::mean() const {
+    if (m_samples.empty()) {
+        return 0.0;
+    }
+    double sum = 0.0;
+    for (double s : m_samples) sum += s;
+    return sum / m_samples.size();
+}
+
+double LatencyStats::stddev() const {
+    if (m_samples.size() < 2) {
+        return 0.0;
+    }
+    double avg = mean();
+    double sumSq = 0.0;
+    for (double s : m_samples) sumSq += (s - avg) * (s - avg);
+    return std::sqrt(sumSq / (m_samples.size() - 1));
+}
+
+double LatencyStats::max() const {
+    if (m_samples.empty()) {
+        return 0.0;
+    }
+    return *std::max_element(m_samples.begin(), m_samples.end());
+}
+
+void LatencyStats::report(std::ostream& out, const char* label) const {
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+
+    out << label << ": n=" << count()
+        << std::fixed << std::setprecision(3)
+        << " p50=" << percentile(50.0)
+        << " p90=" << percentile(90.0)
+        << " p99=" << percentile(99.0)
+        << " max=" << max() << " ms" << std::endl;
+
+    out.flags(flags);
+    out.precision(precision);
+}
+
+} // namespace LidPong
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+#include <vector>
+
+namespace LidPong {
+
+// Fixed-capacity ring of latency samples (milliseconds) with percentile queries.
+// Recording never allocates; only the report path sorts a scratch copy.
+class LatencyStats {
+public:
+    explicit LatencyStats(size_t capacity = 8192);
+
+    void record(double ms);
+    void clear();
+
+    size_t count() const;      // Samples currently held (<= capacity)
+    size_t totalCount() const; // Samples ever recorded
+
+    double percentile(double p) const; // p in [0, 100]
+    double mean() const;
+    double stddev() const;
+    double max() const;
+
+    // One line: "label: n=... p50=... p90=... p99=... max=... ms"
+    void report(std::ostream& out, const char* label) const;
+
+private:
+    void sortScratch() const;
+
+    std::vector<double> m_samples;
+    mutable std::vector<double> m_scratch;
+    mutable bool m_scratchValid;
+    size_t m_next;
+    size_t m_total;
+};
+
+} // namespace LidPong
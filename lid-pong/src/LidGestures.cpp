@@ -0,0 +1,144 @@
+#include "LidGestures.h"
+#include <cmath>
+
+namespace LidPong {
+
+namespace {
+    const double NS_PER_SECOND = 1.0e9;
+
+    // How fast the rest angle follows a slowly drifting lid while no swing is going on
+    const double REST_FOLLOW_SECONDS = 0.2;
+
+    // A lid this still for this long after repositioning is resting again
+    const double SETTLE_SECONDS = 0.1;
+}
+
+const char* lidGestureName(LidGesture gesture) {
+    switch (gesture) {
+    case LidGesture::Flick: return "flick";
+    case LidGesture::DoubleNudge: return "double nudge";
+    case LidGesture::Hold: return "hold";
+    }
+    return "?";
+}
+
+LidGestureRecognizer::LidGestureRecognizer(const GestureOptions& options, const Callback& callback)
+    : m_options(options)
+    , m_callback(callback)
+    , m_samples(0)
+    , m_events(0) {
+    reset();
+}
+
+void LidGestureRecognizer::reset() {
+    m_primed = false;
+    m_lastNs = 0;
+    m_filtered = 0.0;
+    m_state = State::Resting;
+    m_restAngle = 0.0;
+    m_swingStartNs = 0;
+    m_peak = 0.0;
+    m_nudgeEndNs = 0;
+    m_stillAngle = 0.0;
+    m_stillSinceNs = 0;
+    m_holdReported = true; // Wherever the lid starts is not a hold
+    m_lastHoldAngle = 0.0;
+}
+
+void LidGestureRecognizer::addSample(int64_t timestampNs, double angle) {
+    m_samples++;
+    if (!m_primed || timestampNs < m_lastNs) {
+        reset();
+        m_primed = true;
+        m_lastNs = timestampNs;
+        m_filtered = m_restAngle = m_stillAngle = m_lastHoldAngle = angle;
+        m_stillSinceNs = timestampNs;
+        return;
+    }
+
+    // One-pole low-pass, exact for any sample spacing
+    double dt = (timestampNs - m_lastNs) / NS_PER_SECOND;
+    m_lastNs = timestampNs;
+    m_filtered += (angle - m_filtered) * (1.0 - std::exp(-dt / m_options.smoothingSeconds));
+
+    // Hold: still long enough, somewhere new
+    if (std::fabs(m_filtered - m_stillAngle) > m_options.stillDegrees) {
+        m_stillAngle = m_filtered;
+        m_stillSinceNs = timestampNs;
+        m_holdReported = false;
+    } else if (!m_holdReported && (timestampNs - m_stillSinceNs) / NS_PER_SECOND >= m_options.holdSeconds) {
+        m_holdReported = true;
+        if (std::fabs(m_filtered - m_lastHoldAngle) >= m_options.holdMoveDegrees) {
+            m_lastHoldAngle = m_filtered;
+            emit(LidGesture::Hold, timestampNs, m_filtered);
+        }
+    }
+
+    double departure = m_filtered - m_restAngle;
+    switch (m_state) {
+    case State::Resting:
+        if (std::fabs(departure) > m_options.startDegrees) {
+            m_state = State::Swinging;
+            m_swingStartNs = timestampNs;
+            m_peak = departure;
+        } else {
+            m_restAngle += departure * std::fmin(1.0, dt / REST_FOLLOW_SECONDS);
+        }
+        break;
+
+    case State::Swinging:
+        if (std::fabs(departure) > std::fabs(m_peak)) {
+            m_peak = departure;
+        }
+        if (std::fabs(departure) < m_options.returnDegrees) {
+            endSwing(timestampNs);
+            m_state = State::Resting;
+        } else if ((timestampNs - m_swingStartNs) / NS_PER_SECOND >
+                   std::fmax(m_options.flickSeconds, m_options.nudgeSeconds)) {
+            m_state = State::Moving;
+            m_nudgeEndNs = 0;
+        }
+        break;
+
+    case State::Moving:
+        if ((timestampNs - m_stillSinceNs) / NS_PER_SECOND >= SETTLE_SECONDS) {
+            m_restAngle = m_filtered;
+            m_state = State::Resting;
+        }
+        break;
+    }
+}
+
+void LidGestureRecognizer::endSwing(int64_t timestampNs) {
+    double seconds = (timestampNs - m_swingStartNs) / NS_PER_SECOND;
+    double size = std::fabs(m_peak);
+
+    if (size >= m_options.flickDegrees && seconds <= m_options.flickSeconds) {
+        m_nudgeEndNs = 0;
+        emit(LidGesture::Flick, timestampNs, m_peak);
+    } else if (size >= m_options.nudgeMinDegrees && size <= m_options.nudgeMaxDegrees && seconds <= m_options.nudgeSeconds) {
+        bool paired = m_nudgeEndNs != 0 &&
+                      (m_swingStartNs - m_nudgeEndNs) / NS_PER_SECOND <= m_options.nudgeGapSeconds;
+        if (paired) {
+            m_nudgeEndNs = 0;
+            emit(LidGesture::DoubleNudge, timestampNs, m_restAngle);
+        } else {
+            m_nudgeEndNs = timestampNs;
+        }
+    } else {
+        m_nudgeEndNs = 0; // Anything else between two nudges breaks the pair
+    }
+}
+
+void LidGestureRecognizer::emit(LidGesture gesture, int64_t timestampNs, double angle) {
+    m_events++;
+    if (m_callback) {
+        LidGestureEvent event;
+        event.gesture = gesture;
+        event.timestampNs = timestampNs;
+        event.angle = angle;
+        m_callback(event);
+    }
+}
+
+} // namespace LidPong
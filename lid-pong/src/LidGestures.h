@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+namespace LidPong {
+
+enum class LidGesture : uint8_t {
+    Flick,       // Quick swing out and back by flickDegrees or more
+    DoubleNudge, // Two small swings out and back in quick succession
+    Hold         // Lid moved to a new angle and kept still there
+};
+
+const char* lidGestureName(LidGesture gesture);
+
+struct LidGestureEvent {
+    LidGesture gesture;
+    int64_t timestampNs; // Of the sample that completed the gesture
+    double angle;        // Hold: the angle held. Flick: the signed swing (+ = opened further).
+};
+
+struct GestureOptions {
+    double smoothingSeconds; // Low-pass time constant against sensor noise
+    double startDegrees;     // Leaving the rest angle by this much starts a swing
+    double returnDegrees;    // Back within this of the rest angle ends it
+    double flickDegrees;     // A swing at least this big...
+    double flickSeconds;     // ...over within this long is a flick
+    double nudgeMinDegrees;  // A swing between these sizes...
+    double nudgeMaxDegrees;
+    double nudgeSeconds;     // ...over within this long is a nudge
+    double nudgeGapSeconds;  // Longest pause between the two nudges of a double nudge
+    double stillDegrees;     // Hold: the lid stays within this of one angle...
+    double holdSeconds;      // ...for this long...
+    double holdMoveDegrees;  // ...at least this far from where the last hold was
+
+    GestureOptions() : smoothingSeconds(0.015), startDegrees(1.5), returnDegrees(1.0), flickDegrees(10.0), flickSeconds(0.5), nudgeMinDegrees(2.0), nudgeMaxDegrees(8.0), nudgeSeconds(0.35), nudgeGapSeconds(0.5), stillDegrees(1.5), holdSeconds(0.8), holdMoveDegrees(4.0) {}
+};
+
+// Recognises lid gestures as angle samples stream in, with a small state
+// machine rather than template matching: each sample costs O(1) and no
+// history is kept, so it can run on the input thread at full sensor rate.
+// Samples may arrive at any (even irregular) rate; timing comes from their
+// timestamps. Events go to the callback, on the thread calling addSample().
+//
+// A swing is a departure from the resting angle that comes back. Swings
+// that take too long to return are treated as repositioning the lid, which
+// ends in a hold once the lid settles somewhere new.
+class LidGestureRecognizer {
+public:
+    typedef std::function<void(const LidGestureEvent&)> Callback;
+
+    LidGestureRecognizer(const GestureOptions& options, const Callback& callback);
+
+    void addSample(int64_t timestampNs, double angle);
+    void reset(); // Forget everything; the next sample becomes the rest angle
+
+    const GestureOptions& options() const { return m_options; }
+    uint64_t samples() const { return m_samples; }
+    uint64_t events() const { return m_events; }
+
+private:
+    enum class State : uint8_t {
+        Resting,  // Near m_restAngle
+        Swinging, // Away from it since m_swingStartNs
+        Moving    // Repositioning; waiting to settle
+    };
+
+    void endSwing(int64_t timestampNs);
+    void emit(LidGesture gesture, int64_t timestampNs, double angle);
+
+    GestureOptions m_options;
+    Callback m_callback;
+    uint64_t m_samples;
+    uint64_t m_events;
+
+    bool m_primed;
+    int64_t m_lastNs;
+    double m_filtered;
+
+    State m_state;
+    double m_restAngle;
+    int64_t m_swingStartNs;
+    double m_peak;             // Largest signed departure of this swing
+    int64_t m_nudgeEndNs;      // When an unpaired nudge ended, 0 = none
+
+    double m_stillAngle;       // Where the lid has stayed within stillDegrees...
+    int64_t m_stillSinceNs;    // ...since this sample
+    bool m_holdReported;       // For this still spell
+    double m_lastHoldAngle;
+};
+
+} // namespace LidPong
@@ -5,123 +5,408 @@
 #include <chrono>
 #include <iomanip>
 #include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <vector>
+#include <memory>
+#include <ctime>
+#include "AngleTrace.h"
+#include "Audio.h"
+#include "BallSwarm.h"
+#include "Bench.h"
+#include "BrickField.h"
+#include "Clock.h"
+#include "Collision.h"
+#include "Controller.h"
+#include "FramePacer.h"
+#include "GameParams.h"
+#include "IdleGovernor.h"
+#include "InputEvents.h"
+#include "InputSampler.h"
+#include "LatencyStats.h"
+#include "LidGestures.h"
+#include "Particles.h"
+#include "Profiler.h"
+#include "Recording.h"
+#include "RenderThread.h"
+#include "Rollback.h"
+#include "Scene.h"
+#include "ScoreStore.h"
 #include "Sensor.h"
+#include "Simulation.h"
+#include "SnapshotRing.h"
+#include "SpscQueue.h"
+#include "TraceAnalytics.h"
 
-class LidPongGame {
+// Two-player netplay over UDP
+struct NetOptions {
+    uint16_t localPort;
+    std::string peerHost; // Empty: no netplay
+    uint16_t peerPort;
+    int player;           // 0 = left paddle, 1 = right
+    LidPong::NetImpairment impairment; // Make a good network worse, for testing
+
+    NetOptions() : localPort(0), peerPort(0), player(0) {}
+};
+
+// Command line tunables
+struct GameOptions {
+    double inputRateHz; // Lid sensor sampling rate of the input thread (<= 0: as fast as possible)
+    LidPong::FramePacingOptions pacing;
+    std::string traceFile; // Chrome trace written on exit (profiling builds only)
+    size_t multiBallCount; // > 0 switches to the multi-ball party mode
+    double tickRateHz;     // Fixed simulation rate, 0 = one variable step per frame
+    size_t brickCount;     // > 0 switches to the brick-breaking mode
+    uint64_t seed;         // Simulation PRNG seed, 0 = pick one from the clock
+    std::string recordFile; // Input recording written on exit
+    std::string replayFile; // Recording to play back instead of live input
+    bool headless;          // Replay without a window, as fast as possible
+    bool bot;               // Let the tracking bot move the paddle
+    LidPong::BotOptions botOptions;
+    size_t soakGames;       // > 0: play this many bot games headless and exit
+    NetOptions net;
+    std::string frameDumpDir;   // With a headless replay: software-render every frame into this directory
+    LidPong::ImageFormat frameDumpFormat;
+    int frameWidth, frameHeight; // Software-rendered frame size (dumps and the render benchmark)
+    std::string goldenDir;      // Golden images for the render benchmark
+    bool renderThread;          // Draw and swap on a separate thread
+    LidPong::IdleOptions idle;  // Event-wait loop while nothing on screen can change
+    std::string scoresDir;      // Leaderboard and replay store, empty = don't save scores
+    std::string playerName;     // Name finished games are saved under
+    bool keepReplays;           // Save each game's input recording with its score
+    size_t topCount;            // > 0: print this many leaderboard places and exit
+    size_t replayRank;          // > 0: replay the recording kept with this leaderboard place
+    std::string audioOutput;    // "system", "null", "off" or a .wav file to record the mix to
+    size_t audioBufferFrames;   // Frames mixed per audio buffer
+    bool gestures;              // Lid flicks, nudges and holds work as buttons
+    std::string angleTraceFile; // Every lid sensor read is written here for --analyze
+    std::vector<std::string> analyzePaths; // Angle traces (or directories of them) to analyse and exit
+    LidPong::TraceAnalyzeOptions analyze;
+    std::string paramsFile;     // Gameplay params, reloaded while the game runs
+    bool printParams;           // Print a params file and exit
+
+    GameOptions() : inputRateHz(500.0), multiBallCount(0), tickRateHz(0.0), brickCount(0), seed(0), headless(false), bot(false), soakGames(0), frameDumpFormat(LidPong::ImageFormat::Png), frameWidth(800), frameHeight(600), renderThread(false), keepReplays(false), topCount(0), replayRank(0), audioOutput("system"), audioBufferFrames(256), gestures(false), printParams(false) {}
+
+    LidPong::SimulationConfig simulationConfig() const {
+        LidPong::SimulationConfig config;
+        config.seed = seed;
+        config.multiBallCount = multiBallCount;
+        config.brickCount = brickCount;
+        config.versus = !net.peerHost.empty();
+        return config;
+    }
+};
+
+// Canvas over the current thread's legacy OpenGL context. The framebuffer
+// size comes with each frame, since only the main thread may ask GLFW for it.
+class GlCanvas : public LidPong::Canvas {
+public:
+    GlCanvas() : framebufferWidth(1), framebufferHeight(1) {}
+    
+    void setSize(int w, int h) {
+        framebufferWidth = w;
+        framebufferHeight = h;
+    }
+    
+    int width() const override { return framebufferWidth; }
+    int height() const override { return framebufferHeight; }
+    
+    void clear(float r, float g, float b) override {
+        glClearColor(r, g, b, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+    }
+    
+    void setColor(float r, float g, float b, float a) override { glColor4f(r, g, b, a); }
+    
+    void setBlending(bool enabled) override {
+        if (enabled) {
+            glEnable(GL_BLEND);
+            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        } else {
+            glDisable(GL_BLEND);
+        }
+    }
+    
+    void begin(LidPong::Primitive primitive) override {
+        switch (primitive) {
+            case LidPong::Primitive::Quads: glBegin(GL_QUADS); break;
+            case LidPong::Primitive::TriangleFan: glBegin(GL_TRIANGLE_FAN); break;
+            case LidPong::Primitive::LineLoop: glBegin(GL_LINE_LOOP); break;
+        }
+    }
+    
+    void vertex(float x, float y) override { glVertex2f(x, y); }
+    void end() override { glEnd(); }
+    
+    void drawQuads(const float* xy, size_t vertexCount) override {
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glVertexPointer(2, GL_FLOAT, 0, xy);
+        glDrawArrays(GL_QUADS, 0, static_cast<GLsizei>(vertexCount));
+        glDisableClientState(GL_VERTEX_ARRAY);
+    }
+    
+    void drawPoints(const float* xy, size_t count, float diameterPixels) override {
+        glPointSize(diameterPixels < 1.0f ? 1.0f : diameterPixels);
+        glEnable(GL_POINT_SMOOTH);
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glVertexPointer(2, GL_FLOAT, 0, xy);
+        glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(count));
+        glDisableClientState(GL_VERTEX_ARRAY);
+        glDisable(GL_POINT_SMOOTH);
+    }
+    
+    void drawColoredPoints(const float* xy, const uint32_t* rgba, size_t count, float diameterPixels) override {
+        glPointSize(diameterPixels < 1.0f ? 1.0f : diameterPixels);
+        glEnable(GL_POINT_SMOOTH);
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glEnableClientState(GL_COLOR_ARRAY);
+        glVertexPointer(2, GL_FLOAT, 0, xy);
+        glColorPointer(4, GL_UNSIGNED_BYTE, 0, rgba);
+        glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(count));
+        glDisableClientState(GL_COLOR_ARRAY);
+        glDisableClientState(GL_VERTEX_ARRAY);
+        glDisable(GL_POINT_SMOOTH);
+    }
+    
+private:
+    int framebufferWidth, framebufferHeight;
+};
+
+// One line per place: rank, score, player, when, and whether a replay was kept
+static void printLeaderboard(const LidPong::ScoreStore& store, LidPong::ScoreMode mode, size_t count,
+                             const std::string& player = std::string()) {
+    std::vector<LidPong::ScoreEntry> entries = player.empty() ? store.top(mode, count) : store.topForPlayer(player, mode, count);
+    std::cout << "Top " << LidPong::scoreModeName(mode) << " scores" << (player.empty() ? "" : " for " + player)
+              << " (" << store.size() << " games saved):" << std::endl;
+    for (size_t i = 0; i < entries.size(); i++) {
+        LidPong::ScoreRecord record;
+        std::string error;
+        if (!store.read(entries[i], record, nullptr, error)) {
+            std::cout << std::setw(4) << i + 1 << ". " << error << std::endl;
+            continue;
+        }
+        std::time_t when = static_cast<std::time_t>(record.timestampMs / 1000);
+        char date[32];
+        std::strftime(date, sizeof(date), "%Y-%m-%d %H:%M", std::localtime(&when));
+        std::cout << std::setw(4) << i + 1 << ". " << std::setw(6) << record.score << "  " << std::left << std::setw(16)
+                  << record.player << std::right << date << (entries[i].hasReplay ? "  (replay)" : "") << std::endl;
+    }
+}
+
+class LidPongGame : private LidPong::RenderTarget {
 private:
     GLFWwindow* window;
     LidPong::LidSensor sensor;
+    LidPong::InputSampler inputSampler;
+    LidPong::FramePacingOptions pacingOptions;
+    LidPong::FramePacer pacer;
+    std::string traceFile;
+    bool showProfilerOverlay;
     
-    // Game objects
-    struct Ball {
-        float x, y;
-        float vx, vy;
-        float radius;
-        bool active;
-        
-        Ball() : x(0.0f), y(0.0f), vx(0.8f), vy(0.6f), radius(0.02f), active(true) {}
-        
-        void update(float deltaTime, float speedMultiplier) {
-            if (!active) return;
-            
-            x += vx * deltaTime * speedMultiplier;
-            y += vy * deltaTime * speedMultiplier;
-            
-            // Bounce off top/bottom walls
-            if (y + radius > 0.95f || y - radius < -0.95f) {
-                vy = -vy;
-                if (y + radius > 0.95f) y = 0.95f - radius;
-                if (y - radius < -0.95f) y = -0.95f + radius;
-            }
-            
-            // Bounce off right wall
-            if (x + radius > 0.98f) {
-                vx = -vx;
-                x = 0.98f - radius;
-            }
-            
-            // Ball missed - goes off left side
-            if (x + radius < -1.0f) {
-                active = false; // Don't auto-reset, let game handle it
-            }
+    // Input latency tracking
+    int64_t frameInputTimestampNs; // Timestamp of the lid sample used by the current frame
+    int64_t presentedInputTimestampNs; // Same, for the frame the render thread is presenting
+    LidPong::LatencyStats inputAgeStats;  // Sample age when the frame is submitted
+    LidPong::LatencyStats endToEndStats;  // Sample age when the swap returns
+    
+    // Game state and rules; everything it sees goes through a TickInput
+    LidPong::Simulation sim;
+    uint8_t pendingButtons;     // Button edges not yet consumed by a tick
+    float pendingSpeedSetting;  // Speed slider value for BUTTON_SPEED_SET
+    
+    // Rewind history (hold BACKSPACE) and a quick-save checkpoint (F5 save, F9 load)
+    LidPong::SnapshotRing history;
+    LidPong::Simulation::Snapshot checkpoint;
+    bool hasCheckpoint;
+    bool rewinding;
+    
+    // Window events queued by the GLFW callbacks, drained into inputState once per frame
+    LidPong::InputQueue inputQueue;
+    LidPong::InputState inputState;
+    
+    // Replaces the lid sensor when set (e.g. the bot)
+    std::unique_ptr<LidPong::Controller> controller;
+    
+    // Gameplay params from --params FILE, reloaded on every save; null plays the defaults
+    std::string paramsFile;
+    std::unique_ptr<LidPong::ParamStore> params;
+    
+    // Versus over the network: the session steps 'sim', rolling back as the peer's inputs arrive
+    NetOptions netOptions;
+    std::unique_ptr<LidPong::UdpTransport> netSocket;
+    std::unique_ptr<LidPong::ImpairedTransport> netLink;
+    std::unique_ptr<LidPong::RollbackSession> netSession;
+    
+    // Recording of this session, or the recording being played back
+    std::string recordFile;
+    LidPong::InputRecording recording;
+    bool recordingInput; // To recordFile and/or with each saved score
+    const LidPong::InputRecording* replay;
+    std::unique_ptr<LidPong::InputRecording::Reader> replayReader;
+    LidPong::TickInput replayNext;
+    bool replayNextValid, replayNextFrameStart, replayFinished;
+    
+    // The same scene code also renders through SoftwareCanvas for frame dumps
+    GlCanvas canvas;
+    LidPong::SceneRenderer scene;
+    LidPong::RenderSnapshot frame;  // Drawn in place when there is no render thread
+    uint64_t stateGeneration;       // Bumped when the game jumps to another state (rewind, checkpoint)
+    LidPong::ParticleEffects effects; // Hit sparks, ball trail and miss bursts; never touch 'sim'
+    
+    // With --render-thread the GL context lives on its own thread, fed through a triple buffer
+    bool useRenderThread;
+    LidPong::RenderThread renderThread;
+    
+    // Blocks on window events instead of drawing frames while the game is quiet
+    LidPong::IdleGovernor idle;
+    
+    // Sound effects: cues are posted to the mixer's queue, the backend mixes on its own thread
+    LidPong::SoundBank sounds;
+    LidPong::AudioMixer mixer;
+    LidPong::AudioCues audioCues;
+    std::unique_ptr<LidPong::AudioBackend> audio;
+    std::string audioOutput;
+    size_t audioBufferFrames;
+    
+    // Lid gestures, recognised on the input thread and queued for the game
+    bool gesturesEnabled;
+    LidPong::LidGestureRecognizer gestures;
+    LidPong::SpscQueue<LidPong::LidGestureEvent, 16> gestureEvents;
+    bool userPaused;
+    
+    // Every sensor read, written from the input thread for offline analysis
+    std::string angleTraceFile;
+    double inputRateHz;
+    LidPong::AngleTraceWriter angleTrace;
+    
+    // Finished games go to the score store through its writer thread
+    std::string scoresDir;
+    std::string playerName;
+    LidPong::ScoreStore scores;
+    LidPong::ScoreWriter scoreWriter;
+    bool scoresOpen;
+    bool wasGameOver;
+    uint64_t gamesSubmitted;
+    
+    // Fixed-rate simulation (swept collision keeps low tick rates correct)
+    float tickSeconds;
+    float tickAccumulator;
+    double currentLidAngle;
+    size_t frameEvents; // Window events applied this frame
+    
+public:
+    explicit LidPongGame(const GameOptions& options = GameOptions(), const LidPong::InputRecording* replayFrom = nullptr)
+        : window(nullptr), inputSampler(sensor, options.inputRateHz), pacingOptions(options.pacing), pacer(options.pacing), traceFile(options.traceFile), showProfilerOverlay(false), frameInputTimestampNs(0), presentedInputTimestampNs(0), sim(replayFrom ? replayFrom->config() : options.simulationConfig()), pendingButtons(0), pendingSpeedSetting(0.0f), history(historyCapacity(sim)), hasCheckpoint(false), rewinding(false), paramsFile(options.paramsFile), netOptions(options.net), recordFile(options.recordFile), recordingInput(!replayFrom && options.net.peerHost.empty() && (!options.recordFile.empty() || options.keepReplays)), replay(replayFrom), replayNextValid(false), replayNextFrameStart(false), replayFinished(false), stateGeneration(0), useRenderThread(options.renderThread), idle(options.idle), sounds(LidPong::AUDIO_SAMPLE_RATE), mixer(sounds), audioOutput(options.audioOutput), audioBufferFrames(options.audioBufferFrames), gesturesEnabled(options.gestures && !options.bot && !replayFrom && options.net.peerHost.empty()), gestures(LidPong::GestureOptions(), [this](const LidPong::LidGestureEvent& event) { if (gestureEvents.push(event)) glfwPostEmptyEvent(); }), userPaused(false), angleTraceFile(options.angleTraceFile), inputRateHz(options.inputRateHz), scoresDir(options.scoresDir), playerName(options.playerName), scoreWriter(scores), scoresOpen(false), wasGameOver(false), gamesSubmitted(0), tickSeconds(options.tickRateHz > 0.0 ? static_cast<float>(1.0 / options.tickRateHz) : 0.0f), tickAccumulator(0.0f), currentLidAngle(0.0), frameEvents(0) {
+        if (replay) {
+            replayReader.reset(new LidPong::InputRecording::Reader(*replay));
+        } else if (recordingInput) {
+            recording.begin(sim.config(), tickSeconds);
         }
-        
-        void reset() {
-            x = 0.0f;
-            y = 0.0f;
-            vx = 0.8f * (rand() % 2 == 0 ? 1.0f : -1.0f);
-            vy = 0.6f * (rand() % 2 == 0 ? 1.0f : -1.0f);
-            active = true;
+        if (options.bot) {
+            controller.reset(new LidPong::BotController(options.botOptions));
         }
-        
-        void draw() {
-            if (!active) return;
-            
-            glColor3f(1.0f, 1.0f, 1.0f); // White ball
-            glBegin(GL_TRIANGLE_FAN);
-            glVertex2f(x, y);
-            for (int i = 0; i <= 20; i++) {
-                float angle = 2.0f * M_PI * i / 20;
-                glVertex2f(x + radius * cos(angle), y + radius * sin(angle));
-            }
-            glEnd();
+        if (sim.isVersus() && tickSeconds <= 0.0f) {
+            tickSeconds = 1.0f / 60.0f; // Rollback needs fixed ticks
         }
-    };
+    }
     
-    struct Slider {
-        float x, y;
-        float width, height;
-        float targetY;
-        float speed;
-        
-        // VERY SENSITIVE and LONGER slider
-        Slider() : x(-0.95f), y(0.0f), width(0.02f), height(0.6f), targetY(0.0f), speed(12.0f) {}
-        
-        void update(float deltaTime, double lidPosition) {
-            // VERY HIGH SENSITIVITY: small lid movements = big slider movements
-            float normalizedPos = lidPosition - 0.5f; // Center around 0
-            float superSensitive = normalizedPos * 4.0f; // 4x sensitivity!
-            targetY = superSensitive * 0.85f; // Map to screen coordinates
-            
-            // Clamp to screen bounds
-            if (targetY > 0.85f) targetY = 0.85f;
-            if (targetY < -0.85f) targetY = -0.85f;
-            
-            // Very fast movement towards target
-            float diff = targetY - y;
-            y += diff * speed * deltaTime;
+    bool startNetplay() {
+        std::string error;
+        netSocket.reset(new LidPong::UdpTransport());
+        if (!netSocket->open(netOptions.localPort, error) ||
+            !netSocket->setPeer(netOptions.peerHost, netOptions.peerPort, error)) {
+            std::cerr << "Netplay: " << error << std::endl;
+            return false;
         }
-        
-        void draw() {
-            glColor3f(0.8f, 0.8f, 0.8f); // Light gray slider
-            glBegin(GL_QUADS);
-            glVertex2f(x - width/2, y - height/2);
-            glVertex2f(x + width/2, y - height/2);
-            glVertex2f(x + width/2, y + height/2);
-            glVertex2f(x - width/2, y + height/2);
-            glEnd();
+        netLink.reset(new LidPong::ImpairedTransport(*netSocket, netOptions.impairment, sim.config().seed + netOptions.player));
+        netSession.reset(new LidPong::RollbackSession(sim, netOptions.player, tickSeconds, *netLink));
+        std::cout << "Netplay: " << (netOptions.player == 0 ? "left" : "right") << " paddle, UDP port "
+                  << netSocket->localPort() << " <-> " << netOptions.peerHost << ":" << netOptions.peerPort << std::endl;
+        return true;
+    }
+    
+    // The input thread and every tick read the current params without a lock;
+    // the watcher thread swaps in a new set and wakes the main loop on each save
+    bool startParams() {
+        std::string error;
+        params.reset(new LidPong::ParamStore());
+        if (!params->load(paramsFile, error) || !params->watch(glfwPostEmptyEvent, error)) {
+            std::cerr << "Params: " << error << std::endl;
+            return false;
         }
-        
-        bool checkCollision(Ball& ball) {
-            return (ball.x - ball.radius <= x + width/2 && 
-                    ball.x + ball.radius >= x - width/2 &&
-                    ball.y - ball.radius <= y + height/2 && 
-                    ball.y + ball.radius >= y - height/2);
-        }
-    };
-    
-    Ball ball;
-    Slider slider;
-    int score;
-    int lives;
-    int totalHits;
-    float ballSpeedMultiplier;
-    double currentLidAngle;
-    bool gameOver;
-    bool showGameOverModal;
+        sensor.setParams(params.get());
+        sim.setParams(params->current());
+        std::cout << "Params from " << paramsFile << ", reloaded on every save (games aren't saved to the leaderboard)" << std::endl;
+        return true;
+    }
     
-public:
-    LidPongGame() : window(nullptr), score(0), lives(3), totalHits(0), ballSpeedMultiplier(0.6f), currentLidAngle(0.0), gameOver(false), showGameOverModal(false) {}
+    // Reloads and rejected files since the last frame
+    bool reportParams() {
+        std::string message;
+        bool any = false;
+        while (params && params->takeReport(message)) {
+            std::cout << std::endl << message << std::endl;
+            any = true;
+        }
+        return any;
+    }
+    
+    // About ten seconds at 60 fps, capped at 64 MB for big ball or brick counts
+    static size_t historyCapacity(const LidPong::Simulation& s) {
+        size_t bytes = sizeof(LidPong::Simulation::Snapshot) + s.swarm().size() * 4 * sizeof(float) +
+                       s.brickField().copyBytes() + s.brickBalls().size() * sizeof(LidPong::SweptBall);
+        return std::max<size_t>(16, std::min<size_t>(600, (64u << 20) / bytes));
+    }
+    
+    // Events are queued as GLFW delivers them; nothing polls key or window state per frame
+    static LidPongGame& owner(GLFWwindow* w) {
+        return *static_cast<LidPongGame*>(glfwGetWindowUserPointer(w));
+    }
+    static void onKey(GLFWwindow* w, int key, int, int action, int) {
+        if (action != GLFW_REPEAT) {
+            owner(w).inputQueue.push(LidPong::InputEvent::key(key, action == GLFW_PRESS, LidPong::Clock::nowNs()));
+        }
+    }
+    static void onMouseButton(GLFWwindow* w, int button, int action, int) {
+        owner(w).inputQueue.push(LidPong::InputEvent::mouseButton(button, action == GLFW_PRESS, LidPong::Clock::nowNs()));
+    }
+    static void onCursorMove(GLFWwindow* w, double x, double y) {
+        owner(w).inputQueue.push(LidPong::InputEvent::cursor(x, y, LidPong::Clock::nowNs()));
+    }
+    static void onWindowSize(GLFWwindow* w, int width, int height) {
+        owner(w).inputQueue.push(LidPong::InputEvent::windowSize(width, height, LidPong::Clock::nowNs()));
+    }
+    static void onFramebufferSize(GLFWwindow* w, int width, int height) {
+        owner(w).inputQueue.push(LidPong::InputEvent::framebufferSize(width, height, LidPong::Clock::nowNs()));
+    }
+    static void onFocus(GLFWwindow* w, int focused) {
+        owner(w).inputQueue.push(LidPong::InputEvent::focus(focused != 0, LidPong::Clock::nowNs()));
+    }
+    static void onRefresh(GLFWwindow* w) {
+        owner(w).inputQueue.push(LidPong::InputEvent::refresh(LidPong::Clock::nowNs()));
+    }
+    
+    void installInputCallbacks() {
+        glfwSetKeyCallback(window, onKey);
+        glfwSetMouseButtonCallback(window, onMouseButton);
+        glfwSetCursorPosCallback(window, onCursorMove);
+        glfwSetWindowSizeCallback(window, onWindowSize);
+        glfwSetFramebufferSizeCallback(window, onFramebufferSize);
+        glfwSetWindowFocusCallback(window, onFocus);
+        glfwSetWindowRefreshCallback(window, onRefresh);
+        
+        // The callbacks only report changes, so start from the current sizes and cursor
+        int64_t now = LidPong::Clock::nowNs();
+        int width, height;
+        double x, y;
+        glfwGetWindowSize(window, &width, &height);
+        inputState.apply(LidPong::InputEvent::windowSize(width, height, now));
+        glfwGetFramebufferSize(window, &width, &height);
+        inputState.apply(LidPong::InputEvent::framebufferSize(width, height, now));
+        glfwGetCursorPos(window, &x, &y);
+        inputState.apply(LidPong::InputEvent::cursor(x, y, now));
+    }
     
     bool init() {
         if (!glfwInit()) {
@@ -139,10 +424,44 @@ public:
         
         glfwMakeContextCurrent(window);
         glfwSetWindowUserPointer(window, this);
+        installInputCallbacks();
+        glfwSwapInterval(pacingOptions.vsync ? 1 : 0);
+        
+        if (!netOptions.peerHost.empty() && !startNetplay()) {
+            return false;
+        }
+        if (!paramsFile.empty() && !startParams()) {
+            return false;
+        }
         
         // Check sensor availability
-        if (!sensor.isAvailable()) {
+        if (replay || controller) {
+            // Input comes from the recording or the controller
+        } else if (!sensor.isAvailable()) {
             std::cerr << "Warning: Lid sensor not available, using keyboard controls" << std::endl;
+        } else {
+            // While idle the sampler slows down, and lid motion ends the main loop's event wait
+            const LidPong::IdleOptions& idleOptions = idle.options();
+            inputSampler.setIdleSampling(idleOptions.sampleRateHz, idleOptions.wakeDegrees, glfwPostEmptyEvent);
+            if (!angleTraceFile.empty()) {
+                std::string error;
+                if (!angleTrace.open(angleTraceFile, inputRateHz, error)) {
+                    std::cerr << "Can't write the angle trace: " << error << std::endl;
+                    return false;
+                }
+            }
+            if (gesturesEnabled || angleTrace.isOpen()) {
+                inputSampler.setSampleObserver([this](const LidPong::InputSample& sample) {
+                    if (gesturesEnabled) {
+                        gestures.addSample(sample.timestampNs, sample.angle);
+                    }
+                    angleTrace.append(sample);
+                });
+            }
+            inputSampler.start();
+        }
+        if (!angleTraceFile.empty() && !angleTrace.isOpen()) {
+            std::cerr << "Warning: no lid sensor, so no angle trace" << std::endl;
         }
         
         std::cout << "Lid Pong - MacBook Lid Angle Game" << std::endl;
@@ -152,8 +471,30 @@ public:
         std::cout << "  Mouse: Drag speed slider" << std::endl;
         std::cout << "  +/- keys: Adjust ball speed" << std::endl;
         std::cout << "  SPACE: Reset ball / Restart game" << std::endl;
+        std::cout << "  P: Pause / resume" << std::endl;
+        if (gesturesEnabled) {
+            std::cout << "  Lid gestures: flick to restart, double nudge to pause, move and hold to serve or resume" << std::endl;
+        }
+        std::cout << "  BACKSPACE (hold): Rewind | F5/F9: Save/load checkpoint" << std::endl;
         std::cout << "  ESC: Quit" << std::endl;
         std::cout << std::endl;
+        if (replay) {
+            std::cout << "Replaying " << replay->tickCount() << " recorded ticks (seed " << sim.config().seed << ")" << std::endl;
+        } else {
+            std::cout << "Seed: " << sim.config().seed << (recordFile.empty() ? "" : ", recording to " + recordFile) << std::endl;
+        }
+        
+        if (!scoresDir.empty() && !replay) {
+            openScores();
+        }
+        if (audioOutput != "off") {
+            startAudio();
+        }
+        
+        if (useRenderThread) {
+            glfwMakeContextCurrent(nullptr); // The render thread takes the context
+            renderThread.start(*this, pacingOptions.vsync);
+        }
         
         return true;
     }
@@ -162,592 +503,730 @@ public:
         auto lastTime = std::chrono::high_resolution_clock::now();
         
         while (!glfwWindowShouldClose(window)) {
+            if (idle.isIdle()) {
+                // Nothing to draw: sleep until a window event, the sampler's lid wake-up or the timeout
+                glfwWaitEventsTimeout(idle.waitSeconds());
+                bool gestured = handleGestures();
+                bool retuned = reportParams();
+                if (!idle.shouldWake(LidPong::Clock::nowNs(), !inputQueue.empty() || gestured || retuned, idleLidAngle())) {
+                    continue;
+                }
+                resumeFromIdle();
+                lastTime = std::chrono::high_resolution_clock::now(); // The idle time is not a frame step
+            }
+            
+            LIDPONG_PROFILE_FRAME_BEGIN();
+            
+            // With late input this sleeps until just before the frame must start
+            {
+                LIDPONG_PROFILE_SCOPE(Pacing);
+                pacer.beginFrame();
+            }
+            
             auto currentTime = std::chrono::high_resolution_clock::now();
             float deltaTime = std::chrono::duration<float>(currentTime - lastTime).count();
             lastTime = currentTime;
             
             // Handle input
-            glfwPollEvents();
-            if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
-                glfwSetWindowShouldClose(window, true);
+            {
+                LIDPONG_PROFILE_SCOPE(Events);
+                glfwPollEvents();
+                inputState.clearEdges();
+                frameEvents = inputState.drain(inputQueue);
+                handleKeys();
             }
-            static bool spacePressed = false;
-            bool spaceKey = glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS;
-            if (spaceKey && !spacePressed) {
-                if (gameOver) {
-                    // Restart game
-                    score = 0;
-                    lives = 3;
-                    totalHits = 0;
-                    gameOver = false;
-                    showGameOverModal = false;
-                    ball.reset();
-                } else if (!ball.active) {
-                    // Reset ball if it's inactive
-                    ball.reset();
+            
+            if (replay) {
+                // Same ticks as the recorded frame, as fast as the display allows
+                LIDPONG_PROFILE_SCOPE(Update);
+                replayFrame();
+            } else {
+                // Ball speed controls with mouse/keyboard
+                {
+                    LIDPONG_PROFILE_SCOPE(SpeedSlider);
+                    handleSpeedSliderInput();
+                }
+                
+                // Freshest lid position (or keyboard fallback)
+                double lidPosition;
+                {
+                    LIDPONG_PROFILE_SCOPE(Input);
+                    lidPosition = controller ? controller->lidPosition(sim, deltaTime) : readLidPosition();
+                }
+                
+                // Update game (or step back through history)
+                {
+                    LIDPONG_PROFILE_SCOPE(Update);
+                    if (!rewinding && !userPaused) {
+                        simulate(deltaTime, lidPosition);
+                        history.push(sim);
+                    }
                 }
             }
-            spacePressed = spaceKey;
+            effects.update(sim, stateGeneration, deltaTime);
+            if (audio) {
+                audioCues.update(sim, stateGeneration, mixer);
+            }
+            submitFinishedGame();
+            reportParams();
+            printStatus();
             
-            // Ball speed controls with mouse/keyboard
-            handleSpeedSliderInput();
+            if (useRenderThread) {
+                // Hand the frame over; drawing and the swap happen on the render thread
+                {
+                    LIDPONG_PROFILE_SCOPE(Render);
+                    captureFrame(renderThread.snapshotToWrite());
+                    renderThread.publish();
+                }
+                pacer.markSubmit();
+            } else {
+                // Render
+                {
+                    LIDPONG_PROFILE_SCOPE(Render);
+                    captureFrame(frame);
+                    draw(frame);
+                }
+                
+                // Input age at submit, and again once the swap has returned (closest we get to photons)
+                if (frameInputTimestampNs != 0) {
+                    inputAgeStats.record(LidPong::Clock::nsToMs(LidPong::Clock::nowNs() - frameInputTimestampNs));
+                }
+                pacer.markSubmit();
+                {
+                    LIDPONG_PROFILE_SCOPE(Swap);
+                    glfwSwapBuffers(window);
+                }
+                if (frameInputTimestampNs != 0) {
+                    endToEndStats.record(LidPong::Clock::nsToMs(LidPong::Clock::nowNs() - frameInputTimestampNs));
+                }
+            }
             
-            // Update game
-            update(deltaTime);
+            // Frame limiter (when not pacing via late input)
+            {
+                LIDPONG_PROFILE_SCOPE(Pacing);
+                pacer.endFrame();
+            }
             
-            // Render
-            render();
+            LIDPONG_PROFILE_FRAME_END();
             
-            glfwSwapBuffers(window);
+            if (idle.afterFrame(LidPong::Clock::nowNs(), isQuiet(), frameEvents > 0, currentLidAngle)) {
+                enterIdle();
+            }
         }
-    }
-    
-    void update(float deltaTime) {
-        // Update sensor and get current angle
-        sensor.update();
-        currentLidAngle = sensor.getCurrentAngle();
         
-        // Update slider with lid sensor
-        double lidPosition = 0.5; // Default center
-        try {
-            if (sensor.isAvailable()) {
-                lidPosition = sensor.getSliderPosition();
+        idle.finish(LidPong::Clock::nowNs());
+        inputSampler.stop();
+        renderThread.stop();
+        reportLatency();
+        if (angleTrace.isOpen()) {
+            uint64_t reads = angleTrace.recordsWritten();
+            std::string error;
+            if (angleTrace.close(error)) {
+                std::cout << "Angle trace: " << reads << " sensor reads written to " << angleTraceFile << std::endl;
             } else {
-                // Use keyboard fallback
-                if (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS) {
-                    lidPosition = 0.8;
-                } else if (glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS) {
-                    lidPosition = 0.2;
-                }
-            }
-        } catch (...) {
-            // Fallback to keyboard
-            if (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS) {
-                lidPosition = 0.8;
-            } else if (glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS) {
-                lidPosition = 0.2;
+                std::cerr << "Angle trace " << angleTraceFile << ": " << error << std::endl;
             }
         }
+        if (inputQueue.dropped() > 0) {
+            std::cout << "Window input: " << inputQueue.dropped() << " of " << inputQueue.pushed() + inputQueue.dropped()
+                      << " events dropped with the queue full" << std::endl;
+        }
+        if (useRenderThread) {
+            LidPong::RenderThreadStats stats = renderThread.stats();
+            std::cout << "Render thread: " << stats.drawn << " frames drawn from " << stats.published
+                      << " snapshots (" << stats.reused << " redraws of an old snapshot, "
+                      << stats.skipped << " snapshots skipped)" << std::endl;
+        }
+        pacer.report(std::cout);
+        idle.report(std::cout);
+        if (audio) {
+            audio->stop();
+            mixer.report(std::cout, audio->name(), audio->bufferMs());
+        }
+        reportAllocations();
         
-        if (!gameOver) {
-            slider.update(deltaTime, lidPosition);
-            ball.update(deltaTime, ballSpeedMultiplier);
-            
-            // Check collision with slider
-            if (ball.active && slider.checkCollision(ball)) {
-                // Only count if ball was moving towards slider (prevent multiple hits)
-                if (ball.vx < 0) {
-                    ball.vx = std::abs(ball.vx); // Bounce right
-                    
-                    // Add spin based on where ball hits slider
-                    float hitPos = (ball.y - slider.y) / (slider.height / 2);
-                    ball.vy += hitPos * 1.5f; // Reduced spin for smoother gameplay
-                    
-                    // Clamp velocity for smoother gameplay
-                    if (ball.vy > 1.2f) ball.vy = 1.2f;
-                    if (ball.vy < -1.2f) ball.vy = -1.2f;
-                    
-                    totalHits++;
-                    score = totalHits; // Score is number of hits
-                }
-            }
-            
-            // Check if ball was missed
-            if (!ball.active && lives > 0) {
-                lives--;
-                if (lives <= 0) {
-                    gameOver = true;
-                    showGameOverModal = true;
-                } else {
-                    // Auto-reset ball after a short delay
-                    ball.reset();
+        if (!traceFile.empty()) {
+            writeTrace(traceFile);
+        }
+        if (!recordFile.empty() && !replay) {
+            saveRecording();
+        }
+        closeScores();
+        if (netSession) {
+            const LidPong::RollbackStats& stats = netSession->stats();
+            std::cout << "Netplay: " << netSession->currentTick() << " ticks, " << stats.rollbacks << " rollbacks ("
+                      << stats.resimulatedTicks << " ticks re-simulated, deepest " << stats.maxRollbackDepth << "), "
+                      << stats.stalls << " stalls, " << stats.packetsSent << " packets sent / "
+                      << stats.packetsReceived << " received, " << stats.desyncs << " desyncs in "
+                      << stats.checksumsCompared << " checks" << std::endl;
+        }
+    }
+    
+    // Presses count even if the key was released again before this frame
+    void handleKeys() {
+        if (inputState.keyPressed(GLFW_KEY_ESCAPE)) {
+            glfwSetWindowShouldClose(window, true);
+        }
+        handleProfilerKeys();
+        handleHistoryKeys();
+        if (inputState.keyPressed(GLFW_KEY_SPACE) && !replay) {
+            pendingButtons |= LidPong::BUTTON_SERVE;
+        }
+        if (inputState.keyPressed(GLFW_KEY_P)) {
+            setPaused(!userPaused);
+        }
+        handleGestures();
+    }
+    
+    // Flick: restart after game over. Double nudge: pause or resume. Hold: resume.
+    bool handleGestures() {
+        LidPong::LidGestureEvent event;
+        bool any = false;
+        while (gestureEvents.pop(event)) {
+            any = true;
+            switch (event.gesture) {
+            case LidPong::LidGesture::Flick:
+                if (sim.isGameOver()) {
+                    pendingButtons |= LidPong::BUTTON_SERVE;
                 }
+                break;
+            case LidPong::LidGesture::DoubleNudge:
+                setPaused(!userPaused);
+                break;
+            case LidPong::LidGesture::Hold:
+                setPaused(false);
+                break;
             }
         }
-        
-        // Console output with live data
-        if (gameOver) {
-            std::cout << "\rGAME OVER! Final Score: " << score << " hits | Lives: " << lives 
-                      << " | Press SPACE to restart | ESC to quit    " << std::flush;
-        } else {
-            std::cout << "\rHits: " << score << " | Lives: " << lives
-                      << " | Lid: " << std::fixed << std::setprecision(1) << currentLidAngle << " degrees"
-                      << " | Speed: " << std::setprecision(1) << ballSpeedMultiplier << "x"
-                      << " | Ball: (" << std::setprecision(2) << ball.x << "," << ball.y << ")"
-                      << "    " << std::flush;
+        return any;
+    }
+    
+    // Holds the simulation still; not while replaying or in netplay, whose clocks can't stop
+    void setPaused(bool paused) {
+        if (replay || netSession || paused == userPaused) {
+            return;
         }
+        userPaused = paused;
+        std::cout << std::endl << (paused ? "Paused" : "Resumed") << std::endl;
     }
     
-    void render() {
-        glClear(GL_COLOR_BUFFER_BIT);
-        glClearColor(0.0f, 0.0f, 0.0f, 1.0f); // Black background
-        
-        // Draw THIN walls
-        glColor3f(0.5f, 0.5f, 0.5f); // Gray walls
-        
-        // Top wall (very thin)
-        glBegin(GL_QUADS);
-        glVertex2f(-1.0f, 0.95f);
-        glVertex2f(1.0f, 0.95f);
-        glVertex2f(1.0f, 1.0f);
-        glVertex2f(-1.0f, 1.0f);
-        glEnd();
-        
-        // Bottom wall (very thin)
-        glBegin(GL_QUADS);
-        glVertex2f(-1.0f, -1.0f);
-        glVertex2f(1.0f, -1.0f);
-        glVertex2f(1.0f, -0.95f);
-        glVertex2f(-1.0f, -0.95f);
-        glEnd();
-        
-        // Right wall (very thin)
-        glBegin(GL_QUADS);
-        glVertex2f(0.98f, -1.0f);
-        glVertex2f(1.0f, -1.0f);
-        glVertex2f(1.0f, 1.0f);
-        glVertex2f(0.98f, 1.0f);
-        glEnd();
-        
-        // Draw game objects
-        slider.draw();
-        ball.draw();
+    // Rewind and checkpoints; off while recording or replaying, which need an unbroken timeline
+    void handleHistoryKeys() {
+        bool allowed = !replay && !recordingInput && !netSession;
+        bool saveKey = inputState.keyPressed(GLFW_KEY_F5);
+        bool loadKey = inputState.keyPressed(GLFW_KEY_F9);
+        rewinding = allowed && inputState.keyDown(GLFW_KEY_BACKSPACE);
+        if (!allowed) {
+            return;
+        }
         
-        // Draw simple HUD indicators
-        drawHUD();
+        if (saveKey) {
+            sim.save(checkpoint);
+            hasCheckpoint = true;
+        }
+        if (loadKey && hasCheckpoint && sim.restore(checkpoint)) {
+            history.clear();
+            stateGeneration++; // Wall may differ from the cached one
+        }
         
-        // Draw game over modal
-        if (showGameOverModal) {
-            drawGameOverModal();
+        // One frame back per frame held, keeping the oldest
+        if (rewinding && history.size() > 1) {
+            history.popNewest();
+            sim.restore(history.recent(0));
+            stateGeneration++;
         }
     }
     
-    void drawHUD() {
-        // Draw lives as simple squares (no text)
-        glColor3f(1.0f, 0.2f, 0.2f);
-        for (int i = 0; i < lives; i++) {
-            float x = -0.9f + i * 0.08f;
-            glBegin(GL_QUADS);
-            glVertex2f(x - 0.02f, 0.82f);
-            glVertex2f(x + 0.02f, 0.82f);
-            glVertex2f(x + 0.02f, 0.86f);
-            glVertex2f(x - 0.02f, 0.86f);
-            glEnd();
+    // Nothing on screen can change by itself: the game is over or the window
+    // is in the background (which pauses play). A missed ball is served again
+    // at once, so play never waits on a serve.
+    bool isQuiet() const {
+        if (netSession || rewinding || effects.particles().size() > 0) {
+            return false;
         }
-        
-        // Draw score as simple number
-        drawSimpleNumber(score, 0.0f, 0.84f, 0.04f);
-        
-        // Draw speed slider (interactive)
-        drawSpeedSlider();
-        
-        // Lid angle indicator (vertical bar on right)
-        if (sensor.isAvailable()) {
-            glColor3f(0.0f, 1.0f, 0.0f); // Green if sensor working
-            float angleNormalized = (currentLidAngle - 30.0) / 120.0; // Normalize 30-150 degrees
-            if (angleNormalized < 0) angleNormalized = 0;
-            if (angleNormalized > 1) angleNormalized = 1;
-            float barHeight = angleNormalized * 1.6f - 0.8f;
-            
-            glBegin(GL_QUADS);
-            glVertex2f(0.85f, -0.8f);
-            glVertex2f(0.9f, -0.8f);
-            glVertex2f(0.9f, barHeight);
-            glVertex2f(0.85f, barHeight);
-            glEnd();
+        if (userPaused) {
+            return true;
+        }
+        // Held keys and a drag send no further events but still move things
+        if (inputState.keyDown(GLFW_KEY_UP) || inputState.keyDown(GLFW_KEY_DOWN) ||
+            inputState.buttonDown(GLFW_MOUSE_BUTTON_LEFT)) {
+            return false;
+        }
+        if (!inputState.focused()) {
+            return true;
+        }
+        if (replay) {
+            return replayFinished;
+        }
+        return sim.isGameOver();
+    }
+    
+    // Stop drawing and slow the sampler down; the last frame stays on screen
+    void enterIdle() {
+        inputSampler.setIdle(true);
+        renderThread.setPaused(true);
+        if (audio) {
+            audio->setPaused(true);
+        }
+    }
+    
+    void resumeFromIdle() {
+        inputSampler.setIdle(false);
+        renderThread.setPaused(false);
+        if (audio) {
+            audio->setPaused(false);
+        }
+        pacer.resume();
+    }
+    
+    double idleLidAngle() {
+        if (inputSampler.isRunning()) {
+            currentLidAngle = inputSampler.latest().angle;
+        }
+        return currentLidAngle;
+    }
+    
+    // Per-phase heap allocations over the profiler's frame ring; only
+    // ALLOC_TRACK builds count them
+    void reportAllocations() {
+#ifdef LIDPONG_PROFILE
+        if (!LidPong::AllocTracker::enabled()) {
+            return;
+        }
+        LidPong::FrameProfiler& profiler = LidPong::FrameProfiler::instance();
+        std::cout << "Heap allocations over the last " << profiler.frameCount() << " frames:";
+        for (int p = 0; p < static_cast<int>(LidPong::ProfilePhase::Count); p++) {
+            LidPong::ProfilePhase phase = static_cast<LidPong::ProfilePhase>(p);
+            std::cout << " " << LidPong::profilePhaseName(phase) << " " << profiler.phaseStats(phase).allocations;
+        }
+        std::cout << std::endl;
+#endif
+    }
+    
+    // F3 toggles the profiler overlay, F2 dumps a Chrome trace of recent frames
+    void handleProfilerKeys() {
+#ifdef LIDPONG_PROFILE
+        if (inputState.keyPressed(GLFW_KEY_F3)) {
+            showProfilerOverlay = !showProfilerOverlay;
+        }
+        if (inputState.keyPressed(GLFW_KEY_F2)) {
+            writeTrace(traceFile.empty() ? "lidpong-trace.json" : traceFile);
+        }
+#endif
+    }
+    
+    void writeTrace(const std::string& path) {
+#ifdef LIDPONG_PROFILE
+        LidPong::FrameProfiler& profiler = LidPong::FrameProfiler::instance();
+        if (profiler.writeChromeTrace(path, LidPong::FrameProfiler::FRAME_CAPACITY)) {
+            std::cout << std::endl << "Wrote " << profiler.frameCount() << " frames of trace to " << path << std::endl;
         } else {
-            glColor3f(1.0f, 0.0f, 0.0f); // Red if sensor not working
+            std::cerr << std::endl << "Failed to write trace to " << path << std::endl;
         }
-        
-        // Lid angle bar outline
-        glBegin(GL_LINE_LOOP);
-        glVertex2f(0.85f, -0.8f);
-        glVertex2f(0.9f, -0.8f);
-        glVertex2f(0.9f, 0.8f);
-        glVertex2f(0.85f, 0.8f);
-        glEnd();
+#else
+        std::cerr << std::endl << "Profiler not built in; rebuild with 'make PROFILE=1' to write " << path << std::endl;
+#endif
     }
     
-    void drawGameOverModal() {
-        // Semi-transparent overlay
-        glColor4f(0.0f, 0.0f, 0.0f, 0.7f);
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-        glBegin(GL_QUADS);
-        glVertex2f(-1.0f, -1.0f);
-        glVertex2f(1.0f, -1.0f);
-        glVertex2f(1.0f, 1.0f);
-        glVertex2f(-1.0f, 1.0f);
-        glEnd();
-        
-        // Modal box
-        glColor3f(0.2f, 0.2f, 0.3f);
-        glBegin(GL_QUADS);
-        glVertex2f(-0.6f, -0.4f);
-        glVertex2f(0.6f, -0.4f);
-        glVertex2f(0.6f, 0.4f);
-        glVertex2f(-0.6f, 0.4f);
-        glEnd();
-        
-        // Modal border
-        glColor3f(1.0f, 1.0f, 1.0f);
-        glBegin(GL_LINE_LOOP);
-        glVertex2f(-0.6f, -0.4f);
-        glVertex2f(0.6f, -0.4f);
-        glVertex2f(0.6f, 0.4f);
-        glVertex2f(-0.6f, 0.4f);
-        glEnd();
-        
-        // Show final score as number
-        glColor3f(1.0f, 1.0f, 1.0f);
-        drawSimpleNumber(score, 0.0f, 0.0f, 0.08f);
-        
-        // Simple indicator that game is over (red X)
-        glColor3f(1.0f, 0.3f, 0.3f);
-        glBegin(GL_QUADS);
-        // First diagonal
-        glVertex2f(-0.1f, 0.25f); glVertex2f(-0.05f, 0.3f); glVertex2f(0.1f, 0.1f); glVertex2f(0.05f, 0.05f);
-        // Second diagonal  
-        glVertex2f(0.05f, 0.3f); glVertex2f(0.1f, 0.25f); glVertex2f(-0.05f, 0.05f); glVertex2f(-0.1f, 0.1f);
-        glEnd();
-        
-        // "Press space to continue" text
-        glColor3f(0.7f, 0.7f, 0.7f);
-        drawSimpleText("PRESS SPACE TO CONTINUE", 0.0f, -0.25f, 0.025f);
-        
-        glDisable(GL_BLEND);
+    void saveRecording() {
+        recording.finish(sim.checksum());
+        std::string error;
+        if (recording.save(recordFile, error)) {
+            std::cout << "Recorded " << recording.tickCount() << " ticks (" << recording.sizeBytes()
+                      << " bytes of input) to " << recordFile << std::endl;
+        } else {
+            std::cerr << "Failed to save recording: " << error << std::endl;
+        }
     }
     
-    void drawSimpleNumber(int number, float x, float y, float size) {
-        if (number == 0) {
-            drawSimpleDigit(0, x, y, size);
+    void startAudio() {
+        std::string error;
+        audio = LidPong::createAudioBackend(audioOutput, LidPong::AUDIO_SAMPLE_RATE, audioBufferFrames, error);
+        if (!audio || !audio->start(mixer, error)) {
+            std::cerr << "Warning: no sound: " << error << std::endl;
+            audio.reset();
+        }
+    }
+    
+    void openScores() {
+        std::string error;
+        if (!scores.open(scoresDir, error)) {
+            std::cerr << "Warning: scores won't be saved: " << error << std::endl;
             return;
         }
-        
-        // Convert to string to get digits
-        std::string numStr = std::to_string(number);
-        float digitWidth = size * 0.8f;
-        float startX = x - (numStr.length() - 1) * digitWidth * 0.5f;
-        
-        for (size_t i = 0; i < numStr.length(); i++) {
-            int digit = numStr[i] - '0';
-            drawSimpleDigit(digit, startX + i * digitWidth, y, size);
+        if (scores.recoveredBytes() > 0) {
+            std::cerr << "Warning: dropped " << scores.recoveredBytes() << " bytes of an unfinished score record in "
+                      << scoresDir << std::endl;
         }
+        if (scores.corruptBytes() > 0) {
+            std::cerr << "Warning: skipped " << scores.corruptBytes() << " bytes of damaged score records in "
+                      << scoresDir << std::endl;
+        }
+        scoreWriter.start();
+        scoresOpen = true;
     }
     
-    void drawSimpleDigit(int digit, float x, float y, float size) {
-        float w = size * 0.3f;
-        float h = size * 0.5f;
-        float thick = size * 0.08f;
-        
-        glColor3f(1.0f, 1.0f, 1.0f);
+    // On the frame a game ends, queue its score (and input so far) for the writer thread
+    void submitFinishedGame() {
+        bool over = sim.isGameOver();
+        if (over && !wasGameOver && scoresOpen) {
+            LidPong::ScoreRecord record;
+            record.timestampMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+            record.totalHits = sim.totalHits();
+            record.seed = sim.config().seed;
+            record.ticks = sim.tickCount();
+            record.mode = LidPong::scoreModeOf(sim.config());
+            // Ranked by this player's points in versus, bricks broken, otherwise paddle hits
+            if (record.mode == LidPong::ScoreMode::Versus) {
+                record.score = netSession && netOptions.player == 1 ? sim.rightScore() : sim.score();
+            } else {
+                record.score = record.mode == LidPong::ScoreMode::Bricks ? sim.score() : sim.totalHits();
+            }
+            record.player = controller ? controller->name() : playerName;
+            
+            std::vector<uint8_t> replayBytes;
+            if (recordingInput) {
+                LidPong::InputRecording upToNow(recording);
+                upToNow.finish(sim.checksum());
+                upToNow.serialize(replayBytes);
+            }
+            scoreWriter.submit(record, std::move(replayBytes));
+            gamesSubmitted++;
+        }
+        wasGameOver = over;
+    }
+    
+    // Waits for queued scores, then folds them into the index
+    void closeScores() {
+        if (!scoresOpen) {
+            return;
+        }
+        scoreWriter.stop();
+        if (gamesSubmitted > 0) {
+            std::cout << "Scores: saved " << scoreWriter.written() << " of " << gamesSubmitted << " games to " << scoresDir
+                      << std::endl;
+            printLeaderboard(scores, LidPong::scoreModeOf(sim.config()), 5);
+        }
+        scores.close();
+        scoresOpen = false;
+    }
+    
+    void reportLatency() {
+        std::cout << std::endl;
+        if (inputSampler.samplesTaken() == 0) {
+            std::cout << "Input latency: no lid samples were taken" << std::endl;
+            return;
+        }
+        std::cout << "Input thread: " << inputSampler.samplesTaken() << " samples at "
+                  << std::fixed << std::setprecision(1) << inputSampler.achievedRateHz() << " Hz" << std::endl;
+        inputAgeStats.report(std::cout, "Input age at submit");
+        endToEndStats.report(std::cout, "Input to swap complete");
+    }
+    
+    double readLidPosition() {
+        // Pick up the freshest sample from the input thread
+        const LidPong::InputSample& sample = inputSampler.latest();
+        frameInputTimestampNs = sample.timestampNs;
+        currentLidAngle = sample.angle;
         
-        // Very simple 7-segment display using rectangles
-        bool segs[10][7] = {
-            {1,1,1,1,1,1,0}, // 0
-            {0,1,1,0,0,0,0}, // 1  
-            {1,1,0,1,1,0,1}, // 2
-            {1,1,1,1,0,0,1}, // 3
-            {0,1,1,0,0,1,1}, // 4
-            {1,0,1,1,0,1,1}, // 5
-            {1,0,1,1,1,1,1}, // 6
-            {1,1,1,0,0,0,0}, // 7
-            {1,1,1,1,1,1,1}, // 8
-            {1,1,1,1,0,1,1}  // 9
-        };
+        // Update slider with lid sensor
+        double lidPosition = 0.5; // Default center
+        try {
+            if (sensor.isAvailable()) {
+                lidPosition = sample.sliderPosition;
+            } else {
+                // Use keyboard fallback
+                if (inputState.keyDown(GLFW_KEY_UP)) {
+                    lidPosition = 0.8;
+                } else if (inputState.keyDown(GLFW_KEY_DOWN)) {
+                    lidPosition = 0.2;
+                }
+            }
+        } catch (...) {
+            // Fallback to keyboard
+            if (inputState.keyDown(GLFW_KEY_UP)) {
+                lidPosition = 0.8;
+            } else if (inputState.keyDown(GLFW_KEY_DOWN)) {
+                lidPosition = 0.2;
+            }
+        }
         
-        if (digit < 0 || digit > 9) return;
+        return lidPosition;
+    }
+    
+    // Variable step per frame, or as many fixed ticks as the frame time covers.
+    // Button edges go to the first tick that runs after they happened.
+    void simulate(float deltaTime, double lidPosition) {
+        if (netSession) {
+            simulateNet(deltaTime, lidPosition);
+            return;
+        }
         
-        glBegin(GL_QUADS);
+        LidPong::TickInput input;
+        input.lidPosition = LidPong::TickInput::quantiseLid(lidPosition);
+        input.speedSetting = pendingSpeedSetting;
+        input.buttons = pendingButtons;
         
-        // Top horizontal (segment 0)
-        if (segs[digit][0]) {
-            glVertex2f(x-w+thick, y+h-thick);
-            glVertex2f(x+w-thick, y+h-thick);
-            glVertex2f(x+w-thick, y+h);
-            glVertex2f(x-w+thick, y+h);
+        if (tickSeconds <= 0.0f) {
+            input.deltaTime = deltaTime;
+            stepTick(input, true);
+            return;
         }
         
-        // Top right vertical (segment 1)
-        if (segs[digit][1]) {
-            glVertex2f(x+w-thick, y);
-            glVertex2f(x+w, y);
-            glVertex2f(x+w, y+h-thick);
-            glVertex2f(x+w-thick, y+h-thick);
+        const int maxTicksPerFrame = 8; // Don't spiral after a long stall
+        tickAccumulator += deltaTime;
+        int ticks = 0;
+        input.deltaTime = tickSeconds;
+        while (tickAccumulator >= tickSeconds && ticks < maxTicksPerFrame) {
+            stepTick(input, ticks == 0);
+            input.buttons = 0;
+            tickAccumulator -= tickSeconds;
+            ticks++;
         }
-        
-        // Bottom right vertical (segment 2)
-        if (segs[digit][2]) {
-            glVertex2f(x+w-thick, y-h+thick);
-            glVertex2f(x+w, y-h+thick);
-            glVertex2f(x+w, y);
-            glVertex2f(x+w-thick, y);
+        if (ticks == maxTicksPerFrame) {
+            tickAccumulator = 0.0f;
         }
+    }
+    
+    // Fixed ticks through the rollback session; it refuses to run too far ahead of the peer
+    void simulateNet(float deltaTime, double lidPosition) {
+        netLink->pump(LidPong::Clock::nowNs());
         
-        // Bottom horizontal (segment 3)
-        if (segs[digit][3]) {
-            glVertex2f(x-w+thick, y-h);
-            glVertex2f(x+w-thick, y-h);
-            glVertex2f(x+w-thick, y-h+thick);
-            glVertex2f(x-w+thick, y-h+thick);
-        }
+        LidPong::PlayerInput local;
+        local.lid = LidPong::TickInput::lidToFixed(lidPosition);
+        local.buttons = pendingButtons & (LidPong::BUTTON_SERVE | LidPong::BUTTON_SPEED_UP | LidPong::BUTTON_SPEED_DOWN);
         
-        // Bottom left vertical (segment 4)
-        if (segs[digit][4]) {
-            glVertex2f(x-w, y-h+thick);
-            glVertex2f(x-w+thick, y-h+thick);
-            glVertex2f(x-w+thick, y);
-            glVertex2f(x-w, y);
+        const int maxTicksPerFrame = 8;
+        tickAccumulator += deltaTime;
+        int ticks = 0;
+        while (tickAccumulator >= tickSeconds && ticks < maxTicksPerFrame) {
+            if (!netSession->advance(local)) {
+                tickAccumulator = std::min(tickAccumulator, tickSeconds); // Waiting for the peer
+                break;
+            }
+            local.buttons = 0;
+            pendingButtons = 0;
+            tickAccumulator -= tickSeconds;
+            ticks++;
         }
-        
-        // Top left vertical (segment 5)
-        if (segs[digit][5]) {
-            glVertex2f(x-w, y);
-            glVertex2f(x-w+thick, y);
-            glVertex2f(x-w+thick, y+h-thick);
-            glVertex2f(x-w, y+h-thick);
+        if (ticks == maxTicksPerFrame) {
+            tickAccumulator = 0.0f;
         }
-        
-        // Middle horizontal (segment 6)
-        if (segs[digit][6]) {
-            glVertex2f(x-w+thick, y-thick/2);
-            glVertex2f(x+w-thick, y-thick/2);
-            glVertex2f(x+w-thick, y+thick/2);
-            glVertex2f(x-w+thick, y+thick/2);
+        if (ticks == 0) {
+            netSession->update();
         }
-        
-        glEnd();
     }
     
-    void drawSimpleText(const std::string& text, float x, float y, float size) {
-        float charWidth = size * 0.8f;
-        float startX = x - (text.length() - 1) * charWidth * 0.5f;
-        
-        for (size_t i = 0; i < text.length(); i++) {
-            char c = text[i];
-            drawSimpleChar(c, startX + i * charWidth, y, size);
+    void stepTick(const LidPong::TickInput& input, bool frameStart) {
+        if (recordingInput) {
+            recording.append(input, frameStart);
         }
+        if (params) {
+            sim.setParams(params->current()); // Saved edits apply from the next tick
+        }
+        sim.step(input);
+        pendingButtons = 0;
     }
     
-    void drawSimpleChar(char c, float x, float y, float size) {
-        float w = size * 0.3f;
-        float h = size * 0.4f;
-        float thick = size * 0.1f;
-        
-        glBegin(GL_QUADS);
-        
-        switch (c) {
-            case 'A':
-                // Left vertical
-                glVertex2f(x-w, y-h); glVertex2f(x-w+thick, y-h); glVertex2f(x-w+thick, y+h); glVertex2f(x-w, y+h);
-                // Right vertical
-                glVertex2f(x+w-thick, y-h); glVertex2f(x+w, y-h); glVertex2f(x+w, y+h); glVertex2f(x+w-thick, y+h);
-                // Top horizontal
-                glVertex2f(x-w, y+h-thick); glVertex2f(x+w, y+h-thick); glVertex2f(x+w, y+h); glVertex2f(x-w, y+h);
-                // Middle horizontal
-                glVertex2f(x-w+thick, y-thick/2); glVertex2f(x+w-thick, y-thick/2); glVertex2f(x+w-thick, y+thick/2); glVertex2f(x-w+thick, y+thick/2);
-                break;
-                
-            case 'C':
-                // Left vertical
-                glVertex2f(x-w, y-h); glVertex2f(x-w+thick, y-h); glVertex2f(x-w+thick, y+h); glVertex2f(x-w, y+h);
-                // Top horizontal
-                glVertex2f(x-w, y+h-thick); glVertex2f(x+w, y+h-thick); glVertex2f(x+w, y+h); glVertex2f(x-w, y+h);
-                // Bottom horizontal
-                glVertex2f(x-w, y-h); glVertex2f(x+w, y-h); glVertex2f(x+w, y-h+thick); glVertex2f(x-w, y-h+thick);
-                break;
-                
-            case 'E':
-                // Left vertical
-                glVertex2f(x-w, y-h); glVertex2f(x-w+thick, y-h); glVertex2f(x-w+thick, y+h); glVertex2f(x-w, y+h);
-                // Top horizontal
-                glVertex2f(x-w, y+h-thick); glVertex2f(x+w, y+h-thick); glVertex2f(x+w, y+h); glVertex2f(x-w, y+h);
-                // Middle horizontal
-                glVertex2f(x-w+thick, y-thick/2); glVertex2f(x+w*0.7f, y-thick/2); glVertex2f(x+w*0.7f, y+thick/2); glVertex2f(x-w+thick, y+thick/2);
-                // Bottom horizontal
-                glVertex2f(x-w, y-h); glVertex2f(x+w, y-h); glVertex2f(x+w, y-h+thick); glVertex2f(x-w, y-h+thick);
-                break;
-                
-            case 'I':
-                // Top horizontal
-                glVertex2f(x-w, y+h-thick); glVertex2f(x+w, y+h-thick); glVertex2f(x+w, y+h); glVertex2f(x-w, y+h);
-                // Center vertical
-                glVertex2f(x-thick/2, y-h); glVertex2f(x+thick/2, y-h); glVertex2f(x+thick/2, y+h); glVertex2f(x-thick/2, y+h);
-                // Bottom horizontal
-                glVertex2f(x-w, y-h); glVertex2f(x+w, y-h); glVertex2f(x+w, y-h+thick); glVertex2f(x-w, y-h+thick);
-                break;
-                
-            case 'N':
-                // Left vertical
-                glVertex2f(x-w, y-h); glVertex2f(x-w+thick, y-h); glVertex2f(x-w+thick, y+h); glVertex2f(x-w, y+h);
-                // Right vertical
-                glVertex2f(x+w-thick, y-h); glVertex2f(x+w, y-h); glVertex2f(x+w, y+h); glVertex2f(x+w-thick, y+h);
-                // Diagonal
-                glVertex2f(x-w+thick, y+h-thick); glVertex2f(x, y); glVertex2f(x+thick/2, y); glVertex2f(x-w+thick*1.5f, y+h-thick);
-                break;
-                
-            case 'O':
-                // Left vertical
-                glVertex2f(x-w, y-h+thick); glVertex2f(x-w+thick, y-h+thick); glVertex2f(x-w+thick, y+h-thick); glVertex2f(x-w, y+h-thick);
-                // Right vertical
-                glVertex2f(x+w-thick, y-h+thick); glVertex2f(x+w, y-h+thick); glVertex2f(x+w, y+h-thick); glVertex2f(x+w-thick, y+h-thick);
-                // Top horizontal
-                glVertex2f(x-w+thick, y+h-thick); glVertex2f(x+w-thick, y+h-thick); glVertex2f(x+w-thick, y+h); glVertex2f(x-w+thick, y+h);
-                // Bottom horizontal
-                glVertex2f(x-w+thick, y-h); glVertex2f(x+w-thick, y-h); glVertex2f(x+w-thick, y-h+thick); glVertex2f(x-w+thick, y-h+thick);
-                break;
-                
-            case 'P':
-                // Left vertical
-                glVertex2f(x-w, y-h); glVertex2f(x-w+thick, y-h); glVertex2f(x-w+thick, y+h); glVertex2f(x-w, y+h);
-                // Top horizontal
-                glVertex2f(x-w, y+h-thick); glVertex2f(x+w, y+h-thick); glVertex2f(x+w, y+h); glVertex2f(x-w, y+h);
-                // Right vertical (top half)
-                glVertex2f(x+w-thick, y); glVertex2f(x+w, y); glVertex2f(x+w, y+h); glVertex2f(x+w-thick, y+h);
-                // Middle horizontal
-                glVertex2f(x-w+thick, y-thick/2); glVertex2f(x+w, y-thick/2); glVertex2f(x+w, y+thick/2); glVertex2f(x-w+thick, y+thick/2);
-                break;
-                
-            case 'R':
-                // Left vertical
-                glVertex2f(x-w, y-h); glVertex2f(x-w+thick, y-h); glVertex2f(x-w+thick, y+h); glVertex2f(x-w, y+h);
-                // Top horizontal
-                glVertex2f(x-w, y+h-thick); glVertex2f(x+w, y+h-thick); glVertex2f(x+w, y+h); glVertex2f(x-w, y+h);
-                // Right vertical (top half)
-                glVertex2f(x+w-thick, y); glVertex2f(x+w, y); glVertex2f(x+w, y+h); glVertex2f(x+w-thick, y+h);
-                // Middle horizontal
-                glVertex2f(x-w+thick, y-thick/2); glVertex2f(x+w, y-thick/2); glVertex2f(x+w, y+thick/2); glVertex2f(x-w+thick, y+thick/2);
-                // Diagonal
-                glVertex2f(x, y-thick/2); glVertex2f(x+thick/2, y-thick/2); glVertex2f(x+w, y-h); glVertex2f(x+w-thick/2, y-h);
-                break;
-                
-            case 'S':
-                // Top horizontal
-                glVertex2f(x-w, y+h-thick); glVertex2f(x+w, y+h-thick); glVertex2f(x+w, y+h); glVertex2f(x-w, y+h);
-                // Left vertical (top half)
-                glVertex2f(x-w, y); glVertex2f(x-w+thick, y); glVertex2f(x-w+thick, y+h); glVertex2f(x-w, y+h);
-                // Middle horizontal
-                glVertex2f(x-w, y-thick/2); glVertex2f(x+w, y-thick/2); glVertex2f(x+w, y+thick/2); glVertex2f(x-w, y+thick/2);
-                // Right vertical (bottom half)
-                glVertex2f(x+w-thick, y-h); glVertex2f(x+w, y-h); glVertex2f(x+w, y); glVertex2f(x+w-thick, y);
-                // Bottom horizontal
-                glVertex2f(x-w, y-h); glVertex2f(x+w, y-h); glVertex2f(x+w, y-h+thick); glVertex2f(x-w, y-h+thick);
-                break;
-                
-            case 'T':
-                // Top horizontal
-                glVertex2f(x-w, y+h-thick); glVertex2f(x+w, y+h-thick); glVertex2f(x+w, y+h); glVertex2f(x-w, y+h);
-                // Center vertical
-                glVertex2f(x-thick/2, y-h); glVertex2f(x+thick/2, y-h); glVertex2f(x+thick/2, y+h); glVertex2f(x-thick/2, y+h);
-                break;
-                
-            case 'U':
-                // Left vertical
-                glVertex2f(x-w, y-h+thick); glVertex2f(x-w+thick, y-h+thick); glVertex2f(x-w+thick, y+h); glVertex2f(x-w, y+h);
-                // Right vertical
-                glVertex2f(x+w-thick, y-h+thick); glVertex2f(x+w, y-h+thick); glVertex2f(x+w, y+h); glVertex2f(x+w-thick, y+h);
-                // Bottom horizontal
-                glVertex2f(x-w+thick, y-h); glVertex2f(x+w-thick, y-h); glVertex2f(x+w-thick, y-h+thick); glVertex2f(x-w+thick, y-h+thick);
-                break;
-                
-            case ' ':
-                // Space - draw nothing
-                break;
-                
-            default:
-                // Unknown character - draw a small box
-                glVertex2f(x-w/2, y-h/2); glVertex2f(x+w/2, y-h/2); glVertex2f(x+w/2, y+h/2); glVertex2f(x-w/2, y+h/2);
+    // Run the recorded ticks up to the start of the next recorded frame
+    void replayFrame() {
+        int ticks = 0;
+        while (replayNextValid || (replayNextValid = replayReader->next(replayNext, replayNextFrameStart))) {
+            if (replayNextFrameStart && ticks > 0) {
                 break;
+            }
+            sim.step(replayNext);
+            replayNextValid = false;
+            ticks++;
         }
         
-        glEnd();
+        if (ticks == 0 && !replayFinished) {
+            replayFinished = true;
+            bool match = replay->hasFinalChecksum() && sim.checksum() == replay->finalChecksum();
+            std::cout << std::endl << "Replay finished after " << sim.tickCount() << " ticks: "
+                      << (match ? "final state matches the recording" : "final state differs from the recording")
+                      << std::endl;
+        }
     }
     
-    void drawSpeedSlider() {
-        // Speed slider background
-        glColor3f(0.3f, 0.3f, 0.3f);
-        glBegin(GL_QUADS);
-        glVertex2f(-0.4f, -0.85f);
-        glVertex2f(0.4f, -0.85f);
-        glVertex2f(0.4f, -0.8f);
-        glVertex2f(-0.4f, -0.8f);
-        glEnd();
+    // Console output with live data
+    void printStatus() {
+        if (sim.isVersus()) {
+            std::cout << "\rVersus " << sim.score() << " : " << sim.rightScore()
+                      << (sim.isGameOver() ? " GAME OVER - SPACE to restart" : "")
+                      << " | Tick: " << (netSession ? netSession->currentTick() : sim.tickCount())
+                      << " | Rollbacks: " << (netSession ? netSession->stats().rollbacks : 0)
+                      << " | Lid: " << std::fixed << std::setprecision(1) << currentLidAngle << " degrees"
+                      << "    " << std::flush;
+        } else if (sim.isBrickMode()) {
+            std::cout << "\rBricks: " << sim.brickField().aliveCount() << "/" << sim.brickField().brickCount()
+                      << " | Score: " << sim.score() << " | Paddle hits: " << sim.totalHits() << " | Lives: " << sim.lives()
+                      << " | Lid: " << std::fixed << std::setprecision(1) << currentLidAngle << " degrees"
+                      << "    " << std::flush;
+        } else if (sim.isMultiBall()) {
+            std::cout << "\rBalls: " << sim.swarm().size() << " | Hits: " << sim.score() << " | Misses: " << sim.swarmMisses()
+                      << " | Lid: " << std::fixed << std::setprecision(1) << currentLidAngle << " degrees"
+                      << " | Speed: " << std::setprecision(1) << sim.ballSpeedMultiplier() << "x"
+                      << "    " << std::flush;
+        } else if (sim.isGameOver()) {
+            std::cout << "\rGAME OVER! Final Score: " << sim.score() << " hits | Lives: " << sim.lives()
+                      << " | Press SPACE to restart | ESC to quit    " << std::flush;
+        } else {
+            std::cout << "\rHits: " << sim.score() << " | Lives: " << sim.lives()
+                      << " | Lid: " << std::fixed << std::setprecision(1) << currentLidAngle << " degrees"
+                      << " | Speed: " << std::setprecision(1) << sim.ballSpeedMultiplier() << "x"
+                      << " | Ball: (" << std::setprecision(2) << sim.ball().x << "," << sim.ball().y << ")"
+                      << "    " << std::flush;
+        }
+    }
+    
+    // Copy what the next frame shows out of the simulation (main thread)
+    void captureFrame(LidPong::RenderSnapshot& out) {
+        out.capture(sim, stateGeneration);
+        out.captureParticles(effects.particles());
+        out.hud.sensorAvailable = sensor.isAvailable();
+        out.hud.lidAngle = currentLidAngle;
+        out.inputTimestampNs = frameInputTimestampNs;
+        out.framebufferWidth = inputState.framebufferWidth();
+        out.framebufferHeight = inputState.framebufferHeight();
+    }
+    
+    // RenderTarget: called on the render thread with --render-thread, else from run()
+    void beginRendering() override {
+        glfwMakeContextCurrent(window);
+        glfwSwapInterval(pacingOptions.vsync ? 1 : 0);
+    }
+    
+    void draw(const LidPong::RenderSnapshot& snapshot) override {
+        canvas.setSize(snapshot.framebufferWidth, snapshot.framebufferHeight);
+        scene.draw(canvas, snapshot);
         
-        // Speed slider fill
-        glColor3f(0.6f, 0.6f, 1.0f);
-        float speedBarWidth = ((ballSpeedMultiplier - 0.2f) / (3.0f - 0.2f)) * 0.8f;
-        glBegin(GL_QUADS);
-        glVertex2f(-0.4f, -0.85f);
-        glVertex2f(-0.4f + speedBarWidth, -0.85f);
-        glVertex2f(-0.4f + speedBarWidth, -0.8f);
-        glVertex2f(-0.4f, -0.8f);
-        glEnd();
+#ifdef LIDPONG_PROFILE
+        if (showProfilerOverlay && !useRenderThread) {
+            drawProfilerOverlay();
+        }
+#endif
+        if (useRenderThread && snapshot.inputTimestampNs != 0) {
+            presentedInputTimestampNs = snapshot.inputTimestampNs;
+            inputAgeStats.record(LidPong::Clock::nsToMs(LidPong::Clock::nowNs() - presentedInputTimestampNs));
+        }
+    }
+    
+    void present() override {
+        glfwSwapBuffers(window);
+        if (presentedInputTimestampNs != 0) {
+            endToEndStats.record(LidPong::Clock::nsToMs(LidPong::Clock::nowNs() - presentedInputTimestampNs));
+        }
+    }
+    
+    void endRendering() override {
+        glfwMakeContextCurrent(nullptr);
+    }
+    
+#ifdef LIDPONG_PROFILE
+    void drawProfilerOverlay() {
+        using LidPong::ProfilePhase;
+        static const float phaseColors[][3] = {
+            {0.4f, 0.8f, 1.0f}, // events
+            {0.6f, 0.6f, 1.0f}, // speed slider
+            {0.2f, 1.0f, 0.4f}, // input
+            {1.0f, 0.8f, 0.2f}, // update
+            {1.0f, 0.4f, 0.2f}, // render
+            {1.0f, 0.2f, 0.8f}, // swap
+            {0.5f, 0.5f, 0.5f}  // pacing
+        };
+        const int phaseCount = static_cast<int>(ProfilePhase::Count);
+        const float left = -0.75f, top = 0.7f, rowHeight = 0.07f;
+        const float barScale = 1.2f / 16667.0f; // Full bar = one 60 Hz frame
         
-        // Speed slider handle
-        float handleX = -0.4f + speedBarWidth;
-        glColor3f(1.0f, 1.0f, 1.0f);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glColor4f(0.0f, 0.0f, 0.0f, 0.6f);
         glBegin(GL_QUADS);
-        glVertex2f(handleX - 0.02f, -0.87f);
-        glVertex2f(handleX + 0.02f, -0.87f);
-        glVertex2f(handleX + 0.02f, -0.78f);
-        glVertex2f(handleX - 0.02f, -0.78);
+        glVertex2f(left - 0.05f, top - phaseCount * rowHeight - 0.02f);
+        glVertex2f(left + 1.55f, top - phaseCount * rowHeight - 0.02f);
+        glVertex2f(left + 1.55f, top + 0.03f);
+        glVertex2f(left - 0.05f, top + 0.03f);
         glEnd();
+        glDisable(GL_BLEND);
         
-        // Speed value display as simple bars
-        int speedBars = (int)(ballSpeedMultiplier * 5);
-        glColor3f(1.0f, 1.0f, 0.0f);
-        for (int i = 0; i < speedBars && i < 15; i++) {
-            float x = -0.3f + i * 0.04f;
+        for (int p = 0; p < phaseCount; p++) {
+            LidPong::PhaseStats stats = LidPong::FrameProfiler::instance().phaseStats(static_cast<ProfilePhase>(p));
+            float y = top - p * rowHeight - rowHeight / 2;
+            float meanWidth = std::min(1.2f, static_cast<float>(stats.meanUs) * barScale);
+            float p95X = left + std::min(1.2f, static_cast<float>(stats.p95Us) * barScale);
+            
+            // Mean as a filled bar, p95 as a white tick
+            glColor3fv(phaseColors[p]);
+            glBegin(GL_QUADS);
+            glVertex2f(left, y - rowHeight * 0.3f);
+            glVertex2f(left + meanWidth, y - rowHeight * 0.3f);
+            glVertex2f(left + meanWidth, y + rowHeight * 0.3f);
+            glVertex2f(left, y + rowHeight * 0.3f);
+            glEnd();
+            
+            glColor3f(1.0f, 1.0f, 1.0f);
             glBegin(GL_QUADS);
-            glVertex2f(x, -0.92f);
-            glVertex2f(x + 0.02f, -0.92f);
-            glVertex2f(x + 0.02f, -0.88f);
-            glVertex2f(x, -0.88f);
+            glVertex2f(p95X - 0.004f, y - rowHeight * 0.4f);
+            glVertex2f(p95X + 0.004f, y - rowHeight * 0.4f);
+            glVertex2f(p95X + 0.004f, y + rowHeight * 0.4f);
+            glVertex2f(p95X - 0.004f, y + rowHeight * 0.4f);
             glEnd();
+            
+            // Mean in microseconds
+            scene.drawSimpleNumber(canvas, static_cast<int>(stats.meanUs), left + 1.4f, y, 0.04f);
         }
     }
+#endif
     
     void handleSpeedSliderInput() {
-        // Mouse input for speed slider
-        double mouseX, mouseY;
-        glfwGetCursorPos(window, &mouseX, &mouseY);
+        // Mouse input for speed slider: where it is while held, or where a click landed
+        const int button = GLFW_MOUSE_BUTTON_LEFT;
+        bool held = inputState.buttonDown(button);
+        double mouseX = held ? inputState.cursorX() : inputState.pressX(button);
+        double mouseY = held ? inputState.cursorY() : inputState.pressY(button);
         
         // Convert to OpenGL coordinates
-        int windowWidth, windowHeight;
-        glfwGetWindowSize(window, &windowWidth, &windowHeight);
+        int windowWidth = std::max(1, inputState.windowWidth());
+        int windowHeight = std::max(1, inputState.windowHeight());
         float glX = (mouseX / windowWidth) * 2.0f - 1.0f;
         float glY = 1.0f - (mouseY / windowHeight) * 2.0f;
         
         // Check if mouse is over speed slider
-        if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS &&
+        if ((held || inputState.buttonPressed(button)) &&
             glY >= -0.87f && glY <= -0.78f && glX >= -0.4f && glX <= 0.4f) {
             
+            const float minSpeed = LidPong::Simulation::MIN_SPEED, maxSpeed = LidPong::Simulation::MAX_SPEED;
             float sliderPos = (glX + 0.4f) / 0.8f; // Normalize to 0-1
-            ballSpeedMultiplier = 0.2f + sliderPos * (3.0f - 0.2f);
+            float speed = minSpeed + sliderPos * (maxSpeed - minSpeed);
             
             // Clamp values
-            if (ballSpeedMultiplier < 0.2f) ballSpeedMultiplier = 0.2f;
-            if (ballSpeedMultiplier > 3.0f) ballSpeedMultiplier = 3.0f;
+            if (speed < minSpeed) speed = minSpeed;
+            if (speed > maxSpeed) speed = maxSpeed;
+            
+            // Only changes go into the tick input (and the recording)
+            if (speed != sim.ballSpeedMultiplier()) {
+                pendingButtons |= LidPong::BUTTON_SPEED_SET;
+                pendingSpeedSetting = speed;
+            }
         }
         
         // Keyboard fallback
-        static bool plusPressed = false, minusPressed = false;
-        bool plusKey = glfwGetKey(window, GLFW_KEY_EQUAL) == GLFW_PRESS || glfwGetKey(window, GLFW_KEY_KP_ADD) == GLFW_PRESS;
-        bool minusKey = glfwGetKey(window, GLFW_KEY_MINUS) == GLFW_PRESS || glfwGetKey(window, GLFW_KEY_KP_SUBTRACT) == GLFW_PRESS;
-        
-        if (plusKey && !plusPressed) {
-            ballSpeedMultiplier += 0.2f;
-            if (ballSpeedMultiplier > 3.0f) ballSpeedMultiplier = 3.0f;
+        if (inputState.keyPressed(GLFW_KEY_EQUAL) || inputState.keyPressed(GLFW_KEY_KP_ADD)) {
+            pendingButtons |= LidPong::BUTTON_SPEED_UP;
         }
-        if (minusKey && !minusPressed) {
-            ballSpeedMultiplier -= 0.2f;
-            if (ballSpeedMultiplier < 0.2f) ballSpeedMultiplier = 0.2f;
+        if (inputState.keyPressed(GLFW_KEY_MINUS) || inputState.keyPressed(GLFW_KEY_KP_SUBTRACT)) {
+            pendingButtons |= LidPong::BUTTON_SPEED_DOWN;
         }
-        plusPressed = plusKey;
-        minusPressed = minusKey;
     }
     
     void cleanup() {
+        inputSampler.stop(); // Reads 'params'
+        if (params) {
+            params->stopWatching(); // Posts GLFW events
+        }
+        renderThread.stop();
         if (window) {
             glfwDestroyWindow(window);
         }
@@ -759,8 +1238,309 @@ public:
     }
 };
 
-int main() {
-    LidPongGame game;
+// The recording kept with place 'rank' (1-based) of the leaderboard the options select
+static bool loadRankedReplay(const GameOptions& options, LidPong::InputRecording& replay, std::string& error) {
+    LidPong::ScoreStore store;
+    if (!store.open(options.scoresDir, error)) {
+        return false;
+    }
+    LidPong::ScoreMode mode = LidPong::scoreModeOf(options.simulationConfig());
+    std::vector<LidPong::ScoreEntry> entries = store.top(mode, options.replayRank);
+    if (entries.size() < options.replayRank) {
+        error = "only " + std::to_string(entries.size()) + " " + LidPong::scoreModeName(mode) + " scores saved";
+        return false;
+    }
+    const LidPong::ScoreEntry& entry = entries[options.replayRank - 1];
+    if (!entry.hasReplay) {
+        error = "no replay was kept for that game (play with --keep-replays)";
+        return false;
+    }
+    LidPong::ScoreRecord record;
+    std::vector<uint8_t> bytes;
+    return store.read(entry, record, &bytes, error) && replay.deserialize(bytes, error);
+}
+
+static void printUsage(const char* program) {
+    std::cout << "Usage: " << program << " [options]" << std::endl;
+    std::cout << "  --input-hz N   Lid sensor sampling rate of the input thread (default 500, 0 = unthrottled)" << std::endl;
+    std::cout << "  --fps N        Frame limiter target (default off)" << std::endl;
+    std::cout << "  --no-vsync     Don't wait for vertical blank in glfwSwapBuffers" << std::endl;
+    std::cout << "  --late-input   Start each frame just in time so input is sampled right before render" << std::endl;
+    std::cout << "  --render-thread  Draw and swap on their own thread; the main loop runs at --fps (default 240)" << std::endl;
+    std::cout << "  --no-idle      Keep drawing every frame when the game is over, waiting or in the background" << std::endl;
+    std::cout << "  --trace FILE   Write a Chrome trace of the last frames on exit (make PROFILE=1 builds)" << std::endl;
+    std::cout << "  --tick-hz N    Fixed simulation rate (default: one step per frame)" << std::endl;
+    std::cout << "  --balls N      Multi-ball party mode with N balls (ball count in brick mode)" << std::endl;
+    std::cout << "  --bricks N     Brick-breaking mode with about N bricks" << std::endl;
+    std::cout << "  --seed N       Simulation random seed (default: from the clock)" << std::endl;
+    std::cout << "  --record FILE  Record every tick's input to FILE for exact replay" << std::endl;
+    std::cout << "  --replay FILE  Play a recording back instead of live input" << std::endl;
+    std::cout << "  --headless     With --replay: no window, run as fast as possible and verify" << std::endl;
+    std::cout << "  --scores DIR   Leaderboard and replay store (default ~/.lidpong)" << std::endl;
+    std::cout << "  --no-scores    Don't save finished games" << std::endl;
+    std::cout << "  --name NAME    Name to save scores under (default: your login name)" << std::endl;
+    std::cout << "  --keep-replays Save each game's input with its score (turns rewind off, like --record)" << std::endl;
+    std::cout << "  --top N        Print the best N scores for the chosen mode and exit (with --name: yours)" << std::endl;
+    std::cout << "  --replay-score N  Watch the game in place N of that list (saved with --keep-replays)" << std::endl;
+    std::cout << "  --audio OUT    Sound output: system (default), null, off, or FILE.wav to record it" << std::endl;
+    std::cout << "  --audio-buffer N  Frames per audio buffer at 48 kHz (default 256)" << std::endl;
+    std::cout << "  --gestures     Lid gestures as buttons: flick, double nudge, move and hold" << std::endl;
+    std::cout << "  --angle-trace FILE  Write every lid sensor read (failed ones too) to FILE.lpat" << std::endl;
+    std::cout << "  --analyze PATH Report on the angle traces in PATH (a file or a directory, searched" << std::endl;
+    std::cout << "                 recursively; may be repeated) and exit" << std::endl;
+    std::cout << "  --threads N    Threads for --analyze (default: one per core)" << std::endl;
+    std::cout << "  --gap-ms MS    --analyze: longer sample intervals are dropouts (default 4 sample periods)" << std::endl;
+    std::cout << "  --params FILE  Gameplay params (slider feel, serve speed, lid angle range), reloaded" << std::endl;
+    std::cout << "                 on every save; not with --record or --replay, and scores aren't saved" << std::endl;
+    std::cout << "  --print-params Print a params file with the defaults (with --params: check FILE) and exit" << std::endl;
+    std::cout << "  --bot          Let the tracking bot play" << std::endl;
+    std::cout << "  --bot-delay MS Bot reaction delay (default 80)" << std::endl;
+    std::cout << "  --bot-noise X  Bot aiming error in paddle heights (default 1.0)" << std::endl;
+    std::cout << "  --soak N       Play N bot games headless back to back and report" << std::endl;
+    std::cout << "  --peer HOST:PORT  Two-player versus with the peer at HOST:PORT (UDP, rollback)" << std::endl;
+    std::cout << "  --net PORT     Local UDP port for --peer (default: any)" << std::endl;
+    std::cout << "  --player N     0 = left paddle (default), 1 = right paddle" << std::endl;
+    std::cout << "  --net-latency MS / --net-jitter MS / --net-loss P  Degrade outgoing packets for testing" << std::endl;
+    std::cout << "  --dump-frames DIR  With --replay --headless: render every frame in software to DIR" << std::endl;
+    std::cout << "  --dump-format F    png (default) or ppm" << std::endl;
+    std::cout << "  --frame-size WxH   Software-rendered frame size (default 800x600)" << std::endl;
+    std::cout << "  --bench NAME   Run a headless benchmark and exit" << std::endl;
+    std::cout << "                 (balls, ccd, bricks, envs, snapshot, netplay, render, input, particles, alloc, idle, scores, audio, gestures, traces, params)" << std::endl;
+    std::cout << "                 --balls N sets the ball count for 'balls', the game count for 'envs' and 'scores'" << std::endl;
+    std::cout << "                 and the particle count for 'particles'" << std::endl;
+    std::cout << "                 --analyze PATH runs 'traces' on those traces instead of a synthetic corpus" << std::endl;
+    std::cout << "                 --golden DIR compares 'render' frames with DIR/<scene>.ppm" << std::endl;
+    std::cout << "  --help         Show this help message" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    GameOptions options;
+    std::string benchmark;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--input-hz" && i + 1 < argc) {
+            options.inputRateHz = std::atof(argv[++i]);
+        } else if (arg == "--fps" && i + 1 < argc) {
+            options.pacing.targetFps = std::atof(argv[++i]);
+        } else if (arg == "--no-vsync") {
+            options.pacing.vsync = false;
+        } else if (arg == "--late-input") {
+            options.pacing.lateInput = true;
+        } else if (arg == "--trace" && i + 1 < argc) {
+            options.traceFile = argv[++i];
+        } else if (arg == "--tick-hz" && i + 1 < argc) {
+            options.tickRateHz = std::atof(argv[++i]);
+        } else if (arg == "--bricks" && i + 1 < argc) {
+            options.brickCount = static_cast<size_t>(std::atol(argv[++i]));
+        } else if (arg == "--balls" && i + 1 < argc) {
+            options.multiBallCount = static_cast<size_t>(std::atol(argv[++i]));
+        } else if (arg == "--seed" && i + 1 < argc) {
+            options.seed = std::strtoull(argv[++i], nullptr, 0);
+        } else if (arg == "--record" && i + 1 < argc) {
+            options.recordFile = argv[++i];
+        } else if (arg == "--replay" && i + 1 < argc) {
+            options.replayFile = argv[++i];
+        } else if (arg == "--headless") {
+            options.headless = true;
+        } else if (arg == "--scores" && i + 1 < argc) {
+            options.scoresDir = argv[++i];
+        } else if (arg == "--no-scores") {
+            options.scoresDir = "-";
+        } else if (arg == "--name" && i + 1 < argc) {
+            options.playerName = argv[++i];
+        } else if (arg == "--keep-replays") {
+            options.keepReplays = true;
+        } else if (arg == "--top" && i + 1 < argc) {
+            options.topCount = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+        } else if (arg == "--replay-score" && i + 1 < argc) {
+            options.replayRank = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+        } else if (arg == "--audio" && i + 1 < argc) {
+            options.audioOutput = argv[++i];
+        } else if (arg == "--audio-buffer" && i + 1 < argc) {
+            options.audioBufferFrames = static_cast<size_t>(std::max(16, std::atoi(argv[++i])));
+        } else if (arg == "--gestures") {
+            options.gestures = true;
+        } else if (arg == "--angle-trace" && i + 1 < argc) {
+            options.angleTraceFile = argv[++i];
+        } else if (arg == "--analyze" && i + 1 < argc) {
+            options.analyzePaths.push_back(argv[++i]);
+        } else if (arg == "--threads" && i + 1 < argc) {
+            options.analyze.threads = static_cast<size_t>(std::max(0, std::atoi(argv[++i])));
+        } else if (arg == "--gap-ms" && i + 1 < argc) {
+            options.analyze.gapMs = std::atof(argv[++i]);
+        } else if (arg == "--params" && i + 1 < argc) {
+            options.paramsFile = argv[++i];
+        } else if (arg == "--print-params") {
+            options.printParams = true;
+        } else if (arg == "--bot") {
+            options.bot = true;
+        } else if (arg == "--bot-delay" && i + 1 < argc) {
+            options.botOptions.reactionDelay = std::atof(argv[++i]) / 1000.0;
+        } else if (arg == "--bot-noise" && i + 1 < argc) {
+            options.botOptions.noise = std::atof(argv[++i]);
+        } else if (arg == "--soak" && i + 1 < argc) {
+            options.soakGames = static_cast<size_t>(std::atol(argv[++i]));
+        } else if (arg == "--peer" && i + 1 < argc) {
+            std::string peer = argv[++i];
+            size_t colon = peer.rfind(':');
+            if (colon == std::string::npos) {
+                std::cerr << "--peer needs HOST:PORT" << std::endl;
+                return -1;
+            }
+            options.net.peerHost = peer.substr(0, colon);
+            options.net.peerPort = static_cast<uint16_t>(std::atoi(peer.c_str() + colon + 1));
+        } else if (arg == "--net" && i + 1 < argc) {
+            options.net.localPort = static_cast<uint16_t>(std::atoi(argv[++i]));
+        } else if (arg == "--player" && i + 1 < argc) {
+            options.net.player = std::atoi(argv[++i]) == 1 ? 1 : 0;
+        } else if (arg == "--net-latency" && i + 1 < argc) {
+            options.net.impairment.latencyMs = std::atof(argv[++i]);
+        } else if (arg == "--net-jitter" && i + 1 < argc) {
+            options.net.impairment.jitterMs = std::atof(argv[++i]);
+        } else if (arg == "--net-loss" && i + 1 < argc) {
+            options.net.impairment.lossRate = std::atof(argv[++i]);
+        } else if (arg == "--render-thread") {
+            options.renderThread = true;
+        } else if (arg == "--no-idle") {
+            options.idle.enabled = false;
+        } else if (arg == "--dump-frames" && i + 1 < argc) {
+            options.frameDumpDir = argv[++i];
+        } else if (arg == "--dump-format" && i + 1 < argc) {
+            std::string format = argv[++i];
+            if (format != "png" && format != "ppm") {
+                std::cerr << "--dump-format must be png or ppm" << std::endl;
+                return -1;
+            }
+            options.frameDumpFormat = format == "png" ? LidPong::ImageFormat::Png : LidPong::ImageFormat::Ppm;
+        } else if (arg == "--frame-size" && i + 1 < argc) {
+            if (std::sscanf(argv[++i], "%dx%d", &options.frameWidth, &options.frameHeight) != 2 ||
+                options.frameWidth <= 0 || options.frameHeight <= 0) {
+                std::cerr << "--frame-size needs WIDTHxHEIGHT" << std::endl;
+                return -1;
+            }
+        } else if (arg == "--golden" && i + 1 < argc) {
+            options.goldenDir = argv[++i];
+        } else if (arg == "--bench" && i + 1 < argc) {
+            benchmark = argv[++i];
+        } else if (arg == "--help" || arg == "-h") {
+            printUsage(argv[0]);
+            return 0;
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            printUsage(argv[0]);
+            return -1;
+        }
+    }
+    
+    if (!benchmark.empty()) {
+        LidPong::Bench::Options bench;
+        bench.count = options.multiBallCount;
+        bench.goldenDirectory = options.goldenDir;
+        bench.frameWidth = options.frameWidth;
+        bench.frameHeight = options.frameHeight;
+        bench.recordingFile = options.replayFile;
+        bench.tracePaths = options.analyzePaths;
+        return LidPong::Bench::run(benchmark, bench);
+    }
+    
+    if (!options.analyzePaths.empty()) {
+        return LidPong::runTraceAnalysis(options.analyzePaths, options.analyze);
+    }
+    
+    if (options.printParams) {
+        LidPong::GameParams params;
+        std::string error;
+        if (!options.paramsFile.empty() && !LidPong::loadGameParams(options.paramsFile, params, error)) {
+            std::cerr << error << std::endl;
+            return -1;
+        }
+        std::cout << LidPong::formatGameParams(params);
+        return 0;
+    }
+    
+    if (options.soakGames > 0) {
+        LidPong::SimulationConfig config = options.simulationConfig();
+        config.seed = options.seed != 0 ? options.seed : 1;
+        return LidPong::Bench::soak(config, options.soakGames, options.botOptions);
+    }
+    
+    // Scores go to ~/.lidpong unless --scores names another directory ("-" is --no-scores)
+    if (options.scoresDir == "-") {
+        options.scoresDir.clear();
+    } else if (options.scoresDir.empty() && std::getenv("HOME")) {
+        options.scoresDir = std::string(std::getenv("HOME")) + "/.lidpong";
+    }
+    if ((options.topCount > 0 || options.replayRank > 0) && options.scoresDir.empty()) {
+        std::cerr << "--top and --replay-score need a score directory" << std::endl;
+        return -1;
+    }
+    if (options.topCount > 0) {
+        LidPong::ScoreStore store;
+        std::string error;
+        if (!store.open(options.scoresDir, error)) {
+            std::cerr << "Failed to open scores: " << error << std::endl;
+            return -1;
+        }
+        printLeaderboard(store, LidPong::scoreModeOf(options.simulationConfig()), options.topCount, options.playerName);
+        return 0;
+    }
+    if (options.playerName.empty()) {
+        const char* user = std::getenv("USER");
+        options.playerName = user ? user : "player";
+    }
+    
+    if (!options.paramsFile.empty()) {
+        // Recordings don't carry params, and a retuned game isn't comparable on the leaderboard
+        if (!options.recordFile.empty() || options.keepReplays ||
+            !options.replayFile.empty() || options.replayRank > 0 || !options.net.peerHost.empty()) {
+            std::cerr << "--params can't be combined with --record, --keep-replays, --replay or --peer" << std::endl;
+            return -1;
+        }
+        options.scoresDir.clear();
+    }
+    
+    // A recording brings its own seed, mode and tick rate
+    LidPong::InputRecording replay;
+    bool replaying = !options.replayFile.empty() || options.replayRank > 0;
+    if (replaying) {
+        std::string error;
+        bool loaded = options.replayRank > 0 ? loadRankedReplay(options, replay, error) : replay.load(options.replayFile, error);
+        if (!loaded) {
+            std::cerr << "Failed to load recording: " << error << std::endl;
+            return -1;
+        }
+        if (options.headless && !options.frameDumpDir.empty()) {
+            return LidPong::replayToFrames(replay, options.frameDumpDir, options.frameDumpFormat,
+                                           options.frameWidth, options.frameHeight);
+        }
+        if (options.headless) {
+            return LidPong::replayHeadless(replay);
+        }
+        options.tickRateHz = replay.fixedTickSeconds() > 0.0f ? 1.0 / replay.fixedTickSeconds() : 0.0;
+    } else if (options.headless) {
+        std::cerr << "--headless needs --replay FILE" << std::endl;
+        return -1;
+    }
+    if (options.renderThread && options.pacing.targetFps <= 0.0) {
+        options.pacing.targetFps = 240.0; // No swap to block on any more
+    }
+    if (!options.frameDumpDir.empty() && !options.headless) {
+        std::cerr << "--dump-frames needs --replay FILE --headless" << std::endl;
+        return -1;
+    }
+    if (!options.net.peerHost.empty()) {
+        // Both peers must start from the same state and can't record predictions
+        if (options.seed == 0) options.seed = 1;
+        if (!options.recordFile.empty() || replaying || options.bot) {
+            std::cerr << "--peer can't be combined with --record, --replay or --bot" << std::endl;
+            return -1;
+        }
+    }
+    if (options.seed == 0) {
+        options.seed = static_cast<uint64_t>(LidPong::Clock::nowNs()) | 1;
+    }
+    
+    LidPongGame game(options, replaying ? &replay : nullptr);
     
     if (!game.init()) {
         return -1;
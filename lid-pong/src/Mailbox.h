@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace LidPong {
+
+// Single-producer / single-consumer "latest value" mailbox (a triple buffer).
+// The writer publishes complete values without ever waiting for the reader,
+// and the reader always picks up the most recently published value. Values
+// the reader never got to are simply overwritten - nothing queues up.
+template<class T>
+class LatestValueMailbox {
+public:
+    LatestValueMailbox() : m_middle(1), m_writeIndex(0), m_readIndex(2) {}
+
+    LatestValueMailbox(const LatestValueMailbox&) = delete;
+    LatestValueMailbox& operator=(const LatestValueMailbox&) = delete;
+
+    // Writer side: copy a value in and make it the newest one
+    void publish(const T& value) {
+        writeBuffer() = value;
+        commit();
+    }
+
+    // Reader side: returns true and fills 'out' if a value was published
+    // since the last successful consume(), false otherwise ('out' untouched)
+    bool consume(T& out) {
+        if (!fetch()) {
+            return false;
+        }
+        out = readBuffer();
+        return true;
+    }
+
+    // In-place variants for large values. The writer fills writeBuffer()
+    // (which still holds an old value) and commits it; the reader fetches
+    // and reads readBuffer(), which stays put until its next fetch().
+    T& writeBuffer() { return m_slots[m_writeIndex].value; }
+
+    void commit() {
+        m_writeIndex = m_middle.exchange(m_writeIndex | DIRTY, std::memory_order_acq_rel) & INDEX_MASK;
+    }
+
+    bool fetch() {
+        if (!(m_middle.load(std::memory_order_relaxed) & DIRTY)) {
+            return false;
+        }
+        m_readIndex = m_middle.exchange(m_readIndex, std::memory_order_acq_rel) & INDEX_MASK;
+        return true;
+    }
+
+    const T& readBuffer() const { return m_slots[m_readIndex].value; }
+
+private:
+    static const uint32_t INDEX_MASK = 0x3;
+    static const uint32_t DIRTY = 0x4;
+
+    // Keep each slot on its own cache line so writer and reader don't fight
+    struct alignas(64) Slot {
+        T value;
+    };
+
+    Slot m_slots[3];
+    alignas(64) std::atomic<uint32_t> m_middle;
+    alignas(64) uint32_t m_writeIndex; // Owned by the writer
+    alignas(64) uint32_t m_readIndex;  // Owned by the reader
+};
+
+} // namespace LidPong
@@ -0,0 +1,152 @@
+#include "NetTransport.h"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace LidPong {
+
+UdpTransport::UdpTransport()
+    : m_socket(-1)
+    , m_hasPeer(false) {
+    std::memset(&m_peer, 0, sizeof(m_peer));
+}
+
+UdpTransport::~UdpTransport() {
+    if (m_socket >= 0) {
+        close(m_socket);
+    }
+}
+
+bool UdpTransport::open(uint16_t localPort, std::string& error) {
+    m_socket = socket(AF_INET, SOCK_DGRAM, 0);
+    if (m_socket < 0) {
+        error = std::string("socket: ") + std::strerror(errno);
+        return false;
+    }
+
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(localPort);
+    if (bind(m_socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        error = "bind port " + std::to_string(localPort) + ": " + std::strerror(errno);
+        return false;
+    }
+
+    int flags = fcntl(m_socket, F_GETFL, 0);
+    if (flags < 0 || fcntl(m_socket, F_SETFL, flags | O_NONBLOCK) < 0) {
+        error = std::string("fcntl: ") + std::strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+bool UdpTransport::setPeer(const std::string& host, uint16_t port, std::string& error) {
+    addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    addrinfo* result = nullptr;
+    int status = getaddrinfo(host.c_str(), nullptr, &hints, &result);
+    if (status != 0 || !result) {
+        error = "resolve " + host + ": " + gai_strerror(status);
+        return false;
+    }
+
+    std::memcpy(&m_peer, result->ai_addr, sizeof(m_peer));
+    m_peer.sin_port = htons(port);
+    m_hasPeer = true;
+    freeaddrinfo(result);
+    return true;
+}
+
+uint16_t UdpTransport::localPort() const {
+    sockaddr_in address;
+    socklen_t length = sizeof(address);
+    if (m_socket < 0 || getsockname(m_socket, reinterpret_cast<sockaddr*>(&address), &length) < 0) {
+        return 0;
+    }
+    return ntohs(address.sin_port);
+}
+
+void UdpTransport::send(const uint8_t* data, size_t size) {
+    if (m_socket < 0 || !m_hasPeer) {
+        return;
+    }
+    // Best effort: a full socket buffer is just another lost packet
+    sendto(m_socket, data, size, 0, reinterpret_cast<const sockaddr*>(&m_peer), sizeof(m_peer));
+}
+
+int UdpTransport::receive(uint8_t* buffer, size_t capacity) {
+    if (m_socket < 0) {
+        return -1;
+    }
+    for (;;) {
+        sockaddr_in from;
+        socklen_t length = sizeof(from);
+        ssize_t received = recvfrom(m_socket, buffer, capacity, 0, reinterpret_cast<sockaddr*>(&from), &length);
+        if (received < 0) {
+            return -1;
+        }
+        if (!m_hasPeer) {
+            m_peer = from;
+            m_hasPeer = true;
+        }
+        // Once the peer is known, datagrams from anywhere else are dropped
+        if (from.sin_addr.s_addr == m_peer.sin_addr.s_addr && from.sin_port == m_peer.sin_port) {
+            return static_cast<int>(received);
+        }
+    }
+}
+
+ImpairedTransport::ImpairedTransport(Transport& inner, const NetImpairment& impairment, uint64_t seed)
+    : m_inner(inner)
+    , m_impairment(impairment)
+    , m_random(seed)
+    , m_nowNs(0)
+    , m_dropped(0) {
+}
+
+void ImpairedTransport::pump(int64_t nowNs) {
+    m_nowNs = nowNs;
+
+    // Queue is small (one RTT of packets); deliver in due order
+    std::stable_sort(m_queue.begin(), m_queue.end(),
+                     [](const Delayed& a, const Delayed& b) { return a.dueNs < b.dueNs; });
+    size_t due = 0;
+    while (due < m_queue.size() && m_queue[due].dueNs <= nowNs) {
+        m_inner.send(m_queue[due].bytes.data(), m_queue[due].bytes.size());
+        due++;
+    }
+    m_queue.erase(m_queue.begin(), m_queue.begin() + due);
+}
+
+void ImpairedTransport::send(const uint8_t* data, size_t size) {
+    if (m_impairment.lossRate > 0.0 && m_random.unit() < m_impairment.lossRate) {
+        m_dropped++;
+        return;
+    }
+
+    double delayMs = m_impairment.latencyMs + m_impairment.jitterMs * (2.0 * m_random.unit() - 1.0);
+    if (delayMs <= 0.0) {
+        m_inner.send(data, size);
+        return;
+    }
+
+    Delayed packet;
+    packet.dueNs = m_nowNs + static_cast<int64_t>(delayMs * 1e6);
+    packet.bytes.assign(data, data + size);
+    m_queue.push_back(packet);
+}
+
+int ImpairedTransport::receive(uint8_t* buffer, size_t capacity) {
+    return m_inner.receive(buffer, capacity);
+}
+
+} // namespace LidPong
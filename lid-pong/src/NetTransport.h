@@ -0,0 +1,87 @@
+#pragma once
+
+#include "Random.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <netinet/in.h>
+
+namespace LidPong {
+
+// Unreliable datagram pipe to one peer
+class Transport {
+public:
+    virtual ~Transport() {}
+
+    virtual void send(const uint8_t* data, size_t size) = 0;
+
+    // Next datagram into 'buffer'; its size, or -1 if nothing is waiting
+    virtual int receive(uint8_t* buffer, size_t capacity) = 0;
+};
+
+// Non-blocking UDP socket
+class UdpTransport : public Transport {
+public:
+    UdpTransport();
+    ~UdpTransport() override;
+
+    UdpTransport(const UdpTransport&) = delete;
+    UdpTransport& operator=(const UdpTransport&) = delete;
+
+    // Bind to localPort on all interfaces (0: any free port)
+    bool open(uint16_t localPort, std::string& error);
+
+    // Where send() goes and the only sender receive() accepts; until set, the
+    // first sender we hear from is used
+    bool setPeer(const std::string& host, uint16_t port, std::string& error);
+
+    uint16_t localPort() const;
+
+    void send(const uint8_t* data, size_t size) override;
+    int receive(uint8_t* buffer, size_t capacity) override;
+
+private:
+    int m_socket;
+    sockaddr_in m_peer;
+    bool m_hasPeer;
+};
+
+struct NetImpairment {
+    double latencyMs; // One-way delay added to every packet
+    double jitterMs;  // +- random extra delay (reorders packets)
+    double lossRate;  // Fraction of packets dropped, 0..1
+
+    NetImpairment() : latencyMs(0.0), jitterMs(0.0), lossRate(0.0) {}
+};
+
+// Wraps a transport and makes its outgoing side worse on purpose, for
+// testing rollback under latency, jitter and loss. Time is passed in, so a
+// test harness can run on a simulated clock.
+class ImpairedTransport : public Transport {
+public:
+    ImpairedTransport(Transport& inner, const NetImpairment& impairment, uint64_t seed);
+
+    // Hand packets that are due by nowNs to the inner transport
+    void pump(int64_t nowNs);
+
+    void send(const uint8_t* data, size_t size) override;
+    int receive(uint8_t* buffer, size_t capacity) override;
+
+    uint64_t dropped() const { return m_dropped; }
+
+private:
+    struct Delayed {
+        int64_t dueNs;
+        std::vector<uint8_t> bytes;
+    };
+
+    Transport& m_inner;
+    NetImpairment m_impairment;
+    Random m_random;
+    std::vector<Delayed> m_queue;
+    int64_t m_nowNs;
+    uint64_t m_dropped;
+};
+
+} // namespace LidPong
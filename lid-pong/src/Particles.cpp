@@ -0,0 +1,170 @@
+#include "Particles.h"
+#include <algorithm>
+#include <cstring>
+
+namespace LidPong {
+
+namespace {
+
+uint32_t packRgba(uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
+    const uint8_t bytes[4] = {r, g, b, a};
+    uint32_t packed;
+    std::memcpy(&packed, bytes, sizeof(packed));
+    return packed;
+}
+
+const uint32_t SPARK_COLOR = packRgba(255, 230, 120, 255);
+const uint32_t TRAIL_COLOR = packRgba(150, 200, 255, 140);
+const uint32_t MISS_COLOR = packRgba(255, 90, 40, 255);
+
+const float TRAIL_PER_SECOND = 90.0f;
+
+} // namespace
+
+ParticlePool::ParticlePool(size_t capacity)
+    : drag(2.5f)
+    , gravity(0.6f)
+    , m_x(capacity)
+    , m_y(capacity)
+    , m_vx(capacity)
+    , m_vy(capacity)
+    , m_age(capacity)
+    , m_life(capacity)
+    , m_color(capacity)
+    , m_count(0) {
+}
+
+bool ParticlePool::spawn(float x, float y, float vx, float vy, float lifeSeconds, uint32_t rgba) {
+    if (m_count == m_x.size()) {
+        return false;
+    }
+    size_t i = m_count++;
+    m_x[i] = x;
+    m_y[i] = y;
+    m_vx[i] = vx;
+    m_vy[i] = vy;
+    m_age[i] = 0.0f;
+    m_life[i] = lifeSeconds > 0.0f ? lifeSeconds : 1e-3f;
+    m_color[i] = rgba;
+    return true;
+}
+
+void ParticlePool::update(float deltaTime) {
+    // Straight-line loops over the arrays so the compiler can vectorise them
+    const float damping = std::max(0.0f, 1.0f - drag * deltaTime);
+    const float fall = gravity * deltaTime;
+    float* x = m_x.data();
+    float* y = m_y.data();
+    float* vx = m_vx.data();
+    float* vy = m_vy.data();
+    float* age = m_age.data();
+    for (size_t i = 0; i < m_count; i++) {
+        vx[i] *= damping;
+        vy[i] = vy[i] * damping - fall;
+        x[i] += vx[i] * deltaTime;
+        y[i] += vy[i] * deltaTime;
+        age[i] += deltaTime;
+    }
+
+    // Compact: each expired particle takes the last live one's slot
+    size_t i = 0;
+    while (i < m_count) {
+        if (m_age[i] < m_life[i]) {
+            i++;
+            continue;
+        }
+        size_t last = --m_count;
+        m_x[i] = m_x[last];
+        m_y[i] = m_y[last];
+        m_vx[i] = m_vx[last];
+        m_vy[i] = m_vy[last];
+        m_age[i] = m_age[last];
+        m_life[i] = m_life[last];
+        m_color[i] = m_color[last];
+    }
+}
+
+void ParticlePool::write(float* xy, uint32_t* rgba) const {
+    for (size_t i = 0; i < m_count; i++) {
+        xy[2 * i] = m_x[i];
+        xy[2 * i + 1] = m_y[i];
+
+        // Alpha (the top byte in memory order) fades out linearly with age
+        uint8_t bytes[4];
+        std::memcpy(bytes, &m_color[i], sizeof(bytes));
+        float remaining = 1.0f - m_age[i] / m_life[i];
+        bytes[3] = static_cast<uint8_t>(bytes[3] * std::min(1.0f, std::max(0.0f, remaining)));
+        std::memcpy(&rgba[i], bytes, sizeof(bytes));
+    }
+}
+
+ParticleEffects::ParticleEffects(size_t capacity)
+    : m_pool(capacity)
+    , m_random(0x9E3779B97F4A7C15ULL)
+    , m_primed(false)
+    , m_generation(0)
+    , m_tick(0)
+    , m_totalHits(0)
+    , m_lives(0)
+    , m_score(0)
+    , m_rightScore(0)
+    , m_ballY(0.0f)
+    , m_trailDue(0.0f) {
+}
+
+void ParticleEffects::clear() {
+    m_pool.clear();
+    m_primed = false;
+    m_trailDue = 0.0f;
+}
+
+void ParticleEffects::update(const Simulation& sim, uint64_t generation, float deltaTime) {
+    m_pool.update(deltaTime);
+
+    const GameState& state = sim.state();
+    const Ball& ball = state.ball;
+    // Party and brick modes have their own many-ball visuals; only the classic ball gets effects
+    bool classicBall = !sim.isMultiBall() && !sim.isBrickMode();
+    bool jumped = !m_primed || generation != m_generation || state.tick < m_tick;
+
+    if (classicBall && !jumped) {
+        if (state.totalHits > m_totalHits) {
+            // Sparks fly back the way the ball now travels
+            burst(ball.x, ball.y, ball.vx >= 0.0f ? 1.0f : -1.0f, 24, 1.2f, 0.35f, SPARK_COLOR);
+        }
+        // The ball has already been re-served, so burst where it was last seen
+        if (state.lives < m_lives || state.rightScore > m_rightScore) {
+            burst(-1.0f, m_ballY, 1.0f, 96, 1.6f, 0.8f, MISS_COLOR);
+        }
+        if (sim.isVersus() && state.score > m_score) {
+            burst(1.0f, m_ballY, -1.0f, 96, 1.6f, 0.8f, MISS_COLOR);
+        }
+    }
+
+    if (classicBall && ball.active && !state.gameOver && state.tick != m_tick) {
+        m_trailDue += TRAIL_PER_SECOND * deltaTime;
+        for (; m_trailDue >= 1.0f; m_trailDue -= 1.0f) {
+            m_pool.spawn(ball.x + spread(ball.radius * 0.5f), ball.y + spread(ball.radius * 0.5f),
+                         spread(0.05f), spread(0.05f) + m_pool.gravity * 0.2f, 0.25f, TRAIL_COLOR);
+        }
+    }
+
+    m_primed = true;
+    m_generation = generation;
+    m_tick = state.tick;
+    m_totalHits = state.totalHits;
+    m_lives = state.lives;
+    m_score = state.score;
+    m_rightScore = state.rightScore;
+    m_ballY = ball.y;
+}
+
+void ParticleEffects::burst(float x, float y, float directionX, int count, float speed, float life, uint32_t rgba) {
+    for (int i = 0; i < count; i++) {
+        float vx = directionX * speed * m_random.unit() + spread(speed * 0.3f);
+        float vy = spread(speed * 0.7f);
+        m_pool.spawn(x, y, vx, vy, life * (0.5f + 0.5f * m_random.unit()), rgba);
+    }
+}
+
+} // namespace LidPong
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "Random.h"
+#include "Simulation.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace LidPong {
+
+// Fixed-capacity pool of short-lived effect particles, stored as
+// structure-of-arrays. Live particles are packed at the front: spawn()
+// appends and an expired particle is replaced by the last live one, so both
+// are O(1). All storage is allocated in the constructor.
+class ParticlePool {
+public:
+    explicit ParticlePool(size_t capacity);
+
+    size_t capacity() const { return m_x.size(); }
+    size_t size() const { return m_count; }
+
+    // 'rgba' is packed RGBA bytes in memory order; false when the pool is full
+    bool spawn(float x, float y, float vx, float vy, float lifeSeconds, uint32_t rgba);
+
+    // Move, slow down, pull towards the floor, and drop particles past their life
+    void update(float deltaTime);
+    void clear() { m_count = 0; }
+
+    // Interleaved xy and colours faded by age, size() of each, for one batched draw
+    void write(float* xy, uint32_t* rgba) const;
+
+    float drag;    // Fraction of velocity lost per second
+    float gravity; // Downward acceleration, field units per second squared
+
+private:
+    std::vector<float> m_x, m_y, m_vx, m_vy;
+    std::vector<float> m_age, m_life;
+    std::vector<uint32_t> m_color;
+    size_t m_count;
+};
+
+// Turns game events into particles: sparks off a paddle hit, a trail behind
+// the ball, and a burst where a ball is lost. It only compares consecutive
+// game states and has its own random generator, so the simulation (and its
+// recordings and netplay checksums) never sees it.
+class ParticleEffects {
+public:
+    explicit ParticleEffects(size_t capacity = 4096);
+
+    // Once per rendered frame. 'generation' works as in RenderSnapshot::capture:
+    // after a jump to another state nothing is emitted for the difference.
+    void update(const Simulation& sim, uint64_t generation, float deltaTime);
+    void clear();
+
+    const ParticlePool& particles() const { return m_pool; }
+
+private:
+    void burst(float x, float y, float directionX, int count, float speed, float life, uint32_t rgba);
+    float spread(float range) { return (m_random.unit() * 2.0f - 1.0f) * range; }
+
+    ParticlePool m_pool;
+    Random m_random;
+    bool m_primed;
+    uint64_t m_generation;
+    uint64_t m_tick;
+    int m_totalHits, m_lives, m_score, m_rightScore;
+    float m_ballY;
+    float m_trailDue; // Fractional trail particles carried to the next frame
+};
+
+} // namespace LidPong
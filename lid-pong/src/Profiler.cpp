@@ -0,0 +1,175 @@
+#include "Profiler.h"
+
+#ifdef LIDPONG_PROFILE
+
+#include <cstring>
+#include <fstream>
+
+namespace LidPong {
+
+namespace {
+    const size_t PHASES = static_cast<size_t>(ProfilePhase::Count);
+}
+
+const char* profilePhaseName(ProfilePhase phase) {
+    switch (phase) {
+        case ProfilePhase::Events: return "events";
+        case ProfilePhase::SpeedSlider: return "speed_slider";
+        case ProfilePhase::Input: return "input";
+        case ProfilePhase::Update: return "update";
+        case ProfilePhase::Render: return "render";
+        case ProfilePhase::Swap: return "swap";
+        case ProfilePhase::Pacing: return "pacing";
+        default: return "unknown";
+    }
+}
+
+FrameProfiler& FrameProfiler::instance() {
+    static FrameProfiler profiler;
+    return profiler;
+}
+
+FrameProfiler::FrameProfiler()
+    : m_next(0)
+    , m_count(0)
+    , m_inFrame(false) {
+    std::memset(m_frames, 0, sizeof(m_frames));
+    std::memset(m_histograms, 0, sizeof(m_histograms));
+    std::memset(m_phaseTotalNs, 0, sizeof(m_phaseTotalNs));
+    std::memset(m_phaseTotalAllocations, 0, sizeof(m_phaseTotalAllocations));
+}
+
+size_t FrameProfiler::bucketFor(int64_t ns) {
+    // Bucket b holds durations in [2^(b-1), 2^b) microseconds; bucket 0 is < 1 us
+    uint64_t us = static_cast<uint64_t>(ns < 0 ? 0 : ns) / 1000;
+    size_t bucket = 0;
+    while (us > 0 && bucket < BUCKETS - 1) {
+        us >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+void FrameProfiler::addToHistograms(const FrameRecord& frame, int sign) {
+    for (size_t p = 0; p < PHASES; p++) {
+        m_histograms[p][bucketFor(frame.phaseNs[p])] += sign;
+        m_phaseTotalNs[p] += sign * frame.phaseNs[p];
+        m_phaseTotalAllocations[p] += sign * static_cast<int64_t>(frame.phaseAllocations[p]);
+    }
+}
+
+void FrameProfiler::beginFrame() {
+    // Evict the oldest frame if the ring is full, so histograms cover exactly the ring
+    if (m_count == FRAME_CAPACITY) {
+        addToHistograms(m_frames[m_next], -1);
+        m_count--;
+    }
+
+    FrameRecord& frame = m_frames[m_next];
+    std::memset(&frame, 0, sizeof(frame));
+    frame.startNs = Clock::nowNs();
+    m_inFrame = true;
+}
+
+void FrameProfiler::record(ProfilePhase phase, int64_t beginNs, int64_t endNs, uint64_t allocations) {
+    if (!m_inFrame) {
+        return;
+    }
+    FrameRecord& frame = m_frames[m_next];
+    size_t p = static_cast<size_t>(phase);
+    if (frame.phaseNs[p] == 0) {
+        frame.phaseBeginNs[p] = beginNs;
+    }
+    frame.phaseNs[p] += endNs - beginNs; // A phase may run more than once per frame
+    frame.phaseAllocations[p] += static_cast<uint32_t>(allocations);
+}
+
+void FrameProfiler::endFrame() {
+    if (!m_inFrame) {
+        return;
+    }
+    FrameRecord& frame = m_frames[m_next];
+    frame.endNs = Clock::nowNs();
+    addToHistograms(frame, +1);
+
+    m_next = (m_next + 1) % FRAME_CAPACITY;
+    m_count++;
+    m_inFrame = false;
+}
+
+size_t FrameProfiler::frameCount() const {
+    return m_count;
+}
+
+PhaseStats FrameProfiler::phaseStats(ProfilePhase phase) const {
+    PhaseStats stats = {0.0, 0.0, 0.0, 0.0, 0};
+    if (m_count == 0) {
+        return stats;
+    }
+    size_t p = static_cast<size_t>(phase);
+    size_t last = (m_next + FRAME_CAPACITY - 1) % FRAME_CAPACITY;
+    stats.lastUs = m_frames[last].phaseNs[p] / 1000.0;
+    stats.meanUs = m_phaseTotalNs[p] / 1000.0 / m_count;
+    stats.allocations = m_phaseTotalAllocations[p];
+
+    // p95 from the histogram: upper edge of the bucket containing the 95th percentile
+    size_t target = (m_count * 95 + 99) / 100;
+    size_t seen = 0;
+    for (size_t b = 0; b < BUCKETS; b++) {
+        seen += m_histograms[p][b];
+        if (seen >= target) {
+            stats.p95Us = b == 0 ? 1.0 : static_cast<double>(1ull << b);
+            break;
+        }
+    }
+
+    size_t oldest = (m_next + FRAME_CAPACITY - m_count) % FRAME_CAPACITY;
+    for (size_t i = 0; i < m_count; i++) {
+        double us = m_frames[(oldest + i) % FRAME_CAPACITY].phaseNs[p] / 1000.0;
+        if (us > stats.maxUs) stats.maxUs = us;
+    }
+    return stats;
+}
+
+bool FrameProfiler::writeChromeTrace(const std::string& path, size_t frames) const {
+    std::ofstream out(path);
+    if (!out) {
+        return false;
+    }
+    if (frames > m_count) {
+        frames = m_count;
+    }
+
+    size_t first = (m_next + FRAME_CAPACITY - frames) % FRAME_CAPACITY;
+    int64_t originNs = frames > 0 ? m_frames[first].startNs : 0;
+
+    // Complete ("X") events; timestamps and durations in microseconds
+    out << "{\"traceEvents\":[\n";
+    bool firstEvent = true;
+    for (size_t i = 0; i < frames; i++) {
+        const FrameRecord& frame = m_frames[(first + i) % FRAME_CAPACITY];
+
+        out << (firstEvent ? "" : ",\n");
+        firstEvent = false;
+        out << "{\"name\":\"frame\",\"ph\":\"X\",\"pid\":1,\"tid\":1"
+            << ",\"ts\":" << (frame.startNs - originNs) / 1000.0
+            << ",\"dur\":" << (frame.endNs - frame.startNs) / 1000.0
+            << ",\"args\":{\"index\":" << i << "}}";
+
+        for (size_t p = 0; p < PHASES; p++) {
+            if (frame.phaseNs[p] == 0) {
+                continue;
+            }
+            out << ",\n{\"name\":\"" << profilePhaseName(static_cast<ProfilePhase>(p))
+                << "\",\"ph\":\"X\",\"pid\":1,\"tid\":1"
+                << ",\"ts\":" << (frame.phaseBeginNs[p] - originNs) / 1000.0
+                << ",\"dur\":" << frame.phaseNs[p] / 1000.0 << "}";
+        }
+    }
+    out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    return static_cast<bool>(out);
+}
+
+} // namespace LidPong
+
+#endif // LIDPONG_PROFILE
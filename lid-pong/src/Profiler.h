@@ -0,0 +1,111 @@
+#pragma once
+
+// Per-phase frame profiler.
+//
+// Build with -DLIDPONG_PROFILE (make PROFILE=1) to enable. Without it the
+// LIDPONG_PROFILE_* macros expand to nothing and none of this is compiled.
+
+#ifdef LIDPONG_PROFILE
+
+#include "AllocTracker.h"
+#include "Clock.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace LidPong {
+
+enum class ProfilePhase {
+    Events,      // glfwPollEvents and key handling
+    SpeedSlider, // handleSpeedSliderInput
+    Input,       // Picking up the lid sample from the input thread
+    Update,      // Simulation
+    Render,      // Issuing draw calls
+    Swap,        // glfwSwapBuffers
+    Pacing,      // Frame limiter / late-input wait
+    Count
+};
+
+const char* profilePhaseName(ProfilePhase phase);
+
+// Summary of one phase over the frames currently in the ring
+struct PhaseStats {
+    double lastUs;
+    double meanUs;
+    double p95Us;
+    double maxUs;
+    uint64_t allocations; // Heap allocations over the frames in the ring (ALLOC_TRACK builds)
+};
+
+class FrameProfiler {
+public:
+    static const size_t FRAME_CAPACITY = 1024; // Frames kept for histograms and export
+    static const size_t BUCKETS = 32;          // log2 buckets of microseconds
+
+    static FrameProfiler& instance();
+
+    void beginFrame();
+    void endFrame();
+    void record(ProfilePhase phase, int64_t beginNs, int64_t endNs, uint64_t allocations);
+
+    size_t frameCount() const;
+    PhaseStats phaseStats(ProfilePhase phase) const;
+
+    // Writes the last 'frames' frames as Chrome trace-event JSON (chrome://tracing, Perfetto)
+    bool writeChromeTrace(const std::string& path, size_t frames) const;
+
+private:
+    FrameProfiler();
+
+    struct FrameRecord {
+        int64_t startNs;
+        int64_t endNs;
+        int64_t phaseBeginNs[static_cast<size_t>(ProfilePhase::Count)];
+        int64_t phaseNs[static_cast<size_t>(ProfilePhase::Count)];
+        uint32_t phaseAllocations[static_cast<size_t>(ProfilePhase::Count)];
+    };
+
+    static size_t bucketFor(int64_t ns);
+    void addToHistograms(const FrameRecord& frame, int sign);
+
+    FrameRecord m_frames[FRAME_CAPACITY];
+    size_t m_next;     // Ring slot of the frame being recorded
+    size_t m_count;    // Completed frames in the ring
+    bool m_inFrame;
+
+    uint32_t m_histograms[static_cast<size_t>(ProfilePhase::Count)][BUCKETS];
+    int64_t m_phaseTotalNs[static_cast<size_t>(ProfilePhase::Count)];
+    uint64_t m_phaseTotalAllocations[static_cast<size_t>(ProfilePhase::Count)];
+};
+
+// Records the enclosing scope's duration (and heap allocations) against a phase
+class ScopedPhaseTimer {
+public:
+    explicit ScopedPhaseTimer(ProfilePhase phase) : m_phase(phase), m_beginNs(Clock::nowNs()) {}
+    ~ScopedPhaseTimer() { FrameProfiler::instance().record(m_phase, m_beginNs, Clock::nowNs(), m_allocations.allocations()); }
+
+    ScopedPhaseTimer(const ScopedPhaseTimer&) = delete;
+    ScopedPhaseTimer& operator=(const ScopedPhaseTimer&) = delete;
+
+private:
+    ProfilePhase m_phase;
+    int64_t m_beginNs;
+    AllocationScope m_allocations;
+};
+
+} // namespace LidPong
+
+#define LIDPONG_PROFILE_CONCAT_INNER(a, b) a##b
+#define LIDPONG_PROFILE_CONCAT(a, b) LIDPONG_PROFILE_CONCAT_INNER(a, b)
+#define LIDPONG_PROFILE_FRAME_BEGIN() LidPong::FrameProfiler::instance().beginFrame()
+#define LIDPONG_PROFILE_FRAME_END() LidPong::FrameProfiler::instance().endFrame()
+#define LIDPONG_PROFILE_SCOPE(phase) \
+    LidPong::ScopedPhaseTimer LIDPONG_PROFILE_CONCAT(profileScope_, __LINE__)(LidPong::ProfilePhase::phase)
+
+#else
+
+#define LIDPONG_PROFILE_FRAME_BEGIN() ((void)0)
+#define LIDPONG_PROFILE_FRAME_END() ((void)0)
+#define LIDPONG_PROFILE_SCOPE(phase) ((void)0)
+
+#endif // LIDPONG_PROFILE
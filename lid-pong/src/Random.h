@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+
+namespace LidPong {
+
+// Small, fast, seedable PRNG (PCG32). Each simulation owns one, so a run is
+// fully determined by its seed and its inputs - unlike the global rand().
+class Random {
+public:
+    explicit Random(uint64_t seed = 0x853C49E6748FEA9BULL) {
+        reseed(seed);
+    }
+
+    void reseed(uint64_t seed) {
+        m_state = 0;
+        next();
+        m_state += seed;
+        next();
+    }
+
+    uint32_t next() {
+        uint64_t old = m_state;
+        m_state = old * 6364136223846793005ULL + INCREMENT;
+        uint32_t xorShifted = static_cast<uint32_t>(((old >> 18u) ^ old) >> 27u);
+        uint32_t rot = static_cast<uint32_t>(old >> 59u);
+        return (xorShifted >> rot) | (xorShifted << ((32 - rot) & 31));
+    }
+
+    // Uniform in [0, 1)
+    float unit() {
+        return (next() >> 8) * (1.0f / 16777216.0f);
+    }
+
+    bool coin() {
+        return (next() & 1u) != 0;
+    }
+
+    uint64_t state() const { return m_state; }
+    void setState(uint64_t state) { m_state = state; }
+
+private:
+    static const uint64_t INCREMENT = 1442695040888963407ULL;
+    uint64_t m_state;
+};
+
+} // namespace LidPong
@@ -0,0 +1,285 @@
+#include "Recording.h"
+#include "Clock.h"
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace LidPong {
+
+namespace {
+
+const char MAGIC[4] = {'L', 'P', 'R', 'C'};
+const uint32_t VERSION = 2; // 2: versus mode, new state checksum
+
+// Flags byte: low four bits are the TickButton bits
+const uint8_t FLAG_LID = 1 << 4;   // uint16 lid position follows
+const uint8_t FLAG_DT = 1 << 5;    // float step length follows
+const uint8_t FLAG_FRAME = 1 << 6; // First tick of a rendered frame
+const uint8_t FLAG_RIGHT_LID = 1 << 7; // uint16 right-hand lid position follows (versus)
+
+const uint16_t LID_CENTER = 32768;
+
+// Little-endian on every platform we build for, so values are written as-is
+template<class T>
+void put(std::vector<uint8_t>& data, T value) {
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(&value);
+    data.insert(data.end(), p, p + sizeof(T));
+}
+
+template<class T>
+bool get(const std::vector<uint8_t>& data, size_t& offset, T& value) {
+    if (offset + sizeof(T) > data.size()) {
+        return false;
+    }
+    std::memcpy(&value, &data[offset], sizeof(T));
+    offset += sizeof(T);
+    return true;
+}
+
+template<class T>
+void writeValue(std::ostream& out, T value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template<class T>
+bool readValue(std::istream& in, T& value) {
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+// Bytes between the read position and the end of the stream, or -1 if the
+// stream can't tell
+int64_t bytesLeft(std::istream& in) {
+    std::streampos here = in.tellg();
+    if (here == std::streampos(-1) || !in.seekg(0, std::ios::end)) {
+        in.clear();
+        return -1;
+    }
+    std::streampos end = in.tellg();
+    in.seekg(here);
+    return end == std::streampos(-1) ? -1 : static_cast<int64_t>(end - here);
+}
+
+} // namespace
+
+InputRecording::InputRecording()
+    : m_fixedTickSeconds(0.0f)
+    , m_tickCount(0)
+    , m_lastLid(LID_CENTER)
+    , m_lastRightLid(LID_CENTER)
+    , m_hasFinalChecksum(false)
+    , m_finalChecksum(0) {
+}
+
+void InputRecording::begin(const SimulationConfig& config, float fixedTickSeconds) {
+    m_config = config;
+    m_fixedTickSeconds = fixedTickSeconds;
+    m_tickCount = 0;
+    m_lastLid = LID_CENTER;
+    m_lastRightLid = LID_CENTER;
+    m_hasFinalChecksum = false;
+    m_finalChecksum = 0;
+    m_data.clear();
+    m_data.reserve(1 << 16);
+}
+
+void InputRecording::append(const TickInput& input, bool frameStart) {
+    uint16_t lid = TickInput::lidToFixed(input.lidPosition);
+    uint16_t rightLid = TickInput::lidToFixed(input.rightLidPosition);
+    bool fixedStep = m_fixedTickSeconds > 0.0f && input.deltaTime == m_fixedTickSeconds;
+
+    uint8_t flags = input.buttons & BUTTON_MASK;
+    if (lid != m_lastLid) flags |= FLAG_LID;
+    if (!fixedStep) flags |= FLAG_DT;
+    if (frameStart) flags |= FLAG_FRAME;
+    if (rightLid != m_lastRightLid) flags |= FLAG_RIGHT_LID;
+
+    put(m_data, flags);
+    if (flags & FLAG_LID) put(m_data, lid);
+    if (flags & FLAG_RIGHT_LID) put(m_data, rightLid);
+    if (flags & FLAG_DT) put(m_data, input.deltaTime);
+    if (flags & BUTTON_SPEED_SET) put(m_data, input.speedSetting);
+
+    m_lastLid = lid;
+    m_lastRightLid = rightLid;
+    m_tickCount++;
+}
+
+void InputRecording::finish(uint64_t finalChecksum) {
+    m_hasFinalChecksum = true;
+    m_finalChecksum = finalChecksum;
+}
+
+bool InputRecording::save(const std::string& path, std::string& error) const {
+    std::ofstream out(path.c_str(), std::ios::binary);
+    if (!out) {
+        error = "cannot open " + path + " for writing";
+        return false;
+    }
+    if (!write(out)) {
+        error = "failed writing " + path;
+        return false;
+    }
+    return true;
+}
+
+bool InputRecording::load(const std::string& path, std::string& error) {
+    std::ifstream in(path.c_str(), std::ios::binary);
+    if (!in) {
+        error = "cannot open " + path;
+        return false;
+    }
+    return read(in, path, error);
+}
+
+void InputRecording::serialize(std::vector<uint8_t>& out) const {
+    std::ostringstream stream(std::ios::binary);
+    write(stream);
+    const std::string bytes = stream.str();
+    out.assign(bytes.begin(), bytes.end());
+}
+
+bool InputRecording::deserialize(const std::vector<uint8_t>& data, std::string& error) {
+    std::istringstream stream(std::string(data.begin(), data.end()), std::ios::binary);
+    return read(stream, "stored recording", error);
+}
+
+bool InputRecording::write(std::ostream& out) const {
+    out.write(MAGIC, sizeof(MAGIC));
+    writeValue(out, VERSION);
+    writeValue(out, m_config.seed);
+    writeValue(out, static_cast<uint64_t>(m_config.multiBallCount));
+    writeValue(out, static_cast<uint64_t>(m_config.brickCount));
+    writeValue(out, static_cast<uint8_t>(m_config.versus ? 1 : 0));
+    writeValue(out, m_fixedTickSeconds);
+    writeValue(out, m_tickCount);
+    writeValue(out, static_cast<uint8_t>(m_hasFinalChecksum ? 1 : 0));
+    writeValue(out, m_finalChecksum);
+    writeValue(out, static_cast<uint64_t>(m_data.size()));
+    out.write(reinterpret_cast<const char*>(m_data.data()), m_data.size());
+    return static_cast<bool>(out);
+}
+
+bool InputRecording::read(std::istream& in, const std::string& name, std::string& error) {
+    char magic[4];
+    uint32_t version = 0;
+    uint64_t multiBallCount = 0, brickCount = 0, dataSize = 0;
+    uint8_t hasChecksum = 0, versus = 0;
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0) {
+        error = name + " is not a Lid Pong recording";
+        return false;
+    }
+    if (!readValue(in, version) || version != VERSION) {
+        error = name + " has unsupported recording version " + std::to_string(version);
+        return false;
+    }
+    if (!readValue(in, m_config.seed) || !readValue(in, multiBallCount) || !readValue(in, brickCount) || !readValue(in, versus) ||
+        !readValue(in, m_fixedTickSeconds) || !readValue(in, m_tickCount) || !readValue(in, hasChecksum) ||
+        !readValue(in, m_finalChecksum) || !readValue(in, dataSize)) {
+        error = name + " has a truncated header";
+        return false;
+    }
+    m_config.multiBallCount = static_cast<size_t>(multiBallCount);
+    m_config.brickCount = static_cast<size_t>(brickCount);
+    m_config.versus = versus != 0;
+    m_hasFinalChecksum = hasChecksum != 0;
+
+    // The size comes from the file: don't allocate more than the file holds
+    int64_t left = bytesLeft(in);
+    if (left < 0 || dataSize > static_cast<uint64_t>(left)) {
+        error = name + " is truncated";
+        return false;
+    }
+    m_data.resize(static_cast<size_t>(dataSize));
+    if (!in.read(reinterpret_cast<char*>(m_data.data()), m_data.size())) {
+        error = name + " is truncated";
+        return false;
+    }
+    m_lastLid = LID_CENTER;
+    m_lastRightLid = LID_CENTER;
+    return true;
+}
+
+InputRecording::Reader::Reader(const InputRecording& recording)
+    : m_recording(recording)
+    , m_offset(0)
+    , m_lid(LID_CENTER)
+    , m_rightLid(LID_CENTER) {
+}
+
+bool InputRecording::Reader::next(TickInput& out, bool& frameStart) {
+    const std::vector<uint8_t>& data = m_recording.m_data;
+    uint8_t flags;
+    if (!get(data, m_offset, flags)) {
+        return false;
+    }
+
+    out.buttons = flags & BUTTON_MASK;
+    frameStart = (flags & FLAG_FRAME) != 0;
+    if ((flags & FLAG_LID) && !get(data, m_offset, m_lid)) {
+        return false;
+    }
+    out.lidPosition = TickInput::lidFromFixed(m_lid);
+    if ((flags & FLAG_RIGHT_LID) && !get(data, m_offset, m_rightLid)) {
+        return false;
+    }
+    out.rightLidPosition = TickInput::lidFromFixed(m_rightLid);
+    out.deltaTime = m_recording.m_fixedTickSeconds;
+    if ((flags & FLAG_DT) && !get(data, m_offset, out.deltaTime)) {
+        return false;
+    }
+    out.speedSetting = 0.0f;
+    if ((flags & BUTTON_SPEED_SET) && !get(data, m_offset, out.speedSetting)) {
+        return false;
+    }
+    return true;
+}
+
+int replayHeadless(const InputRecording& recording, const std::function<bool(const Simulation&)>& onFrame) {
+    Simulation simulation(recording.config());
+    InputRecording::Reader reader(recording);
+    TickInput input;
+    bool frameStart;
+
+    int64_t startNs = Clock::nowNs();
+    while (reader.next(input, frameStart)) {
+        if (onFrame && frameStart && simulation.tickCount() > 0 && !onFrame(simulation)) {
+            return 1;
+        }
+        simulation.step(input);
+    }
+    if (onFrame && simulation.tickCount() > 0 && !onFrame(simulation)) {
+        return 1;
+    }
+    double elapsedMs = Clock::nsToMs(Clock::nowNs() - startNs);
+
+    std::cout << "Replayed " << simulation.tickCount() << " of " << recording.tickCount() << " ticks ("
+              << recording.sizeBytes() << " bytes of input) in "
+              << std::fixed << std::setprecision(2) << elapsedMs << " ms";
+    if (elapsedMs > 0.0) {
+        std::cout << " = " << std::setprecision(0) << simulation.tickCount() / (elapsedMs / 1000.0) << " ticks/s";
+    }
+    std::cout << std::endl;
+    std::cout << "Final score " << simulation.score() << ", lives " << simulation.lives()
+              << ", state checksum " << std::hex << std::setw(16) << std::setfill('0') << simulation.checksum()
+              << std::dec << std::setfill(' ') << std::endl;
+
+    if (simulation.tickCount() != recording.tickCount()) {
+        std::cout << "FAIL: recording is truncated or corrupt" << std::endl;
+        return 1;
+    }
+    if (!recording.hasFinalChecksum()) {
+        std::cout << "Recording has no final checksum to verify against" << std::endl;
+        return 0;
+    }
+    if (simulation.checksum() != recording.finalChecksum()) {
+        std::cout << "FAIL: diverged from the recorded session (expected " << std::hex << recording.finalChecksum()
+                  << std::dec << ")" << std::endl;
+        return 1;
+    }
+    std::cout << "OK: matches the recorded session" << std::endl;
+    return 0;
+}
+
+} // namespace LidPong
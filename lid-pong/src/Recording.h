@@ -0,0 +1,84 @@
+#pragma once
+
+#include "Simulation.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace LidPong {
+
+// Compact log of every tick's input, enough to re-run a session exactly.
+//
+// Each tick is one flags byte (buttons plus what follows), then only what
+// changed: the 16-bit lid position(s) when they moved, the step length when it
+// isn't the fixed tick, and the slider value when the speed slider was
+// dragged. An idle tick at a fixed rate costs a single byte.
+class InputRecording {
+public:
+    InputRecording();
+
+    // Start a fresh recording (fixedTickSeconds <= 0: variable step per frame)
+    void begin(const SimulationConfig& config, float fixedTickSeconds);
+
+    // frameStart marks the first tick of a rendered frame, so a windowed
+    // replay can show the session frame by frame
+    void append(const TickInput& input, bool frameStart);
+
+    // Final-state checksum a replay must reproduce
+    void finish(uint64_t finalChecksum);
+
+    bool save(const std::string& path, std::string& error) const;
+    bool load(const std::string& path, std::string& error);
+
+    // The same bytes as save()/load(), kept in memory (e.g. inside the score store)
+    void serialize(std::vector<uint8_t>& out) const;
+    bool deserialize(const std::vector<uint8_t>& data, std::string& error);
+
+    const SimulationConfig& config() const { return m_config; }
+    float fixedTickSeconds() const { return m_fixedTickSeconds; }
+    uint64_t tickCount() const { return m_tickCount; }
+    size_t sizeBytes() const { return m_data.size(); }
+    bool hasFinalChecksum() const { return m_hasFinalChecksum; }
+    uint64_t finalChecksum() const { return m_finalChecksum; }
+
+    // Sequential decoder over the recorded ticks
+    class Reader {
+    public:
+        explicit Reader(const InputRecording& recording);
+
+        // False at the end of the recording (or on corrupt data)
+        bool next(TickInput& out, bool& frameStart);
+        bool atEnd() const { return m_offset >= m_recording.m_data.size(); }
+
+    private:
+        const InputRecording& m_recording;
+        size_t m_offset;
+        uint16_t m_lid;
+        uint16_t m_rightLid;
+    };
+
+private:
+    bool write(std::ostream& out) const;
+    bool read(std::istream& in, const std::string& name, std::string& error);
+
+    SimulationConfig m_config;
+    float m_fixedTickSeconds;
+    uint64_t m_tickCount;
+    uint16_t m_lastLid;
+    uint16_t m_lastRightLid;
+    bool m_hasFinalChecksum;
+    uint64_t m_finalChecksum;
+    std::vector<uint8_t> m_data;
+};
+
+// Run a recording through a headless simulation as fast as possible and
+// report throughput and whether the final state matches. 0 on a match.
+// 'onFrame' (optional) sees the state at the end of every recorded frame;
+// returning false stops the replay with a failure.
+int replayHeadless(const InputRecording& recording,
+                   const std::function<bool(const Simulation&)>& onFrame = std::function<bool(const Simulation&)>());
+
+} // namespace LidPong
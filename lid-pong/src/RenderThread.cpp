@@ -0,0 +1,107 @@
+#include "RenderThread.h"
+#include <chrono>
+
+namespace LidPong {
+
+RenderThread::RenderThread()
+    : m_target(nullptr)
+    , m_redrawWhenIdle(true)
+    , m_running(false)
+    , m_paused(false)
+    , m_sequence(0)
+    , m_drawn(0)
+    , m_reused(0)
+    , m_skipped(0) {
+}
+
+RenderThread::~RenderThread() {
+    stop();
+}
+
+void RenderThread::start(RenderTarget& target, bool redrawWhenIdle) {
+    if (m_running.load()) {
+        return;
+    }
+    m_target = &target;
+    m_redrawWhenIdle = redrawWhenIdle;
+    m_running.store(true);
+    m_thread = std::thread(&RenderThread::threadMain, this);
+}
+
+void RenderThread::stop() {
+    if (!m_running.exchange(false)) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_pauseMutex);
+    }
+    m_resumed.notify_all();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+bool RenderThread::isRunning() const {
+    return m_running.load(std::memory_order_relaxed);
+}
+
+void RenderThread::publish() {
+    m_mailbox.writeBuffer().sequence = ++m_sequence;
+    m_mailbox.commit();
+}
+
+void RenderThread::setPaused(bool paused) {
+    {
+        std::lock_guard<std::mutex> lock(m_pauseMutex);
+        m_paused.store(paused);
+    }
+    if (!paused) {
+        m_resumed.notify_all();
+    }
+}
+
+RenderThreadStats RenderThread::stats() const {
+    RenderThreadStats stats;
+    stats.published = m_sequence;
+    stats.drawn = m_drawn.load(std::memory_order_relaxed);
+    stats.reused = m_reused.load(std::memory_order_relaxed);
+    stats.skipped = m_skipped.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void RenderThread::threadMain() {
+    m_target->beginRendering();
+
+    uint64_t lastSequence = 0;
+    while (m_running.load(std::memory_order_relaxed)) {
+        bool fresh = m_mailbox.fetch();
+        if (!fresh && m_paused.load()) {
+            // Look again: the pause may have come right after a publish we missed
+            fresh = m_mailbox.fetch();
+            if (!fresh) {
+                std::unique_lock<std::mutex> lock(m_pauseMutex);
+                m_resumed.wait(lock, [this] { return !m_paused.load() || !m_running.load(); });
+                continue;
+            }
+        }
+
+        if (fresh) {
+            uint64_t sequence = m_mailbox.readBuffer().sequence;
+            m_skipped.fetch_add(sequence - lastSequence - 1, std::memory_order_relaxed);
+            lastSequence = sequence;
+        } else if (lastSequence == 0 || !m_redrawWhenIdle) {
+            std::this_thread::sleep_for(std::chrono::microseconds(250));
+            continue;
+        } else {
+            m_reused.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        m_target->draw(m_mailbox.readBuffer());
+        m_target->present();
+        m_drawn.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    m_target->endRendering();
+}
+
+} // namespace LidPong
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "Mailbox.h"
+#include "Scene.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+namespace LidPong {
+
+// What the render thread drives, e.g. the game's GL window
+class RenderTarget {
+public:
+    virtual ~RenderTarget() {}
+
+    virtual void beginRendering() {} // On the render thread first (make the GL context current)
+    virtual void draw(const RenderSnapshot& frame) = 0;
+    virtual void present() = 0;      // May block on vsync or the compositor
+    virtual void endRendering() {}   // On the render thread last (release the context)
+};
+
+struct RenderThreadStats {
+    uint64_t published; // Snapshots handed over by the simulation
+    uint64_t drawn;     // Frames presented
+    uint64_t reused;    // Frames that redrew the previous snapshot because nothing newer arrived
+    uint64_t skipped;   // Snapshots overwritten before the render thread got to them
+};
+
+// Draws on its own thread so a blocking swap never holds up the simulation
+// or the next input read. The simulation thread fills snapshotToWrite() and
+// calls publish() once per update; the render thread always draws the newest
+// snapshot, through a triple buffer, so neither side ever waits for the other.
+class RenderThread {
+public:
+    RenderThread();
+    ~RenderThread();
+
+    RenderThread(const RenderThread&) = delete;
+    RenderThread& operator=(const RenderThread&) = delete;
+
+    // redrawWhenIdle: keep presenting the last snapshot when nothing new has
+    // arrived (with vsync that is one redraw per refresh); otherwise wait for one
+    void start(RenderTarget& target, bool redrawWhenIdle);
+    void stop();
+    bool isRunning() const;
+
+    // Simulation thread: storage for the next snapshot (holds an older one)
+    RenderSnapshot& snapshotToWrite() { return m_mailbox.writeBuffer(); }
+    void publish();
+
+    // Paused, the thread still shows a snapshot published before the pause,
+    // then blocks (no redraws, no polling) until resumed
+    void setPaused(bool paused);
+
+    RenderThreadStats stats() const;
+
+private:
+    void threadMain();
+
+    RenderTarget* m_target;
+    bool m_redrawWhenIdle;
+    std::thread m_thread;
+    std::atomic<bool> m_running;
+    std::atomic<bool> m_paused;
+    std::mutex m_pauseMutex;
+    std::condition_variable m_resumed;
+
+    LatestValueMailbox<RenderSnapshot> m_mailbox;
+    uint64_t m_sequence; // Owned by the simulation thread
+
+    std::atomic<uint64_t> m_drawn;
+    std::atomic<uint64_t> m_reused;
+    std::atomic<uint64_t> m_skipped;
+};
+
+} // namespace LidPong
@@ -0,0 +1,222 @@
+#include "Rollback.h"
+#include <cstring>
+
+namespace LidPong {
+
+namespace {
+    const uint32_t MAGIC = 0x504E504C; // "LPNP"
+    const uint64_t NONE = UINT64_MAX;
+    const uint32_t NO_CHECKSUM = UINT32_MAX;
+    const uint32_t MAX_INPUTS_PER_PACKET = 64;
+
+    // Wire header; inputs follow as {uint16 lid, uint8 buttons, uint8 pad}.
+    // Little-endian on every platform we build for, so it is copied as-is.
+    struct PacketHeader {
+        uint32_t magic;
+        uint8_t player;
+        uint8_t inputCount;
+        uint16_t reserved;
+        uint32_t firstTick;     // Tick of the first input carried
+        uint32_t ack;           // First tick of the receiver's inputs the sender lacks
+        uint32_t checksumTick;  // NO_CHECKSUM if none yet
+        uint64_t checksum;
+    };
+
+    const size_t INPUT_BYTES = 4;
+    const size_t MAX_PACKET = sizeof(PacketHeader) + MAX_INPUTS_PER_PACKET * INPUT_BYTES;
+}
+
+RollbackSession::RollbackSession(Simulation& sim, int localPlayer, float tickSeconds, Transport& transport)
+    : m_sim(sim)
+    , m_localPlayer(localPlayer)
+    , m_tickSeconds(tickSeconds)
+    , m_transport(transport)
+    , m_currentTick(0)
+    , m_remoteNext(0)
+    , m_peerAck(0)
+    , m_firstMismatch(NONE)
+    , m_checksumNext(0)
+    , m_lastChecksumTick(NONE)
+    , m_lastComparedTick(NONE) {
+    std::memset(&m_stats, 0, sizeof(m_stats));
+    const PlayerInput centre = {TickInput::lidToFixed(0.5), 0};
+    for (uint32_t i = 0; i < HISTORY; i++) {
+        m_localInputs[i] = centre;
+        m_remoteInputs[i] = centre;
+        m_usedRemote[i] = centre;
+        m_checksums[i] = 0;
+    }
+}
+
+void RollbackSession::update() {
+    receive();
+    rollback();
+    recordChecksums();
+    send();
+}
+
+bool RollbackSession::advance(const PlayerInput& local) {
+    receive();
+    rollback();
+
+    if (m_currentTick >= m_remoteNext + MAX_PREDICTION) {
+        m_stats.stalls++;
+        recordChecksums();
+        send();
+        return false;
+    }
+
+    m_localInputs[m_currentTick % HISTORY] = local;
+    stepTick(m_currentTick);
+    m_currentTick++;
+
+    recordChecksums();
+    send();
+    return true;
+}
+
+bool RollbackSession::isSettled() const {
+    return m_remoteNext >= m_currentTick && m_peerAck >= m_currentTick && m_firstMismatch == NONE;
+}
+
+PlayerInput RollbackSession::remoteInputFor(uint64_t tick) const {
+    if (tick < m_remoteNext) {
+        return m_remoteInputs[tick % HISTORY];
+    }
+    // Prediction: the lid stays where it was last seen, nobody presses anything
+    PlayerInput predicted = m_remoteNext > 0 ? m_remoteInputs[(m_remoteNext - 1) % HISTORY]
+                                             : m_remoteInputs[0];
+    predicted.buttons = 0;
+    return predicted;
+}
+
+void RollbackSession::stepTick(uint64_t tick) {
+    const uint32_t slot = tick % HISTORY;
+    const PlayerInput& local = m_localInputs[slot];
+    PlayerInput remote = remoteInputFor(tick);
+    m_usedRemote[slot] = remote;
+    m_states[slot] = m_sim.state();
+
+    const PlayerInput& left = m_localPlayer == 0 ? local : remote;
+    const PlayerInput& right = m_localPlayer == 0 ? remote : local;
+
+    TickInput input;
+    input.deltaTime = m_tickSeconds;
+    input.lidPosition = TickInput::lidFromFixed(left.lid);
+    input.rightLidPosition = TickInput::lidFromFixed(right.lid);
+    input.buttons = static_cast<uint8_t>((left.buttons | right.buttons) & (BUTTON_SERVE | BUTTON_SPEED_UP | BUTTON_SPEED_DOWN));
+    m_sim.step(input);
+}
+
+void RollbackSession::receive() {
+    uint8_t packet[MAX_PACKET];
+    int size;
+    while ((size = m_transport.receive(packet, sizeof(packet))) >= 0) {
+        PacketHeader header;
+        if (static_cast<size_t>(size) < sizeof(header)) continue;
+        std::memcpy(&header, packet, sizeof(header));
+        if (header.magic != MAGIC || header.player == m_localPlayer ||
+            static_cast<size_t>(size) < sizeof(header) + header.inputCount * INPUT_BYTES) {
+            continue;
+        }
+        m_stats.packetsReceived++;
+
+        if (header.ack > m_peerAck && header.ack <= m_currentTick) {
+            m_peerAck = header.ack;
+        }
+
+        // Inputs are contiguous from firstTick; anything new extends m_remoteNext
+        uint64_t end = static_cast<uint64_t>(header.firstTick) + header.inputCount;
+        if (header.firstTick <= m_remoteNext && end > m_remoteNext) {
+            for (uint64_t tick = m_remoteNext; tick < end; tick++) {
+                const uint8_t* bytes = packet + sizeof(header) + (tick - header.firstTick) * INPUT_BYTES;
+                PlayerInput input;
+                std::memcpy(&input.lid, bytes, sizeof(input.lid));
+                input.buttons = bytes[2];
+                m_remoteInputs[tick % HISTORY] = input;
+
+                if (tick < m_currentTick && m_usedRemote[tick % HISTORY] != input && tick < m_firstMismatch) {
+                    m_firstMismatch = tick;
+                }
+            }
+            m_remoteNext = end;
+        }
+
+        // Compare fingerprints of ticks both sides have confirmed, once per
+        // tick: every packet repeats the latest checksum until the next one
+        if (header.checksumTick != NO_CHECKSUM && header.checksumTick < m_checksumNext &&
+            header.checksumTick + HISTORY > m_checksumNext &&
+            (m_lastComparedTick == NONE || header.checksumTick > m_lastComparedTick)) {
+            m_lastComparedTick = header.checksumTick;
+            m_stats.checksumsCompared++;
+            if (m_checksums[header.checksumTick % HISTORY] != header.checksum) {
+                m_stats.desyncs++;
+            }
+        }
+    }
+}
+
+void RollbackSession::rollback() {
+    if (m_firstMismatch == NONE) {
+        return;
+    }
+
+    uint64_t from = m_firstMismatch;
+    m_firstMismatch = NONE;
+    if (from + HISTORY <= m_currentTick) {
+        return; // Can't happen while MAX_PREDICTION < HISTORY
+    }
+
+    m_sim.restore(m_states[from % HISTORY]);
+    for (uint64_t tick = from; tick < m_currentTick; tick++) {
+        stepTick(tick);
+    }
+
+    uint64_t depth = m_currentTick - from;
+    m_stats.rollbacks++;
+    m_stats.resimulatedTicks += depth;
+    if (depth > m_stats.maxRollbackDepth) m_stats.maxRollbackDepth = depth;
+}
+
+// Fingerprint states that can no longer change
+void RollbackSession::recordChecksums() {
+    uint64_t final = confirmedTick();
+    while (m_checksumNext < final) {
+        m_checksums[m_checksumNext % HISTORY] = Simulation::checksum(m_states[m_checksumNext % HISTORY]);
+        m_lastChecksumTick = m_checksumNext;
+        m_checksumNext += CHECKSUM_INTERVAL;
+    }
+}
+
+void RollbackSession::send() {
+    uint64_t first = m_peerAck;
+    if (m_currentTick > MAX_INPUTS_PER_PACKET && first < m_currentTick - MAX_INPUTS_PER_PACKET) {
+        first = m_currentTick - MAX_INPUTS_PER_PACKET;
+    }
+
+    PacketHeader header;
+    std::memset(&header, 0, sizeof(header)); // Padding goes on the wire too
+    header.magic = MAGIC;
+    header.player = static_cast<uint8_t>(m_localPlayer);
+    header.inputCount = static_cast<uint8_t>(m_currentTick - first);
+    header.firstTick = static_cast<uint32_t>(first);
+    header.ack = static_cast<uint32_t>(m_remoteNext);
+    header.checksumTick = m_lastChecksumTick == NONE ? NO_CHECKSUM : static_cast<uint32_t>(m_lastChecksumTick);
+    header.checksum = m_lastChecksumTick == NONE ? 0 : m_checksums[m_lastChecksumTick % HISTORY];
+
+    uint8_t packet[MAX_PACKET];
+    std::memcpy(packet, &header, sizeof(header));
+    uint8_t* out = packet + sizeof(header);
+    for (uint64_t tick = first; tick < m_currentTick; tick++) {
+        const PlayerInput& input = m_localInputs[tick % HISTORY];
+        std::memcpy(out, &input.lid, sizeof(input.lid));
+        out[2] = input.buttons;
+        out[3] = 0;
+        out += INPUT_BYTES;
+    }
+
+    m_transport.send(packet, out - packet);
+    m_stats.packetsSent++;
+}
+
+} // namespace LidPong
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "NetTransport.h"
+#include "Simulation.h"
+#include <cstdint>
+
+namespace LidPong {
+
+// One player's input for one tick, as sent over the wire
+struct PlayerInput {
+    uint16_t lid;    // TickInput::lidToFixed position
+    uint8_t buttons; // BUTTON_SERVE / SPEED_UP / SPEED_DOWN (the slider isn't networked)
+
+    bool operator==(const PlayerInput& other) const { return lid == other.lid && buttons == other.buttons; }
+    bool operator!=(const PlayerInput& other) const { return !(*this == other); }
+};
+
+struct RollbackStats {
+    uint64_t rollbacks;         // Corrections that forced a re-simulation
+    uint64_t resimulatedTicks;
+    uint64_t maxRollbackDepth;  // Most ticks re-simulated by one correction
+    uint64_t stalls;            // advance() calls refused for being too far ahead
+    uint64_t packetsSent;
+    uint64_t packetsReceived;
+    uint64_t checksumsCompared;
+    uint64_t desyncs;           // Confirmed ticks where the peers' states differed
+};
+
+// Peer-to-peer rollback for the versus mode. Only inputs cross the wire.
+//
+// The local input is applied at once; the remote one is predicted (last known
+// lid, no buttons) until it arrives. When a received input differs from what
+// was predicted, the game state from just before that tick is restored - a
+// GameState memcpy - and every tick since is simulated again with the
+// corrected input. Each packet repeats every input the peer hasn't
+// acknowledged, so lost packets cost latency rather than correctness, and
+// the peers swap checksums of confirmed ticks to catch desyncs.
+class RollbackSession {
+public:
+    static const uint32_t MAX_PREDICTION = 24; // Ticks we may run ahead of the peer's inputs
+    static const uint32_t HISTORY = 256;       // Saved states/inputs (power of two)
+    static const uint32_t CHECKSUM_INTERVAL = 16;
+
+    // 'sim' must be a versus simulation; localPlayer 0 is the left paddle
+    RollbackSession(Simulation& sim, int localPlayer, float tickSeconds, Transport& transport);
+
+    // Receive, apply corrections and send; call at least once per frame
+    void update();
+
+    // update(), then simulate the next tick with this local input. Returns
+    // false (and does nothing else) when too far ahead of the peer.
+    bool advance(const PlayerInput& local);
+
+    uint64_t currentTick() const { return m_currentTick; }
+
+    // Ticks below this have both players' real inputs
+    uint64_t confirmedTick() const { return m_remoteNext < m_currentTick ? m_remoteNext : m_currentTick; }
+
+    // Both sides have all of each other's inputs up to currentTick() and no
+    // correction is pending: the state is final and identical on both peers
+    bool isSettled() const;
+
+    int localPlayer() const { return m_localPlayer; }
+    const RollbackStats& stats() const { return m_stats; }
+
+private:
+    void receive();
+    void rollback();
+    void recordChecksums();
+    void send();
+    void stepTick(uint64_t tick);
+    PlayerInput remoteInputFor(uint64_t tick) const;
+
+    Simulation& m_sim;
+    int m_localPlayer;
+    float m_tickSeconds;
+    Transport& m_transport;
+
+    uint64_t m_currentTick;   // Next tick to simulate
+    uint64_t m_remoteNext;    // First tick whose remote input we lack
+    uint64_t m_peerAck;       // First tick whose local input the peer lacks
+    uint64_t m_firstMismatch; // Earliest mispredicted tick, or NONE
+    uint64_t m_checksumNext;  // Next CHECKSUM_INTERVAL tick to fingerprint
+    uint64_t m_lastChecksumTick;
+    uint64_t m_lastComparedTick; // Latest peer checksum tick compared, or NONE
+
+    PlayerInput m_localInputs[HISTORY];
+    PlayerInput m_remoteInputs[HISTORY];
+    PlayerInput m_usedRemote[HISTORY]; // What the simulation used (maybe a prediction)
+    GameState m_states[HISTORY];       // State before each tick
+    uint64_t m_checksums[HISTORY];     // Of confirmed states, at CHECKSUM_INTERVAL ticks
+
+    RollbackStats m_stats;
+};
+
+} // namespace LidPong
@@ -0,0 +1,626 @@
+#include "Scene.h"
+#include "Clock.h"
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <sys/stat.h>
+
+namespace LidPong {
+
+RenderSnapshot::RenderSnapshot()
+    : sequence(0)
+    , versus(false)
+    , multiBall(false)
+    , brickMode(false)
+    , swarmRadius(0.0f)
+    , inputTimestampNs(0)
+    , framebufferWidth(0)
+    , framebufferHeight(0)
+    , m_brickRevision(UINT64_MAX)
+    , m_brickGeneration(UINT64_MAX) {
+    hud.sensorAvailable = false;
+    hud.lidAngle = 0.0;
+}
+
+void RenderSnapshot::capture(const Simulation& sim, uint64_t generation) {
+    state = sim.state();
+    versus = sim.isVersus();
+    multiBall = sim.isMultiBall();
+    brickMode = sim.isBrickMode();
+
+    if (multiBall) {
+        const BallSwarm& swarm = sim.swarm();
+        swarmRadius = swarm.radius();
+        swarmPositions.resize(2 * swarm.size());
+        swarm.writePositions(swarmPositions.data());
+    }
+
+    if (brickMode) {
+        // Vertex data only changes when a brick breaks
+        const BrickField& brickField = sim.brickField();
+        if (m_brickRevision != brickField.revision() || m_brickGeneration != generation) {
+            brickQuads.clear();
+            for (const Brick& brick : brickField.bricks()) {
+                if (!brick.alive) continue;
+                const float quad[8] = {brick.minX, brick.minY, brick.maxX, brick.minY,
+                                       brick.maxX, brick.maxY, brick.minX, brick.maxY};
+                brickQuads.insert(brickQuads.end(), quad, quad + 8);
+            }
+            m_brickRevision = brickField.revision();
+            m_brickGeneration = generation;
+        }
+        brickBalls = sim.brickBalls();
+    }
+}
+
+void RenderSnapshot::captureParticles(const ParticlePool& particles) {
+    // Grow once to the pool's capacity; after that capturing never allocates
+    if (particleColors.capacity() < particles.capacity()) {
+        particlePositions.reserve(2 * particles.capacity());
+        particleColors.reserve(particles.capacity());
+    }
+    particlePositions.resize(2 * particles.size());
+    particleColors.resize(particles.size());
+    particles.write(particlePositions.data(), particleColors.data());
+}
+
+void SceneRenderer::draw(Canvas& canvas, const RenderSnapshot& frame) {
+    const GameState& state = frame.state;
+    canvas.clear(0.0f, 0.0f, 0.0f); // Black background
+
+    // Draw THIN walls
+    canvas.setColor(0.5f, 0.5f, 0.5f); // Gray walls
+
+    // Top wall (very thin)
+    canvas.begin(Primitive::Quads);
+    canvas.vertex(-1.0f, 0.95f);
+    canvas.vertex(1.0f, 0.95f);
+    canvas.vertex(1.0f, 1.0f);
+    canvas.vertex(-1.0f, 1.0f);
+    canvas.end();
+
+    // Bottom wall (very thin)
+    canvas.begin(Primitive::Quads);
+    canvas.vertex(-1.0f, -1.0f);
+    canvas.vertex(1.0f, -1.0f);
+    canvas.vertex(1.0f, -0.95f);
+    canvas.vertex(-1.0f, -0.95f);
+    canvas.end();
+
+    // Right wall (very thin); in versus the right player's paddle guards that side
+    if (frame.versus) {
+        drawSlider(canvas, state.rightSlider);
+    } else {
+        canvas.begin(Primitive::Quads);
+        canvas.vertex(0.98f, -1.0f);
+        canvas.vertex(1.0f, -1.0f);
+        canvas.vertex(1.0f, 1.0f);
+        canvas.vertex(0.98f, 1.0f);
+        canvas.end();
+    }
+
+    // Draw game objects
+    drawSlider(canvas, state.slider);
+    if (frame.brickMode) {
+        drawBricks(canvas, frame);
+    } else if (frame.multiBall) {
+        drawSwarm(canvas, frame);
+    } else {
+        drawBall(canvas, state.ball);
+    }
+    drawParticles(canvas, frame);
+
+    // Draw simple HUD indicators
+    drawHUD(canvas, frame);
+
+    // Draw game over modal
+    if (state.showGameOverModal) {
+        drawGameOverModal(canvas, frame);
+    }
+}
+
+void SceneRenderer::drawBall(Canvas& canvas, const Ball& ball) {
+    if (!ball.active) return;
+
+    canvas.setColor(1.0f, 1.0f, 1.0f); // White ball
+    canvas.begin(Primitive::TriangleFan);
+    canvas.vertex(ball.x, ball.y);
+    for (int i = 0; i <= 20; i++) {
+        float angle = 2.0f * M_PI * i / 20;
+        canvas.vertex(ball.x + ball.radius * cos(angle), ball.y + ball.radius * sin(angle));
+    }
+    canvas.end();
+}
+
+void SceneRenderer::drawSlider(Canvas& canvas, const Slider& slider) {
+    canvas.setColor(0.8f, 0.8f, 0.8f); // Light gray slider
+    canvas.begin(Primitive::Quads);
+    canvas.vertex(slider.x - slider.width/2, slider.y - slider.height/2);
+    canvas.vertex(slider.x + slider.width/2, slider.y - slider.height/2);
+    canvas.vertex(slider.x + slider.width/2, slider.y + slider.height/2);
+    canvas.vertex(slider.x - slider.width/2, slider.y + slider.height/2);
+    canvas.end();
+}
+
+// All balls in one draw call: round points sized to the ball radius
+void SceneRenderer::drawSwarm(Canvas& canvas, const RenderSnapshot& frame) {
+    canvas.setColor(1.0f, 1.0f, 1.0f);
+    canvas.drawPoints(frame.swarmPositions.data(), frame.swarmPositions.size() / 2, frame.swarmRadius * canvas.height());
+}
+
+// Every particle in one batched draw, blended by its faded alpha
+void SceneRenderer::drawParticles(Canvas& canvas, const RenderSnapshot& frame) {
+    if (frame.particleColors.empty()) return;
+
+    canvas.setBlending(true);
+    canvas.drawColoredPoints(frame.particlePositions.data(), frame.particleColors.data(), frame.particleColors.size(),
+                             0.008f * canvas.height());
+    canvas.setBlending(false);
+}
+
+void SceneRenderer::drawBricks(Canvas& canvas, const RenderSnapshot& frame) {
+    canvas.setColor(0.9f, 0.5f, 0.2f);
+    canvas.drawQuads(frame.brickQuads.data(), frame.brickQuads.size() / 2);
+
+    canvas.setColor(1.0f, 1.0f, 1.0f);
+    for (const SweptBall& b : frame.brickBalls) {
+        canvas.begin(Primitive::TriangleFan);
+        canvas.vertex(b.x, b.y);
+        for (int i = 0; i <= 12; i++) {
+            float angle = 2.0f * M_PI * i / 12;
+            canvas.vertex(b.x + b.radius * cos(angle), b.y + b.radius * sin(angle));
+        }
+        canvas.end();
+    }
+}
+
+void SceneRenderer::drawHUD(Canvas& canvas, const RenderSnapshot& frame) {
+    const GameState& state = frame.state;
+    const HudInfo& hud = frame.hud;
+    // Draw lives as simple squares (no text)
+    canvas.setColor(1.0f, 0.2f, 0.2f);
+    for (int i = 0; i < (frame.versus ? 0 : state.lives); i++) {
+        float x = -0.9f + i * 0.08f;
+        canvas.begin(Primitive::Quads);
+        canvas.vertex(x - 0.02f, 0.82f);
+        canvas.vertex(x + 0.02f, 0.82f);
+        canvas.vertex(x + 0.02f, 0.86f);
+        canvas.vertex(x - 0.02f, 0.86f);
+        canvas.end();
+    }
+
+    // Draw score as simple number (one per side in versus)
+    if (frame.versus) {
+        drawSimpleNumber(canvas, state.score, -0.3f, 0.84f, 0.04f);
+        drawSimpleNumber(canvas, state.rightScore, 0.3f, 0.84f, 0.04f);
+    } else {
+        drawSimpleNumber(canvas, state.score, 0.0f, 0.84f, 0.04f);
+    }
+
+    // Draw speed slider (interactive)
+    drawSpeedSlider(canvas, frame);
+
+    // Lid angle indicator (vertical bar on right)
+    if (hud.sensorAvailable) {
+        canvas.setColor(0.0f, 1.0f, 0.0f); // Green if sensor working
+        float angleNormalized = (hud.lidAngle - 30.0) / 120.0; // Normalize 30-150 degrees
+        if (angleNormalized < 0) angleNormalized = 0;
+        if (angleNormalized > 1) angleNormalized = 1;
+        float barHeight = angleNormalized * 1.6f - 0.8f;
+        
+        canvas.begin(Primitive::Quads);
+        canvas.vertex(0.85f, -0.8f);
+        canvas.vertex(0.9f, -0.8f);
+        canvas.vertex(0.9f, barHeight);
+        canvas.vertex(0.85f, barHeight);
+        canvas.end();
+    } else {
+        canvas.setColor(1.0f, 0.0f, 0.0f); // Red if sensor not working
+    }
+
+    // Lid angle bar outline
+    canvas.begin(Primitive::LineLoop);
+    canvas.vertex(0.85f, -0.8f);
+    canvas.vertex(0.9f, -0.8f);
+    canvas.vertex(0.9f, 0.8f);
+    canvas.vertex(0.85f, 0.8f);
+    canvas.end();
+}
+
+void SceneRenderer::drawGameOverModal(Canvas& canvas, const RenderSnapshot& frame) {
+    // Semi-transparent overlay
+    canvas.setColor(0.0f, 0.0f, 0.0f, 0.7f);
+    canvas.setBlending(true);
+    canvas.begin(Primitive::Quads);
+    canvas.vertex(-1.0f, -1.0f);
+    canvas.vertex(1.0f, -1.0f);
+    canvas.vertex(1.0f, 1.0f);
+    canvas.vertex(-1.0f, 1.0f);
+    canvas.end();
+
+    // Modal box
+    canvas.setColor(0.2f, 0.2f, 0.3f);
+    canvas.begin(Primitive::Quads);
+    canvas.vertex(-0.6f, -0.4f);
+    canvas.vertex(0.6f, -0.4f);
+    canvas.vertex(0.6f, 0.4f);
+    canvas.vertex(-0.6f, 0.4f);
+    canvas.end();
+
+    // Modal border
+    canvas.setColor(1.0f, 1.0f, 1.0f);
+    canvas.begin(Primitive::LineLoop);
+    canvas.vertex(-0.6f, -0.4f);
+    canvas.vertex(0.6f, -0.4f);
+    canvas.vertex(0.6f, 0.4f);
+    canvas.vertex(-0.6f, 0.4f);
+    canvas.end();
+
+    // Show final score as number
+    canvas.setColor(1.0f, 1.0f, 1.0f);
+    drawSimpleNumber(canvas, frame.state.score, 0.0f, 0.0f, 0.08f);
+
+    // Simple indicator that game is over (red X)
+    canvas.setColor(1.0f, 0.3f, 0.3f);
+    canvas.begin(Primitive::Quads);
+    // First diagonal
+    canvas.vertex(-0.1f, 0.25f); canvas.vertex(-0.05f, 0.3f); canvas.vertex(0.1f, 0.1f); canvas.vertex(0.05f, 0.05f);
+    // Second diagonal  
+    canvas.vertex(0.05f, 0.3f); canvas.vertex(0.1f, 0.25f); canvas.vertex(-0.05f, 0.05f); canvas.vertex(-0.1f, 0.1f);
+    canvas.end();
+
+    // "Press space to continue" text
+    canvas.setColor(0.7f, 0.7f, 0.7f);
+    drawSimpleText(canvas, "PRESS SPACE TO CONTINUE", 0.0f, -0.25f, 0.025f);
+
+    canvas.setBlending(false);
+}
+
+void SceneRenderer::drawSimpleNumber(Canvas& canvas, int number, float x, float y, float size) {
+    // Digits least significant first into a fixed buffer: nothing allocates per frame
+    int digits[10];
+    int count = 0;
+    unsigned value = number < 0 ? 0u - static_cast<unsigned>(number) : static_cast<unsigned>(number);
+    do {
+        digits[count++] = static_cast<int>(value % 10);
+        value /= 10;
+    } while (value > 0);
+
+    float digitWidth = size * 0.8f;
+    float startX = x - (count - 1) * digitWidth * 0.5f;
+    for (int i = 0; i < count; i++) {
+        drawSimpleDigit(canvas, digits[count - 1 - i], startX + i * digitWidth, y, size);
+    }
+}
+
+void SceneRenderer::drawSimpleDigit(Canvas& canvas, int digit, float x, float y, float size) {
+    float w = size * 0.3f;
+    float h = size * 0.5f;
+    float thick = size * 0.08f;
+
+    canvas.setColor(1.0f, 1.0f, 1.0f);
+
+    // Very simple 7-segment display using rectangles
+    bool segs[10][7] = {
+        {1,1,1,1,1,1,0}, // 0
+        {0,1,1,0,0,0,0}, // 1  
+        {1,1,0,1,1,0,1}, // 2
+        {1,1,1,1,0,0,1}, // 3
+        {0,1,1,0,0,1,1}, // 4
+        {1,0,1,1,0,1,1}, // 5
+        {1,0,1,1,1,1,1}, // 6
+        {1,1,1,0,0,0,0}, // 7
+        {1,1,1,1,1,1,1}, // 8
+        {1,1,1,1,0,1,1}  // 9
+    };
+
+    if (digit < 0 || digit > 9) return;
+
+    canvas.begin(Primitive::Quads);
+
+    // Top horizontal (segment 0)
+    if (segs[digit][0]) {
+        canvas.vertex(x-w+thick, y+h-thick);
+        canvas.vertex(x+w-thick, y+h-thick);
+        canvas.vertex(x+w-thick, y+h);
+        canvas.vertex(x-w+thick, y+h);
+    }
+
+    // Top right vertical (segment 1)
+    if (segs[digit][1]) {
+        canvas.vertex(x+w-thick, y);
+        canvas.vertex(x+w, y);
+        canvas.vertex(x+w, y+h-thick);
+        canvas.vertex(x+w-thick, y+h-thick);
+    }
+
+    // Bottom right vertical (segment 2)
+    if (segs[digit][2]) {
+        canvas.vertex(x+w-thick, y-h+thick);
+        canvas.vertex(x+w, y-h+thick);
+        canvas.vertex(x+w, y);
+        canvas.vertex(x+w-thick, y);
+    }
+
+    // Bottom horizontal (segment 3)
+    if (segs[digit][3]) {
+        canvas.vertex(x-w+thick, y-h);
+        canvas.vertex(x+w-thick, y-h);
+        canvas.vertex(x+w-thick, y-h+thick);
+        canvas.vertex(x-w+thick, y-h+thick);
+    }
+
+    // Bottom left vertical (segment 4)
+    if (segs[digit][4]) {
+        canvas.vertex(x-w, y-h+thick);
+        canvas.vertex(x-w+thick, y-h+thick);
+        canvas.vertex(x-w+thick, y);
+        canvas.vertex(x-w, y);
+    }
+
+    // Top left vertical (segment 5)
+    if (segs[digit][5]) {
+        canvas.vertex(x-w, y);
+        canvas.vertex(x-w+thick, y);
+        canvas.vertex(x-w+thick, y+h-thick);
+        canvas.vertex(x-w, y+h-thick);
+    }
+
+    // Middle horizontal (segment 6)
+    if (segs[digit][6]) {
+        canvas.vertex(x-w+thick, y-thick/2);
+        canvas.vertex(x+w-thick, y-thick/2);
+        canvas.vertex(x+w-thick, y+thick/2);
+        canvas.vertex(x-w+thick, y+thick/2);
+    }
+
+    canvas.end();
+}
+
+void SceneRenderer::drawSimpleText(Canvas& canvas, const char* text, float x, float y, float size) {
+    size_t length = std::strlen(text);
+    float charWidth = size * 0.8f;
+    float startX = x - (length - 1) * charWidth * 0.5f;
+
+    for (size_t i = 0; i < length; i++) {
+        char c = text[i];
+        drawSimpleChar(canvas, c, startX + i * charWidth, y, size);
+    }
+}
+
+void SceneRenderer::drawSimpleChar(Canvas& canvas, char c, float x, float y, float size) {
+    float w = size * 0.3f;
+    float h = size * 0.4f;
+    float thick = size * 0.1f;
+
+    canvas.begin(Primitive::Quads);
+
+    switch (c) {
+        case 'A':
+            // Left vertical
+            canvas.vertex(x-w, y-h); canvas.vertex(x-w+thick, y-h); canvas.vertex(x-w+thick, y+h); canvas.vertex(x-w, y+h);
+            // Right vertical
+            canvas.vertex(x+w-thick, y-h); canvas.vertex(x+w, y-h); canvas.vertex(x+w, y+h); canvas.vertex(x+w-thick, y+h);
+            // Top horizontal
+            canvas.vertex(x-w, y+h-thick); canvas.vertex(x+w, y+h-thick); canvas.vertex(x+w, y+h); canvas.vertex(x-w, y+h);
+            // Middle horizontal
+            canvas.vertex(x-w+thick, y-thick/2); canvas.vertex(x+w-thick, y-thick/2); canvas.vertex(x+w-thick, y+thick/2); canvas.vertex(x-w+thick, y+thick/2);
+            break;
+            
+        case 'C':
+            // Left vertical
+            canvas.vertex(x-w, y-h); canvas.vertex(x-w+thick, y-h); canvas.vertex(x-w+thick, y+h); canvas.vertex(x-w, y+h);
+            // Top horizontal
+            canvas.vertex(x-w, y+h-thick); canvas.vertex(x+w, y+h-thick); canvas.vertex(x+w, y+h); canvas.vertex(x-w, y+h);
+            // Bottom horizontal
+            canvas.vertex(x-w, y-h); canvas.vertex(x+w, y-h); canvas.vertex(x+w, y-h+thick); canvas.vertex(x-w, y-h+thick);
+            break;
+            
+        case 'E':
+            // Left vertical
+            canvas.vertex(x-w, y-h); canvas.vertex(x-w+thick, y-h); canvas.vertex(x-w+thick, y+h); canvas.vertex(x-w, y+h);
+            // Top horizontal
+            canvas.vertex(x-w, y+h-thick); canvas.vertex(x+w, y+h-thick); canvas.vertex(x+w, y+h); canvas.vertex(x-w, y+h);
+            // Middle horizontal
+            canvas.vertex(x-w+thick, y-thick/2); canvas.vertex(x+w*0.7f, y-thick/2); canvas.vertex(x+w*0.7f, y+thick/2); canvas.vertex(x-w+thick, y+thick/2);
+            // Bottom horizontal
+            canvas.vertex(x-w, y-h); canvas.vertex(x+w, y-h); canvas.vertex(x+w, y-h+thick); canvas.vertex(x-w, y-h+thick);
+            break;
+            
+        case 'I':
+            // Top horizontal
+            canvas.vertex(x-w, y+h-thick); canvas.vertex(x+w, y+h-thick); canvas.vertex(x+w, y+h); canvas.vertex(x-w, y+h);
+            // Center vertical
+            canvas.vertex(x-thick/2, y-h); canvas.vertex(x+thick/2, y-h); canvas.vertex(x+thick/2, y+h); canvas.vertex(x-thick/2, y+h);
+            // Bottom horizontal
+            canvas.vertex(x-w, y-h); canvas.vertex(x+w, y-h); canvas.vertex(x+w, y-h+thick); canvas.vertex(x-w, y-h+thick);
+            break;
+            
+        case 'N':
+            // Left vertical
+            canvas.vertex(x-w, y-h); canvas.vertex(x-w+thick, y-h); canvas.vertex(x-w+thick, y+h); canvas.vertex(x-w, y+h);
+            // Right vertical
+            canvas.vertex(x+w-thick, y-h); canvas.vertex(x+w, y-h); canvas.vertex(x+w, y+h); canvas.vertex(x+w-thick, y+h);
+            // Diagonal
+            canvas.vertex(x-w+thick, y+h-thick); canvas.vertex(x, y); canvas.vertex(x+thick/2, y); canvas.vertex(x-w+thick*1.5f, y+h-thick);
+            break;
+            
+        case 'O':
+            // Left vertical
+            canvas.vertex(x-w, y-h+thick); canvas.vertex(x-w+thick, y-h+thick); canvas.vertex(x-w+thick, y+h-thick); canvas.vertex(x-w, y+h-thick);
+            // Right vertical
+            canvas.vertex(x+w-thick, y-h+thick); canvas.vertex(x+w, y-h+thick); canvas.vertex(x+w, y+h-thick); canvas.vertex(x+w-thick, y+h-thick);
+            // Top horizontal
+            canvas.vertex(x-w+thick, y+h-thick); canvas.vertex(x+w-thick, y+h-thick); canvas.vertex(x+w-thick, y+h); canvas.vertex(x-w+thick, y+h);
+            // Bottom horizontal
+            canvas.vertex(x-w+thick, y-h); canvas.vertex(x+w-thick, y-h); canvas.vertex(x+w-thick, y-h+thick); canvas.vertex(x-w+thick, y-h+thick);
+            break;
+            
+        case 'P':
+            // Left vertical
+            canvas.vertex(x-w, y-h); canvas.vertex(x-w+thick, y-h); canvas.vertex(x-w+thick, y+h); canvas.vertex(x-w, y+h);
+            // Top horizontal
+            canvas.vertex(x-w, y+h-thick); canvas.vertex(x+w, y+h-thick); canvas.vertex(x+w, y+h); canvas.vertex(x-w, y+h);
+            // Right vertical (top half)
+            canvas.vertex(x+w-thick, y); canvas.vertex(x+w, y); canvas.vertex(x+w, y+h); canvas.vertex(x+w-thick, y+h);
+            // Middle horizontal
+            canvas.vertex(x-w+thick, y-thick/2); canvas.vertex(x+w, y-thick/2); canvas.vertex(x+w, y+thick/2); canvas.vertex(x-w+thick, y+thick/2);
+            break;
+            
+        case 'R':
+            // Left vertical
+            canvas.vertex(x-w, y-h); canvas.vertex(x-w+thick, y-h); canvas.vertex(x-w+thick, y+h); canvas.vertex(x-w, y+h);
+            // Top horizontal
+            canvas.vertex(x-w, y+h-thick); canvas.vertex(x+w, y+h-thick); canvas.vertex(x+w, y+h); canvas.vertex(x-w, y+h);
+            // Right vertical (top half)
+            canvas.vertex(x+w-thick, y); canvas.vertex(x+w, y); canvas.vertex(x+w, y+h); canvas.vertex(x+w-thick, y+h);
+            // Middle horizontal
+            canvas.vertex(x-w+thick, y-thick/2); canvas.vertex(x+w, y-thick/2); canvas.vertex(x+w, y+thick/2); canvas.vertex(x-w+thick, y+thick/2);
+            // Diagonal
+            canvas.vertex(x, y-thick/2); canvas.vertex(x+thick/2, y-thick/2); canvas.vertex(x+w, y-h); canvas.vertex(x+w-thick/2, y-h);
+            break;
+            
+        case 'S':
+            // Top horizontal
+            canvas.vertex(x-w, y+h-thick); canvas.vertex(x+w, y+h-thick); canvas.vertex(x+w, y+h); canvas.vertex(x-w, y+h);
+            // Left vertical (top half)
+            canvas.vertex(x-w, y); canvas.vertex(x-w+thick, y); canvas.vertex(x-w+thick, y+h); canvas.vertex(x-w, y+h);
+            // Middle horizontal
+            canvas.vertex(x-w, y-thick/2); canvas.vertex(x+w, y-thick/2); canvas.vertex(x+w, y+thick/2); canvas.vertex(x-w, y+thick/2);
+            // Right vertical (bottom half)
+            canvas.vertex(x+w-thick, y-h); canvas.vertex(x+w, y-h); canvas.vertex(x+w, y); canvas.vertex(x+w-thick, y);
+            // Bottom horizontal
+            canvas.vertex(x-w, y-h); canvas.vertex(x+w, y-h); canvas.vertex(x+w, y-h+thick); canvas.vertex(x-w, y-h+thick);
+            break;
+            
+        case 'T':
+            // Top horizontal
+            canvas.vertex(x-w, y+h-thick); canvas.vertex(x+w, y+h-thick); canvas.vertex(x+w, y+h); canvas.vertex(x-w, y+h);
+            // Center vertical
+            canvas.vertex(x-thick/2, y-h); canvas.vertex(x+thick/2, y-h); canvas.vertex(x+thick/2, y+h); canvas.vertex(x-thick/2, y+h);
+            break;
+            
+        case 'U':
+            // Left vertical
+            canvas.vertex(x-w, y-h+thick); canvas.vertex(x-w+thick, y-h+thick); canvas.vertex(x-w+thick, y+h); canvas.vertex(x-w, y+h);
+            // Right vertical
+            canvas.vertex(x+w-thick, y-h+thick); canvas.vertex(x+w, y-h+thick); canvas.vertex(x+w, y+h); canvas.vertex(x+w-thick, y+h);
+            // Bottom horizontal
+            canvas.vertex(x-w+thick, y-h); canvas.vertex(x+w-thick, y-h); canvas.vertex(x+w-thick, y-h+thick); canvas.vertex(x-w+thick, y-h+thick);
+            break;
+            
+        case ' ':
+            // Space - draw nothing
+            break;
+            
+        default:
+            // Unknown character - draw a small box
+            canvas.vertex(x-w/2, y-h/2); canvas.vertex(x+w/2, y-h/2); canvas.vertex(x+w/2, y+h/2); canvas.vertex(x-w/2, y+h/2);
+            break;
+    }
+
+    canvas.end();
+}
+
+void SceneRenderer::drawSpeedSlider(Canvas& canvas, const RenderSnapshot& frame) {
+    // Speed slider background
+    canvas.setColor(0.3f, 0.3f, 0.3f);
+    canvas.begin(Primitive::Quads);
+    canvas.vertex(-0.4f, -0.85f);
+    canvas.vertex(0.4f, -0.85f);
+    canvas.vertex(0.4f, -0.8f);
+    canvas.vertex(-0.4f, -0.8f);
+    canvas.end();
+
+    // Speed slider fill
+    canvas.setColor(0.6f, 0.6f, 1.0f);
+    const float minSpeed = Simulation::MIN_SPEED, maxSpeed = Simulation::MAX_SPEED;
+    float speedBarWidth = ((frame.state.ballSpeedMultiplier - minSpeed) / (maxSpeed - minSpeed)) * 0.8f;
+    canvas.begin(Primitive::Quads);
+    canvas.vertex(-0.4f, -0.85f);
+    canvas.vertex(-0.4f + speedBarWidth, -0.85f);
+    canvas.vertex(-0.4f + speedBarWidth, -0.8f);
+    canvas.vertex(-0.4f, -0.8f);
+    canvas.end();
+
+    // Speed slider handle
+    float handleX = -0.4f + speedBarWidth;
+    canvas.setColor(1.0f, 1.0f, 1.0f);
+    canvas.begin(Primitive::Quads);
+    canvas.vertex(handleX - 0.02f, -0.87f);
+    canvas.vertex(handleX + 0.02f, -0.87f);
+    canvas.vertex(handleX + 0.02f, -0.78f);
+    canvas.vertex(handleX - 0.02f, -0.78);
+    canvas.end();
+
+    // Speed value display as simple bars
+    int speedBars = (int)(frame.state.ballSpeedMultiplier * 5);
+    canvas.setColor(1.0f, 1.0f, 0.0f);
+    for (int i = 0; i < speedBars && i < 15; i++) {
+        float x = -0.3f + i * 0.04f;
+        canvas.begin(Primitive::Quads);
+        canvas.vertex(x, -0.92f);
+        canvas.vertex(x + 0.02f, -0.92f);
+        canvas.vertex(x + 0.02f, -0.88f);
+        canvas.vertex(x, -0.88f);
+        canvas.end();
+    }
+}
+
+FrameDumper::FrameDumper(const std::string& directory, ImageFormat format, int width, int height, float tickSeconds)
+    : m_directory(directory)
+    , m_format(format)
+    , m_canvas(width, height)
+    , m_tickSeconds(tickSeconds)
+    , m_lastTick(0)
+    , m_frames(0)
+    , m_renderMs(0.0) {
+}
+
+bool FrameDumper::write(const Simulation& sim, std::string& error) {
+    if (m_frames == 0 && mkdir(m_directory.c_str(), 0755) != 0 && errno != EEXIST) {
+        error = "cannot create " + m_directory;
+        return false;
+    }
+
+    int64_t startNs = Clock::nowNs();
+    m_frame.capture(sim, 0); // No sensor when replaying: default HUD
+    float seconds = m_tickSeconds > 0.0f ? (sim.tickCount() - m_lastTick) * m_tickSeconds : 1.0f / 60.0f;
+    m_lastTick = sim.tickCount();
+    m_effects.update(sim, 0, seconds);
+    m_frame.captureParticles(m_effects.particles());
+    m_scene.draw(m_canvas, m_frame);
+    m_renderMs += Clock::nsToMs(Clock::nowNs() - startNs);
+
+    char name[32];
+    std::snprintf(name, sizeof(name), "/frame-%06zu.%s", m_frames, m_format == ImageFormat::Png ? "png" : "ppm");
+    if (!writeImage(m_directory + name, m_format, m_canvas.pixels(), m_canvas.width(), m_canvas.height(), error)) {
+        return false;
+    }
+    m_frames++;
+    return true;
+}
+
+int replayToFrames(const InputRecording& recording, const std::string& directory, ImageFormat format,
+                   int width, int height) {
+    FrameDumper dumper(directory, format, width, height, recording.fixedTickSeconds());
+    int result = replayHeadless(recording, [&dumper](const Simulation& state) {
+        std::string error;
+        if (dumper.write(state, error)) return true;
+        std::cerr << "Frame dump failed: " << error << std::endl;
+        return false;
+    });
+    std::cout << "Wrote " << dumper.framesWritten() << " frames to " << directory;
+    if (dumper.framesWritten() > 0) {
+        std::cout << " (" << std::fixed << std::setprecision(3) << dumper.renderMs() / dumper.framesWritten()
+                  << " ms per frame to rasterise)";
+    }
+    std::cout << std::endl;
+    return result;
+}
+
+} // namespace LidPong
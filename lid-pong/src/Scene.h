@@ -0,0 +1,107 @@
+#pragma once
+
+#include "Canvas.h"
+#include "Particles.h"
+#include "Recording.h"
+#include "Simulation.h"
+#include "SoftwareCanvas.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace LidPong {
+
+// What the HUD shows besides the game state
+struct HudInfo {
+    bool sensorAvailable; // Green lid bar when true, red outline otherwise
+    double lidAngle;      // Degrees
+};
+
+// Everything needed to draw one frame, copied out of the simulation so it
+// can be drawn later or on another thread. Capturing into the same snapshot
+// again reuses its storage.
+struct RenderSnapshot {
+    uint64_t sequence;        // Set by whoever hands snapshots over (RenderThread)
+    GameState state;
+    bool versus, multiBall, brickMode;
+    float swarmRadius;
+    std::vector<float> swarmPositions; // Interleaved xy
+    std::vector<float> brickQuads;     // Four xy corners per live brick
+    std::vector<SweptBall> brickBalls;
+    std::vector<float> particlePositions; // Interleaved xy
+    std::vector<uint32_t> particleColors; // Packed RGBA, faded by age
+    HudInfo hud;
+    int64_t inputTimestampNs; // Lid sample behind this state (0 if none), for latency stats
+    int framebufferWidth, framebufferHeight;
+
+    RenderSnapshot();
+
+    // 'generation' must change whenever 'sim' jumps to another state
+    // (rewind, checkpoint), since brick quads are only rebuilt when it or the
+    // brick revision differs
+    void capture(const Simulation& sim, uint64_t generation);
+
+    // Effects live outside the simulation, so they are captured separately
+    // (a snapshot that never captures any draws none)
+    void captureParticles(const ParticlePool& particles);
+
+private:
+    uint64_t m_brickRevision;
+    uint64_t m_brickGeneration;
+};
+
+// Draws a frame of the game onto any Canvas: the GL window, or the software
+// rasteriser for frame dumps, golden images and GPU-less benchmarks
+class SceneRenderer {
+public:
+    void draw(Canvas& canvas, const RenderSnapshot& frame);
+
+    // Seven-segment number centred on (x, y)
+    void drawSimpleNumber(Canvas& canvas, int number, float x, float y, float size);
+
+private:
+    void drawBall(Canvas& canvas, const Ball& ball);
+    void drawSlider(Canvas& canvas, const Slider& slider);
+    void drawSwarm(Canvas& canvas, const RenderSnapshot& frame);
+    void drawBricks(Canvas& canvas, const RenderSnapshot& frame);
+    void drawParticles(Canvas& canvas, const RenderSnapshot& frame);
+    void drawHUD(Canvas& canvas, const RenderSnapshot& frame);
+    void drawGameOverModal(Canvas& canvas, const RenderSnapshot& frame);
+    void drawSimpleDigit(Canvas& canvas, int digit, float x, float y, float size);
+    void drawSimpleText(Canvas& canvas, const char* text, float x, float y, float size);
+    void drawSimpleChar(Canvas& canvas, char c, float x, float y, float size);
+    void drawSpeedSlider(Canvas& canvas, const RenderSnapshot& frame);
+};
+
+// Renders frames in software and writes them to a directory as a numbered
+// image sequence (frame-000000.png, ...), effects included. 'tickSeconds' is
+// the recording's fixed tick, to advance the particles (0: 1/60 s per frame).
+class FrameDumper {
+public:
+    FrameDumper(const std::string& directory, ImageFormat format, int width, int height, float tickSeconds);
+
+    bool write(const Simulation& sim, std::string& error);
+
+    size_t framesWritten() const { return m_frames; }
+    double renderMs() const { return m_renderMs; } // Rasterising only, not file output
+
+private:
+    std::string m_directory;
+    ImageFormat m_format;
+    SoftwareCanvas m_canvas;
+    SceneRenderer m_scene;
+    RenderSnapshot m_frame;
+    ParticleEffects m_effects;
+    float m_tickSeconds;
+    uint64_t m_lastTick;
+    size_t m_frames;
+    double m_renderMs;
+};
+
+// replayHeadless() with every frame written to 'directory' by a FrameDumper
+// ("--replay FILE --headless --dump-frames DIR")
+int replayToFrames(const InputRecording& recording, const std::string& directory, ImageFormat format,
+                   int width, int height);
+
+} // namespace LidPong
@@ -0,0 +1,645 @@
+#include "ScoreStore.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace LidPong {
+
+namespace {
+
+const char LOG_MAGIC[4] = {'L', 'P', 'S', 'R'};
+const char INDEX_MAGIC[4] = {'L', 'P', 'S', 'I'};
+const uint32_t INDEX_VERSION = 1;
+const uint32_t MAX_RECORD_BYTES = 64u << 20; // Anything larger is garbage, not a record
+
+// Log record: header, then the payload the CRC covers
+struct RecordHeader {
+    char magic[4];
+    uint32_t payloadBytes;
+    uint32_t crc;
+    uint32_t reserved;
+};
+
+// Start of every payload; the player name and the replay follow
+struct RecordFields {
+    int64_t timestampMs;
+    int32_t score;
+    int32_t totalHits;
+    uint64_t seed;
+    uint64_t ticks;
+    uint8_t mode;
+    uint8_t playerBytes;
+    uint16_t reserved;
+    uint32_t replayBytes;
+};
+
+struct IndexHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t count;
+    uint64_t logBytes; // The entries cover the log up to here
+    uint64_t reserved;
+};
+
+static_assert(sizeof(RecordHeader) == 16, "log record header layout");
+static_assert(sizeof(RecordFields) == 40, "log record layout");
+static_assert(sizeof(IndexHeader) == 32, "index header layout");
+static_assert(sizeof(ScoreEntry) == 40, "index entry layout");
+
+struct Crc32Table {
+    uint32_t entries[256];
+
+    Crc32Table() {
+        for (uint32_t n = 0; n < 256; n++) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            entries[n] = c;
+        }
+    }
+};
+
+uint32_t crc32(const uint8_t* data, size_t size) {
+    static const Crc32Table table;
+    uint32_t crc = ~0u;
+    for (size_t i = 0; i < size; i++) crc = table.entries[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+// Best first: higher score, then whoever got there first
+bool ranksBefore(const ScoreEntry& a, const ScoreEntry& b) {
+    if (a.score != b.score) return a.score > b.score;
+    if (a.timestampMs != b.timestampMs) return a.timestampMs < b.timestampMs;
+    return a.logOffset < b.logOffset;
+}
+
+bool readFully(int fd, void* data, size_t size, uint64_t offset) {
+    uint8_t* p = static_cast<uint8_t*>(data);
+    while (size > 0) {
+        ssize_t n = pread(fd, p, size, static_cast<off_t>(offset));
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) continue;
+            return false;
+        }
+        p += n;
+        size -= static_cast<size_t>(n);
+        offset += static_cast<uint64_t>(n);
+    }
+    return true;
+}
+
+bool writeFully(int fd, const void* data, size_t size, uint64_t offset) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    while (size > 0) {
+        ssize_t n = pwrite(fd, p, size, static_cast<off_t>(offset));
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) continue;
+            return false;
+        }
+        p += n;
+        size -= static_cast<size_t>(n);
+        offset += static_cast<uint64_t>(n);
+    }
+    return true;
+}
+
+std::string systemError(const std::string& what) {
+    return what + ": " + std::strerror(errno);
+}
+
+// The whole record at 'offset' if its header, CRC and field sizes all check out
+bool readRecord(int fd, uint64_t offset, uint64_t logBytes, RecordHeader& header, std::vector<uint8_t>& payload,
+                RecordFields& fields) {
+    if (offset + sizeof(header) > logBytes || !readFully(fd, &header, sizeof(header), offset) ||
+        std::memcmp(header.magic, LOG_MAGIC, sizeof(LOG_MAGIC)) != 0 ||
+        header.payloadBytes < sizeof(RecordFields) || header.payloadBytes > MAX_RECORD_BYTES ||
+        offset + sizeof(header) + header.payloadBytes > logBytes) {
+        return false;
+    }
+    payload.resize(header.payloadBytes);
+    if (!readFully(fd, payload.data(), payload.size(), offset + sizeof(header)) ||
+        crc32(payload.data(), payload.size()) != header.crc) {
+        return false;
+    }
+    std::memcpy(&fields, payload.data(), sizeof(fields));
+    return sizeof(fields) + fields.playerBytes + static_cast<uint64_t>(fields.replayBytes) == header.payloadBytes;
+}
+
+// Offset of the first valid record after 'from', or 'logBytes' if none follows
+uint64_t findNextRecord(int fd, uint64_t from, uint64_t logBytes, std::vector<uint8_t>& payload) {
+    std::vector<uint8_t> chunk(64 * 1024);
+    RecordHeader header;
+    RecordFields fields;
+    uint64_t position = from + 1;
+    while (position + sizeof(RecordHeader) <= logBytes) {
+        size_t bytes = static_cast<size_t>(std::min<uint64_t>(chunk.size(), logBytes - position));
+        if (!readFully(fd, chunk.data(), bytes, position)) {
+            break;
+        }
+        for (size_t i = 0; i + sizeof(LOG_MAGIC) <= bytes; i++) {
+            if (std::memcmp(&chunk[i], LOG_MAGIC, sizeof(LOG_MAGIC)) == 0 &&
+                readRecord(fd, position + i, logBytes, header, payload, fields)) {
+                return position + i;
+            }
+        }
+        if (bytes < chunk.size()) {
+            break;
+        }
+        position += bytes - (sizeof(LOG_MAGIC) - 1); // A magic may straddle two chunks
+    }
+    return logBytes;
+}
+
+} // namespace
+
+ScoreMode scoreModeOf(const SimulationConfig& config) {
+    if (config.versus) return ScoreMode::Versus;
+    if (config.brickCount > 0) return ScoreMode::Bricks;
+    if (config.multiBallCount > 0) return ScoreMode::Party;
+    return ScoreMode::Classic;
+}
+
+const char* scoreModeName(ScoreMode mode) {
+    switch (mode) {
+    case ScoreMode::Classic: return "classic";
+    case ScoreMode::Party: return "party";
+    case ScoreMode::Bricks: return "bricks";
+    case ScoreMode::Versus: return "versus";
+    case ScoreMode::Any: return "any";
+    }
+    return "unknown";
+}
+
+ScoreStore::ScoreStore(const ScoreStoreOptions& options)
+    : m_options(options)
+    , m_logFd(-1)
+    , m_logBytes(0)
+    , m_recoveredBytes(0)
+    , m_corruptBytes(0)
+    , m_map(nullptr)
+    , m_mapBytes(0)
+    , m_index(nullptr)
+    , m_indexCount(0)
+    , m_indexLogBytes(0)
+    , m_tailSorted(true) {
+}
+
+ScoreStore::~ScoreStore() {
+    close();
+}
+
+uint64_t ScoreStore::playerHash(const std::string& player) {
+    uint64_t hash = 1469598103934665603ULL;
+    for (unsigned char c : player) {
+        hash = (hash ^ c) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+bool ScoreStore::open(const std::string& directory, std::string& error) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_logFd >= 0) {
+        error = "score store already open";
+        return false;
+    }
+    if (mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST) {
+        error = systemError("cannot create " + directory);
+        return false;
+    }
+    m_directory = directory;
+    std::string logPath = directory + "/scores.log";
+    m_logFd = ::open(logPath.c_str(), O_RDWR | O_CREAT, 0644);
+    if (m_logFd < 0) {
+        error = systemError("cannot open " + logPath);
+        return false;
+    }
+    struct stat info;
+    if (fstat(m_logFd, &info) != 0) {
+        error = systemError("cannot stat " + logPath);
+        ::close(m_logFd);
+        m_logFd = -1;
+        return false;
+    }
+    m_logBytes = static_cast<uint64_t>(info.st_size);
+    m_recoveredBytes = 0;
+    m_corruptBytes = 0;
+    m_tail.clear();
+
+    // A missing or stale index only costs a longer scan; the log is the truth
+    std::string indexError;
+    if (!mapIndex(indexError)) {
+        unmapIndex();
+    }
+    if (!scanLog(m_indexLogBytes, error)) {
+        unmapIndex();
+        ::close(m_logFd);
+        m_logFd = -1;
+        return false;
+    }
+    if (m_tail.size() >= m_options.foldTailAt) {
+        std::string foldError;
+        writeIndexLocked(foldError); // Next open is fast again; failing only costs time
+    }
+    return true;
+}
+
+void ScoreStore::close() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_logFd < 0) {
+        return;
+    }
+    if (!m_tail.empty()) {
+        std::string error;
+        writeIndexLocked(error);
+    }
+    unmapIndex();
+    ::close(m_logFd);
+    m_logFd = -1;
+    m_tail.clear();
+}
+
+bool ScoreStore::isOpen() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_logFd >= 0;
+}
+
+bool ScoreStore::mapIndex(std::string& error) {
+    m_index = nullptr;
+    m_indexCount = 0;
+    m_indexLogBytes = 0;
+
+    std::string path = m_directory + "/scores.idx";
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = systemError("cannot open " + path);
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(IndexHeader)) {
+        ::close(fd);
+        error = path + " is truncated";
+        return false;
+    }
+    size_t bytes = static_cast<size_t>(info.st_size);
+    void* map = mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // The mapping keeps the file alive
+    if (map == MAP_FAILED) {
+        error = systemError("cannot map " + path);
+        return false;
+    }
+    m_map = map;
+    m_mapBytes = bytes;
+
+    IndexHeader header;
+    std::memcpy(&header, map, sizeof(header));
+    if (std::memcmp(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0 || header.version != INDEX_VERSION ||
+        bytes != sizeof(IndexHeader) + header.count * sizeof(ScoreEntry) || header.logBytes > m_logBytes) {
+        error = path + " does not match the log";
+        return false;
+    }
+    m_index = reinterpret_cast<const ScoreEntry*>(static_cast<const uint8_t*>(map) + sizeof(IndexHeader));
+    m_indexCount = static_cast<size_t>(header.count);
+    m_indexLogBytes = header.logBytes;
+    return true;
+}
+
+void ScoreStore::unmapIndex() {
+    if (m_map) {
+        munmap(m_map, m_mapBytes);
+    }
+    m_map = nullptr;
+    m_mapBytes = 0;
+    m_index = nullptr;
+    m_indexCount = 0;
+    m_indexLogBytes = 0;
+}
+
+// Reads records from 'from' to the end of the log into the tail. A bad
+// record with nothing valid after it is a torn end (a crash mid-append) and
+// is cut off; damage further in is skipped over to the next valid record, so
+// one bad byte never costs the games saved after it.
+bool ScoreStore::scanLog(uint64_t from, std::string& error) {
+    std::vector<uint8_t> payload;
+    uint64_t offset = from;
+    while (offset < m_logBytes) {
+        RecordHeader header;
+        RecordFields fields;
+        if (!readRecord(m_logFd, offset, m_logBytes, header, payload, fields)) {
+            uint64_t next = findNextRecord(m_logFd, offset, m_logBytes, payload);
+            if (next < m_logBytes) {
+                m_corruptBytes += next - offset;
+                offset = next;
+                continue;
+            }
+            if (ftruncate(m_logFd, static_cast<off_t>(offset)) != 0) {
+                error = systemError("cannot cut the torn end off " + m_directory + "/scores.log");
+                return false;
+            }
+            m_recoveredBytes = m_logBytes - offset;
+            m_logBytes = offset;
+            break;
+        }
+
+        ScoreEntry entry;
+        std::memset(&entry, 0, sizeof(entry));
+        entry.score = fields.score;
+        entry.totalHits = fields.totalHits;
+        entry.timestampMs = fields.timestampMs;
+        entry.logOffset = offset;
+        entry.player = playerHash(std::string(reinterpret_cast<const char*>(payload.data()) + sizeof(fields), fields.playerBytes));
+        entry.mode = static_cast<ScoreMode>(fields.mode);
+        entry.hasReplay = fields.replayBytes > 0 ? 1 : 0;
+        m_tail.push_back(entry);
+        offset += sizeof(header) + header.payloadBytes;
+    }
+    m_tailSorted = false;
+    sortTail();
+    return true;
+}
+
+bool ScoreStore::append(const ScoreRecord& record, const std::vector<uint8_t>& replay, std::string& error) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_logFd < 0) {
+        error = "score store not open";
+        return false;
+    }
+
+    RecordFields fields;
+    std::memset(&fields, 0, sizeof(fields));
+    fields.timestampMs = record.timestampMs;
+    fields.score = record.score;
+    fields.totalHits = record.totalHits;
+    fields.seed = record.seed;
+    fields.ticks = record.ticks;
+    fields.mode = static_cast<uint8_t>(record.mode);
+    fields.playerBytes = static_cast<uint8_t>(std::min<size_t>(record.player.size(), 255));
+    fields.replayBytes = static_cast<uint32_t>(replay.size());
+
+    // One write per record: header, fields, name, replay
+    size_t payloadBytes = sizeof(fields) + fields.playerBytes + replay.size();
+    if (payloadBytes > MAX_RECORD_BYTES) {
+        error = "score record too large";
+        return false;
+    }
+    std::vector<uint8_t> buffer(sizeof(RecordHeader) + payloadBytes);
+    uint8_t* payload = buffer.data() + sizeof(RecordHeader);
+    std::memcpy(payload, &fields, sizeof(fields));
+    std::memcpy(payload + sizeof(fields), record.player.data(), fields.playerBytes);
+    if (!replay.empty()) {
+        std::memcpy(payload + sizeof(fields) + fields.playerBytes, replay.data(), replay.size());
+    }
+    RecordHeader header;
+    std::memcpy(header.magic, LOG_MAGIC, sizeof(LOG_MAGIC));
+    header.payloadBytes = static_cast<uint32_t>(payloadBytes);
+    header.crc = crc32(payload, payloadBytes);
+    header.reserved = 0;
+    std::memcpy(buffer.data(), &header, sizeof(header));
+
+    if (!writeFully(m_logFd, buffer.data(), buffer.size(), m_logBytes) ||
+        (m_options.syncEachAppend && fsync(m_logFd) != 0)) {
+        error = systemError("cannot append to " + m_directory + "/scores.log");
+        if (ftruncate(m_logFd, static_cast<off_t>(m_logBytes)) != 0) {
+            error += "; " + systemError("cannot cut the partial record off") + " (the next open() will)";
+        }
+        return false;
+    }
+
+    ScoreEntry entry;
+    std::memset(&entry, 0, sizeof(entry));
+    entry.score = record.score;
+    entry.totalHits = record.totalHits;
+    entry.timestampMs = record.timestampMs;
+    entry.logOffset = m_logBytes;
+    entry.player = playerHash(record.player.substr(0, fields.playerBytes));
+    entry.mode = record.mode;
+    entry.hasReplay = replay.empty() ? 0 : 1;
+    m_tail.push_back(entry);
+    m_tailSorted = m_tail.size() == 1;
+    m_logBytes += buffer.size();
+
+    if (m_tail.size() >= m_options.foldTailAt) {
+        std::string foldError;
+        writeIndexLocked(foldError); // The tail just stays longer if this fails
+    }
+    return true;
+}
+
+bool ScoreStore::writeIndex(std::string& error) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_logFd < 0) {
+        error = "score store not open";
+        return false;
+    }
+    return writeIndexLocked(error);
+}
+
+// Merges the mapped index and the tail into a new file, then swaps it in with rename()
+bool ScoreStore::writeIndexLocked(std::string& error) {
+    // The log must be on disk before an index that points into it
+    if (!m_options.syncEachAppend && fsync(m_logFd) != 0) {
+        error = systemError("cannot sync " + m_directory + "/scores.log");
+        return false;
+    }
+
+    std::string path = m_directory + "/scores.idx";
+    std::string temporary = path + ".tmp";
+    int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        error = systemError("cannot create " + temporary);
+        return false;
+    }
+
+    IndexHeader header;
+    std::memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    header.version = INDEX_VERSION;
+    sortTail();
+    header.count = m_indexCount + m_tail.size();
+    header.logBytes = m_logBytes;
+    header.reserved = 0;
+
+    const size_t chunkEntries = 8192;
+    std::vector<ScoreEntry> chunk;
+    chunk.reserve(chunkEntries);
+    uint64_t offset = 0;
+    bool ok = writeFully(fd, &header, sizeof(header), offset);
+    offset += sizeof(header);
+
+    size_t i = 0, j = 0;
+    while (ok && (i < m_indexCount || j < m_tail.size())) {
+        bool fromIndex = j == m_tail.size() || (i < m_indexCount && !ranksBefore(m_tail[j], m_index[i]));
+        chunk.push_back(fromIndex ? m_index[i++] : m_tail[j++]);
+        if (chunk.size() == chunkEntries || (i == m_indexCount && j == m_tail.size())) {
+            ok = writeFully(fd, chunk.data(), chunk.size() * sizeof(ScoreEntry), offset);
+            offset += chunk.size() * sizeof(ScoreEntry);
+            chunk.clear();
+        }
+    }
+    ok = ok && fsync(fd) == 0;
+    if (::close(fd) != 0) ok = false;
+    if (!ok || std::rename(temporary.c_str(), path.c_str()) != 0) {
+        error = systemError("cannot write " + path);
+        std::remove(temporary.c_str());
+        return false;
+    }
+
+    unmapIndex();
+    m_tail.clear();
+    if (!mapIndex(error)) {
+        // Should not happen with the file just written; rescan so nothing goes missing
+        unmapIndex();
+        std::string scanError;
+        scanLog(0, scanError);
+        return false;
+    }
+    return true;
+}
+
+size_t ScoreStore::size() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_indexCount + m_tail.size();
+}
+
+size_t ScoreStore::unindexed() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_tail.size();
+}
+
+uint64_t ScoreStore::recoveredBytes() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_recoveredBytes;
+}
+
+uint64_t ScoreStore::corruptBytes() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_corruptBytes;
+}
+
+// Appends only push; the order is restored when something reads the tail
+void ScoreStore::sortTail() const {
+    if (!m_tailSorted) {
+        std::sort(m_tail.begin(), m_tail.end(), ranksBefore);
+        m_tailSorted = true;
+    }
+}
+
+std::vector<ScoreEntry> ScoreStore::top(ScoreMode mode, size_t count) const {
+    return query(mode, true, 0, count);
+}
+
+std::vector<ScoreEntry> ScoreStore::topForPlayer(const std::string& player, ScoreMode mode, size_t count) const {
+    return query(mode, false, playerHash(player.substr(0, 255)), count);
+}
+
+// Walks index and tail together in rank order until 'count' entries match
+std::vector<ScoreEntry> ScoreStore::query(ScoreMode mode, bool anyPlayer, uint64_t player, size_t count) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    sortTail();
+    std::vector<ScoreEntry> result;
+    size_t i = 0, j = 0;
+    while (result.size() < count && (i < m_indexCount || j < m_tail.size())) {
+        bool fromIndex = j == m_tail.size() || (i < m_indexCount && !ranksBefore(m_tail[j], m_index[i]));
+        const ScoreEntry& entry = fromIndex ? m_index[i++] : m_tail[j++];
+        if ((mode == ScoreMode::Any || entry.mode == mode) && (anyPlayer || entry.player == player)) {
+            result.push_back(entry);
+        }
+    }
+    return result;
+}
+
+bool ScoreStore::read(const ScoreEntry& entry, ScoreRecord& record, std::vector<uint8_t>* replay, std::string& error) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    RecordHeader header;
+    RecordFields fields;
+    std::vector<uint8_t> payload;
+    if (m_logFd < 0 || entry.logOffset + sizeof(header) + sizeof(fields) > m_logBytes) {
+        error = "score record out of range";
+        return false;
+    }
+    if (!readRecord(m_logFd, entry.logOffset, m_logBytes, header, payload, fields)) {
+        error = "score record damaged (bad magic, length or checksum)";
+        return false;
+    }
+    const uint8_t* name = payload.data() + sizeof(fields);
+    std::string player(reinterpret_cast<const char*>(name), fields.playerBytes);
+    if (replay) {
+        replay->assign(name + fields.playerBytes, name + fields.playerBytes + fields.replayBytes);
+    }
+    record.timestampMs = fields.timestampMs;
+    record.score = fields.score;
+    record.totalHits = fields.totalHits;
+    record.seed = fields.seed;
+    record.ticks = fields.ticks;
+    record.mode = static_cast<ScoreMode>(fields.mode);
+    record.player = player;
+    return true;
+}
+
+ScoreWriter::ScoreWriter(ScoreStore& store)
+    : m_store(store)
+    , m_stop(false)
+    , m_written(0)
+    , m_failed(0) {
+}
+
+ScoreWriter::~ScoreWriter() {
+    stop();
+}
+
+void ScoreWriter::start() {
+    if (m_thread.joinable()) {
+        return;
+    }
+    m_stop = false;
+    m_thread = std::thread(&ScoreWriter::threadMain, this);
+}
+
+void ScoreWriter::stop() {
+    if (!m_thread.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_one();
+    m_thread.join();
+}
+
+void ScoreWriter::submit(const ScoreRecord& record, std::vector<uint8_t>&& replay) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Pending pending;
+        pending.record = record;
+        pending.replay.swap(replay);
+        m_queue.push_back(std::move(pending));
+    }
+    m_wake.notify_one();
+}
+
+void ScoreWriter::threadMain() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        m_wake.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+        if (m_queue.empty()) {
+            return; // Stopping with everything written
+        }
+        Pending pending = std::move(m_queue.front());
+        m_queue.pop_front();
+
+        // Never hold the queue while on disk, so submit() can't wait on an fsync
+        lock.unlock();
+        std::string error;
+        if (m_store.append(pending.record, pending.replay, error)) {
+            m_written.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            m_failed.fetch_add(1, std::memory_order_relaxed);
+        }
+        lock.lock();
+    }
+}
+
+} // namespace LidPong
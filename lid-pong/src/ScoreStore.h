@@ -0,0 +1,169 @@
+#pragma once
+
+#include "Simulation.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace LidPong {
+
+enum class ScoreMode : uint8_t {
+    Classic,
+    Party,
+    Bricks,
+    Versus,
+    Any = 0xFF // Queries only
+};
+
+ScoreMode scoreModeOf(const SimulationConfig& config);
+const char* scoreModeName(ScoreMode mode);
+
+// One finished game
+struct ScoreRecord {
+    int64_t timestampMs; // Unix time the game ended
+    int32_t score;
+    int32_t totalHits;
+    uint64_t seed;
+    uint64_t ticks;
+    ScoreMode mode;
+    std::string player; // Up to 255 bytes
+};
+
+// Index entry: what a query needs without touching the log. Stored as-is
+// (little-endian, 40 bytes) in the index file.
+struct ScoreEntry {
+    int32_t score;
+    int32_t totalHits;
+    int64_t timestampMs;
+    uint64_t logOffset; // Where the full record (and any replay) starts in the log
+    uint64_t player;    // Hash of the player name
+    ScoreMode mode;
+    uint8_t hasReplay;
+    uint8_t reserved[6];
+};
+
+struct ScoreStoreOptions {
+    bool syncEachAppend;    // fsync the log after every record (a crash loses nothing acknowledged)
+    size_t foldTailAt;      // Rewrite the index once this many records sit outside it
+
+    ScoreStoreOptions() : syncEachAppend(true), foldTailAt(65536) {}
+};
+
+// Local leaderboard and replay store, kept in a directory.
+//
+// scores.log is append-only: each finished game is one checksummed record,
+// optionally with the session's input recording. A torn record at the end
+// (a crash mid-append) is cut off on open; everything before it survives.
+// A damaged record further in is skipped, never cut off with what follows.
+//
+// scores.idx holds every entry up to some log offset, sorted best first, and
+// is memory-mapped, so opening a store of millions of games only reads the
+// log records appended after it. Those stay in a small sorted tail that
+// queries merge with the index. The index is rewritten (to a temporary file,
+// then renamed over the old one) on close() and whenever the tail gets long.
+//
+// All members are safe to call from any thread; appends usually come from a
+// ScoreWriter.
+class ScoreStore {
+public:
+    explicit ScoreStore(const ScoreStoreOptions& options = ScoreStoreOptions());
+    ~ScoreStore();
+
+    ScoreStore(const ScoreStore&) = delete;
+    ScoreStore& operator=(const ScoreStore&) = delete;
+
+    bool open(const std::string& directory, std::string& error);
+    void close();
+    bool isOpen() const;
+
+    // 'replay' may be empty (no recording kept)
+    bool append(const ScoreRecord& record, const std::vector<uint8_t>& replay, std::string& error);
+
+    // Fold the tail into a fresh index file now
+    bool writeIndex(std::string& error);
+
+    size_t size() const;
+    size_t unindexed() const;       // Records only in the tail
+    uint64_t recoveredBytes() const; // Torn log tail cut off by the last open()
+    uint64_t corruptBytes() const;   // Damaged records the last open() skipped mid-log
+
+    // Best first; ScoreMode::Any for every mode
+    std::vector<ScoreEntry> top(ScoreMode mode, size_t count) const;
+    std::vector<ScoreEntry> topForPlayer(const std::string& player, ScoreMode mode, size_t count) const;
+
+    // The full record behind an entry, and its replay if 'replay' is non-null
+    bool read(const ScoreEntry& entry, ScoreRecord& record, std::vector<uint8_t>* replay, std::string& error) const;
+
+    static uint64_t playerHash(const std::string& player);
+
+private:
+    bool mapIndex(std::string& error);
+    void unmapIndex();
+    bool scanLog(uint64_t from, std::string& error);
+    bool writeIndexLocked(std::string& error);
+    void sortTail() const;
+    std::vector<ScoreEntry> query(ScoreMode mode, bool anyPlayer, uint64_t player, size_t count) const;
+
+    ScoreStoreOptions m_options;
+    mutable std::mutex m_mutex;
+    std::string m_directory;
+    int m_logFd;
+    uint64_t m_logBytes;
+    uint64_t m_recoveredBytes;
+    uint64_t m_corruptBytes;
+
+    // Memory-mapped index: m_indexCount sorted entries covering the log up to m_indexLogBytes
+    void* m_map;
+    size_t m_mapBytes;
+    const ScoreEntry* m_index;
+    size_t m_indexCount;
+    uint64_t m_indexLogBytes;
+
+    // Records after m_indexLogBytes, sorted on demand
+    mutable std::vector<ScoreEntry> m_tail;
+    mutable bool m_tailSorted;
+};
+
+// Appends records on its own thread, so the fsync behind each one never
+// stalls a frame. submit() only queues; stop() writes out what is queued.
+class ScoreWriter {
+public:
+    explicit ScoreWriter(ScoreStore& store);
+    ~ScoreWriter();
+
+    ScoreWriter(const ScoreWriter&) = delete;
+    ScoreWriter& operator=(const ScoreWriter&) = delete;
+
+    void start();
+    void stop();
+
+    void submit(const ScoreRecord& record, std::vector<uint8_t>&& replay);
+
+    uint64_t written() const { return m_written.load(std::memory_order_relaxed); }
+    uint64_t failed() const { return m_failed.load(std::memory_order_relaxed); }
+
+private:
+    struct Pending {
+        ScoreRecord record;
+        std::vector<uint8_t> replay;
+    };
+
+    void threadMain();
+
+    ScoreStore& m_store;
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::deque<Pending> m_queue;
+    bool m_stop;
+    std::atomic<uint64_t> m_written;
+    std::atomic<uint64_t> m_failed;
+};
+
+} // namespace LidPong
@@ -12,13 +12,12 @@ namespace {
 
 namespace LidPong {
 
-const double LidSensor::MIN_ANGLE = 0.0;   // Lid closed
-const double LidSensor::MAX_ANGLE = 180.0; // Lid fully open
-
 LidSensor::LidSensor() 
     : m_currentAngle(0.0)
     , m_sliderPosition(0.5) // Start in middle
-    , m_available(false) {
+    , m_available(false)
+    , m_lastStatus(MacBookLidAngle::ReadStatus::Ok)
+    , m_params(nullptr) {
     
     try {
         m_sensor = std::make_unique<MacBookLidAngle::LidAngleSensor>();
@@ -55,19 +54,27 @@ void LidSensor::update() {
         return;
     }
     
-    try {
-        m_currentAngle = m_sensor->readAngle();
-        
-        // Convert angle to slider position (0.0 = bottom, 1.0 = top)
-        // Clamp angle to our range
-        double clampedAngle = clamp(m_currentAngle, MIN_ANGLE, MAX_ANGLE);
-        
-        // Map angle to slider position
-        m_sliderPosition = (clampedAngle - MIN_ANGLE) / (MAX_ANGLE - MIN_ANGLE);
-        
-    } catch (const std::exception& e) {
-        std::cout << "Warning: Failed to read lid angle: " << e.what() << std::endl;
+    // Non-throwing read: a failing sensor costs no exception or message string
+    double angle = 0.0;
+    MacBookLidAngle::ReadStatus status = m_sensor->tryReadAngle(angle);
+    if (status != MacBookLidAngle::ReadStatus::Ok) {
+        if (status != m_lastStatus) {
+            std::cout << "Warning: Failed to read lid angle: " << MacBookLidAngle::readStatusMessage(status) << std::endl;
+        }
+        m_lastStatus = status; // Only report when the failure changes
+        return;
     }
+    m_lastStatus = status;
+    m_currentAngle = angle;
+    
+    // Convert angle to slider position (0.0 = bottom, 1.0 = top)
+    // Clamp angle to our range (lid closed to fully open by default)
+    const GameParams& params = m_params ? m_params->current() : GameParams::defaults();
+    double minAngle = params.minAngle, maxAngle = params.maxAngle;
+    double clampedAngle = clamp(m_currentAngle, minAngle, maxAngle);
+    
+    // Map angle to slider position
+    m_sliderPosition = (clampedAngle - minAngle) / (maxAngle - minAngle);
 }
 
 } // namespace LidPong
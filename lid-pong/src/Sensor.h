@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../mac-angle/angle.h"
+#include "GameParams.h"
 #include <memory>
 
 namespace LidPong {
@@ -14,17 +15,24 @@ public:
     double getCurrentAngle() const;
     double getSliderPosition() const; // Convert angle to slider position (0.0 to 1.0)
     
+    // How the last update() went; after a failed read the getters keep the last good angle
+    MacBookLidAngle::ReadStatus lastStatus() const { return m_lastStatus; }
+    
+    // Reads the hardware. Not thread-safe: once an InputSampler is running,
+    // only its thread may call update() and the getters above.
     void update();
     
+    // Take the angle range from 'params' (read lock-free on every update)
+    // instead of the defaults. Call before the sampler starts.
+    void setParams(const ParamStore* params) { m_params = params; }
+    
 private:
     std::unique_ptr<MacBookLidAngle::LidAngleSensor> m_sensor;
     double m_currentAngle;
     double m_sliderPosition;
     bool m_available;
-    
-    // Angle to slider position mapping
-    static const double MIN_ANGLE; // Minimum angle for slider at bottom
-    static const double MAX_ANGLE; // Maximum angle for slider at top
+    MacBookLidAngle::ReadStatus m_lastStatus;
+    const ParamStore* m_params; // Angle to slider position mapping; null: GameParams::defaults()
 };
 
 } // namespace LidPong
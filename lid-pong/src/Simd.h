@@ -0,0 +1,108 @@
+#pragma once
+
+// Minimal 4-wide float SIMD wrapper: SSE2 on x86-64, NEON on Apple Silicon,
+// plain scalar lanes anywhere else. Comparisons return lane masks that are
+// consumed by select() and the logical ops.
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define LIDPONG_SIMD_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define LIDPONG_SIMD_NEON 1
+#endif
+
+namespace LidPong {
+namespace simd {
+
+#if defined(LIDPONG_SIMD_SSE2)
+
+struct f32x4 { __m128 v; };
+struct mask4 { __m128 v; };
+
+inline const char* name() { return "SSE2"; }
+inline f32x4 load(const float* p) { return {_mm_loadu_ps(p)}; }
+inline void store(float* p, f32x4 a) { _mm_storeu_ps(p, a.v); }
+inline f32x4 splat(float s) { return {_mm_set1_ps(s)}; }
+inline f32x4 operator+(f32x4 a, f32x4 b) { return {_mm_add_ps(a.v, b.v)}; }
+inline f32x4 operator-(f32x4 a, f32x4 b) { return {_mm_sub_ps(a.v, b.v)}; }
+inline f32x4 operator*(f32x4 a, f32x4 b) { return {_mm_mul_ps(a.v, b.v)}; }
+inline f32x4 operator/(f32x4 a, f32x4 b) { return {_mm_div_ps(a.v, b.v)}; }
+inline f32x4 operator-(f32x4 a) { return {_mm_xor_ps(a.v, _mm_set1_ps(-0.0f))}; }
+inline f32x4 min(f32x4 a, f32x4 b) { return {_mm_min_ps(a.v, b.v)}; }
+inline f32x4 max(f32x4 a, f32x4 b) { return {_mm_max_ps(a.v, b.v)}; }
+inline f32x4 abs(f32x4 a) { return {_mm_andnot_ps(_mm_set1_ps(-0.0f), a.v)}; }
+inline mask4 operator<(f32x4 a, f32x4 b) { return {_mm_cmplt_ps(a.v, b.v)}; }
+inline mask4 operator>(f32x4 a, f32x4 b) { return {_mm_cmpgt_ps(a.v, b.v)}; }
+inline mask4 operator<=(f32x4 a, f32x4 b) { return {_mm_cmple_ps(a.v, b.v)}; }
+inline mask4 operator>=(f32x4 a, f32x4 b) { return {_mm_cmpge_ps(a.v, b.v)}; }
+inline mask4 operator&(mask4 a, mask4 b) { return {_mm_and_ps(a.v, b.v)}; }
+inline mask4 operator|(mask4 a, mask4 b) { return {_mm_or_ps(a.v, b.v)}; }
+inline f32x4 select(mask4 m, f32x4 a, f32x4 b) { return {_mm_or_ps(_mm_and_ps(m.v, a.v), _mm_andnot_ps(m.v, b.v))}; }
+inline bool any(mask4 m) { return _mm_movemask_ps(m.v) != 0; }
+inline int count(mask4 m) { return __builtin_popcount(_mm_movemask_ps(m.v)); }
+
+#elif defined(LIDPONG_SIMD_NEON)
+
+struct f32x4 { float32x4_t v; };
+struct mask4 { uint32x4_t v; };
+
+inline const char* name() { return "NEON"; }
+inline f32x4 load(const float* p) { return {vld1q_f32(p)}; }
+inline void store(float* p, f32x4 a) { vst1q_f32(p, a.v); }
+inline f32x4 splat(float s) { return {vdupq_n_f32(s)}; }
+inline f32x4 operator+(f32x4 a, f32x4 b) { return {vaddq_f32(a.v, b.v)}; }
+inline f32x4 operator-(f32x4 a, f32x4 b) { return {vsubq_f32(a.v, b.v)}; }
+inline f32x4 operator*(f32x4 a, f32x4 b) { return {vmulq_f32(a.v, b.v)}; }
+inline f32x4 operator/(f32x4 a, f32x4 b) { return {vdivq_f32(a.v, b.v)}; }
+inline f32x4 operator-(f32x4 a) { return {vnegq_f32(a.v)}; }
+inline f32x4 min(f32x4 a, f32x4 b) { return {vminq_f32(a.v, b.v)}; }
+inline f32x4 max(f32x4 a, f32x4 b) { return {vmaxq_f32(a.v, b.v)}; }
+inline f32x4 abs(f32x4 a) { return {vabsq_f32(a.v)}; }
+inline mask4 operator<(f32x4 a, f32x4 b) { return {vcltq_f32(a.v, b.v)}; }
+inline mask4 operator>(f32x4 a, f32x4 b) { return {vcgtq_f32(a.v, b.v)}; }
+inline mask4 operator<=(f32x4 a, f32x4 b) { return {vcleq_f32(a.v, b.v)}; }
+inline mask4 operator>=(f32x4 a, f32x4 b) { return {vcgeq_f32(a.v, b.v)}; }
+inline mask4 operator&(mask4 a, mask4 b) { return {vandq_u32(a.v, b.v)}; }
+inline mask4 operator|(mask4 a, mask4 b) { return {vorrq_u32(a.v, b.v)}; }
+inline f32x4 select(mask4 m, f32x4 a, f32x4 b) { return {vbslq_f32(m.v, a.v, b.v)}; }
+inline bool any(mask4 m) { return vmaxvq_u32(m.v) != 0; }
+inline int count(mask4 m) { return static_cast<int>(vaddvq_u32(vshrq_n_u32(m.v, 31))); }
+
+#else
+
+struct f32x4 { float v[4]; };
+struct mask4 { bool v[4]; };
+
+inline const char* name() { return "scalar lanes"; }
+inline f32x4 load(const float* p) { return {{p[0], p[1], p[2], p[3]}}; }
+inline void store(float* p, f32x4 a) { for (int i = 0; i < 4; i++) p[i] = a.v[i]; }
+inline f32x4 splat(float s) { return {{s, s, s, s}}; }
+#define LIDPONG_SIMD_LANEWISE(op) \
+    f32x4 r; for (int i = 0; i < 4; i++) r.v[i] = op; return r
+#define LIDPONG_SIMD_MASKWISE(op) \
+    mask4 r; for (int i = 0; i < 4; i++) r.v[i] = op; return r
+inline f32x4 operator+(f32x4 a, f32x4 b) { LIDPONG_SIMD_LANEWISE(a.v[i] + b.v[i]); }
+inline f32x4 operator-(f32x4 a, f32x4 b) { LIDPONG_SIMD_LANEWISE(a.v[i] - b.v[i]); }
+inline f32x4 operator*(f32x4 a, f32x4 b) { LIDPONG_SIMD_LANEWISE(a.v[i] * b.v[i]); }
+inline f32x4 operator/(f32x4 a, f32x4 b) { LIDPONG_SIMD_LANEWISE(a.v[i] / b.v[i]); }
+inline f32x4 operator-(f32x4 a) { LIDPONG_SIMD_LANEWISE(-a.v[i]); }
+inline f32x4 min(f32x4 a, f32x4 b) { LIDPONG_SIMD_LANEWISE(b.v[i] < a.v[i] ? b.v[i] : a.v[i]); }
+inline f32x4 max(f32x4 a, f32x4 b) { LIDPONG_SIMD_LANEWISE(a.v[i] < b.v[i] ? b.v[i] : a.v[i]); }
+inline f32x4 abs(f32x4 a) { LIDPONG_SIMD_LANEWISE(a.v[i] < 0.0f ? -a.v[i] : a.v[i]); }
+inline mask4 operator<(f32x4 a, f32x4 b) { LIDPONG_SIMD_MASKWISE(a.v[i] < b.v[i]); }
+inline mask4 operator>(f32x4 a, f32x4 b) { LIDPONG_SIMD_MASKWISE(a.v[i] > b.v[i]); }
+inline mask4 operator<=(f32x4 a, f32x4 b) { LIDPONG_SIMD_MASKWISE(a.v[i] <= b.v[i]); }
+inline mask4 operator>=(f32x4 a, f32x4 b) { LIDPONG_SIMD_MASKWISE(a.v[i] >= b.v[i]); }
+inline mask4 operator&(mask4 a, mask4 b) { LIDPONG_SIMD_MASKWISE(a.v[i] && b.v[i]); }
+inline mask4 operator|(mask4 a, mask4 b) { LIDPONG_SIMD_MASKWISE(a.v[i] || b.v[i]); }
+inline f32x4 select(mask4 m, f32x4 a, f32x4 b) { LIDPONG_SIMD_LANEWISE(m.v[i] ? a.v[i] : b.v[i]); }
+inline bool any(mask4 m) { return m.v[0] || m.v[1] || m.v[2] || m.v[3]; }
+inline int count(mask4 m) { return m.v[0] + m.v[1] + m.v[2] + m.v[3]; }
+#undef LIDPONG_SIMD_LANEWISE
+#undef LIDPONG_SIMD_MASKWISE
+
+#endif
+
+} // namespace simd
+} // namespace LidPong
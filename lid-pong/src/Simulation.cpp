@@ -0,0 +1,341 @@
+#include "Simulation.h"
+#include <algorithm>
+#include <cmath>
+
+namespace LidPong {
+
+const float Simulation::MIN_SPEED = 0.2f;
+const float Simulation::MAX_SPEED = 3.0f;
+
+void Ball::reset(Random& random, const GameParams& params) {
+    x = 0.0f;
+    y = 0.0f;
+    vx = params.ballSpeedX * (random.coin() ? 1.0f : -1.0f);
+    vy = params.ballSpeedY * (random.coin() ? 1.0f : -1.0f);
+    active = true;
+}
+
+void Slider::update(float deltaTime, double lidPosition, const GameParams& params) {
+    // VERY HIGH SENSITIVITY: small lid movements = big slider movements
+    float normalizedPos = lidPosition - 0.5f; // Center around 0
+    float superSensitive = normalizedPos * params.sliderSensitivity; // 4x sensitivity by default!
+    targetY = superSensitive * params.sliderReach; // Map to screen coordinates
+
+    // Clamp to screen bounds
+    if (targetY > params.sliderReach) targetY = params.sliderReach;
+    if (targetY < -params.sliderReach) targetY = -params.sliderReach;
+
+    // Very fast movement towards target
+    float diff = targetY - y;
+    y += diff * params.sliderSpeed * deltaTime;
+}
+
+uint16_t TickInput::lidToFixed(double position) {
+    if (!(position > 0.0)) return 0;
+    if (position >= 1.0) return 65535;
+    return static_cast<uint16_t>(std::lround(position * 65535.0));
+}
+
+float TickInput::lidFromFixed(uint16_t fixed) {
+    return fixed / 65535.0f;
+}
+
+Simulation::Simulation(const SimulationConfig& config)
+    : m_config(config)
+    , m_brickRows(0)
+    , m_brickColumns(0) {
+    m_state.random.reseed(config.seed);
+    if (config.versus) {
+        // Versus is the classic single ball; no party or brick extras
+    } else if (config.brickCount > 0) {
+        // Bricks about twice as wide as tall in the right part of the field
+        m_brickColumns = std::max(1, static_cast<int>(std::lround(std::sqrt(config.brickCount / 3.6))));
+        m_brickRows = static_cast<int>((config.brickCount + m_brickColumns - 1) / m_brickColumns);
+        buildBricks();
+        m_brickBalls.resize(config.multiBallCount > 0 ? config.multiBallCount : 1);
+        for (SweptBall& b : m_brickBalls) {
+            respawnBrickBall(b);
+        }
+    } else if (config.multiBallCount > 0) {
+        m_swarm.reset(config.multiBallCount, m_state.random.next());
+    }
+}
+
+void Simulation::step(const TickInput& input) {
+    applyButtons(input);
+
+    if (isVersus()) {
+        stepVersus(input.deltaTime, input.lidPosition, input.rightLidPosition);
+    } else if (isBrickMode()) {
+        stepBricks(input.deltaTime, input.lidPosition);
+    } else if (isMultiBall()) {
+        stepMultiBall(input.deltaTime, input.lidPosition);
+    } else {
+        stepClassic(input.deltaTime, input.lidPosition);
+    }
+    m_state.tick++;
+}
+
+void Simulation::applyButtons(const TickInput& input) {
+    if (input.buttons & BUTTON_SERVE) {
+        if (m_state.gameOver) {
+            restart();
+        } else if (!m_state.ball.active) {
+            // Reset ball if it's inactive
+            m_state.ball.reset(m_state.random, m_params);
+        }
+    }
+
+    if (input.buttons & BUTTON_SPEED_SET) {
+        m_state.ballSpeedMultiplier = input.speedSetting;
+    }
+    if (input.buttons & BUTTON_SPEED_UP) {
+        m_state.ballSpeedMultiplier += 0.2f;
+    }
+    if (input.buttons & BUTTON_SPEED_DOWN) {
+        m_state.ballSpeedMultiplier -= 0.2f;
+    }
+    if (m_state.ballSpeedMultiplier < MIN_SPEED) m_state.ballSpeedMultiplier = MIN_SPEED;
+    if (m_state.ballSpeedMultiplier > MAX_SPEED) m_state.ballSpeedMultiplier = MAX_SPEED;
+}
+
+void Simulation::restart() {
+    m_state.score = 0;
+    m_state.rightScore = 0;
+    m_state.lives = 3;
+    m_state.totalHits = 0;
+    m_state.gameOver = false;
+    m_state.showGameOverModal = false;
+    m_state.ball.reset(m_state.random, m_params);
+    if (isBrickMode()) {
+        buildBricks();
+    }
+}
+
+void Simulation::stepClassic(float deltaTime, double lidPosition) {
+    if (m_state.gameOver) {
+        return;
+    }
+
+    float previousSliderY = m_state.slider.y;
+    m_state.slider.update(deltaTime, lidPosition, m_params);
+
+    // Swept ball vs walls and the moving slider: no tunnelling at any speed or step size
+    if (m_state.ball.active) {
+        SweptBall swept = {m_state.ball.x, m_state.ball.y, m_state.ball.vx, m_state.ball.vy, m_state.ball.radius};
+        SweptPaddle paddle = {m_state.slider.x, previousSliderY, m_state.slider.y, m_state.slider.width / 2, m_state.slider.height / 2};
+        SweepResult sweep = sweepBall(swept, deltaTime * m_state.ballSpeedMultiplier, paddle, Playfield::standard());
+        m_state.ball.x = swept.x;
+        m_state.ball.y = swept.y;
+        m_state.ball.vx = swept.vx;
+        m_state.ball.vy = swept.vy;
+
+        // Ball missed - goes off left side; don't auto-reset, handled below
+        if (sweep.missed) {
+            m_state.ball.active = false;
+        }
+
+        m_state.totalHits += sweep.paddleHits;
+        m_state.score = m_state.totalHits; // Score is number of hits
+    }
+
+    // Check if ball was missed
+    if (!m_state.ball.active && m_state.lives > 0) {
+        m_state.lives--;
+        if (m_state.lives <= 0) {
+            m_state.gameOver = true;
+            m_state.showGameOverModal = true;
+        } else {
+            // Auto-reset ball after a short delay
+            m_state.ball.reset(m_state.random, m_params);
+        }
+    }
+}
+
+// Versus: a miss is a point for the other side, first to VERSUS_WINNING_SCORE wins
+void Simulation::stepVersus(float deltaTime, double leftLid, double rightLid) {
+    if (m_state.gameOver) {
+        return;
+    }
+
+    Slider& left = m_state.slider;
+    Slider& right = m_state.rightSlider;
+    float previousLeftY = left.y, previousRightY = right.y;
+    left.update(deltaTime, leftLid, m_params);
+    right.update(deltaTime, rightLid, m_params);
+
+    Ball& ball = m_state.ball;
+    SweptBall swept = {ball.x, ball.y, ball.vx, ball.vy, ball.radius};
+    SweptPaddle leftPaddle = {left.x, previousLeftY, left.y, left.width / 2, left.height / 2};
+    SweptPaddle rightPaddle = {right.x, previousRightY, right.y, right.width / 2, right.height / 2};
+    SweepResult sweep = sweepBallVersus(swept, deltaTime * m_state.ballSpeedMultiplier,
+                                        leftPaddle, rightPaddle, Playfield::standard());
+    ball.x = swept.x;
+    ball.y = swept.y;
+    ball.vx = swept.vx;
+    ball.vy = swept.vy;
+    m_state.totalHits += sweep.paddleHits + sweep.rightPaddleHits;
+
+    if (sweep.missed || sweep.missedRight) {
+        if (sweep.missed) {
+            m_state.rightScore++;
+        } else {
+            m_state.score++;
+        }
+        ball.reset(m_state.random, m_params);
+        if (m_state.score >= VERSUS_WINNING_SCORE || m_state.rightScore >= VERSUS_WINNING_SCORE) {
+            m_state.gameOver = true;
+            m_state.showGameOverModal = true;
+        }
+    }
+}
+
+// Party mode: every hit scores, misses respawn the ball and cost no lives
+void Simulation::stepMultiBall(float deltaTime, double lidPosition) {
+    m_state.slider.update(deltaTime, lidPosition, m_params);
+
+    PaddleBox paddle = {m_state.slider.x, m_state.slider.y, m_state.slider.width / 2, m_state.slider.height / 2};
+    SwarmStepResult result = m_swarm.stepSimd(deltaTime, m_state.ballSpeedMultiplier, paddle);
+    m_state.totalHits += result.hits;
+    m_state.score = m_state.totalHits;
+    m_state.swarmMisses += result.misses;
+}
+
+// Brick mode: bricks score, each lost ball costs a life and respawns
+void Simulation::stepBricks(float deltaTime, double lidPosition) {
+    if (m_state.gameOver) {
+        return;
+    }
+
+    float previousSliderY = m_state.slider.y;
+    m_state.slider.update(deltaTime, lidPosition, m_params);
+
+    SweptPaddle paddle = {m_state.slider.x, previousSliderY, m_state.slider.y, m_state.slider.width / 2, m_state.slider.height / 2};
+    const Playfield field = Playfield::standard();
+    for (SweptBall& b : m_brickBalls) {
+        BrickStepResult result = m_bricks.stepBall(b, deltaTime * m_state.ballSpeedMultiplier, paddle, field);
+        m_state.totalHits += result.paddleHits;
+        m_state.score += result.bricksBroken;
+        if (result.missed && m_state.lives > 0) {
+            m_state.lives--;
+            respawnBrickBall(b);
+        }
+    }
+    if (m_state.lives <= 0) {
+        m_state.gameOver = true;
+        m_state.showGameOverModal = true;
+    }
+
+    // Cleared the wall: next one
+    if (m_bricks.aliveCount() == 0) {
+        buildBricks();
+    }
+}
+
+void Simulation::buildBricks() {
+    m_bricks.build(m_brickRows, m_brickColumns, -0.1f, -0.9f, 0.9f, 0.9f);
+}
+
+void Simulation::respawnBrickBall(SweptBall& b) {
+    b.x = -0.5f;
+    b.y = 0.0f;
+    b.vx = m_params.ballSpeedX;
+    b.vy = m_params.ballSpeedY * (m_state.random.coin() ? 1.0f : -1.0f);
+    b.radius = 0.015f;
+}
+
+bool Simulation::restore(const GameState& state) {
+    if (state.version != GameState::VERSION || isMultiBall() || isBrickMode()) {
+        return false;
+    }
+    m_state = state;
+    return true;
+}
+
+void Simulation::save(Snapshot& out) const {
+    out.state = m_state;
+    if (isMultiBall()) {
+        out.swarm = m_swarm;
+    }
+    if (isBrickMode()) {
+        out.bricks = m_bricks;
+        out.brickBalls = m_brickBalls;
+    }
+}
+
+bool Simulation::restore(const Snapshot& in) {
+    if (in.state.version != GameState::VERSION ||
+        in.swarm.size() != m_swarm.size() ||
+        in.bricks.brickCount() != m_bricks.brickCount() ||
+        in.brickBalls.size() != m_brickBalls.size()) {
+        return false;
+    }
+    m_state = in.state;
+    if (isMultiBall()) {
+        m_swarm = in.swarm;
+    }
+    if (isBrickMode()) {
+        m_bricks = in.bricks;
+        m_brickBalls = in.brickBalls;
+    }
+    return true;
+}
+
+namespace {
+
+struct Fnv1a {
+    uint64_t hash;
+
+    Fnv1a() : hash(1469598103934665603ULL) {}
+
+    void bytes(const void* data, size_t size) {
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; i++) {
+            hash = (hash ^ p[i]) * 1099511628211ULL;
+        }
+    }
+
+    template<class T>
+    void value(T v) {
+        bytes(&v, sizeof(v));
+    }
+};
+
+} // namespace
+
+uint64_t Simulation::checksum(const GameState& state) {
+    Fnv1a h;
+    h.value(state.tick);
+    h.value(state.random.state());
+    h.value(state.ball.x); h.value(state.ball.y); h.value(state.ball.vx); h.value(state.ball.vy);
+    h.value(state.ball.active);
+    h.value(state.slider.y);
+    h.value(state.rightSlider.y);
+    h.value(state.score); h.value(state.rightScore); h.value(state.lives); h.value(state.totalHits);
+    h.value(state.ballSpeedMultiplier);
+    h.value(state.gameOver);
+    return h.hash;
+}
+
+uint64_t Simulation::checksum() const {
+    Fnv1a h;
+    h.value(checksum(m_state));
+
+    if (isMultiBall()) {
+        std::vector<float> positions(2 * m_swarm.size());
+        m_swarm.writePositions(positions.data());
+        h.bytes(positions.data(), positions.size() * sizeof(float));
+        h.value(m_state.swarmMisses);
+    }
+    if (isBrickMode()) {
+        for (const SweptBall& b : m_brickBalls) {
+            h.value(b.x); h.value(b.y); h.value(b.vx); h.value(b.vy);
+        }
+        for (const Brick& brick : m_bricks.bricks()) {
+            h.value(brick.alive);
+        }
+    }
+    return h.hash;
+}
+
+} // namespace LidPong
@@ -0,0 +1,187 @@
+#pragma once
+
+#include "BallSwarm.h"
+#include "BrickField.h"
+#include "Collision.h"
+#include "GameParams.h"
+#include "Random.h"
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+namespace LidPong {
+
+struct Ball {
+    float x, y;
+    float vx, vy;
+    float radius;
+    bool active;
+
+    Ball() : x(0.0f), y(0.0f), vx(0.8f), vy(0.6f), radius(0.02f), active(true) {}
+
+    void reset(Random& random, const GameParams& params);
+};
+
+struct Slider {
+    float x, y;
+    float width, height;
+    float targetY;
+
+    // VERY SENSITIVE and LONGER slider
+    Slider() : x(-0.95f), y(0.0f), width(0.02f), height(0.6f), targetY(0.0f) {}
+
+    void update(float deltaTime, double lidPosition, const GameParams& params);
+};
+
+// Buttons for one tick. Edge-triggered: set only on the tick the key went down.
+enum TickButton : uint8_t {
+    BUTTON_SERVE = 1 << 0,      // SPACE: reset ball / restart after game over
+    BUTTON_SPEED_UP = 1 << 1,   // + key
+    BUTTON_SPEED_DOWN = 1 << 2, // - key
+    BUTTON_SPEED_SET = 1 << 3,  // Speed slider dragged; speedSetting holds the value
+    BUTTON_MASK = 0x0F
+};
+
+// Everything the simulation consumes in one tick. Live play and replays both
+// go through this, which is what makes a recorded session reproducible.
+struct TickInput {
+    float deltaTime;
+    float lidPosition;      // 0..1, always quantised with quantiseLid()
+    float rightLidPosition; // Versus only: the right-hand player's lid
+    float speedSetting;     // Only meaningful with BUTTON_SPEED_SET
+    uint8_t buttons;
+
+    TickInput() : deltaTime(0.0f), lidPosition(0.5f), rightLidPosition(0.5f), speedSetting(0.0f), buttons(0) {}
+
+    // 16-bit lid resolution, so a recording stores exactly what the game used
+    static uint16_t lidToFixed(double position);
+    static float lidFromFixed(uint16_t fixed);
+    static float quantiseLid(double position) { return lidFromFixed(lidToFixed(position)); }
+};
+
+// Everything a classic game is made of, in one flat struct: copying it is a
+// memcpy, so saving and restoring it is essentially free. Bump VERSION when
+// the layout changes.
+struct GameState {
+    static const uint32_t VERSION = 3; // 3: slider speed moved to GameParams
+
+    uint32_t version;
+    uint64_t tick;
+    Random random;
+    Ball ball;
+    Slider slider;
+    Slider rightSlider; // Versus only
+    long swarmMisses;
+    int score;          // Versus: the left player's points
+    int rightScore;     // Versus: the right player's points
+    int lives;
+    int totalHits;
+    float ballSpeedMultiplier;
+    bool gameOver;
+    bool showGameOverModal;
+
+    GameState()
+        : version(VERSION), tick(0), swarmMisses(0), score(0), rightScore(0), lives(3), totalHits(0)
+        , ballSpeedMultiplier(0.6f), gameOver(false), showGameOverModal(false) {
+        rightSlider.x = -slider.x;
+    }
+};
+
+static_assert(std::is_trivially_copyable<GameState>::value, "GameState must stay memcpy-able");
+
+struct SimulationConfig {
+    uint64_t seed;
+    size_t multiBallCount; // > 0: multi-ball party mode (or ball count in brick mode)
+    size_t brickCount;     // > 0: brick-breaking mode
+    bool versus;           // Two players: a right paddle replaces the right wall
+
+    SimulationConfig() : seed(1), multiBallCount(0), brickCount(0), versus(false) {}
+};
+
+// The game rules with no window, input devices or clock attached. Given the
+// same config and the same TickInput sequence it always ends in the same state.
+class Simulation {
+public:
+    static const int VERSUS_WINNING_SCORE = 11;
+
+    // Full snapshot: the GameState plus the per-ball and per-brick arrays of
+    // the party and brick modes. Saving into the same Snapshot again reuses
+    // its storage, so after the first save nothing allocates.
+    struct Snapshot {
+        GameState state;
+        BallSwarm swarm;
+        BrickField bricks;
+        std::vector<SweptBall> brickBalls;
+    };
+
+    static const float MIN_SPEED;
+    static const float MAX_SPEED;
+
+    explicit Simulation(const SimulationConfig& config = SimulationConfig());
+
+    void step(const TickInput& input);
+
+    // FNV-1a over the whole game state, for checking replays reproduce a run
+    uint64_t checksum() const;
+    static uint64_t checksum(const GameState& state);
+
+    // Snapshot and restore. restore() refuses snapshots from another version
+    // or another mode (ball / brick counts) and leaves the game untouched.
+    const GameState& state() const { return m_state; }
+    bool restore(const GameState& state);
+    void save(Snapshot& out) const;
+    bool restore(const Snapshot& in);
+
+    const SimulationConfig& config() const { return m_config; }
+
+    // Tunables read by the coming ticks; not part of the state, so a tuned
+    // game is only reproducible with the same params
+    void setParams(const GameParams& params) { m_params = params; }
+    const GameParams& params() const { return m_params; }
+    uint64_t tickCount() const { return m_state.tick; }
+
+    bool isMultiBall() const { return m_swarm.size() > 0; }
+    bool isBrickMode() const { return m_bricks.brickCount() > 0; }
+    bool isVersus() const { return m_config.versus; }
+
+    const Ball& ball() const { return m_state.ball; }
+    const Slider& slider() const { return m_state.slider; }
+    const Slider& rightSlider() const { return m_state.rightSlider; }
+    const BallSwarm& swarm() const { return m_swarm; }
+    long swarmMisses() const { return m_state.swarmMisses; }
+    const BrickField& brickField() const { return m_bricks; }
+    const std::vector<SweptBall>& brickBalls() const { return m_brickBalls; }
+
+    int score() const { return m_state.score; }
+    int rightScore() const { return m_state.rightScore; }
+    int lives() const { return m_state.lives; }
+    int totalHits() const { return m_state.totalHits; }
+    float ballSpeedMultiplier() const { return m_state.ballSpeedMultiplier; }
+    bool isGameOver() const { return m_state.gameOver; }
+    bool showGameOverModal() const { return m_state.showGameOverModal; }
+
+private:
+    void applyButtons(const TickInput& input);
+    void restart();
+    void stepClassic(float deltaTime, double lidPosition);
+    void stepVersus(float deltaTime, double leftLid, double rightLid);
+    void stepMultiBall(float deltaTime, double lidPosition);
+    void stepBricks(float deltaTime, double lidPosition);
+    void buildBricks();
+    void respawnBrickBall(SweptBall& ball);
+
+    SimulationConfig m_config;
+    GameParams m_params;
+    GameState m_state;
+
+    // Multi-ball party mode: SoA swarm replaces the single ball
+    BallSwarm m_swarm;
+
+    // Brick mode: brick wall with a grid broadphase, one or more swept balls
+    BrickField m_bricks;
+    std::vector<SweptBall> m_brickBalls;
+    int m_brickRows, m_brickColumns;
+};
+
+} // namespace LidPong
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "Simulation.h"
+#include <cstddef>
+#include <vector>
+
+namespace LidPong {
+
+// The most recent simulation snapshots, oldest overwritten first. Slots are
+// allocated once and reused, so recording a snapshot every tick is cheap.
+class SnapshotRing {
+public:
+    explicit SnapshotRing(size_t capacity) : m_slots(capacity > 0 ? capacity : 1), m_newest(0), m_count(0) {}
+
+    size_t capacity() const { return m_slots.size(); }
+    size_t size() const { return m_count; }
+    bool empty() const { return m_count == 0; }
+
+    void push(const Simulation& sim) {
+        m_newest = (m_newest + 1) % m_slots.size();
+        sim.save(m_slots[m_newest]);
+        if (m_count < m_slots.size()) m_count++;
+    }
+
+    // 0 = newest, size() - 1 = oldest
+    const Simulation::Snapshot& recent(size_t age) const {
+        return m_slots[(m_newest + m_slots.size() - age) % m_slots.size()];
+    }
+
+    // Drop the newest snapshot (stepping back through history)
+    void popNewest() {
+        if (m_count == 0) return;
+        m_newest = (m_newest + m_slots.size() - 1) % m_slots.size();
+        m_count--;
+    }
+
+    void clear() { m_count = 0; }
+
+private:
+    std::vector<Simulation::Snapshot> m_slots;
+    size_t m_newest;
+    size_t m_count;
+};
+
+} // namespace LidPong
@@ -0,0 +1,467 @@
+#include "SoftwareCanvas.h"
+#include "Simd.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+namespace LidPong {
+
+namespace {
+
+uint32_t packRgba(uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
+    const uint8_t bytes[4] = {r, g, b, a};
+    uint32_t packed;
+    std::memcpy(&packed, bytes, sizeof(packed));
+    return packed;
+}
+
+uint8_t toByte(float c) {
+    return static_cast<uint8_t>(std::lround(std::min(1.0f, std::max(0.0f, c)) * 255.0f));
+}
+
+// Pixel coordinate to an int without overflowing on far off-canvas geometry
+int clampedCeil(float v, int limit) {
+    return static_cast<int>(std::ceil(std::min(static_cast<float>(limit), std::max(-1.0f, v))));
+}
+
+// (src * a + dst * (255 - a)) / 255, rounded; exact for every input, so the
+// scalar and SIMD paths agree bit for bit
+inline uint8_t blendChannel(uint8_t src, uint8_t dst, uint8_t alpha) {
+    unsigned t = src * alpha + dst * (255u - alpha) + 128u;
+    return static_cast<uint8_t>((t + (t >> 8)) >> 8);
+}
+
+void fillSpanScalar(uint32_t* p, int count, uint32_t color) {
+    std::fill(p, p + count, color);
+}
+
+void blendSpanScalar(uint32_t* p, int count, uint32_t color, uint8_t alpha) {
+    uint8_t src[4];
+    std::memcpy(src, &color, sizeof(src));
+    for (int i = 0; i < count; i++) {
+        uint8_t dst[4];
+        std::memcpy(dst, &p[i], sizeof(dst));
+        dst[0] = blendChannel(src[0], dst[0], alpha);
+        dst[1] = blendChannel(src[1], dst[1], alpha);
+        dst[2] = blendChannel(src[2], dst[2], alpha);
+        dst[3] = 255;
+        std::memcpy(&p[i], dst, sizeof(dst));
+    }
+}
+
+#if defined(LIDPONG_SIMD_SSE2)
+
+void fillSpanSimd(uint32_t* p, int count, uint32_t color) {
+    const __m128i value = _mm_set1_epi32(static_cast<int>(color));
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p + i), value);
+    }
+    fillSpanScalar(p + i, count - i, color);
+}
+
+// Eight 16-bit channels (two pixels) at a time
+inline __m128i blendChannels(__m128i dst, __m128i srcTimesAlpha, __m128i inverseAlpha) {
+    __m128i t = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(dst, inverseAlpha), srcTimesAlpha), _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+void blendSpanSimd(uint32_t* p, int count, uint32_t color, uint8_t alpha) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i srcTimesAlpha = _mm_mullo_epi16(_mm_unpacklo_epi8(_mm_set1_epi32(static_cast<int>(color)), zero),
+                                                  _mm_set1_epi16(alpha));
+    const __m128i inverseAlpha = _mm_set1_epi16(static_cast<short>(255 - alpha));
+    const __m128i opaque = _mm_set1_epi32(static_cast<int>(packRgba(0, 0, 0, 255)));
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i dst = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        __m128i lo = blendChannels(_mm_unpacklo_epi8(dst, zero), srcTimesAlpha, inverseAlpha);
+        __m128i hi = blendChannels(_mm_unpackhi_epi8(dst, zero), srcTimesAlpha, inverseAlpha);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p + i), _mm_or_si128(_mm_packus_epi16(lo, hi), opaque));
+    }
+    blendSpanScalar(p + i, count - i, color, alpha);
+}
+
+#elif defined(LIDPONG_SIMD_NEON)
+
+void fillSpanSimd(uint32_t* p, int count, uint32_t color) {
+    const uint32x4_t value = vdupq_n_u32(color);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        vst1q_u32(p + i, value);
+    }
+    fillSpanScalar(p + i, count - i, color);
+}
+
+// Sixteen 8-bit channels (four pixels) at a time, widened to 16 bits
+void blendSpanSimd(uint32_t* p, int count, uint32_t color, uint8_t alpha) {
+    const uint8x16_t src = vreinterpretq_u8_u32(vdupq_n_u32(color));
+    const uint16x8_t srcTimesAlpha = vmull_u8(vget_low_u8(src), vdup_n_u8(alpha));
+    const uint8x8_t inverseAlpha = vdup_n_u8(static_cast<uint8_t>(255 - alpha));
+    const uint8x16_t opaque = vreinterpretq_u8_u32(vdupq_n_u32(packRgba(0, 0, 0, 255)));
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        uint8x16_t dst = vreinterpretq_u8_u32(vld1q_u32(p + i));
+        uint16x8_t lo = vaddq_u16(vmlal_u8(srcTimesAlpha, vget_low_u8(dst), inverseAlpha), vdupq_n_u16(128));
+        uint16x8_t hi = vaddq_u16(vmlal_u8(srcTimesAlpha, vget_high_u8(dst), inverseAlpha), vdupq_n_u16(128));
+        uint8x8_t loBytes = vshrn_n_u16(vaddq_u16(lo, vshrq_n_u16(lo, 8)), 8);
+        uint8x8_t hiBytes = vshrn_n_u16(vaddq_u16(hi, vshrq_n_u16(hi, 8)), 8);
+        vst1q_u32(p + i, vreinterpretq_u32_u8(vorrq_u8(vcombine_u8(loBytes, hiBytes), opaque)));
+    }
+    blendSpanScalar(p + i, count - i, color, alpha);
+}
+
+#else
+
+void fillSpanSimd(uint32_t* p, int count, uint32_t color) {
+    fillSpanScalar(p, count, color);
+}
+
+void blendSpanSimd(uint32_t* p, int count, uint32_t color, uint8_t alpha) {
+    blendSpanScalar(p, count, color, alpha);
+}
+
+#endif
+
+} // namespace
+
+SoftwareCanvas::SoftwareCanvas(int width, int height)
+    : m_width(std::max(1, width))
+    , m_height(std::max(1, height))
+    , m_pixels(static_cast<size_t>(m_width) * m_height, packRgba(0, 0, 0, 255))
+    , m_color(packRgba(255, 255, 255, 255))
+    , m_alpha(255)
+    , m_blending(false)
+    , m_simd(true)
+    , m_primitive(Primitive::Quads) {
+    m_vertices.reserve(256);
+}
+
+const char* SoftwareCanvas::simdName() {
+    return simd::name();
+}
+
+void SoftwareCanvas::clear(float r, float g, float b) {
+    std::fill(m_pixels.begin(), m_pixels.end(), packRgba(toByte(r), toByte(g), toByte(b), 255));
+}
+
+void SoftwareCanvas::setColor(float r, float g, float b, float a) {
+    m_color = packRgba(toByte(r), toByte(g), toByte(b), 255);
+    m_alpha = toByte(a);
+}
+
+void SoftwareCanvas::begin(Primitive primitive) {
+    m_primitive = primitive;
+    m_vertices.clear();
+}
+
+void SoftwareCanvas::vertex(float x, float y) {
+    m_vertices.push_back(toPixelX(x));
+    m_vertices.push_back(toPixelY(y));
+}
+
+void SoftwareCanvas::end() {
+    size_t count = m_vertices.size() / 2;
+    switch (m_primitive) {
+        case Primitive::Quads:
+            for (size_t i = 0; i + 4 <= count; i += 4) {
+                fillPolygon(&m_vertices[2 * i], 4);
+            }
+            break;
+        case Primitive::TriangleFan:
+            fillPolygon(m_vertices.data(), count);
+            break;
+        case Primitive::LineLoop:
+            for (size_t i = 0; count > 1 && i < count; i++) {
+                size_t next = (i + 1) % count;
+                drawLine(m_vertices[2 * i], m_vertices[2 * i + 1], m_vertices[2 * next], m_vertices[2 * next + 1]);
+            }
+            break;
+    }
+    m_vertices.clear();
+}
+
+void SoftwareCanvas::drawQuads(const float* xy, size_t vertexCount) {
+    float quad[8];
+    for (size_t i = 0; i + 4 <= vertexCount; i += 4) {
+        for (int v = 0; v < 4; v++) {
+            quad[2 * v] = toPixelX(xy[2 * (i + v)]);
+            quad[2 * v + 1] = toPixelY(xy[2 * (i + v) + 1]);
+        }
+        fillPolygon(quad, 4);
+    }
+}
+
+void SoftwareCanvas::drawPoints(const float* xy, size_t count, float diameterPixels) {
+    for (size_t i = 0; i < count; i++) {
+        fillDisc(toPixelX(xy[2 * i]), toPixelY(xy[2 * i + 1]), diameterPixels);
+    }
+}
+
+void SoftwareCanvas::drawColoredPoints(const float* xy, const uint32_t* rgba, size_t count, float diameterPixels) {
+    const uint32_t color = m_color;
+    const uint8_t alpha = m_alpha;
+    for (size_t i = 0; i < count; i++) {
+        uint8_t bytes[4];
+        std::memcpy(bytes, &rgba[i], sizeof(bytes));
+        m_color = packRgba(bytes[0], bytes[1], bytes[2], 255);
+        m_alpha = bytes[3];
+        fillDisc(toPixelX(xy[2 * i]), toPixelY(xy[2 * i + 1]), diameterPixels);
+    }
+    m_color = color;
+    m_alpha = alpha;
+}
+
+// Round points: a span per row of the disc
+void SoftwareCanvas::fillDisc(float cx, float cy, float diameterPixels) {
+    if (diameterPixels <= 1.0f) {
+        plot(static_cast<int>(std::floor(cx)), static_cast<int>(std::floor(cy)));
+        return;
+    }
+    float radius = diameterPixels * 0.5f;
+    int rowEnd = std::min(m_height, clampedCeil(cy + radius - 0.5f, m_height));
+    for (int row = std::max(0, clampedCeil(cy - radius - 0.5f, m_height)); row < rowEnd; row++) {
+        float dy = row + 0.5f - cy;
+        float halfWidth = std::sqrt(std::max(0.0f, radius * radius - dy * dy));
+        int begin = std::max(0, clampedCeil(cx - halfWidth - 0.5f, m_width));
+        int end = std::min(m_width, clampedCeil(cx + halfWidth - 0.5f, m_width));
+        if (begin < end) fillSpan(row, begin, end);
+    }
+}
+
+// Convex polygon in pixel space. A pixel is covered when its centre is inside;
+// edges are half-open in y so shared vertices aren't counted twice.
+void SoftwareCanvas::fillPolygon(const float* xy, size_t vertexCount) {
+    if (vertexCount < 3) return;
+
+    float minY = xy[1], maxY = xy[1];
+    for (size_t i = 1; i < vertexCount; i++) {
+        minY = std::min(minY, xy[2 * i + 1]);
+        maxY = std::max(maxY, xy[2 * i + 1]);
+    }
+
+    int rowEnd = std::min(m_height, clampedCeil(maxY - 0.5f, m_height));
+    for (int row = std::max(0, clampedCeil(minY - 0.5f, m_height)); row < rowEnd; row++) {
+        float centerY = row + 0.5f;
+        float left = 1e30f, right = -1e30f;
+        for (size_t i = 0; i < vertexCount; i++) {
+            const float* a = xy + 2 * i;
+            const float* b = xy + 2 * ((i + 1) % vertexCount);
+            if (centerY < std::min(a[1], b[1]) || centerY >= std::max(a[1], b[1])) {
+                continue; // Also skips horizontal edges
+            }
+            float x = a[0] + (centerY - a[1]) * (b[0] - a[0]) / (b[1] - a[1]);
+            left = std::min(left, x);
+            right = std::max(right, x);
+        }
+        if (left >= right) continue;
+
+        int begin = std::max(0, clampedCeil(left - 0.5f, m_width));
+        int end = std::min(m_width, clampedCeil(right - 0.5f, m_width));
+        if (begin < end) fillSpan(row, begin, end);
+    }
+}
+
+// Bresenham between the pixels containing the endpoints
+void SoftwareCanvas::drawLine(float x0, float y0, float x1, float y1) {
+    int ax = std::min(m_width - 1, static_cast<int>(std::floor(x0)));
+    int ay = std::min(m_height - 1, static_cast<int>(std::floor(y0)));
+    int bx = std::min(m_width - 1, static_cast<int>(std::floor(x1)));
+    int by = std::min(m_height - 1, static_cast<int>(std::floor(y1)));
+
+    int dx = std::abs(bx - ax), sx = ax < bx ? 1 : -1;
+    int dy = -std::abs(by - ay), sy = ay < by ? 1 : -1;
+    int err = dx + dy;
+    while (true) {
+        plot(ax, ay);
+        if (ax == bx && ay == by) break;
+        int e2 = 2 * err;
+        if (e2 >= dy) { err += dy; ax += sx; }
+        if (e2 <= dx) { err += dx; ay += sy; }
+    }
+}
+
+void SoftwareCanvas::fillSpan(int row, int begin, int end) {
+    uint32_t* p = &m_pixels[static_cast<size_t>(row) * m_width + begin];
+    int count = end - begin;
+    bool blend = m_blending && m_alpha < 255;
+    if (m_simd) {
+        if (blend) blendSpanSimd(p, count, m_color, m_alpha);
+        else fillSpanSimd(p, count, m_color);
+    } else {
+        if (blend) blendSpanScalar(p, count, m_color, m_alpha);
+        else fillSpanScalar(p, count, m_color);
+    }
+}
+
+void SoftwareCanvas::plot(int x, int y) {
+    if (x >= 0 && x < m_width && y >= 0 && y < m_height) {
+        fillSpan(y, x, x + 1);
+    }
+}
+
+// Image files
+
+namespace {
+
+void writeBigEndian(std::ostream& out, uint32_t value) {
+    const char bytes[4] = {static_cast<char>(value >> 24), static_cast<char>(value >> 16),
+                           static_cast<char>(value >> 8), static_cast<char>(value)};
+    out.write(bytes, 4);
+}
+
+uint32_t crc32(uint32_t crc, const uint8_t* data, size_t size) {
+    static uint32_t table[256];
+    static bool tableReady = false;
+    if (!tableReady) {
+        for (uint32_t n = 0; n < 256; n++) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            table[n] = c;
+        }
+        tableReady = true;
+    }
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+void writePngChunk(std::ostream& out, const char type[4], const std::vector<uint8_t>& data) {
+    writeBigEndian(out, static_cast<uint32_t>(data.size()));
+    out.write(type, 4);
+    out.write(reinterpret_cast<const char*>(data.data()), data.size());
+    uint32_t crc = crc32(0, reinterpret_cast<const uint8_t*>(type), 4);
+    writeBigEndian(out, crc32(crc, data.data(), data.size()));
+}
+
+void appendBigEndian(std::vector<uint8_t>& data, uint32_t value) {
+    data.push_back(static_cast<uint8_t>(value >> 24));
+    data.push_back(static_cast<uint8_t>(value >> 16));
+    data.push_back(static_cast<uint8_t>(value >> 8));
+    data.push_back(static_cast<uint8_t>(value));
+}
+
+} // namespace
+
+bool writePpm(const std::string& path, const uint32_t* pixels, int width, int height, std::string& error) {
+    std::ofstream out(path.c_str(), std::ios::binary);
+    if (!out) {
+        error = "cannot open " + path + " for writing";
+        return false;
+    }
+    out << "P6\n" << width << " " << height << "\n255\n";
+    std::vector<uint8_t> row(static_cast<size_t>(width) * 3);
+    for (int y = 0; y < height; y++) {
+        const uint8_t* src = reinterpret_cast<const uint8_t*>(pixels + static_cast<size_t>(y) * width);
+        for (int x = 0; x < width; x++) {
+            row[3 * x] = src[4 * x];
+            row[3 * x + 1] = src[4 * x + 1];
+            row[3 * x + 2] = src[4 * x + 2];
+        }
+        out.write(reinterpret_cast<const char*>(row.data()), row.size());
+    }
+    if (!out) {
+        error = "write to " + path + " failed";
+        return false;
+    }
+    return true;
+}
+
+bool writePng(const std::string& path, const uint32_t* pixels, int width, int height, std::string& error) {
+    std::ofstream out(path.c_str(), std::ios::binary);
+    if (!out) {
+        error = "cannot open " + path + " for writing";
+        return false;
+    }
+
+    // Filter byte 0 (none) and RGB for every row
+    const size_t rowBytes = 1 + static_cast<size_t>(width) * 3;
+    std::vector<uint8_t> raw(rowBytes * height);
+    for (int y = 0; y < height; y++) {
+        const uint8_t* src = reinterpret_cast<const uint8_t*>(pixels + static_cast<size_t>(y) * width);
+        uint8_t* dst = &raw[y * rowBytes];
+        *dst++ = 0;
+        for (int x = 0; x < width; x++) {
+            *dst++ = src[4 * x];
+            *dst++ = src[4 * x + 1];
+            *dst++ = src[4 * x + 2];
+        }
+    }
+
+    // zlib stream of stored deflate blocks
+    const size_t maxBlock = 65535;
+    std::vector<uint8_t> idat;
+    idat.reserve(raw.size() + raw.size() / maxBlock * 5 + 16);
+    idat.push_back(0x78);
+    idat.push_back(0x01);
+    uint32_t adlerA = 1, adlerB = 0;
+    for (size_t offset = 0;; offset += maxBlock) {
+        size_t size = std::min(maxBlock, raw.size() - offset);
+        bool last = offset + size >= raw.size();
+        idat.push_back(last ? 1 : 0);
+        idat.push_back(static_cast<uint8_t>(size));
+        idat.push_back(static_cast<uint8_t>(size >> 8));
+        idat.push_back(static_cast<uint8_t>(~size));
+        idat.push_back(static_cast<uint8_t>(~size >> 8));
+        idat.insert(idat.end(), raw.begin() + offset, raw.begin() + offset + size);
+        for (size_t i = offset; i < offset + size; i++) {
+            adlerA = (adlerA + raw[i]) % 65521;
+            adlerB = (adlerB + adlerA) % 65521;
+        }
+        if (last) break;
+    }
+    appendBigEndian(idat, (adlerB << 16) | adlerA);
+
+    std::vector<uint8_t> header;
+    appendBigEndian(header, static_cast<uint32_t>(width));
+    appendBigEndian(header, static_cast<uint32_t>(height));
+    const uint8_t format[5] = {8, 2, 0, 0, 0}; // 8-bit RGB, no interlace
+    header.insert(header.end(), format, format + 5);
+
+    const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    out.write(reinterpret_cast<const char*>(signature), sizeof(signature));
+    writePngChunk(out, "IHDR", header);
+    writePngChunk(out, "IDAT", idat);
+    writePngChunk(out, "IEND", std::vector<uint8_t>());
+
+    if (!out) {
+        error = "write to " + path + " failed";
+        return false;
+    }
+    return true;
+}
+
+bool writeImage(const std::string& path, ImageFormat format, const uint32_t* pixels, int width, int height, std::string& error) {
+    return format == ImageFormat::Png ? writePng(path, pixels, width, height, error)
+                                      : writePpm(path, pixels, width, height, error);
+}
+
+bool readPpm(const std::string& path, std::vector<uint32_t>& pixels, int& width, int& height, std::string& error) {
+    std::ifstream in(path.c_str(), std::ios::binary);
+    if (!in) {
+        error = "cannot open " + path;
+        return false;
+    }
+    std::string magic;
+    int maxValue = 0;
+    in >> magic >> width >> height >> maxValue;
+    if (!in || magic != "P6" || width <= 0 || height <= 0 || maxValue != 255) {
+        error = path + " is not an 8-bit binary PPM";
+        return false;
+    }
+    in.get(); // Single whitespace before the pixel data
+
+    std::vector<uint8_t> rgb(static_cast<size_t>(width) * height * 3);
+    if (!in.read(reinterpret_cast<char*>(rgb.data()), rgb.size())) {
+        error = path + " is truncated";
+        return false;
+    }
+    pixels.resize(static_cast<size_t>(width) * height);
+    for (size_t i = 0; i < pixels.size(); i++) {
+        pixels[i] = packRgba(rgb[3 * i], rgb[3 * i + 1], rgb[3 * i + 2], 255);
+    }
+    return true;
+}
+
+} // namespace LidPong
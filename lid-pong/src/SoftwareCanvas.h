@@ -0,0 +1,75 @@
+#pragma once
+
+#include "Canvas.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace LidPong {
+
+// Canvas that rasterises into an in-memory RGBA8 framebuffer - no GPU or
+// display needed. Polygons are filled a scanline span at a time (pixel
+// centres inside the edges are covered, like GL), spans with SIMD stores.
+// Output is a pure function of the draw calls, so frames can be compared
+// pixel for pixel.
+class SoftwareCanvas : public Canvas {
+public:
+    SoftwareCanvas(int width, int height);
+
+    int width() const override { return m_width; }
+    int height() const override { return m_height; }
+
+    void clear(float r, float g, float b) override;
+    void setColor(float r, float g, float b, float a = 1.0f) override;
+    void setBlending(bool enabled) override { m_blending = enabled; }
+
+    void begin(Primitive primitive) override;
+    void vertex(float x, float y) override;
+    void end() override;
+
+    void drawQuads(const float* xy, size_t vertexCount) override;
+    void drawPoints(const float* xy, size_t count, float diameterPixels) override;
+    void drawColoredPoints(const float* xy, const uint32_t* rgba, size_t count, float diameterPixels) override;
+
+    // Rows top to bottom, RGBA bytes in memory order
+    const uint32_t* pixels() const { return m_pixels.data(); }
+
+    // Span filling through SIMD (default) or the scalar reference; both give identical pixels
+    void setSimd(bool enabled) { m_simd = enabled; }
+    static const char* simdName();
+
+private:
+    void fillPolygon(const float* xy, size_t vertexCount);
+    void drawLine(float x0, float y0, float x1, float y1);
+    void fillDisc(float cx, float cy, float diameterPixels);
+    void fillSpan(int row, int begin, int end);
+    void plot(int x, int y);
+
+    float toPixelX(float x) const { return (x + 1.0f) * 0.5f * m_width; }
+    float toPixelY(float y) const { return (1.0f - y) * 0.5f * m_height; }
+
+    int m_width;
+    int m_height;
+    std::vector<uint32_t> m_pixels;
+
+    uint32_t m_color;    // Packed RGBA of the current colour
+    uint8_t m_alpha;
+    bool m_blending;
+    bool m_simd;
+
+    Primitive m_primitive;
+    std::vector<float> m_vertices; // Pixel-space xy between begin() and end()
+};
+
+enum class ImageFormat { Ppm, Png };
+
+// Still images of an RGBA8 framebuffer (alpha is dropped). PNGs use stored
+// deflate blocks, so they need no zlib but are uncompressed.
+bool writePpm(const std::string& path, const uint32_t* pixels, int width, int height, std::string& error);
+bool writePng(const std::string& path, const uint32_t* pixels, int width, int height, std::string& error);
+bool writeImage(const std::string& path, ImageFormat format, const uint32_t* pixels, int width, int height, std::string& error);
+
+// Reads a binary (P6) PPM back as RGBA8, e.g. a golden image
+bool readPpm(const std::string& path, std::vector<uint32_t>& pixels, int& width, int& height, std::string& error);
+
+} // namespace LidPong
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace LidPong {
+
+// Single-producer / single-consumer bounded FIFO. Neither side ever blocks,
+// locks or allocates: push() fails when the queue is full and pop() when it
+// is empty, so it is safe to use from a real-time audio callback. Capacity
+// must be a power of two; all of it is usable.
+template<class T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+public:
+    SpscQueue() : m_head(0), m_tail(0), m_cachedHead(0), m_cachedTail(0) {}
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // Producer side
+    bool push(const T& value) {
+        uint64_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_cachedHead == Capacity) {
+            // Only look at the consumer's index (and its cache line) when we seem to be full
+            m_cachedHead = m_head.load(std::memory_order_acquire);
+            if (tail - m_cachedHead == Capacity) {
+                return false;
+            }
+        }
+        m_slots[tail & (Capacity - 1)] = value;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side
+    bool pop(T& out) {
+        uint64_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_cachedTail) {
+            m_cachedTail = m_tail.load(std::memory_order_acquire);
+            if (head == m_cachedTail) {
+                return false;
+            }
+        }
+        out = m_slots[head & (Capacity - 1)];
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    static size_t capacity() { return Capacity; }
+
+private:
+    T m_slots[Capacity];
+    // Each index, and each side's cached copy of the other's, on its own cache line
+    alignas(64) std::atomic<uint64_t> m_head; // Next slot to pop; written by the consumer
+    alignas(64) std::atomic<uint64_t> m_tail; // Next slot to push; written by the producer
+    alignas(64) uint64_t m_cachedHead;        // Producer's last look at m_head
+    alignas(64) uint64_t m_cachedTail;        // Consumer's last look at m_tail
+};
+
+} // namespace LidPong
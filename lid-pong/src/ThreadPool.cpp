@@ -0,0 +1,141 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+namespace LidPong {
+
+namespace {
+    // Polls before a worker goes to sleep; lock-step callers start a new
+    // loop every few hundred microseconds and a futex wake costs more
+    const int SPIN_POLLS = 20000;
+}
+
+ThreadPool::ThreadPool(size_t threadCount)
+    : m_generation(0)
+    , m_pending(0)
+    , m_stolen(0)
+    , m_stop(false) {
+    if (threadCount == 0) {
+        threadCount = std::thread::hardware_concurrency();
+    }
+    if (threadCount == 0) {
+        threadCount = 1;
+    }
+
+    for (size_t i = 0; i < threadCount; i++) {
+        m_queues.emplace_back(new Queue());
+    }
+    for (size_t i = 1; i < threadCount; i++) {
+        m_workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (std::thread& worker : m_workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, size_t grain, const RangeFunction& body) {
+    parallelForAsync(count, grain, body);
+    wait();
+}
+
+void ThreadPool::parallelForAsync(size_t count, size_t grain, const RangeFunction& body) {
+    if (count == 0) {
+        return;
+    }
+    if (grain == 0) {
+        grain = 1;
+    }
+
+    size_t chunks = (count + grain - 1) / grain;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_body = body;
+        m_pending.store(chunks, std::memory_order_relaxed);
+
+        // Deal contiguous runs of chunks so neighbouring data stays on one thread
+        size_t perQueue = (chunks + m_queues.size() - 1) / m_queues.size();
+        for (size_t c = 0; c < chunks; c++) {
+            Range range = {c * grain, std::min(count, (c + 1) * grain)};
+            Queue& queue = *m_queues[c / perQueue];
+            std::lock_guard<std::mutex> queueLock(queue.mutex);
+            queue.ranges.push_back(range);
+        }
+        m_generation.fetch_add(1, std::memory_order_release);
+    }
+    m_wake.notify_all();
+}
+
+void ThreadPool::wait() {
+    runChunks(0);
+
+    if (m_pending.load(std::memory_order_acquire) == 0) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this] { return m_pending.load(std::memory_order_acquire) == 0; });
+}
+
+void ThreadPool::workerLoop(size_t self) {
+    uint64_t seen = 0;
+    for (;;) {
+        // Spin briefly for the next loop, then sleep
+        for (int i = 0; i < SPIN_POLLS && m_generation.load(std::memory_order_acquire) == seen; i++) {
+            std::this_thread::yield();
+        }
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this, seen] { return m_stop || m_generation.load(std::memory_order_relaxed) != seen; });
+            if (m_stop) {
+                return;
+            }
+            seen = m_generation.load(std::memory_order_relaxed);
+        }
+        runChunks(self);
+    }
+}
+
+void ThreadPool::runChunks(size_t self) {
+    Range range;
+    while (takeChunk(self, range)) {
+        m_body(range.begin, range.end);
+        if (m_pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_done.notify_all();
+        }
+    }
+}
+
+bool ThreadPool::takeChunk(size_t self, Range& out) {
+    // Own queue from the back (most recently dealt, still warm)
+    {
+        Queue& own = *m_queues[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.ranges.empty()) {
+            out = own.ranges.back();
+            own.ranges.pop_back();
+            return true;
+        }
+    }
+
+    // Steal from the front of the others
+    for (size_t i = 1; i < m_queues.size(); i++) {
+        Queue& victim = *m_queues[(self + i) % m_queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.ranges.empty()) {
+            out = victim.ranges.front();
+            victim.ranges.pop_front();
+            m_stolen.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace LidPong
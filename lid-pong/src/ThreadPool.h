@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace LidPong {
+
+// Fork/join pool for data-parallel loops. A range is cut into chunks that are
+// dealt out to per-thread queues; each thread drains its own queue and then
+// steals from the others, so uneven chunks still finish together. The calling
+// thread works too, so a pool of N threads starts N - 1 workers.
+//
+// One loop runs at a time: start the next only after wait() has returned.
+class ThreadPool {
+public:
+    typedef std::function<void(size_t begin, size_t end)> RangeFunction;
+
+    // threadCount 0: one per hardware thread
+    explicit ThreadPool(size_t threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t threadCount() const { return m_queues.size(); }
+
+    // Run body over [0, count) in chunks of 'grain' and return when all are done
+    void parallelFor(size_t count, size_t grain, const RangeFunction& body);
+
+    // Same, but return at once; the caller joins in (and blocks) in wait()
+    void parallelForAsync(size_t count, size_t grain, const RangeFunction& body);
+    void wait();
+
+    uint64_t chunksStolen() const { return m_stolen.load(std::memory_order_relaxed); }
+
+private:
+    struct Range {
+        size_t begin, end;
+    };
+
+    // Separately allocated and padded so neighbouring queues don't share a cache line
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Range> ranges;
+        char padding[64];
+    };
+
+    void workerLoop(size_t self);
+    void runChunks(size_t self);
+    bool takeChunk(size_t self, Range& out);
+
+    std::vector<std::unique_ptr<Queue>> m_queues; // [0] belongs to the calling thread
+    std::vector<std::thread> m_workers;
+    RangeFunction m_body;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    std::atomic<uint64_t> m_generation;
+    std::atomic<size_t> m_pending;
+    std::atomic<uint64_t> m_stolen;
+    bool m_stop;
+};
+
+} // namespace LidPong
@@ -0,0 +1,684 @@
+#include "TraceAnalytics.h"
+#include "Clock.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <dirent.h>
+#include <fcntl.h>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace LidPong {
+
+namespace {
+    const size_t READ_BLOCK_RECORDS = 65536; // 1 MB per read
+    const int DERIVATIVE_BLOCK = 8;          // Velocity and jerk compare means of this many reads...
+    const uint64_t CONTEXT_RECORDS = 4 * DERIVATIVE_BLOCK; // ...four blocks for jerk: what a piece re-reads
+    const double FIXED_ONE = 65536.0;        // Angle sums are kept in 1/65536 degree
+    const double BLOCK_MEAN = 1.0 / (FIXED_ONE * DERIVATIVE_BLOCK);
+    const double GAP_PERIODS = 4.0;          // Default gap threshold, in requested sample periods
+    const double UNPACED_GAP_MS = 20.0;      // ...and for traces sampled as fast as possible
+    const double REST_WINDOW_DEGREES = 2.0;  // Three samples within this of each other: the lid is at rest
+    const int HISTOGRAM_BAR_WIDTH = 40;
+
+    bool endsWith(const std::string& text, const char* suffix) {
+        size_t length = std::strlen(suffix);
+        return text.size() >= length && text.compare(text.size() - length, length, suffix) == 0;
+    }
+
+    std::string formatValue(double value) {
+        char text[32];
+        std::snprintf(text, sizeof(text), "%.3g", value);
+        return text;
+    }
+
+    // A piece of a file: records [begin, end)
+    struct Piece {
+        size_t file;
+        uint64_t begin, end;
+    };
+
+    // Running state over consecutive records. Feeding a piece's context
+    // records uncounted first makes its state exactly what a pass over the
+    // whole file would have had there (nothing looks further back than that).
+    //
+    // Differences of single reads would measure the sensor noise rather than
+    // the lid, so velocity and jerk use the means of blocks of DERIVATIVE_BLOCK
+    // reads, from running sums in fixed point: exact integers, so a file cut
+    // anywhere gives bit-identical results. They, and the noise, are sampled
+    // once a block: millions of values either way, at an eighth of the cost.
+    class Scanner {
+    public:
+        explicit Scanner(int64_t gapNs) : m_gapNs(gapNs), m_state(), m_ring{} {}
+
+        // 'index' is the file's record number of records[0]
+        template<bool Count>
+        void feed(const AngleTraceRecord* records, size_t count, uint64_t index, TraceStats& stats) {
+            // The loop works on local copies: a histogram count is a uint64_t
+            // store that may alias any 64-bit integer member, so updating
+            // members directly reloads all of them after every record
+            State state = m_state;
+            Tally tally;
+            tally.firstNs = stats.firstNs;
+            tally.lastNs = stats.lastNs;
+            tally.longestIntervalNs = stats.longestIntervalNs;
+
+            for (size_t i = 0; i < count; i++) {
+                const AngleTraceRecord& record = records[i];
+                const bool good = record.status == 0;
+                const bool idle = (record.flags & ANGLE_TRACE_IDLE) != 0;
+                const int64_t ns = record.timestampNs;
+                const double angle = record.angle;
+
+                if (Count) {
+                    tally.samples++;
+                    if (!good) {
+                        tally.failedReads++;
+                        if (!state.hasPrevious || state.previousGood) {
+                            tally.failureRuns++;
+                        }
+                    }
+                    if (idle) {
+                        tally.idleSamples++;
+                    }
+                    tally.firstNs = std::min(tally.firstNs, ns);
+                    tally.lastNs = std::max(tally.lastNs, ns);
+                }
+
+                // Intervals after an idle sample are the idle sleep, not sensor timing
+                bool linked = false;
+                if (state.hasPrevious) {
+                    int64_t interval = ns - state.previousNs;
+                    if (interval < 0) {
+                        if (Count) {
+                            tally.backwardSteps++;
+                        }
+                    } else if (!state.previousIdle) {
+                        if (Count) {
+                            stats.intervalUs.add(interval * 1.0e-3);
+                            tally.intervalSumNs += interval;
+                            tally.intervals++;
+                            tally.longestIntervalNs = std::max(tally.longestIntervalNs, interval);
+                            if (interval > m_gapNs) {
+                                tally.gaps++;
+                            }
+                        }
+                        linked = interval > 0 && interval <= m_gapNs;
+                    }
+                }
+                const bool previousGood = state.previousGood;
+                state.hasPrevious = true;
+                state.previousNs = ns;
+                state.previousIdle = idle;
+                state.previousGood = good;
+                if (!good) {
+                    state.chain = 0;
+                    continue;
+                }
+
+                // Good reads in a row, joined by timed gap-free intervals
+                if (linked && previousGood) {
+                    state.chain = std::min(state.chain + 1, int(CHAIN_NEEDED));
+                } else {
+                    state.chain = 1;
+                    state.sum = 0;
+                }
+                state.sum += static_cast<int64_t>(angle * FIXED_ONE + (angle < 0.0 ? -0.5 : 0.5)); // Rounded, without a libm call
+                m_ring[state.head & RING_MASK] = Read{ns, state.sum, angle};
+                state.head++;
+                if (!Count) {
+                    continue;
+                }
+
+                // Noise and derivatives once a block of the file, so wherever it is cut the same reads are used
+                if ((index + i) % DERIVATIVE_BLOCK != 0) {
+                    continue;
+                }
+                if (state.chain >= 3) {
+                    double before = back(state, 1).angle, first = back(state, 2).angle;
+                    double low = std::min(std::min(first, before), angle);
+                    double high = std::max(std::max(first, before), angle);
+                    if (high - low < REST_WINDOW_DEGREES) {
+                        // White noise of RMS s leaves a residual of RMS s * sqrt(1.5)
+                        double residual = before - 0.5 * (first + angle);
+                        tally.noiseSumSquares += residual * residual;
+                        tally.noiseCount++;
+                    }
+                }
+                if (state.chain >= 2 * DERIVATIVE_BLOCK + 1) {
+                    const Read& block1 = back(state, DERIVATIVE_BLOCK);
+                    const Read& block2 = back(state, 2 * DERIVATIVE_BLOCK);
+                    double newest = static_cast<double>(state.sum - block1.sum);
+                    double older = static_cast<double>(block1.sum - block2.sum);
+                    double seconds = (ns - block1.ns) * 1.0e-9;
+                    stats.velocity.add(std::fabs(newest - older) * BLOCK_MEAN / seconds);
+                    if (state.chain >= 4 * DERIVATIVE_BLOCK + 1) {
+                        const Read& block3 = back(state, 3 * DERIVATIVE_BLOCK);
+                        const Read& block4 = back(state, 4 * DERIVATIVE_BLOCK);
+                        double oldest = static_cast<double>(block3.sum - block4.sum);
+                        double third = newest - 3.0 * older + 3.0 * static_cast<double>(block2.sum - block3.sum) - oldest;
+                        double step = (ns - block3.ns) * (1.0e-9 / 3.0);
+                        stats.jerk.add(std::fabs(third) * BLOCK_MEAN / (step * step * step));
+                    }
+                }
+            }
+
+            m_state = state;
+            if (Count) {
+                tally.addTo(stats);
+            }
+        }
+
+    private:
+        static const int CHAIN_NEEDED = 4 * DERIVATIVE_BLOCK + 1;
+        static const size_t RING_MASK = 63;
+        static_assert(RING_MASK + 1 >= CHAIN_NEEDED, "Scanner ring too small for the jerk blocks");
+
+        struct State {
+            bool hasPrevious;
+            int64_t previousNs;
+            bool previousGood;
+            bool previousIdle;
+            int chain;   // Up to CHAIN_NEEDED; only whether there are enough reads matters
+            int64_t sum; // Fixed-point angles of the chain so far
+            size_t head; // Reads ever put in the ring
+
+            State() : hasPrevious(false), previousNs(0), previousGood(false), previousIdle(false), chain(0), sum(0), head(0) {}
+        };
+
+        // The scalar parts of TraceStats, for one feed()
+        struct Tally {
+            uint64_t samples, failedReads, failureRuns, idleSamples, backwardSteps, intervals, gaps, noiseCount;
+            int64_t firstNs, lastNs, longestIntervalNs, intervalSumNs;
+            double noiseSumSquares;
+
+            Tally() : samples(0), failedReads(0), failureRuns(0), idleSamples(0), backwardSteps(0), intervals(0), gaps(0), noiseCount(0), firstNs(0), lastNs(0), longestIntervalNs(0), intervalSumNs(0), noiseSumSquares(0.0) {}
+
+            void addTo(TraceStats& stats) const {
+                stats.samples += samples;
+                stats.failedReads += failedReads;
+                stats.failureRuns += failureRuns;
+                stats.idleSamples += idleSamples;
+                stats.backwardSteps += backwardSteps;
+                stats.intervals += intervals;
+                stats.gaps += gaps;
+                stats.noiseCount += noiseCount;
+                stats.firstNs = firstNs;
+                stats.lastNs = lastNs;
+                stats.longestIntervalNs = longestIntervalNs;
+                stats.intervalSumNs += intervalSumNs;
+                stats.noiseSumSquares += noiseSumSquares;
+            }
+        };
+
+        struct Read {
+            int64_t ns;
+            int64_t sum; // state.sum with this read included
+            double angle;
+        };
+
+        const Read& back(const State& state, size_t reads) const { return m_ring[(state.head - 1 - reads) & RING_MASK]; }
+
+        int64_t m_gapNs;
+        State m_state;
+        Read m_ring[RING_MASK + 1];
+    };
+
+    bool readFully(int fd, void* buffer, size_t bytes, off_t offset) {
+        char* at = static_cast<char*>(buffer);
+        while (bytes > 0) {
+            ssize_t got = ::pread(fd, at, bytes, offset);
+            if (got < 0 && errno == EINTR) {
+                continue;
+            }
+            if (got <= 0) {
+                return false;
+            }
+            at += got;
+            bytes -= static_cast<size_t>(got);
+            offset += got;
+        }
+        return true;
+    }
+
+    bool scanPiece(const std::string& path, const Piece& piece, int64_t gapNs, std::vector<AngleTraceRecord>& buffer,
+                   TraceStats& stats, std::string& error) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            error = path + ": " + std::strerror(errno);
+            return false;
+        }
+        uint64_t first = piece.begin >= CONTEXT_RECORDS ? piece.begin - CONTEXT_RECORDS : 0;
+        off_t offset = static_cast<off_t>(ANGLE_TRACE_HEADER_BYTES + first * sizeof(AngleTraceRecord));
+#ifdef POSIX_FADV_SEQUENTIAL
+        posix_fadvise(fd, offset, static_cast<off_t>((piece.end - first) * sizeof(AngleTraceRecord)), POSIX_FADV_SEQUENTIAL);
+#endif
+        Scanner scanner(gapNs);
+        uint64_t context = piece.begin - first;
+        bool ok = true;
+        for (uint64_t at = first; at < piece.end;) {
+            size_t count = static_cast<size_t>(std::min<uint64_t>(buffer.size(), piece.end - at));
+            if (!readFully(fd, buffer.data(), count * sizeof(AngleTraceRecord), offset)) {
+                error = path + ": read failed";
+                ok = false;
+                break;
+            }
+            size_t skip = static_cast<size_t>(std::min<uint64_t>(context, count));
+            scanner.feed<false>(buffer.data(), skip, at, stats);
+            scanner.feed<true>(buffer.data() + skip, count - skip, at + skip, stats);
+            context -= skip;
+            at += count;
+            offset += static_cast<off_t>(count * sizeof(AngleTraceRecord));
+        }
+        ::close(fd);
+        stats.bytes = (piece.end - piece.begin) * sizeof(AngleTraceRecord);
+        return ok;
+    }
+
+    void summarise(const TraceStats& stats, TraceFileResult& result) {
+        result.samples = stats.samples;
+        result.failedReads = stats.failedReads;
+        result.failureRuns = stats.failureRuns;
+        result.gaps = stats.gaps;
+        result.idleSamples = stats.idleSamples;
+        result.rateHz = stats.rateHz();
+        result.intervalP50Ms = stats.intervalMs(50.0);
+        result.intervalP99Ms = stats.intervalMs(99.0);
+        result.intervalP999Ms = stats.intervalMs(99.9);
+        result.longestIntervalMs = stats.longestIntervalNs / 1.0e6;
+        result.noiseDegrees = stats.noiseDegrees();
+        result.velocityP50 = stats.velocity.percentile(50.0);
+        result.velocityP99 = stats.velocity.percentile(99.0);
+        result.jerkP99 = stats.jerk.percentile(99.0);
+    }
+
+    void findIn(const std::string& directory, std::vector<std::string>& files) {
+        DIR* dir = opendir(directory.c_str());
+        if (!dir) {
+            return;
+        }
+        while (dirent* entry = readdir(dir)) {
+            std::string name = entry->d_name;
+            if (name == "." || name == "..") {
+                continue;
+            }
+            std::string path = directory + "/" + name;
+            struct stat info;
+            if (lstat(path.c_str(), &info) != 0) {
+                continue;
+            }
+            if (S_ISDIR(info.st_mode)) {
+                findIn(path, files); // Not through symlinks, so no loops
+            } else if (endsWith(name, ANGLE_TRACE_EXTENSION)) {
+                files.push_back(path);
+            }
+        }
+        closedir(dir);
+    }
+}
+
+LogHistogram::LogHistogram(int minPow2, int maxPow2)
+    : m_min(std::ldexp(1.0, minPow2))
+    , m_max(std::ldexp(1.0, maxPow2)) {
+    uint64_t bits;
+    std::memcpy(&bits, &m_min, sizeof(bits));
+    m_minKey = bits >> KEY_SHIFT;
+    m_counts.assign(static_cast<size_t>(maxPow2 - minPow2) * (1u << SUB_BIN_BITS) + 2, 0);
+}
+
+void LogHistogram::merge(const LogHistogram& other) {
+    for (size_t i = 0; i < m_counts.size() && i < other.m_counts.size(); i++) {
+        m_counts[i] += other.m_counts[i];
+    }
+}
+
+uint64_t LogHistogram::count() const {
+    uint64_t total = 0;
+    for (uint64_t count : m_counts) {
+        total += count;
+    }
+    return total;
+}
+
+double LogHistogram::lowerEdge(size_t bin) const {
+    uint64_t bits = (m_minKey + bin - 1) << KEY_SHIFT;
+    double edge;
+    std::memcpy(&edge, &bits, sizeof(edge));
+    return edge;
+}
+
+double LogHistogram::percentile(double p) const {
+    uint64_t total = count();
+    if (total == 0) {
+        return 0.0;
+    }
+    double target = std::min(std::max(p, 0.0), 100.0) / 100.0 * total;
+    double seen = 0.0;
+    for (size_t bin = 0; bin < m_counts.size(); bin++) {
+        if (m_counts[bin] == 0 || seen + m_counts[bin] < target) {
+            seen += m_counts[bin];
+            continue;
+        }
+        if (bin == 0) {
+            return 0.0;
+        }
+        if (bin == m_counts.size() - 1) {
+            return m_max;
+        }
+        double low = lowerEdge(bin);
+        double high = lowerEdge(bin + 1);
+        return low + (high - low) * ((target - seen) / m_counts[bin]);
+    }
+    return m_max;
+}
+
+void LogHistogram::print(std::ostream& out, const char* unit, int octavesPerRow) const {
+    uint64_t total = count();
+    if (total == 0) {
+        return;
+    }
+    // Rows: the underflow bin, groups of octavesPerRow powers of two, the overflow bin
+    const size_t binsPerRow = static_cast<size_t>(octavesPerRow) << SUB_BIN_BITS;
+    struct Row {
+        std::string range;
+        uint64_t count;
+    };
+    std::vector<Row> rows;
+    rows.push_back(Row{"< " + formatValue(m_min), m_counts.front()});
+    for (size_t bin = 1; bin + 1 < m_counts.size(); bin += binsPerRow) {
+        size_t end = std::min(bin + binsPerRow, m_counts.size() - 1);
+        uint64_t sum = 0;
+        for (size_t i = bin; i < end; i++) {
+            sum += m_counts[i];
+        }
+        double high = end == m_counts.size() - 1 ? m_max : lowerEdge(end);
+        rows.push_back(Row{formatValue(lowerEdge(bin)) + " - " + formatValue(high), sum});
+    }
+    rows.push_back(Row{">= " + formatValue(m_max), m_counts.back()});
+
+    uint64_t largest = 0;
+    for (const Row& row : rows) {
+        largest = std::max(largest, row.count);
+    }
+    for (const Row& row : rows) {
+        if (row.count == 0) {
+            continue;
+        }
+        int bar = static_cast<int>(std::ceil(HISTOGRAM_BAR_WIDTH * static_cast<double>(row.count) / largest));
+        out << "    " << std::setw(26) << std::right << (row.range + " " + unit) << " " << std::setw(6) << std::fixed
+            << std::setprecision(2) << 100.0 * row.count / total << "% " << std::string(static_cast<size_t>(bar), '#')
+            << std::endl;
+    }
+}
+
+TraceStats::TraceStats()
+    : bytes(0)
+    , samples(0)
+    , failedReads(0)
+    , failureRuns(0)
+    , gaps(0)
+    , idleSamples(0)
+    , backwardSteps(0)
+    , firstNs(INT64_MAX)
+    , lastNs(INT64_MIN)
+    , longestIntervalNs(0)
+    , intervalSumNs(0)
+    , intervals(0)
+    , noiseSumSquares(0.0)
+    , noiseCount(0)
+    , intervalUs(-3, 30)
+    , velocity(-6, 20)
+    , jerk(0, 44) {
+}
+
+void TraceStats::merge(const TraceStats& other) {
+    bytes += other.bytes;
+    samples += other.samples;
+    failedReads += other.failedReads;
+    failureRuns += other.failureRuns;
+    gaps += other.gaps;
+    idleSamples += other.idleSamples;
+    backwardSteps += other.backwardSteps;
+    firstNs = std::min(firstNs, other.firstNs);
+    lastNs = std::max(lastNs, other.lastNs);
+    longestIntervalNs = std::max(longestIntervalNs, other.longestIntervalNs);
+    intervalSumNs += other.intervalSumNs;
+    intervals += other.intervals;
+    noiseSumSquares += other.noiseSumSquares;
+    noiseCount += other.noiseCount;
+    intervalUs.merge(other.intervalUs);
+    velocity.merge(other.velocity);
+    jerk.merge(other.jerk);
+}
+
+double TraceStats::rateHz() const {
+    return intervalSumNs > 0 ? intervals * 1.0e9 / intervalSumNs : 0.0;
+}
+
+double TraceStats::intervalMs(double p) const {
+    return std::min(intervalUs.percentile(p) / 1000.0, longestIntervalNs / 1.0e6);
+}
+
+double TraceStats::noiseDegrees() const {
+    return noiseCount > 0 ? std::sqrt(noiseSumSquares / noiseCount / 1.5) : 0.0;
+}
+
+double TraceStats::seconds() const {
+    return lastNs > firstNs ? (lastNs - firstNs) / 1.0e9 : 0.0;
+}
+
+TraceFileResult::TraceFileResult()
+    : requestedRateHz(0.0), strayBytes(0), samples(0), failedReads(0), failureRuns(0), gaps(0), idleSamples(0), rateHz(0.0), intervalP50Ms(0.0), intervalP99Ms(0.0), intervalP999Ms(0.0), longestIntervalMs(0.0), noiseDegrees(0.0), velocityP50(0.0), velocityP99(0.0), jerkP99(0.0) {
+}
+
+size_t TraceAnalysis::failedFiles() const {
+    size_t failed = 0;
+    for (const TraceFileResult& file : files) {
+        failed += file.error.empty() ? 0 : 1;
+    }
+    return failed;
+}
+
+bool findAngleTraces(const std::vector<std::string>& paths, std::vector<std::string>& files, std::string& error) {
+    for (const std::string& path : paths) {
+        struct stat info;
+        if (stat(path.c_str(), &info) != 0) {
+            error = path + ": " + std::strerror(errno);
+            return false;
+        }
+        if (S_ISDIR(info.st_mode)) {
+            std::vector<std::string> found;
+            findIn(path, found);
+            std::sort(found.begin(), found.end());
+            files.insert(files.end(), found.begin(), found.end());
+        } else {
+            files.push_back(path);
+        }
+    }
+    return true;
+}
+
+void analyzeAngleTraces(const std::vector<std::string>& files, const TraceAnalyzeOptions& options, TraceAnalysis& out) {
+    int64_t startNs = Clock::nowNs();
+    out = TraceAnalysis();
+    out.files.resize(files.size());
+    ThreadPool pool(options.threads);
+    out.threads = pool.threadCount();
+
+    // Headers and sizes first, in parallel too: a corpus may be thousands of small files
+    std::vector<uint64_t> records(files.size(), 0);
+    std::vector<int64_t> gapNs(files.size(), 0);
+    pool.parallelFor(files.size(), 16, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            TraceFileResult& result = out.files[i];
+            result.path = files[i];
+            std::FILE* file = std::fopen(files[i].c_str(), "rb");
+            if (!file) {
+                result.error = files[i] + ": " + std::strerror(errno);
+                continue;
+            }
+            AngleTraceHeader header;
+            struct stat info;
+            if (readAngleTraceHeader(file, header, files[i], result.error) && fstat(fileno(file), &info) == 0) {
+                uint64_t body = static_cast<uint64_t>(info.st_size) - ANGLE_TRACE_HEADER_BYTES;
+                records[i] = body / sizeof(AngleTraceRecord);
+                result.strayBytes = body % sizeof(AngleTraceRecord);
+                result.requestedRateHz = header.rateHz;
+                gapNs[i] = static_cast<int64_t>(options.gapMs > 0.0 ? options.gapMs * 1.0e6
+                                                : header.rateHz > 0.0f ? GAP_PERIODS * 1.0e9 / header.rateHz
+                                                : UNPACED_GAP_MS * 1.0e6);
+            }
+            std::fclose(file);
+        }
+    });
+
+    const uint64_t pieceRecords = std::max<uint64_t>(options.chunkBytes / sizeof(AngleTraceRecord), CONTEXT_RECORDS + 1);
+    std::vector<Piece> pieces;
+    std::vector<size_t> piecesLeft(files.size(), 0);
+    for (size_t i = 0; i < files.size(); i++) {
+        for (uint64_t begin = 0; begin < records[i]; begin += pieceRecords) {
+            pieces.push_back(Piece{i, begin, std::min(begin + pieceRecords, records[i])});
+            piecesLeft[i]++;
+        }
+    }
+    // Biggest first, so the long pieces don't all end up last
+    std::stable_sort(pieces.begin(), pieces.end(), [](const Piece& a, const Piece& b) {
+        return a.end - a.begin > b.end - b.begin;
+    });
+    out.chunks = pieces.size();
+
+    // A file's pieces collect here until its last one is in
+    std::vector<std::unique_ptr<TraceStats>> partial(files.size());
+    std::mutex mutex;
+    pool.parallelFor(pieces.size(), 1, [&](size_t begin, size_t end) {
+        std::vector<AngleTraceRecord> buffer(READ_BLOCK_RECORDS);
+        for (size_t p = begin; p < end; p++) {
+            const Piece& piece = pieces[p];
+            std::unique_ptr<TraceStats> stats(new TraceStats());
+            std::string error;
+            bool ok = scanPiece(files[piece.file], piece, gapNs[piece.file], buffer, *stats, error);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            TraceFileResult& result = out.files[piece.file];
+            if (!ok && result.error.empty()) {
+                result.error = error;
+            }
+            if (!partial[piece.file]) {
+                partial[piece.file] = std::move(stats);
+            } else {
+                partial[piece.file]->merge(*stats);
+            }
+            if (--piecesLeft[piece.file] == 0) {
+                TraceStats& whole = *partial[piece.file];
+                if (result.error.empty()) {
+                    whole.bytes += ANGLE_TRACE_HEADER_BYTES + result.strayBytes;
+                    summarise(whole, result);
+                    out.total.merge(whole);
+                }
+                partial[piece.file].reset();
+            }
+        }
+    });
+
+    // Files with a header and no records yet
+    for (size_t i = 0; i < files.size(); i++) {
+        if (records[i] == 0 && out.files[i].error.empty()) {
+            out.total.bytes += ANGLE_TRACE_HEADER_BYTES + out.files[i].strayBytes;
+        }
+    }
+    out.seconds = (Clock::nowNs() - startNs) / 1.0e9;
+}
+
+void printTraceReport(const TraceAnalysis& analysis, std::ostream& out, bool perFile) {
+    const TraceStats& total = analysis.total;
+    size_t failedFiles = analysis.failedFiles();
+    std::ios::fmtflags flags = out.flags();
+    out << std::fixed;
+
+    if (perFile) {
+        out << "   samples   rate Hz  p50 ms  p99 ms p99.9 ms   failed  dropouts  noise deg  |v|p99 deg/s  file" << std::endl;
+        for (const TraceFileResult& file : analysis.files) {
+            if (!file.error.empty()) {
+                out << "  " << file.error << std::endl;
+                continue;
+            }
+            out << std::setw(10) << file.samples << std::setprecision(1) << std::setw(10) << file.rateHz
+                << std::setprecision(3) << std::setw(8) << file.intervalP50Ms << std::setw(8) << file.intervalP99Ms
+                << std::setw(9) << file.intervalP999Ms << std::setw(9) << file.failedReads << std::setw(10)
+                << file.failureRuns + file.gaps << std::setw(11) << file.noiseDegrees << std::setprecision(1)
+                << std::setw(14) << file.velocityP99 << "  " << file.path
+                << (file.strayBytes ? " (torn last record)" : "") << std::endl;
+        }
+        out << std::endl;
+    }
+
+    out << "Angle traces: " << analysis.files.size() << " files";
+    if (failedFiles > 0) {
+        out << " (" << failedFiles << " unreadable)";
+    }
+    out << std::setprecision(3) << ", " << total.bytes / 1.0e9 << " GB, " << total.samples << " samples" << std::endl;
+    out << "  Read in " << analysis.seconds << " s on " << analysis.threads << " threads, " << analysis.chunks
+        << " pieces: " << analysis.gigabytesPerSecond() << " GB/s, " << std::setprecision(1)
+        << (analysis.seconds > 0.0 ? total.samples / analysis.seconds / 1.0e6 : 0.0) << "M samples/s" << std::endl;
+    if (total.samples == 0) {
+        out.flags(flags);
+        return;
+    }
+
+    double p50 = total.intervalMs(50.0);
+    out << "  Sample rate:  " << std::setprecision(1) << total.rateHz() << " Hz mean over timed intervals, "
+        << 100.0 * total.idleSamples / total.samples << "% of samples taken idling" << std::endl;
+    out << "  Interval:     " << std::setprecision(3) << "p50 " << p50 << "  p90 " << total.intervalMs(90.0)
+        << "  p99 " << total.intervalMs(99.0) << "  p99.9 " << total.intervalMs(99.9)
+        << "  max " << total.longestIntervalNs / 1.0e6 << " ms" << std::endl;
+    out << "  Jitter:       p99 - p50 " << total.intervalMs(99.0) - p50 << " ms, p99.9 - p50 "
+        << total.intervalMs(99.9) - p50 << " ms" << std::endl;
+    out << "  Failed reads: " << total.failedReads << " (" << std::setprecision(3)
+        << 100.0 * total.failedReads / total.samples << "%) in " << total.failureRuns << " runs" << std::endl;
+    double hours = total.intervalSumNs / 3.6e12;
+    out << "  Dropouts:     " << total.dropouts() << " (" << total.failureRuns << " failure runs, " << total.gaps
+        << " gaps)" << std::setprecision(1) << ", " << (hours > 0.0 ? total.dropouts() / hours : 0.0)
+        << " per hour of sampling";
+    if (total.backwardSteps > 0) {
+        out << "; timestamps went backwards " << total.backwardSteps << " times";
+    }
+    out << std::endl;
+    out << "  Noise floor:  " << std::setprecision(3) << total.noiseDegrees() << " deg RMS at rest (" << total.noiseCount
+        << " samples)" << std::endl;
+    const LogHistogram& velocity = total.velocity;
+    out << "  Lid speed:    " << std::setprecision(1) << 100.0 * velocity.underflow() / std::max<uint64_t>(1, velocity.count())
+        << "% still; p50 " << velocity.percentile(50.0) << "  p90 " << velocity.percentile(90.0) << "  p99 "
+        << velocity.percentile(99.0) << "  p99.9 " << velocity.percentile(99.9) << " deg/s" << std::endl;
+    velocity.print(out, "deg/s", 2);
+    const LogHistogram& jerk = total.jerk;
+    out << "  Jerk:         " << std::scientific << std::setprecision(2) << "p50 " << jerk.percentile(50.0) << "  p90 "
+        << jerk.percentile(90.0) << "  p99 " << jerk.percentile(99.0) << " deg/s^3"
+        << std::endl;
+    jerk.print(out, "deg/s^3", 4);
+    out.flags(flags);
+}
+
+int runTraceAnalysis(const std::vector<std::string>& paths, const TraceAnalyzeOptions& options) {
+    std::vector<std::string> files;
+    std::string error;
+    if (!findAngleTraces(paths, files, error)) {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+    if (files.empty()) {
+        std::cerr << "No angle traces (*" << ANGLE_TRACE_EXTENSION << ") found" << std::endl;
+        return 1;
+    }
+    TraceAnalysis analysis;
+    analyzeAngleTraces(files, options, analysis);
+    printTraceReport(analysis, std::cout, true);
+    return analysis.failedFiles() == files.size() ? 1 : 0;
+}
+
+} // namespace LidPong
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "AngleTrace.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace LidPong {
+
+// Counts over log-spaced bins, 8 per power of two (each at most 12.5% wide),
+// covering [2^minPow2, 2^maxPow2). Zero and smaller values go to an underflow
+// bin, larger ones to an overflow bin. The bin comes straight from the
+// double's exponent and top mantissa bits, so add() costs no log(), and
+// histograms with the same range merge by adding counts.
+class LogHistogram {
+public:
+    LogHistogram(int minPow2, int maxPow2);
+
+    void add(double value) { m_counts[binOf(value)]++; }
+    void merge(const LogHistogram& other);
+
+    uint64_t count() const;
+    uint64_t underflow() const { return m_counts.front(); }
+    const std::vector<uint64_t>& counts() const { return m_counts; }
+
+    // p in [0, 100], interpolated within the bin; 0 in the underflow bin
+    double percentile(double p) const;
+
+    // One line per 'octavesPerRow' powers of two that holds anything: range, share and a bar
+    void print(std::ostream& out, const char* unit, int octavesPerRow) const;
+
+private:
+    static const int SUB_BIN_BITS = 3;
+    static const int KEY_SHIFT = 52 - SUB_BIN_BITS;
+
+    size_t binOf(double value) const {
+        if (!(value >= m_min)) {
+            return 0; // Also NaN
+        }
+        if (value >= m_max) {
+            return m_counts.size() - 1;
+        }
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return static_cast<size_t>((bits >> KEY_SHIFT) - m_minKey) + 1;
+    }
+    double lowerEdge(size_t bin) const; // Of bins 1 .. size - 1
+
+    double m_min, m_max;
+    uint64_t m_minKey;
+    std::vector<uint64_t> m_counts;
+};
+
+// Everything measured over a run of trace records. All of it is counts, sums,
+// extremes and histograms, so the stats of the pieces of a file (or of many
+// files) merge into exactly what one pass over the whole would give.
+struct TraceStats {
+    uint64_t bytes;
+    uint64_t samples;
+    uint64_t failedReads;
+    uint64_t failureRuns;    // Back-to-back failed reads count once
+    uint64_t gaps;           // Intervals over the gap threshold (idle ones excepted)
+    uint64_t idleSamples;    // Taken at the idle rate; the interval after one isn't timed
+    uint64_t backwardSteps;  // Timestamps that went backwards
+    int64_t firstNs, lastNs; // Earliest and latest timestamp
+    int64_t longestIntervalNs;
+    int64_t intervalSumNs;   // Over the timed intervals, for the mean rate
+    uint64_t intervals;
+    double noiseSumSquares;  // Second-difference residuals where the lid is at rest
+    uint64_t noiseCount;
+    LogHistogram intervalUs; // Between consecutive samples, microseconds
+    LogHistogram velocity;   // |degrees/s| between means of consecutive blocks of good reads
+    LogHistogram jerk;       // |degrees/s^3| over four such blocks
+
+    TraceStats();
+
+    void merge(const TraceStats& other);
+
+    uint64_t dropouts() const { return failureRuns + gaps; }
+    double rateHz() const;       // Mean over timed intervals
+    double intervalMs(double p) const; // Percentile p in [0, 100], at most the longest seen
+    double noiseDegrees() const; // RMS sensor noise at rest
+    double seconds() const;      // First to last timestamp
+};
+
+struct TraceFileResult {
+    std::string path;
+    std::string error; // Empty if the file was analysed
+    double requestedRateHz;
+    uint64_t strayBytes; // After the last whole record (a torn write)
+
+    // Copied out of the file's TraceStats once its last piece is done, so a
+    // corpus of many small files doesn't keep a set of histograms per file
+    uint64_t samples, failedReads, failureRuns, gaps, idleSamples;
+    double rateHz, intervalP50Ms, intervalP99Ms, intervalP999Ms, longestIntervalMs;
+    double noiseDegrees, velocityP50, velocityP99, jerkP99;
+
+    TraceFileResult();
+};
+
+struct TraceAnalyzeOptions {
+    size_t threads;    // 0 = one per hardware thread
+    double gapMs;      // Longer intervals are dropouts; 0 = 4 requested periods (20 ms if unpaced)
+    size_t chunkBytes; // Files are cut into pieces this big for the threads
+
+    TraceAnalyzeOptions() : threads(0), gapMs(0.0), chunkBytes(16u << 20) {}
+};
+
+struct TraceAnalysis {
+    std::vector<TraceFileResult> files;
+    TraceStats total;
+    size_t threads;
+    size_t chunks;
+    double seconds; // Wall time of the analysis
+
+    TraceAnalysis() : threads(0), chunks(0), seconds(0.0) {}
+    double gigabytesPerSecond() const { return seconds > 0.0 ? total.bytes / seconds / 1.0e9 : 0.0; }
+    size_t failedFiles() const;
+};
+
+// Files named directly are taken as they are; directories are searched
+// recursively for *.lpat. False (and 'error') if a path can't be read.
+bool findAngleTraces(const std::vector<std::string>& paths, std::vector<std::string>& files, std::string& error);
+
+// Analyses every file on a thread pool. Files are cut at record boundaries
+// into pieces of about chunkBytes, biggest first, and each piece is streamed
+// through a small buffer with positional reads, so neither one big file nor
+// many small ones leave cores idle and no file is ever held in memory. Each
+// piece re-reads the records before it that the velocity and jerk blocks
+// need to see across the cut. Unreadable files are reported in
+// their result and skipped.
+void analyzeAngleTraces(const std::vector<std::string>& files, const TraceAnalyzeOptions& options, TraceAnalysis& out);
+
+// Per-file table (when perFile) and the fleet-wide summary
+void printTraceReport(const TraceAnalysis& analysis, std::ostream& out, bool perFile);
+
+// "lid-pong --analyze": find, analyse and report. 0 unless nothing could be analysed.
+int runTraceAnalysis(const std::vector<std::string>& paths, const TraceAnalyzeOptions& options);
+
+} // namespace LidPong
@@ -6,15 +6,23 @@
 //
 
 #include "angle.h"
+#ifndef LID_ANGLE_STUB_BACKEND
 #include <IOKit/hid/IOHIDManager.h>
 #include <IOKit/hid/IOHIDDevice.h>
 #include <IOKit/IOReturn.h>
 #include <CoreFoundation/CoreFoundation.h>
+#else
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#endif
 #include <iostream>
 #include <sstream>
 
 namespace MacBookLidAngle {
 
+#ifndef LID_ANGLE_STUB_BACKEND
+
 // PIMPL implementation class
 class LidAngleSensor::Impl {
 public:
@@ -22,7 +30,7 @@ public:
     ~Impl();
     
     bool isAvailable() const noexcept;
-    double readAngle();
+    ReadStatus tryReadAngle(double& angle, long& detail) noexcept; // detail: IOReturn or report length
     
 private:
     IOHIDDeviceRef findLidAngleSensor();
@@ -160,9 +168,9 @@ bool LidAngleSensor::Impl::testDevice(IOHIDDeviceRef device) {
     return (result == kIOReturnSuccess && reportLength >= 3);
 }
 
-double LidAngleSensor::Impl::readAngle() {
+ReadStatus LidAngleSensor::Impl::tryReadAngle(double& angle, long& detail) noexcept {
     if (!isAvailable()) {
-        throw SensorNotSupportedException("Sensor device is not available");
+        return ReadStatus::NotAvailable;
     }
     
     uint8_t report[8] = {0};
@@ -175,18 +183,68 @@ double LidAngleSensor::Impl::readAngle() {
                                           &reportLength);
     
     if (result != kIOReturnSuccess) {
-        throw SensorReadException("Failed to read from HID device (IOReturn: " + std::to_string(result) + ")");
+        detail = result;
+        return ReadStatus::DeviceError;
     }
     
     if (reportLength < 3) {
-        throw SensorReadException("Invalid report length: " + std::to_string(reportLength) + " (expected >= 3)");
+        detail = reportLength;
+        return ReadStatus::ShortReport;
     }
     
     // Parse the 16-bit angle value from bytes 1-2 (skipping report ID at byte 0)
     uint16_t rawValue = (report[2] << 8) | report[1]; // High byte, low byte
-    double angle = static_cast<double>(rawValue);
+    angle = static_cast<double>(rawValue);
     
-    return angle;
+    return ReadStatus::Ok;
+}
+
+#else // LID_ANGLE_STUB_BACKEND
+
+// Simulated sensor for builds without IOKit (e.g. Linux CI and benchmarks of
+// the layers above): the lid swings between 10 and 130 degrees every four
+// seconds, in whole degrees like the real sensor. LID_ANGLE_STUB_ANGLE in the
+// environment holds it at a fixed angle instead.
+class LidAngleSensor::Impl {
+public:
+    Impl();
+    
+    bool isAvailable() const noexcept { return true; }
+    ReadStatus tryReadAngle(double& angle, long& detail) noexcept;
+    
+private:
+    std::chrono::steady_clock::time_point start;
+    double fixedAngle; // Negative: swinging
+};
+
+LidAngleSensor::Impl::Impl() : start(std::chrono::steady_clock::now()), fixedAngle(-1.0) {
+    if (const char* fixed = std::getenv("LID_ANGLE_STUB_ANGLE")) {
+        fixedAngle = std::atof(fixed);
+    }
+}
+
+ReadStatus LidAngleSensor::Impl::tryReadAngle(double& angle, long& detail) noexcept {
+    detail = 0; // Never fails
+    if (fixedAngle >= 0.0) {
+        angle = fixedAngle;
+        return ReadStatus::Ok;
+    }
+    const double radiansPerSecond = 1.5707963267948966; // One swing every 4 s
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    angle = std::floor(70.0 - 60.0 * std::cos(seconds * radiansPerSecond) + 0.5);
+    return ReadStatus::Ok;
+}
+
+#endif // LID_ANGLE_STUB_BACKEND
+
+const char* readStatusMessage(ReadStatus status) noexcept {
+    switch (status) {
+        case ReadStatus::Ok: return "OK";
+        case ReadStatus::NotAvailable: return "sensor device is not available";
+        case ReadStatus::DeviceError: return "failed to read from HID device";
+        case ReadStatus::ShortReport: return "invalid report length (expected >= 3)";
+    }
+    return "unknown error";
 }
 
 // Public interface implementation
@@ -214,7 +272,29 @@ double LidAngleSensor::readAngle() {
     if (!pImpl) {
         throw SensorNotSupportedException("Sensor object not properly initialized");
     }
-    return pImpl->readAngle();
+    
+    // The throwing API, with detailed messages, on top of the non-throwing read
+    double angle = 0.0;
+    long detail = 0;
+    switch (pImpl->tryReadAngle(angle, detail)) {
+        case ReadStatus::Ok:
+            return angle;
+        case ReadStatus::NotAvailable:
+            throw SensorNotSupportedException("Sensor device is not available");
+        case ReadStatus::DeviceError:
+            throw SensorReadException("Failed to read from HID device (IOReturn: " + std::to_string(detail) + ")");
+        case ReadStatus::ShortReport:
+            throw SensorReadException("Invalid report length: " + std::to_string(detail) + " (expected >= 3)");
+    }
+    return angle;
+}
+
+ReadStatus LidAngleSensor::tryReadAngle(double& angle) noexcept {
+    if (!pImpl) {
+        return ReadStatus::NotAvailable;
+    }
+    long detail = 0;
+    return pImpl->tryReadAngle(angle, detail);
 }
 
 bool LidAngleSensor::isDeviceSupported() {
@@ -232,4 +312,12 @@ std::string LidAngleSensor::getVersion() {
     return "1.0.0";
 }
 
+const char* LidAngleSensor::getBackend() noexcept {
+#ifdef LID_ANGLE_STUB_BACKEND
+    return "simulated";
+#else
+    return "IOKit HID";
+#endif
+}
+
 } // namespace MacBookLidAngle
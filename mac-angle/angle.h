@@ -65,6 +65,21 @@ private:
     std::string message_;
 };
 
+/**
+ * Outcome of LidAngleSensor::tryReadAngle()
+ */
+enum class ReadStatus {
+    Ok,
+    NotAvailable, // No sensor, or it failed to initialize
+    DeviceError,  // The HID report request failed
+    ShortReport   // The report was too short to hold an angle
+};
+
+/**
+ * Static description of a ReadStatus (never allocates)
+ */
+const char* readStatusMessage(ReadStatus status) noexcept;
+
 /**
  * MacBook Lid Angle Sensor interface
  * 
@@ -123,6 +138,17 @@ public:
      */
     double readAngle();
     
+    /**
+     * Read the current lid angle without throwing
+     * 
+     * Meant for polling loops: a failed read reports a status instead of
+     * building an exception and its message, so no call allocates.
+     * 
+     * @param angle Set to the angle in degrees (0-360) when the read succeeds
+     * @return ReadStatus::Ok, or why the read failed
+     */
+    ReadStatus tryReadAngle(double& angle) noexcept;
+    
     /**
      * Check if this device is expected to have a lid angle sensor
      * 
@@ -136,6 +162,13 @@ public:
      * @return version string
      */
     static std::string getVersion();
+    
+    /**
+     * Get the name of the backend the library was built with
+     * 
+     * @return "IOKit HID", or "simulated" in LID_ANGLE_STUB_BACKEND builds
+     */
+    static const char* getBackend() noexcept;
 
 private:
     class Impl; // Forward declaration for PIMPL idiom
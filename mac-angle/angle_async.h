@@ -0,0 +1,510 @@
+//
+//  angle_async.h
+//  MacBook Lid Angle Sensor C++ Library
+//
+//  Coroutine interface: co_await lid samples and angle crossings (C++20)
+//
+
+#pragma once
+
+#if __cplusplus < 202002L || !defined(__cpp_impl_coroutine)
+#error "angle_async.h needs C++20 coroutines (compile with -std=c++20)"
+#endif
+
+#include "angle.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace MacBookLidAngle {
+
+/**
+ * One reading taken by an AngleExecutor
+ */
+struct AngleSample {
+    double angle;             // Degrees; after a failed read, the last good angle
+    ReadStatus status;
+    std::chrono::steady_clock::time_point time;
+    uint64_t sequence;        // 1 for the executor's first sample
+};
+
+/**
+ * The lid passing a threshold angle
+ */
+struct AngleCrossing {
+    AngleSample sample;       // The first sample on the far side
+    double threshold;
+    bool opening;             // true: the angle rose past the threshold
+};
+
+class AngleExecutor;
+
+/**
+ * A consumer coroutine, started and resumed by AngleExecutor::spawn()
+ *
+ * Any coroutine returning AngleTask can co_await the executor's awaitables.
+ * Its frame is freed when it finishes, or by the executor's destructor if it
+ * never does. An exception escaping a task ends the program, as it would
+ * escaping a thread.
+ */
+class AngleTask {
+public:
+    struct promise_type {
+        AngleExecutor* executor = nullptr;
+        promise_type* previous = nullptr; // The executor's list of live tasks
+        promise_type* next = nullptr;
+
+        AngleTask get_return_object() noexcept {
+            return AngleTask(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+        ~promise_type();
+    };
+
+    AngleTask(AngleTask&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    AngleTask(const AngleTask&) = delete;
+    AngleTask& operator=(const AngleTask&) = delete;
+    ~AngleTask() {
+        if (handle_) {
+            handle_.destroy(); // Never spawned
+        }
+    }
+
+private:
+    friend class AngleExecutor;
+    explicit AngleTask(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+/**
+ * A coroutine that co_yields values and may co_await in between
+ *
+ * Consume it with `while (auto value = co_await generator.next())`; next()
+ * gives an empty optional once the generator returns. Nothing runs until the
+ * first next(), and destroying the generator cancels whatever it awaits.
+ */
+template<class T>
+class AsyncGenerator {
+public:
+    struct promise_type {
+        const T* current = nullptr;        // The co_yielded value, alive while suspended
+        std::coroutine_handle<> consumer;  // Who awaits next()
+        std::exception_ptr error;
+
+        // Suspend the generator and continue the consumer
+        struct ToConsumer {
+            bool await_ready() const noexcept { return false; }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> self) noexcept {
+                return self.promise().consumer;
+            }
+            void await_resume() const noexcept {}
+        };
+
+        AsyncGenerator get_return_object() noexcept {
+            return AsyncGenerator(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        ToConsumer final_suspend() noexcept { return {}; }
+        ToConsumer yield_value(const T& value) noexcept {
+            current = &value;
+            return {};
+        }
+        void return_void() noexcept { current = nullptr; }
+        void unhandled_exception() noexcept {
+            current = nullptr;
+            error = std::current_exception();
+        }
+    };
+
+    class NextAwaiter {
+    public:
+        explicit NextAwaiter(std::coroutine_handle<promise_type> generator) : generator_(generator) {}
+
+        bool await_ready() const noexcept { return !generator_ || generator_.done(); }
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> consumer) noexcept {
+            generator_.promise().consumer = consumer;
+            return generator_; // Symmetric transfer: no stack growth however long the stream
+        }
+        std::optional<T> await_resume() {
+            if (!generator_ || generator_.done()) {
+                if (generator_ && generator_.promise().error) {
+                    std::rethrow_exception(std::exchange(generator_.promise().error, nullptr));
+                }
+                return std::nullopt;
+            }
+            return *generator_.promise().current;
+        }
+
+    private:
+        std::coroutine_handle<promise_type> generator_;
+    };
+
+    AsyncGenerator(AsyncGenerator&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    AsyncGenerator(const AsyncGenerator&) = delete;
+    AsyncGenerator& operator=(const AsyncGenerator&) = delete;
+    ~AsyncGenerator() {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+    NextAwaiter next() { return NextAwaiter(handle_); }
+
+private:
+    explicit AsyncGenerator(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+/**
+ * Single-threaded executor that samples the lid sensor for coroutines
+ *
+ * Consumers co_await nextSample(), angleCrosses(angle) or the samples()
+ * generator. Each suspended consumer is only a few pointers linked into the
+ * executor; every sample resumes exactly the consumers it satisfies, so
+ * thousands of logical consumers share one thread with no thread or polling
+ * loop of their own. Crossing waiters are kept ordered by threshold, so a
+ * sample costs O(log n) plus the consumers it wakes.
+ *
+ * The executor samples only while someone waits. Drive it with run(), which
+ * paces reads at rateHz and sleeps in between, or with poll()/publish() from
+ * a loop you already have (e.g. an existing sampler thread). Everything but
+ * stop() must be called on that one thread, and awaitables are co_awaited
+ * from coroutines the executor resumes. A sample wakes the consumers that
+ * were waiting when it arrived, in no particular order; anything they await
+ * next waits for a later sample.
+ */
+class AngleExecutor {
+    // A suspended consumer, linked into one of the executor's lists
+    struct Waiter {
+        std::coroutine_handle<> handle;
+        Waiter* previous = nullptr;
+        Waiter* next = nullptr;
+        Waiter** list = nullptr; // Head of the list it is in, nullptr if none
+    };
+
+public:
+    using ReadFunction = std::function<ReadStatus(double& angle)>;
+
+    class NextSampleAwaiter : Waiter {
+    public:
+        explicit NextSampleAwaiter(AngleExecutor& executor) : executor_(executor), sample_() {}
+        NextSampleAwaiter(const NextSampleAwaiter&) = delete;
+        NextSampleAwaiter& operator=(const NextSampleAwaiter&) = delete;
+        ~NextSampleAwaiter() {
+            if (list == &executor_.sampleWaiters_) {
+                executor_.sampleWaiterCount_--;
+            }
+            AngleExecutor::unlink(this); // Cancelled while suspended
+        }
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> consumer) noexcept {
+            handle = consumer;
+            AngleExecutor::link(this, &executor_.sampleWaiters_);
+            executor_.sampleWaiterCount_++;
+        }
+        AngleSample await_resume() const noexcept { return sample_; }
+
+    private:
+        friend class AngleExecutor;
+        AngleExecutor& executor_;
+        AngleSample sample_;
+    };
+
+    class CrossingAwaiter : Waiter {
+    public:
+        CrossingAwaiter(AngleExecutor& executor, double threshold)
+            : executor_(executor), threshold_(threshold), crossing_(), inMap_(false) {}
+        CrossingAwaiter(const CrossingAwaiter&) = delete;
+        CrossingAwaiter& operator=(const CrossingAwaiter&) = delete;
+        ~CrossingAwaiter() {
+            if (inMap_) {
+                executor_.crossings_.erase(where_);
+            }
+            AngleExecutor::unlink(this);
+        }
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> consumer) {
+            handle = consumer;
+            where_ = executor_.crossings_.emplace(threshold_, this);
+            inMap_ = true;
+        }
+        AngleCrossing await_resume() const noexcept { return crossing_; }
+
+    private:
+        friend class AngleExecutor;
+        AngleExecutor& executor_;
+        double threshold_;
+        AngleCrossing crossing_;
+        std::multimap<double, CrossingAwaiter*>::iterator where_;
+        bool inMap_;
+    };
+
+    /**
+     * Executor over a sensor, reading it rateHz times a second while anyone waits
+     * (rateHz <= 0: back to back)
+     */
+    explicit AngleExecutor(LidAngleSensor& sensor, double rateHz = 100.0)
+        : AngleExecutor([&sensor](double& angle) { return sensor.tryReadAngle(angle); }, rateHz) {}
+
+    /**
+     * Executor over any angle source, e.g. a recorded trace or a test signal
+     */
+    AngleExecutor(ReadFunction read, double rateHz)
+        : read_(std::move(read))
+        , period_(rateHz > 0.0 ? std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                     std::chrono::duration<double>(1.0 / rateHz))
+                               : std::chrono::steady_clock::duration::zero())
+        , stopRequested_(false) {}
+
+    AngleExecutor(const AngleExecutor&) = delete;
+    AngleExecutor& operator=(const AngleExecutor&) = delete;
+
+    ~AngleExecutor() {
+        // Unfinished tasks are destroyed; their awaiters unlink themselves as they go
+        starting_.clear();
+        while (tasks_) {
+            std::coroutine_handle<AngleTask::promise_type>::from_promise(*tasks_).destroy();
+        }
+    }
+
+    /**
+     * co_await: the next sample taken
+     */
+    NextSampleAwaiter nextSample() { return NextSampleAwaiter(*this); }
+
+    /**
+     * co_await: the first good sample on the other side of 'threshold' from
+     * the one before it (a move from below to at-or-above counts as opening)
+     */
+    CrossingAwaiter angleCrosses(double threshold) { return CrossingAwaiter(*this, threshold); }
+
+    /**
+     * Every sample from the first next() on, as an async generator
+     */
+    AsyncGenerator<AngleSample> samples() {
+        for (;;) {
+            co_yield co_await nextSample();
+        }
+    }
+
+    /**
+     * Hand a consumer coroutine to the executor; it starts on the next run() or poll()
+     */
+    void spawn(AngleTask task) {
+        auto handle = std::exchange(task.handle_, {});
+        AngleTask::promise_type& promise = handle.promise();
+        promise.executor = this;
+        promise.next = tasks_;
+        if (tasks_) {
+            tasks_->previous = &promise;
+        }
+        tasks_ = &promise;
+        taskCount_++;
+        starting_.push_back(handle);
+    }
+
+    /**
+     * Sample and resume consumers until stop(), or until no task is left and
+     * nothing waits. Sleeps between samples, and without sampling at all while
+     * the live tasks wait on something else.
+     */
+    void run() {
+        using clock = std::chrono::steady_clock;
+        clock::time_point deadline = clock::now();
+        for (;;) {
+            startSpawned();
+            if (stopRequested_.load() || (taskCount_ == 0 && waiting() == 0)) {
+                break;
+            }
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (waiting() == 0) {
+                wake_.wait(lock, [this] { return stopRequested_.load(); });
+                break;
+            }
+            if (wake_.wait_until(lock, deadline, [this] { return stopRequested_.load(); })) {
+                break;
+            }
+            lock.unlock();
+            poll();
+            deadline += period_;
+            clock::time_point now = clock::now();
+            if (deadline < now) {
+                deadline = now; // Fell behind: don't catch up with a burst
+            }
+        }
+        stopRequested_.store(false);
+    }
+
+    /**
+     * Make run() return; callable from any thread
+     */
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopRequested_.store(true);
+        }
+        wake_.notify_all();
+    }
+
+    /**
+     * Start spawned tasks, take one reading now and resume whoever it satisfies
+     */
+    void poll() {
+        startSpawned();
+        double angle = 0.0;
+        ReadStatus status = read_(angle);
+        publish(angle, status, std::chrono::steady_clock::now());
+    }
+
+    /**
+     * Resume consumers with a reading taken elsewhere (don't call from a consumer)
+     */
+    void publish(double angle, ReadStatus status, std::chrono::steady_clock::time_point time) {
+        AngleSample sample;
+        sample.angle = status == ReadStatus::Ok ? angle : lastGoodAngle_;
+        sample.status = status;
+        sample.time = time;
+        sample.sequence = ++sequence_;
+        latest_ = sample;
+
+        // Gather everyone this sample satisfies before resuming anyone, so what
+        // they await next waits for a later sample
+        while (Waiter* waiter = sampleWaiters_) {
+            unlink(waiter);
+            static_cast<NextSampleAwaiter*>(waiter)->sample_ = sample;
+            link(waiter, &pending_);
+        }
+        sampleWaiterCount_ = 0;
+        if (status == ReadStatus::Ok) {
+            if (hasGoodAngle_ && angle != lastGoodAngle_) {
+                // Thresholds in (low, high] lie between the two readings
+                double low = std::min(lastGoodAngle_, angle), high = std::max(lastGoodAngle_, angle);
+                auto it = crossings_.upper_bound(low);
+                auto end = crossings_.upper_bound(high);
+                while (it != end) {
+                    CrossingAwaiter* waiter = it->second;
+                    waiter->crossing_.sample = sample;
+                    waiter->crossing_.threshold = it->first;
+                    waiter->crossing_.opening = angle > lastGoodAngle_;
+                    waiter->inMap_ = false;
+                    it = crossings_.erase(it);
+                    link(waiter, &pending_);
+                }
+            }
+            hasGoodAngle_ = true;
+            lastGoodAngle_ = angle;
+        }
+
+        // A consumer may cancel another (by destroying its generator); the
+        // cancelled one unlinks itself from pending_ and is never resumed
+        while (Waiter* waiter = pending_) {
+            unlink(waiter);
+            resumed_++;
+            waiter->handle.resume();
+        }
+    }
+
+    size_t waiting() const noexcept { return sampleWaiterCount_ + crossings_.size(); }
+    size_t tasks() const noexcept { return taskCount_; }
+    uint64_t samplesTaken() const noexcept { return sequence_; }
+    uint64_t resumptions() const noexcept { return resumed_; }
+    const AngleSample& latest() const noexcept { return latest_; }
+
+private:
+    friend struct AngleTask::promise_type;
+
+    static void link(Waiter* waiter, Waiter** list) noexcept {
+        waiter->list = list;
+        waiter->previous = nullptr;
+        waiter->next = *list;
+        if (*list) {
+            (*list)->previous = waiter;
+        }
+        *list = waiter;
+    }
+
+    static void unlink(Waiter* waiter) noexcept {
+        if (!waiter->list) {
+            return;
+        }
+        if (waiter->previous) {
+            waiter->previous->next = waiter->next;
+        } else {
+            *waiter->list = waiter->next;
+        }
+        if (waiter->next) {
+            waiter->next->previous = waiter->previous;
+        }
+        waiter->list = nullptr;
+        waiter->previous = waiter->next = nullptr;
+    }
+
+    void startSpawned() {
+        while (!starting_.empty()) {
+            std::vector<std::coroutine_handle<>> starting;
+            starting.swap(starting_);
+            for (std::coroutine_handle<> handle : starting) {
+                handle.resume(); // Runs to its first co_await (or to the end)
+            }
+        }
+    }
+
+    void taskFinished(AngleTask::promise_type& promise) noexcept {
+        if (promise.previous) {
+            promise.previous->next = promise.next;
+        } else {
+            tasks_ = promise.next;
+        }
+        if (promise.next) {
+            promise.next->previous = promise.previous;
+        }
+        taskCount_--;
+    }
+
+    ReadFunction read_;
+    std::chrono::steady_clock::duration period_;
+
+    Waiter* sampleWaiters_ = nullptr;
+    size_t sampleWaiterCount_ = 0;
+    std::multimap<double, CrossingAwaiter*> crossings_;
+    Waiter* pending_ = nullptr; // Satisfied by the sample being published, not yet resumed
+
+    AngleTask::promise_type* tasks_ = nullptr;
+    size_t taskCount_ = 0;
+    std::vector<std::coroutine_handle<>> starting_;
+
+    AngleSample latest_ = AngleSample();
+    bool hasGoodAngle_ = false;
+    double lastGoodAngle_ = 0.0;
+    uint64_t sequence_ = 0;
+    uint64_t resumed_ = 0;
+
+    std::atomic<bool> stopRequested_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+};
+
+inline AngleTask::promise_type::~promise_type() {
+    if (executor) {
+        executor->taskFinished(*this);
+    }
+}
+
+} // namespace MacBookLidAngle
@@ -0,0 +1,320 @@
+//
+//  angle_c.cpp
+//  MacBook Lid Angle Sensor C++ Library
+//
+//  C interface over LidAngleSensor: no exception crosses it, and samples
+//  reach the caller through a ring the sampler thread writes in place
+//
+
+#include "angle_c.h"
+#include "angle.h"
+#include <sys/mman.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <string>
+#include <system_error>
+#include <thread>
+
+using namespace MacBookLidAngle;
+
+static_assert(sizeof(lid_angle_sample) == 32, "lid_angle_sample is part of the ABI");
+static_assert(sizeof(lid_angle_ring) == 128, "lid_angle_ring is part of the ABI");
+static_assert(offsetof(lid_angle_ring, published) == 64, "The sampler's counters get their own cache line");
+static_assert(LID_ANGLE_DEVICE_ERROR == static_cast<int>(ReadStatus::DeviceError) &&
+              LID_ANGLE_SHORT_REPORT == static_cast<int>(ReadStatus::ShortReport),
+              "C status codes 0-3 are ReadStatus values");
+
+struct lid_angle_sensor {
+    LidAngleSensor sensor;
+    std::mutex sensorMutex;        // lid_angle_read() and the sampler share the device
+
+    lid_angle_ring* ring = nullptr;
+    size_t ringBytes = 0;
+    std::thread sampler;
+    std::atomic<bool> running{false};
+
+    std::mutex wakeMutex;
+    std::condition_variable wake;  // Stops the sampler's sleep, wakes lid_angle_wait()
+    std::atomic<int> waiters{0};   // In lid_angle_wait(), so the sampler only notifies when needed
+};
+
+namespace {
+
+const uint32_t DEFAULT_CAPACITY = 4096;
+const uint32_t MAX_CAPACITY = 1u << 24;
+
+int64_t monotonicNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void freeRing(lid_angle_sensor* sensor) {
+    if (sensor->ring) {
+        munmap(sensor->ring, sensor->ringBytes);
+        sensor->ring = nullptr;
+        sensor->ringBytes = 0;
+    }
+}
+
+void runSampler(lid_angle_sensor* sensor, double rateHz) {
+    using clock = std::chrono::steady_clock;
+    lid_angle_ring* ring = sensor->ring;
+    lid_angle_sample* slots = reinterpret_cast<lid_angle_sample*>(reinterpret_cast<char*>(ring) + ring->samples_offset);
+    const uint64_t mask = ring->capacity - 1;
+    const clock::duration period = rateHz > 0.0
+        ? std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / rateHz))
+        : clock::duration::zero();
+
+    clock::time_point deadline = clock::now();
+    double lastGoodAngle = 0.0;
+    uint64_t sequence = 0;
+    while (sensor->running.load(std::memory_order_relaxed)) {
+        double angle = lastGoodAngle;
+        ReadStatus status;
+        {
+            std::lock_guard<std::mutex> lock(sensor->sensorMutex);
+            status = sensor->sensor.tryReadAngle(angle);
+        }
+        if (status == ReadStatus::Ok) {
+            lastGoodAngle = angle;
+        } else {
+            angle = lastGoodAngle;
+        }
+
+        // Seqlock-style publication: announce the slot, fence, fill it, publish
+        sequence++;
+        __atomic_store_n(&ring->writing, sequence, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        lid_angle_sample& slot = slots[(sequence - 1) & mask];
+        slot.sequence = sequence;
+        slot.timestamp_ns = monotonicNs();
+        slot.angle = angle;
+        slot.status = static_cast<int32_t>(status);
+        slot.reserved = 0;
+        // Sequentially consistent, pairing with the waiter count in lid_angle_wait()
+        __atomic_store_n(&ring->published, sequence, __ATOMIC_SEQ_CST);
+        if (sensor->waiters.load() > 0) {
+            std::lock_guard<std::mutex> lock(sensor->wakeMutex);
+            sensor->wake.notify_all();
+        }
+
+        if (period != clock::duration::zero()) {
+            deadline += period;
+            clock::time_point now = clock::now();
+            if (deadline < now) {
+                deadline = now; // Fell behind: don't catch up with a burst
+            }
+            std::unique_lock<std::mutex> lock(sensor->wakeMutex);
+            sensor->wake.wait_until(lock, deadline, [sensor] { return !sensor->running.load(); });
+        }
+    }
+}
+
+} // namespace
+
+extern "C" {
+
+uint32_t lid_angle_abi_version(void) {
+    return LID_ANGLE_ABI_VERSION;
+}
+
+const char* lid_angle_version(void) {
+    static const std::string version = LidAngleSensor::getVersion();
+    return version.c_str();
+}
+
+const char* lid_angle_status_message(int status) {
+    switch (status) {
+        case LID_ANGLE_OK:
+        case LID_ANGLE_NOT_AVAILABLE:
+        case LID_ANGLE_DEVICE_ERROR:
+        case LID_ANGLE_SHORT_REPORT:
+            return readStatusMessage(static_cast<ReadStatus>(status));
+        case LID_ANGLE_NOT_SUPPORTED: return "lid angle sensor not supported on this device";
+        case LID_ANGLE_INIT_FAILED: return "sensor initialization failed";
+        case LID_ANGLE_INVALID_ARGUMENT: return "invalid argument";
+        case LID_ANGLE_NO_MEMORY: return "out of memory";
+        case LID_ANGLE_NOT_SAMPLING: return "sampling is not running";
+        case LID_ANGLE_ALREADY_SAMPLING: return "sampling is already running";
+        case LID_ANGLE_TIMEOUT: return "timed out waiting for a sample";
+        case LID_ANGLE_OVERRUN: return "samples were overwritten before they were read";
+    }
+    return "unknown status";
+}
+
+int lid_angle_open(lid_angle_sensor** sensor) {
+    if (!sensor) {
+        return LID_ANGLE_INVALID_ARGUMENT;
+    }
+    *sensor = nullptr;
+    try {
+        *sensor = new lid_angle_sensor();
+    } catch (const SensorNotSupportedException&) {
+        return LID_ANGLE_NOT_SUPPORTED;
+    } catch (const SensorInitializationException&) {
+        return LID_ANGLE_INIT_FAILED;
+    } catch (const std::bad_alloc&) {
+        return LID_ANGLE_NO_MEMORY;
+    } catch (...) {
+        return LID_ANGLE_INIT_FAILED;
+    }
+    return LID_ANGLE_OK;
+}
+
+void lid_angle_close(lid_angle_sensor* sensor) {
+    if (!sensor) {
+        return;
+    }
+    lid_angle_stop(sensor);
+    freeRing(sensor);
+    delete sensor;
+}
+
+int lid_angle_read(lid_angle_sensor* sensor, double* angle) {
+    if (!sensor || !angle) {
+        return LID_ANGLE_INVALID_ARGUMENT;
+    }
+    std::lock_guard<std::mutex> lock(sensor->sensorMutex);
+    return static_cast<int>(sensor->sensor.tryReadAngle(*angle));
+}
+
+int lid_angle_start(lid_angle_sensor* sensor, double rate_hz, uint32_t capacity) {
+    if (!sensor || capacity > MAX_CAPACITY) {
+        return LID_ANGLE_INVALID_ARGUMENT;
+    }
+    if (sensor->running.load()) {
+        return LID_ANGLE_ALREADY_SAMPLING;
+    }
+    uint32_t slots = 1;
+    while (slots < std::max(capacity == 0 ? DEFAULT_CAPACITY : capacity, 2u)) {
+        slots <<= 1;
+    }
+
+    // Whole pages straight from the kernel: zeroed, page aligned, and never
+    // shared with the allocator's bookkeeping
+    freeRing(sensor);
+    size_t bytes = sizeof(lid_angle_ring) + static_cast<size_t>(slots) * sizeof(lid_angle_sample);
+    void* memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+    if (memory == MAP_FAILED) {
+        return LID_ANGLE_NO_MEMORY;
+    }
+    lid_angle_ring* ring = static_cast<lid_angle_ring*>(memory);
+    ring->magic = LID_ANGLE_RING_MAGIC;
+    ring->abi_version = LID_ANGLE_ABI_VERSION;
+    ring->capacity = slots;
+    ring->sample_bytes = sizeof(lid_angle_sample);
+    ring->samples_offset = sizeof(lid_angle_ring);
+    ring->rate_hz = rate_hz > 0.0 ? rate_hz : 0.0;
+    sensor->ring = ring;
+    sensor->ringBytes = bytes;
+
+    sensor->running.store(true);
+    try {
+        sensor->sampler = std::thread(runSampler, sensor, rate_hz);
+    } catch (const std::system_error&) {
+        sensor->running.store(false);
+        freeRing(sensor);
+        return LID_ANGLE_NO_MEMORY;
+    }
+    return LID_ANGLE_OK;
+}
+
+int lid_angle_stop(lid_angle_sensor* sensor) {
+    if (!sensor) {
+        return LID_ANGLE_INVALID_ARGUMENT;
+    }
+    if (!sensor->sampler.joinable()) {
+        return LID_ANGLE_NOT_SAMPLING;
+    }
+    {
+        std::lock_guard<std::mutex> lock(sensor->wakeMutex);
+        sensor->running.store(false);
+    }
+    sensor->wake.notify_all(); // The sampler's sleep and any lid_angle_wait()
+    sensor->sampler.join();
+    return LID_ANGLE_OK;
+}
+
+int lid_angle_read_batch(lid_angle_sensor* sensor, uint64_t* cursor,
+                         lid_angle_sample* samples, size_t max_samples, size_t* count) {
+    if (!sensor || !cursor || !count || (!samples && max_samples > 0)) {
+        return LID_ANGLE_INVALID_ARGUMENT;
+    }
+    *count = 0;
+    const lid_angle_ring* ring = sensor->ring;
+    if (!ring) {
+        return LID_ANGLE_NOT_SAMPLING;
+    }
+    uint64_t newest = lid_angle_ring_published(ring);
+    if (*cursor > newest) {
+        return LID_ANGLE_INVALID_ARGUMENT; // A cursor from an earlier ring
+    }
+
+    // Skip what is certainly gone, copy at most two runs (the ring wraps), then
+    // drop whatever the sampler overwrote while we copied
+    uint64_t first = *cursor + 1;
+    if (newest >= ring->capacity && first < newest - ring->capacity + 1) {
+        first = newest - ring->capacity + 1;
+    }
+    size_t n = static_cast<size_t>(std::min<uint64_t>(max_samples, newest - first + 1));
+    if (n > 0) {
+        const lid_angle_sample* start = lid_angle_ring_slot(ring, first);
+        const lid_angle_sample* slots = lid_angle_ring_slot(ring, 1);
+        size_t run = std::min<size_t>(n, ring->capacity - static_cast<size_t>(start - slots));
+        std::memcpy(samples, start, run * sizeof(lid_angle_sample));
+        std::memcpy(samples + run, slots, (n - run) * sizeof(lid_angle_sample));
+    }
+    uint64_t intact = lid_angle_ring_oldest_intact(ring);
+    if (first < intact) {
+        size_t torn = static_cast<size_t>(std::min<uint64_t>(n, intact - first));
+        std::memmove(samples, samples + torn, (n - torn) * sizeof(lid_angle_sample));
+        n -= torn;
+        first = intact;
+    }
+
+    int status = first > *cursor + 1 ? LID_ANGLE_OVERRUN : LID_ANGLE_OK;
+    *cursor = first + n - 1;
+    *count = n;
+    return status;
+}
+
+int lid_angle_wait(lid_angle_sensor* sensor, uint64_t sequence, int timeout_ms) {
+    if (!sensor) {
+        return LID_ANGLE_INVALID_ARGUMENT;
+    }
+    const lid_angle_ring* ring = sensor->ring;
+    if (!ring) {
+        return LID_ANGLE_NOT_SAMPLING;
+    }
+    auto ready = [&] {
+        return __atomic_load_n(&ring->published, __ATOMIC_SEQ_CST) > sequence || !sensor->running.load();
+    };
+    std::unique_lock<std::mutex> lock(sensor->wakeMutex);
+    sensor->waiters.fetch_add(1);
+    if (timeout_ms < 0) {
+        sensor->wake.wait(lock, ready);
+    } else {
+        sensor->wake.wait_for(lock, std::chrono::milliseconds(timeout_ms), ready);
+    }
+    sensor->waiters.fetch_sub(1);
+    if (lid_angle_ring_published(ring) > sequence) {
+        return LID_ANGLE_OK;
+    }
+    return sensor->running.load() ? LID_ANGLE_TIMEOUT : LID_ANGLE_NOT_SAMPLING;
+}
+
+int lid_angle_map_ring(lid_angle_sensor* sensor, const lid_angle_ring** ring) {
+    if (!sensor || !ring) {
+        return LID_ANGLE_INVALID_ARGUMENT;
+    }
+    *ring = sensor->ring;
+    return sensor->ring ? LID_ANGLE_OK : LID_ANGLE_NOT_SAMPLING;
+}
+
+} // extern "C"
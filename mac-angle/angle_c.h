@@ -0,0 +1,167 @@
+/*
+ *  angle_c.h
+ *  MacBook Lid Angle Sensor C++ Library
+ *
+ *  Stable C interface for consumers that can't link C++ (Python via ctypes
+ *  or cffi, Rust, ...): an opaque handle, status codes instead of
+ *  exceptions, and a sample ring that can be read in place
+ */
+
+#ifndef MACBOOK_LID_ANGLE_C_H
+#define MACBOOK_LID_ANGLE_C_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Bumped whenever a struct layout or function signature below changes;
+ * compare with lid_angle_abi_version() at run time
+ */
+#define LID_ANGLE_ABI_VERSION 1
+
+/** lid_angle_ring.magic: "LARB" */
+#define LID_ANGLE_RING_MAGIC 0x4252414Cu
+
+/**
+ * Status codes. 0-3 match MacBookLidAngle::ReadStatus, so they also appear
+ * in lid_angle_sample.status; the rest come from the C interface itself.
+ */
+enum {
+    LID_ANGLE_OK = 0,
+    LID_ANGLE_NOT_AVAILABLE = 1,     /* No sensor, or it failed to initialize */
+    LID_ANGLE_DEVICE_ERROR = 2,      /* The HID report request failed */
+    LID_ANGLE_SHORT_REPORT = 3,      /* The report was too short to hold an angle */
+    LID_ANGLE_NOT_SUPPORTED = 16,    /* lid_angle_open(): no sensor on this machine */
+    LID_ANGLE_INIT_FAILED = 17,      /* lid_angle_open(): the sensor wouldn't open */
+    LID_ANGLE_INVALID_ARGUMENT = 18,
+    LID_ANGLE_NO_MEMORY = 19,
+    LID_ANGLE_NOT_SAMPLING = 20,     /* Needs lid_angle_start() first */
+    LID_ANGLE_ALREADY_SAMPLING = 21,
+    LID_ANGLE_TIMEOUT = 22,
+    LID_ANGLE_OVERRUN = 23           /* Samples were lost; what was returned is still valid */
+};
+
+typedef struct lid_angle_sensor lid_angle_sensor;
+
+/**
+ * One reading by the sampler thread (32 bytes)
+ */
+typedef struct lid_angle_sample {
+    uint64_t sequence;     /* 1 for the first sample after lid_angle_start() */
+    int64_t timestamp_ns;  /* Monotonic clock when the read completed */
+    double angle;          /* Degrees; a failed read repeats the last good angle */
+    int32_t status;        /* LID_ANGLE_OK, or why the read failed (1-3) */
+    uint32_t reserved;
+} lid_angle_sample;
+
+/**
+ * The sampler's ring, as mapped by lid_angle_map_ring(): this 128-byte
+ * header, then 'capacity' slots at 'samples_offset'. Sample n lives in slot
+ * (n - 1) & (capacity - 1) until it is overwritten capacity samples later.
+ *
+ * Reading in place, without a call or copy per sample:
+ *   1. newest = lid_angle_ring_published(ring)
+ *   2. use *lid_angle_ring_slot(ring, n) for cursor < n <= newest
+ *   3. oldest = lid_angle_ring_oldest_intact(ring): anything used in step 2
+ *      with n < oldest may have been overwritten while it was read; drop it
+ *      (the consumer fell more than 'capacity' samples behind)
+ *   4. cursor = newest
+ * Foreign readers follow the same steps with acquire loads of 'published'
+ * and 'writing'.
+ */
+typedef struct lid_angle_ring {
+    uint32_t magic;          /* LID_ANGLE_RING_MAGIC */
+    uint32_t abi_version;    /* LID_ANGLE_ABI_VERSION */
+    uint32_t capacity;       /* Slots, a power of two */
+    uint32_t sample_bytes;   /* sizeof(lid_angle_sample) */
+    uint32_t samples_offset; /* Bytes from the start of the ring to slot 0 */
+    uint32_t reserved0;
+    double rate_hz;          /* Requested sampling rate, 0 = back to back */
+    uint8_t pad0[32];
+    /* Written by the sampler thread; on a cache line of their own */
+    uint64_t published;      /* Sequence of the newest complete sample, 0 = none yet */
+    uint64_t writing;        /* Sequence of the slot being (or last) written */
+    uint8_t pad1[48];
+} lid_angle_ring;
+
+/** Sequence of the newest complete sample (an acquire load) */
+static inline uint64_t lid_angle_ring_published(const lid_angle_ring* ring) {
+    return __atomic_load_n(&ring->published, __ATOMIC_ACQUIRE);
+}
+
+/** Slot holding sample 'sequence' (1-based) */
+static inline const lid_angle_sample* lid_angle_ring_slot(const lid_angle_ring* ring, uint64_t sequence) {
+    const lid_angle_sample* slots = (const lid_angle_sample*)((const char*)ring + ring->samples_offset);
+    return &slots[(sequence - 1) & (ring->capacity - 1)];
+}
+
+/** Oldest sample still intact after the slot reads made before this call */
+static inline uint64_t lid_angle_ring_oldest_intact(const lid_angle_ring* ring) {
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    uint64_t writing = __atomic_load_n(&ring->writing, __ATOMIC_RELAXED);
+    return writing >= ring->capacity ? writing - ring->capacity + 1 : 1;
+}
+
+/** LID_ANGLE_ABI_VERSION the library was built with */
+uint32_t lid_angle_abi_version(void);
+
+/** Library version, e.g. "1.0.0" (static storage) */
+const char* lid_angle_version(void);
+
+/** Static description of a status code (never NULL) */
+const char* lid_angle_status_message(int status);
+
+/**
+ * Opens the sensor. On success *sensor is a handle for lid_angle_close().
+ * Returns LID_ANGLE_NOT_SUPPORTED, LID_ANGLE_INIT_FAILED or
+ * LID_ANGLE_NO_MEMORY otherwise, with *sensor set to NULL.
+ */
+int lid_angle_open(lid_angle_sensor** sensor);
+
+/** Stops sampling and frees the sensor and its ring (NULL is ignored) */
+void lid_angle_close(lid_angle_sensor* sensor);
+
+/** One read now, on the calling thread. Safe while the sampler runs. */
+int lid_angle_read(lid_angle_sensor* sensor, double* angle);
+
+/**
+ * Starts a thread reading the sensor rate_hz times a second (back to back
+ * if rate_hz <= 0) into a ring of at least 'capacity' samples (0: 4096),
+ * rounded up to a power of two. A new start replaces the previous ring.
+ */
+int lid_angle_start(lid_angle_sensor* sensor, double rate_hz, uint32_t capacity);
+
+/** Stops the sampler thread. The ring stays readable until the next start or close. */
+int lid_angle_stop(lid_angle_sensor* sensor);
+
+/**
+ * Copies up to max_samples samples newer than *cursor into 'samples' and
+ * advances *cursor past them; *count is how many. Start with *cursor = 0.
+ * Returns LID_ANGLE_OVERRUN (with the samples still copied) if some were
+ * overwritten before they could be read.
+ */
+int lid_angle_read_batch(lid_angle_sensor* sensor, uint64_t* cursor,
+                         lid_angle_sample* samples, size_t max_samples, size_t* count);
+
+/**
+ * Blocks until a sample newer than 'sequence' is published, for up to
+ * timeout_ms (forever if negative). Returns LID_ANGLE_TIMEOUT, or
+ * LID_ANGLE_NOT_SAMPLING if sampling stops first.
+ */
+int lid_angle_wait(lid_angle_sensor* sensor, uint64_t sequence, int timeout_ms);
+
+/**
+ * Sets *ring to the sampler's ring, readable in place (see lid_angle_ring)
+ * until the next lid_angle_start() or lid_angle_close()
+ */
+int lid_angle_map_ring(lid_angle_sensor* sensor, const lid_angle_ring** ring);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MACBOOK_LID_ANGLE_C_H */
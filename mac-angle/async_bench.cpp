@@ -0,0 +1,253 @@
+//
+//  async_bench.cpp
+//  MacBook Lid Angle Sensor C++ Library
+//
+//  Checks and times the coroutine interface in angle_async.h against a
+//  synthetic sensor, with thousands of consumers suspended at once
+//
+
+#include "angle_async.h"
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <thread>
+
+using namespace MacBookLidAngle;
+
+namespace {
+
+// A lid swinging between 5 and 135 degrees, with every 97th read failing
+class SyntheticLid {
+public:
+    ReadStatus read(double& angle) {
+        reads_++;
+        if (reads_ % 97 == 0) {
+            log_.push_back(-1.0);
+            return ReadStatus::DeviceError;
+        }
+        angle = 70.0 + 65.0 * std::sin(reads_ * 0.013) + 0.25 * std::sin(reads_ * 1.7);
+        log_.push_back(angle);
+        return ReadStatus::Ok;
+    }
+
+    const std::vector<double>& log() const { return log_; } // -1 marks a failed read
+
+private:
+    uint64_t reads_ = 0;
+    std::vector<double> log_;
+};
+
+struct Counters {
+    uint64_t sequenceErrors = 0;
+    uint64_t directionErrors = 0;
+    uint64_t framesAlive = 0;
+    uint64_t finished = 0;
+};
+
+// Lives in each task frame, so destroyed frames can be counted
+struct FrameGuard {
+    explicit FrameGuard(Counters& counters) : counters_(counters) { counters_.framesAlive++; }
+    ~FrameGuard() { counters_.framesAlive--; }
+    Counters& counters_;
+};
+
+AngleTask sampleConsumer(AngleExecutor& executor, Counters& counters, int samples) {
+    FrameGuard guard(counters);
+    uint64_t previous = 0;
+    for (int i = 0; i < samples; i++) {
+        AngleSample sample = co_await executor.nextSample();
+        if (previous != 0 && sample.sequence != previous + 1) {
+            counters.sequenceErrors++;
+        }
+        previous = sample.sequence;
+    }
+    counters.finished++;
+}
+
+AngleTask generatorConsumer(AngleExecutor& executor, Counters& counters, int samples) {
+    FrameGuard guard(counters);
+    AsyncGenerator<AngleSample> stream = executor.samples();
+    uint64_t previous = 0;
+    int seen = 0;
+    while (std::optional<AngleSample> sample = co_await stream.next()) {
+        if (previous != 0 && sample->sequence != previous + 1) {
+            counters.sequenceErrors++;
+        }
+        previous = sample->sequence;
+        if (++seen == samples) {
+            break; // Destroys the generator while it is suspended
+        }
+    }
+    counters.finished++;
+}
+
+// Never finishes; left to the executor's destructor
+AngleTask crossingConsumer(AngleExecutor& executor, Counters& counters, double threshold, uint64_t& crossings) {
+    FrameGuard guard(counters);
+    bool expectOpening = false, first = true;
+    for (;;) {
+        AngleCrossing crossing = co_await executor.angleCrosses(threshold);
+        bool onFarSide = crossing.opening ? crossing.sample.angle >= threshold : crossing.sample.angle < threshold;
+        if (!onFarSide || (!first && crossing.opening != expectOpening) || crossing.threshold != threshold) {
+            counters.directionErrors++;
+        }
+        first = false;
+        expectOpening = !crossing.opening;
+        crossings++;
+    }
+}
+
+uint64_t bruteForceCrossings(const std::vector<double>& log, double threshold) {
+    uint64_t crossings = 0;
+    double previous = -1.0;
+    for (double angle : log) {
+        if (angle < 0.0) {
+            continue;
+        }
+        if (previous >= 0.0 && (previous < threshold) != (angle < threshold)) {
+            crossings++;
+        }
+        previous = angle;
+    }
+    return crossings;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Thousands of consumers on one executor, driven by poll() as fast as it goes
+int checkManyConsumers(int sampleTasks, int generatorTasks, int crossingTasks, int samples) {
+    SyntheticLid lid;
+    Counters counters;
+    std::vector<double> thresholds;
+    std::vector<uint64_t> crossings(crossingTasks, 0);
+    uint64_t resumptions = 0;
+    size_t peakWaiting = 0;
+    double seconds = 0.0;
+    {
+        AngleExecutor executor([&lid](double& angle) { return lid.read(angle); }, 0.0);
+        for (int i = 0; i < sampleTasks; i++) {
+            executor.spawn(sampleConsumer(executor, counters, samples / 2 + i % (samples / 2)));
+        }
+        for (int i = 0; i < generatorTasks; i++) {
+            executor.spawn(generatorConsumer(executor, counters, samples / 2 + i % (samples / 2)));
+        }
+        for (int i = 0; i < crossingTasks; i++) {
+            thresholds.push_back(10.0 + 120.0 * i / crossingTasks);
+        }
+        for (int i = 0; i < crossingTasks; i++) {
+            executor.spawn(crossingConsumer(executor, counters, thresholds[i], crossings[i]));
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < samples; i++) {
+            executor.poll();
+            peakWaiting = std::max(peakWaiting, executor.waiting());
+        }
+        seconds = secondsSince(start);
+        resumptions = executor.resumptions();
+
+        if (executor.tasks() != static_cast<size_t>(crossingTasks)) {
+            std::printf("FAIL: %zu tasks left, expected the %d crossing waiters\n", executor.tasks(), crossingTasks);
+            return 1;
+        }
+    }
+
+    uint64_t crossingErrors = 0, totalCrossings = 0;
+    for (int i = 0; i < crossingTasks; i++) {
+        totalCrossings += crossings[i];
+        if (crossings[i] != bruteForceCrossings(lid.log(), thresholds[i])) {
+            crossingErrors++;
+        }
+    }
+    std::printf("  %d sample + %d generator + %d crossing consumers, %d samples: peak %zu suspended\n",
+                sampleTasks, generatorTasks, crossingTasks, samples, peakWaiting);
+    std::printf("  %.0f ns per sample, %.1f ns per resumption (%llu resumptions, %llu crossings)\n",
+                seconds * 1.0e9 / samples, seconds * 1.0e9 / resumptions,
+                static_cast<unsigned long long>(resumptions), static_cast<unsigned long long>(totalCrossings));
+
+    if (counters.sequenceErrors || counters.directionErrors || crossingErrors) {
+        std::printf("FAIL: %llu skipped samples, %llu wrong crossings, %llu thresholds with missed crossings\n",
+                    static_cast<unsigned long long>(counters.sequenceErrors),
+                    static_cast<unsigned long long>(counters.directionErrors),
+                    static_cast<unsigned long long>(crossingErrors));
+        return 1;
+    }
+    if (counters.finished != static_cast<uint64_t>(sampleTasks + generatorTasks) || counters.framesAlive != 0) {
+        std::printf("FAIL: %llu tasks finished, %llu frames leaked\n",
+                    static_cast<unsigned long long>(counters.finished),
+                    static_cast<unsigned long long>(counters.framesAlive));
+        return 1;
+    }
+    return 0;
+}
+
+// run() at a real rate: the thread must sleep between samples, and return
+// once the last task is done
+int checkPacedRun(int tasks, double rateHz, int samples) {
+    SyntheticLid lid;
+    Counters counters;
+    AngleExecutor executor([&lid](double& angle) { return lid.read(angle); }, rateHz);
+    for (int i = 0; i < tasks; i++) {
+        executor.spawn(sampleConsumer(executor, counters, samples));
+    }
+    std::clock_t cpuStart = std::clock();
+    auto start = std::chrono::steady_clock::now();
+    executor.run();
+    double wall = secondsSince(start);
+    double cpu = static_cast<double>(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+
+    std::printf("  %d consumers at %.0f Hz: %llu samples in %.2f s wall, %.3f s CPU (%.1f%%)\n",
+                tasks, rateHz, static_cast<unsigned long long>(executor.samplesTaken()), wall, cpu,
+                100.0 * cpu / wall);
+    double expected = samples / rateHz;
+    if (executor.samplesTaken() != static_cast<uint64_t>(samples) || wall < expected * 0.9) {
+        std::printf("FAIL: run() took %llu samples in %.2f s, expected %d in about %.2f s\n",
+                    static_cast<unsigned long long>(executor.samplesTaken()), wall, samples, expected);
+        return 1;
+    }
+    if (cpu > wall * 0.5) {
+        std::printf("FAIL: run() kept the CPU busy between samples\n");
+        return 1;
+    }
+    return 0;
+}
+
+// A consumer waiting for a crossing that never comes: run() keeps sampling
+// until stop() arrives from another thread
+int checkStop() {
+    SyntheticLid lid;
+    Counters counters;
+    uint64_t crossings = 0;
+    AngleExecutor executor([&lid](double& angle) { return lid.read(angle); }, 1000.0);
+    executor.spawn(crossingConsumer(executor, counters, 500.0, crossings));
+    std::thread stopper([&executor] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        executor.stop();
+    });
+    auto start = std::chrono::steady_clock::now();
+    executor.run();
+    double wall = secondsSince(start);
+    stopper.join();
+    if (wall > 1.0 || executor.samplesTaken() == 0 || executor.tasks() != 1) {
+        std::printf("FAIL: stop() ended run() after %.2f s and %llu samples\n", wall,
+                    static_cast<unsigned long long>(executor.samplesTaken()));
+        return 1;
+    }
+    return 0;
+}
+
+} // namespace
+
+int main() {
+    std::printf("Coroutine interface benchmark\n");
+    int failures = 0;
+    failures += checkManyConsumers(4000, 2000, 4000, 2000);
+    failures += checkPacedRun(2000, 200.0, 60);
+    failures += checkStop();
+    if (failures == 0) {
+        std::printf("OK: every consumer saw every sample and every crossing, without busy waiting\n");
+    }
+    return failures == 0 ? 0 : 1;
+}
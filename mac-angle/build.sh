@@ -57,6 +57,7 @@ if [[ -f "lid_angle_example" ]]; then
     echo "🎯 Example program built successfully"
     echo "   Run with: ./build/lid_angle_example"
     echo "   Run continuous demo: ./build/lid_angle_example --continuous"
+    echo "   Characterise the sensor: ./build/lid_angle_bench --seconds 5"
 else
     echo "⚠️  Example program not found"
 fi
@@ -0,0 +1,171 @@
+/*
+ *  c_api_bench.c
+ *  MacBook Lid Angle Sensor C++ Library
+ *
+ *  Per-sample cost of the C interface: a call per read, against batches
+ *  copied out of the sampler's ring, against reading the ring in place
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#define _DARWIN_C_SOURCE
+
+#include "angle_c.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define BATCH 1024
+
+static double nowSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+typedef struct {
+    uint64_t samples;
+    uint64_t lost;
+    uint64_t sequenceErrors;
+    double busySeconds; /* Inside the reads, not waiting for the sampler */
+    double checksum;
+} Consumed;
+
+static void report(const char* name, const Consumed* consumed) {
+    printf("  %-26s %10llu samples  %7.2f ns/sample  %llu lost\n", name,
+           (unsigned long long)consumed->samples,
+           consumed->samples ? consumed->busySeconds * 1e9 / consumed->samples : 0.0,
+           (unsigned long long)consumed->lost);
+}
+
+/* Samples come and go back to back; consume them for 'seconds' with lid_angle_read_batch() */
+static int consumeBatches(lid_angle_sensor* sensor, double seconds, Consumed* out) {
+    static lid_angle_sample samples[BATCH];
+    uint64_t cursor = 0, expected = 0;
+    double end = nowSeconds() + seconds;
+    while (nowSeconds() < end) {
+        size_t count = 0;
+        double start = nowSeconds();
+        int status = lid_angle_read_batch(sensor, &cursor, samples, BATCH, &count);
+        if (status != LID_ANGLE_OK && status != LID_ANGLE_OVERRUN) {
+            printf("FAIL: lid_angle_read_batch: %s\n", lid_angle_status_message(status));
+            return 1;
+        }
+        for (size_t i = 0; i < count; i++) {
+            out->checksum += samples[i].angle;
+        }
+        out->busySeconds += nowSeconds() - start;
+        if (count == 0) {
+            lid_angle_wait(sensor, cursor, 10);
+            continue;
+        }
+        if (expected != 0 && samples[0].sequence != expected) {
+            if (status == LID_ANGLE_OVERRUN) {
+                out->lost += samples[0].sequence - expected;
+            } else {
+                out->sequenceErrors++;
+            }
+        }
+        for (size_t i = 1; i < count; i++) {
+            out->sequenceErrors += samples[i].sequence != samples[i - 1].sequence + 1;
+        }
+        out->samples += count;
+        expected = cursor + 1;
+    }
+    return 0;
+}
+
+/* The same, reading the mapped ring in place */
+static int consumeRing(lid_angle_sensor* sensor, double seconds, Consumed* out) {
+    const lid_angle_ring* ring = NULL;
+    uint64_t cursor = 0;
+    double end = nowSeconds() + seconds;
+    if (lid_angle_map_ring(sensor, &ring) != LID_ANGLE_OK) {
+        printf("FAIL: lid_angle_map_ring\n");
+        return 1;
+    }
+    while (nowSeconds() < end) {
+        double start = nowSeconds();
+        uint64_t newest = lid_angle_ring_published(ring);
+        if (newest == cursor) {
+            out->busySeconds += nowSeconds() - start;
+            lid_angle_wait(sensor, cursor, 10);
+            continue;
+        }
+        double sum = 0.0;
+        uint64_t bad = 0;
+        for (uint64_t n = cursor + 1; n <= newest; n++) {
+            const lid_angle_sample* slot = lid_angle_ring_slot(ring, n);
+            sum += slot->angle;
+            bad += slot->sequence != n;
+        }
+        uint64_t oldest = lid_angle_ring_oldest_intact(ring);
+        out->busySeconds += nowSeconds() - start;
+
+        uint64_t first = cursor + 1;
+        if (first < oldest) {
+            /* Fell behind: what was read below 'oldest' may be torn, so drop
+               the whole pass rather than its sum (a real consumer would keep
+               the intact part) */
+            out->lost += oldest - first;
+            cursor = newest;
+            continue;
+        }
+        out->sequenceErrors += bad;
+        out->checksum += sum;
+        out->samples += newest - cursor;
+        cursor = newest;
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    double seconds = argc > 1 ? atof(argv[1]) : 1.0;
+    lid_angle_sensor* sensor = NULL;
+    int status = lid_angle_open(&sensor);
+    if (status != LID_ANGLE_OK) {
+        printf("FAIL: lid_angle_open: %s\n", lid_angle_status_message(status));
+        return 1;
+    }
+    printf("C interface per-sample cost (%.1f s each)\n", seconds);
+
+    /* One call per sample, each reading the device */
+    Consumed single = {0, 0, 0, 0.0, 0.0};
+    double end = nowSeconds() + seconds, start = nowSeconds();
+    while (nowSeconds() < end) {
+        for (int i = 0; i < 1000; i++) {
+            double angle = 0.0;
+            lid_angle_read(sensor, &angle);
+            single.checksum += angle;
+        }
+        single.samples += 1000;
+    }
+    single.busySeconds = nowSeconds() - start;
+    report("lid_angle_read", &single);
+
+    int failures = 0;
+    Consumed batches = {0, 0, 0, 0.0, 0.0};
+    lid_angle_start(sensor, 0.0, 1u << 16);
+    failures += consumeBatches(sensor, seconds, &batches);
+    lid_angle_stop(sensor);
+    report("lid_angle_read_batch", &batches);
+
+    Consumed mapped = {0, 0, 0, 0.0, 0.0};
+    lid_angle_start(sensor, 0.0, 1u << 16);
+    failures += consumeRing(sensor, seconds, &mapped);
+    lid_angle_stop(sensor);
+    report("lid_angle_map_ring", &mapped);
+
+    lid_angle_close(sensor);
+
+    if (batches.sequenceErrors || mapped.sequenceErrors) {
+        printf("FAIL: %llu batch and %llu ring samples out of sequence\n",
+               (unsigned long long)batches.sequenceErrors, (unsigned long long)mapped.sequenceErrors);
+        failures++;
+    }
+    if (failures == 0) {
+        double perCall = single.busySeconds / single.samples;
+        printf("OK: batches cost %.1fx less per sample than a call each, the mapped ring %.1fx less\n",
+               perCall / (batches.busySeconds / batches.samples), perCall / (mapped.busySeconds / mapped.samples));
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,167 @@
+/*
+ *  c_api_test.c
+ *  MacBook Lid Angle Sensor C++ Library
+ *
+ *  Exercises the C interface from plain C: error codes, batch reads, the
+ *  mapped ring, waiting and overruns
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#define _DARWIN_C_SOURCE
+
+#include "angle_c.h"
+#include <stdio.h>
+#include <time.h>
+
+static int failures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            printf("FAIL: %s (line %d)\n", #condition, __LINE__); \
+            failures++; \
+        } \
+    } while (0)
+
+static double nowSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void sleepMs(long ms) {
+    struct timespec ts;
+    ts.tv_sec = ms / 1000;
+    ts.tv_nsec = (ms % 1000) * 1000000L;
+    nanosleep(&ts, NULL);
+}
+
+static void checkWithoutSensor(void) {
+    CHECK(lid_angle_abi_version() == LID_ANGLE_ABI_VERSION);
+    CHECK(lid_angle_version() != NULL);
+    for (int status = 0; status <= LID_ANGLE_OVERRUN; status++) {
+        CHECK(lid_angle_status_message(status) != NULL);
+    }
+    CHECK(lid_angle_open(NULL) == LID_ANGLE_INVALID_ARGUMENT);
+    CHECK(lid_angle_read(NULL, NULL) == LID_ANGLE_INVALID_ARGUMENT);
+    CHECK(lid_angle_stop(NULL) == LID_ANGLE_INVALID_ARGUMENT);
+    lid_angle_close(NULL);
+}
+
+static void checkBeforeStart(lid_angle_sensor* sensor) {
+    uint64_t cursor = 0;
+    size_t count = 1;
+    lid_angle_sample sample;
+    const lid_angle_ring* ring = NULL;
+    double angle = -1.0;
+
+    CHECK(lid_angle_read(sensor, &angle) == LID_ANGLE_OK);
+    CHECK(angle >= 0.0 && angle <= 360.0);
+    CHECK(lid_angle_read_batch(sensor, &cursor, &sample, 1, &count) == LID_ANGLE_NOT_SAMPLING);
+    CHECK(count == 0);
+    CHECK(lid_angle_map_ring(sensor, &ring) == LID_ANGLE_NOT_SAMPLING);
+    CHECK(ring == NULL);
+    CHECK(lid_angle_wait(sensor, 0, 0) == LID_ANGLE_NOT_SAMPLING);
+    CHECK(lid_angle_stop(sensor) == LID_ANGLE_NOT_SAMPLING);
+    CHECK(lid_angle_start(sensor, 100.0, (1u << 24) + 1) == LID_ANGLE_INVALID_ARGUMENT);
+}
+
+/* Paced sampling: consecutive batches, and the ring agrees with them */
+static void checkPaced(lid_angle_sensor* sensor) {
+    const lid_angle_ring* ring = NULL;
+    lid_angle_sample samples[16];
+    uint64_t cursor = 0, expected = 1;
+    int64_t lastNs = 0;
+
+    CHECK(lid_angle_start(sensor, 500.0, 100) == LID_ANGLE_OK);
+    CHECK(lid_angle_start(sensor, 500.0, 100) == LID_ANGLE_ALREADY_SAMPLING);
+    CHECK(lid_angle_map_ring(sensor, &ring) == LID_ANGLE_OK);
+    if (!ring) {
+        return;
+    }
+    CHECK(ring->magic == LID_ANGLE_RING_MAGIC);
+    CHECK(ring->abi_version == LID_ANGLE_ABI_VERSION);
+    CHECK(ring->capacity == 128);
+    CHECK(ring->sample_bytes == sizeof(lid_angle_sample));
+    CHECK(ring->samples_offset >= sizeof(lid_angle_ring));
+    CHECK(ring->rate_hz == 500.0);
+
+    while (expected <= 40) {
+        size_t count = 0;
+        CHECK(lid_angle_wait(sensor, cursor, 1000) == LID_ANGLE_OK);
+        CHECK(lid_angle_read_batch(sensor, &cursor, samples, 16, &count) == LID_ANGLE_OK);
+        if (count == 0) {
+            break;
+        }
+        for (size_t i = 0; i < count; i++) {
+            const lid_angle_sample* slot = lid_angle_ring_slot(ring, samples[i].sequence);
+            CHECK(samples[i].sequence == expected);
+            CHECK(samples[i].status == LID_ANGLE_OK);
+            CHECK(samples[i].angle >= 0.0 && samples[i].angle <= 360.0);
+            CHECK(samples[i].timestamp_ns >= lastNs);
+            CHECK(slot->sequence == samples[i].sequence && slot->angle == samples[i].angle);
+            lastNs = samples[i].timestamp_ns;
+            expected++;
+        }
+        CHECK(cursor == expected - 1);
+    }
+    CHECK(lid_angle_ring_published(ring) >= 40);
+
+    /* A sample 1000 ahead can't arrive within a millisecond... */
+    CHECK(lid_angle_wait(sensor, lid_angle_ring_published(ring) + 1000, 1) == LID_ANGLE_TIMEOUT);
+    CHECK(lid_angle_stop(sensor) == LID_ANGLE_OK);
+    /* ...and after stopping the ring still holds the samples */
+    CHECK(lid_angle_wait(sensor, 0, 0) == LID_ANGLE_OK);
+    CHECK(lid_angle_wait(sensor, lid_angle_ring_published(ring), 1000) == LID_ANGLE_NOT_SAMPLING);
+}
+
+/* Back-to-back sampling into a small ring: a late reader sees an overrun */
+static void checkOverrun(lid_angle_sensor* sensor) {
+    lid_angle_sample samples[64];
+    uint64_t cursor = 0;
+    size_t count = 0;
+    int status;
+
+    CHECK(lid_angle_start(sensor, 0.0, 64) == LID_ANGLE_OK);
+    sleepMs(50);
+    status = lid_angle_read_batch(sensor, &cursor, samples, 64, &count);
+    CHECK(status == LID_ANGLE_OVERRUN);
+    CHECK(count > 0 && samples[0].sequence > 1);
+    for (size_t i = 1; i < count; i++) {
+        CHECK(samples[i].sequence == samples[i - 1].sequence + 1);
+    }
+    CHECK(count == 0 || cursor == samples[count - 1].sequence);
+
+    /* A slow start (1 Hz) still stops at once */
+    CHECK(lid_angle_stop(sensor) == LID_ANGLE_OK);
+    CHECK(lid_angle_start(sensor, 1.0, 0) == LID_ANGLE_OK);
+    sleepMs(20);
+    double start = nowSeconds();
+    CHECK(lid_angle_stop(sensor) == LID_ANGLE_OK);
+    CHECK(nowSeconds() - start < 0.5);
+
+    /* Cursors from the replaced ring are rejected */
+    cursor = 1000000;
+    CHECK(lid_angle_read_batch(sensor, &cursor, samples, 64, &count) == LID_ANGLE_INVALID_ARGUMENT);
+}
+
+int main(void) {
+    lid_angle_sensor* sensor = NULL;
+    int status;
+
+    checkWithoutSensor();
+    status = lid_angle_open(&sensor);
+    if (status != LID_ANGLE_OK) {
+        printf("SKIP: %s\n", lid_angle_status_message(status));
+        return failures == 0 ? 0 : 1;
+    }
+    checkBeforeStart(sensor);
+    checkPaced(sensor);
+    checkOverrun(sensor);
+    lid_angle_close(sensor);
+
+    if (failures == 0) {
+        printf("OK: C interface\n");
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -71,6 +71,7 @@ void demoContinuousReading() {
     std::cout << "Demo: Continuous angle monitoring" << std::endl;
     std::cout << "--------------------------------" << std::endl;
     std::cout << "Reading lid angle every 0.5 seconds. Press Ctrl+C to stop..." << std::endl;
+    std::cout << "(For how fast and how evenly the sensor can be read, run lid_angle_bench.)" << std::endl;
     std::cout << std::endl;
     
     try {
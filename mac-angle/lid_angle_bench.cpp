@@ -0,0 +1,533 @@
+//
+//  lid_angle_bench.cpp
+//  MacBook Lid Angle Sensor C++ Library
+//
+//  Characterises the sensor: how fast it can be read, how long reads take,
+//  how evenly paced samples arrive and how often the value actually changes
+//
+
+#include "angle.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace MacBookLidAngle;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+int64_t nanosecondsBetween(Clock::time_point from, Clock::time_point to) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count();
+}
+
+// Counts of nanosecond values: exact below 32, then 16 bins per power of two
+// (at most 6.25% wide). Fixed size, so recording a read costs a few
+// instructions and no allocation.
+class NanosecondHistogram {
+public:
+    NanosecondHistogram() : counts_(BINS, 0), count_(0), max_(0), sum_(0.0), sumSquares_(0.0) {}
+
+    void add(int64_t value) {
+        uint64_t v = value > 0 ? static_cast<uint64_t>(value) : 0;
+        counts_[binOf(v)]++;
+        count_++;
+        max_ = std::max(max_, v);
+        sum_ += static_cast<double>(v);
+        sumSquares_ += static_cast<double>(v) * static_cast<double>(v);
+    }
+
+    uint64_t count() const { return count_; }
+    uint64_t max() const { return max_; }
+    double mean() const { return count_ ? sum_ / count_ : 0.0; }
+    double standardDeviation() const {
+        if (count_ < 2) {
+            return 0.0;
+        }
+        double m = mean();
+        return std::sqrt(std::max(0.0, sumSquares_ / count_ - m * m));
+    }
+
+    // Midpoint of the bin holding percentile p in [0, 100], at most the maximum
+    double percentile(double p) const {
+        if (count_ == 0) {
+            return 0.0;
+        }
+        uint64_t rank = static_cast<uint64_t>(std::ceil(p / 100.0 * count_));
+        rank = std::max<uint64_t>(rank, 1);
+        uint64_t seen = 0;
+        for (size_t bin = 0; bin < BINS; bin++) {
+            seen += counts_[bin];
+            if (seen >= rank) {
+                double low = static_cast<double>(lowerEdge(bin));
+                double high = static_cast<double>(lowerEdge(bin + 1));
+                return std::min((low + high) / 2.0, static_cast<double>(max_));
+            }
+        }
+        return static_cast<double>(max_);
+    }
+
+private:
+    static const size_t EXACT = 32;
+    static const int SUB_BITS = 4;
+    static const size_t BINS = EXACT + (64 - 5) * (1 << SUB_BITS);
+
+    static size_t binOf(uint64_t v) {
+        if (v < EXACT) {
+            return static_cast<size_t>(v);
+        }
+        int msb = 63 - __builtin_clzll(v);
+        size_t sub = static_cast<size_t>(v >> (msb - SUB_BITS)) & ((1 << SUB_BITS) - 1);
+        return EXACT + static_cast<size_t>(msb - 5) * (1 << SUB_BITS) + sub;
+    }
+
+    static uint64_t lowerEdge(size_t bin) {
+        if (bin < EXACT) {
+            return bin;
+        }
+        size_t octave = (bin - EXACT) >> SUB_BITS, sub = (bin - EXACT) & ((1 << SUB_BITS) - 1);
+        int msb = static_cast<int>(octave) + 5;
+        return (static_cast<uint64_t>((1 << SUB_BITS) + sub)) << (msb - SUB_BITS);
+    }
+
+    std::vector<uint64_t> counts_;
+    uint64_t count_;
+    uint64_t max_;
+    double sum_, sumSquares_;
+};
+
+// Which angles have been seen, in hundredths of a degree, as a bitmap over
+// everything the sensor's 16-bit report can hold (800 KB, allocated up
+// front so recording a value never allocates). Values outside that range
+// count as its nearest end.
+class DistinctValues {
+public:
+    DistinctValues() : bits_(SLOTS / 64, 0), count_(0) {}
+
+    void add(int64_t hundredths) {
+        size_t slot = static_cast<size_t>(std::min<int64_t>(std::max<int64_t>(hundredths, 0), SLOTS - 1));
+        uint64_t mask = uint64_t(1) << (slot % 64);
+        if (!(bits_[slot / 64] & mask)) {
+            bits_[slot / 64] |= mask;
+            count_++;
+        }
+    }
+
+    size_t count() const { return count_; }
+
+private:
+    static const int64_t SLOTS = 65536 * 100;
+
+    std::vector<uint64_t> bits_;
+    size_t count_;
+};
+
+// Binary output: a 16-byte header, then one 24-byte record per read, in the
+// native (little-endian) byte order
+const char BENCH_MAGIC[4] = {'L', 'A', 'B', 'R'};
+const uint16_t BENCH_VERSION = 1;
+
+struct BenchHeader {
+    char magic[4];
+    uint16_t version;
+    uint16_t recordBytes;
+    float rateHz;        // Target rate, 0 = as fast as possible
+    uint32_t reserved;
+};
+
+struct BenchRecord {
+    int64_t timeNs;      // Read completion, from the start of the run
+    uint32_t latencyNs;  // Duration of the read call (saturates at ~4.3 s)
+    float angle;         // Degrees; a failed read repeats the last good angle
+    uint8_t status;      // ReadStatus
+    uint8_t reserved[7];
+};
+
+static_assert(sizeof(BenchHeader) == 16, "Bench header must stay 16 bytes");
+static_assert(sizeof(BenchRecord) == 24, "Bench records must stay 24 bytes");
+
+// Writes records as CSV and/or binary on a thread of its own. The reading
+// loop only copies a record into the current block; full blocks are handed
+// over, so formatting and disk writes don't land between reads.
+class RecordWriter {
+public:
+    RecordWriter() : csv_(nullptr), binary_(nullptr), stopping_(false), failed_(false), stalls_(0), failedWrites_(0) {}
+    ~RecordWriter() { finish(); }
+
+    bool open(const std::string& csvPath, const std::string& binaryPath, double rateHz, std::string& error) {
+        if (!csvPath.empty()) {
+            csv_ = std::fopen(csvPath.c_str(), "w");
+            if (!csv_) {
+                error = csvPath + ": " + std::strerror(errno);
+                return false;
+            }
+            if (std::fputs("time_ns,latency_ns,angle,status\n", csv_) == EOF) {
+                failed_ = true;
+                failedWrites_++;
+            }
+        }
+        if (!binaryPath.empty()) {
+            binary_ = std::fopen(binaryPath.c_str(), "wb");
+            if (!binary_) {
+                error = binaryPath + ": " + std::strerror(errno);
+                return false;
+            }
+            BenchHeader header;
+            std::memcpy(header.magic, BENCH_MAGIC, sizeof(header.magic));
+            header.version = BENCH_VERSION;
+            header.recordBytes = sizeof(BenchRecord);
+            header.rateHz = static_cast<float>(rateHz);
+            header.reserved = 0;
+            if (std::fwrite(&header, sizeof(header), 1, binary_) != 1) {
+                failed_ = true;
+                failedWrites_++;
+            }
+        }
+        if (csv_ || binary_) {
+            filling_.reserve(BLOCK_RECORDS);
+            writer_ = std::thread(&RecordWriter::writerMain, this);
+        }
+        return true;
+    }
+
+    bool isOpen() const { return csv_ || binary_; }
+
+    void append(const BenchRecord& record) {
+        filling_.push_back(record);
+        if (filling_.size() == BLOCK_RECORDS) {
+            handOver();
+        }
+    }
+
+    // Writes what is left and closes the files; false if any write failed
+    bool finish() {
+        if (!writer_.joinable()) {
+            return !failed_;
+        }
+        handOver();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        ready_.notify_all();
+        writer_.join();
+        for (std::FILE* file : {csv_, binary_}) {
+            if (file && std::fclose(file) != 0) {
+                failed_ = true;
+            }
+        }
+        csv_ = binary_ = nullptr;
+        return !failed_;
+    }
+
+    uint64_t stalls() const { return stalls_; } // Times the reading loop waited for the writer
+    uint64_t failedWrites() const { return failedWrites_; } // Binary blocks and CSV lines; read after finish()
+
+private:
+    static const size_t BLOCK_RECORDS = 1 << 16;
+
+    void handOver() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!writing_.empty()) {
+            stalls_++;
+            done_.wait(lock, [this] { return writing_.empty(); });
+        }
+        writing_.swap(filling_);
+        lock.unlock();
+        ready_.notify_one();
+        filling_.reserve(BLOCK_RECORDS);
+    }
+
+    void writerMain() {
+        std::vector<BenchRecord> block;
+        char line[96];
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                ready_.wait(lock, [this] { return !writing_.empty() || stopping_; });
+                if (writing_.empty()) {
+                    return;
+                }
+                block.swap(writing_);
+            }
+            done_.notify_one();
+            if (binary_ && std::fwrite(block.data(), sizeof(BenchRecord), block.size(), binary_) != block.size()) {
+                failed_ = true;
+                failedWrites_++;
+            }
+            if (csv_) {
+                for (const BenchRecord& record : block) {
+                    int length = std::snprintf(line, sizeof(line), "%lld,%u,%.2f,%u\n",
+                                               static_cast<long long>(record.timeNs), record.latencyNs,
+                                               record.angle, static_cast<unsigned>(record.status));
+                    if (std::fwrite(line, 1, static_cast<size_t>(length), csv_) != static_cast<size_t>(length)) {
+                        failed_ = true;
+                        failedWrites_++;
+                    }
+                }
+            }
+            block.clear();
+        }
+    }
+
+    std::FILE* csv_;
+    std::FILE* binary_;
+    std::vector<BenchRecord> filling_;  // Reading loop only
+    std::vector<BenchRecord> writing_;  // Handed over, guarded by mutex_
+    std::thread writer_;
+    std::mutex mutex_;
+    std::condition_variable ready_, done_;
+    bool stopping_;
+    bool failed_;
+    uint64_t stalls_;
+    uint64_t failedWrites_; // Writer thread only until it is joined
+};
+
+struct Options {
+    double rateHz;      // 0 = as fast as possible
+    double seconds;
+    uint64_t reads;     // 0 = run for 'seconds'
+    std::string csvPath;
+    std::string binaryPath;
+
+    Options() : rateHz(0.0), seconds(5.0), reads(0) {}
+};
+
+struct Results {
+    uint64_t reads;
+    uint64_t failures[4];         // By ReadStatus
+    double elapsedSeconds;
+    NanosecondHistogram latency;  // Of each read call
+    NanosecondHistogram interval; // Between consecutive read completions
+    NanosecondHistogram held;     // How long each value lasted before it changed
+    double sumAbsoluteError;      // |interval - period| when paced
+    uint64_t changes;
+    uint64_t latePeriods;         // Paced: deadlines already past when reached
+    DistinctValues distinct;
+
+    Results() : reads(0), failures(), elapsedSeconds(0.0), sumAbsoluteError(0.0), changes(0), latePeriods(0) {}
+};
+
+void run(LidAngleSensor& sensor, const Options& options, RecordWriter& writer, Results& results) {
+    const bool paced = options.rateHz > 0.0;
+    const Clock::duration period = paced
+        ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / options.rateHz))
+        : Clock::duration::zero();
+    const int64_t periodNs = std::chrono::duration_cast<std::chrono::nanoseconds>(period).count();
+
+    const Clock::time_point start = Clock::now();
+    const Clock::time_point end = start + std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(options.seconds));
+    Clock::time_point deadline = start;
+    Clock::time_point readStart = start;
+    Clock::time_point previousDone;
+    Clock::time_point valueSince = start;
+    double lastGoodAngle = 0.0;
+    int64_t lastValue = INT64_MIN;
+
+    for (uint64_t i = 0; options.reads ? i < options.reads : readStart < end; i++) {
+        if (paced) {
+            // Absolute deadlines, so pacing doesn't drift; when behind, skip ahead
+            // rather than catching up with a burst
+            Clock::time_point now = Clock::now();
+            if (deadline > now) {
+                std::this_thread::sleep_until(deadline);
+                readStart = Clock::now();
+            } else {
+                readStart = now;
+                if (i > 0) {
+                    results.latePeriods++;
+                }
+                deadline = now;
+            }
+            deadline += period;
+        } else {
+            readStart = Clock::now();
+        }
+
+        double angle = lastGoodAngle;
+        ReadStatus status = sensor.tryReadAngle(angle);
+        Clock::time_point done = Clock::now();
+
+        int64_t latencyNs = nanosecondsBetween(readStart, done);
+        results.latency.add(latencyNs);
+        if (i > 0) {
+            int64_t intervalNs = nanosecondsBetween(previousDone, done);
+            results.interval.add(intervalNs);
+            if (paced) {
+                results.sumAbsoluteError += std::abs(static_cast<double>(intervalNs - periodNs));
+            }
+        }
+        previousDone = done;
+        results.reads++;
+
+        if (status == ReadStatus::Ok) {
+            lastGoodAngle = angle;
+            int64_t value = static_cast<int64_t>(std::llround(angle * 100.0));
+            if (value != lastValue) {
+                if (lastValue != INT64_MIN) {
+                    results.changes++;
+                    results.held.add(nanosecondsBetween(valueSince, done));
+                }
+                results.distinct.add(value);
+                lastValue = value;
+                valueSince = done;
+            }
+        } else {
+            results.failures[static_cast<int>(status)]++;
+            angle = lastGoodAngle;
+        }
+
+        if (writer.isOpen()) {
+            BenchRecord record;
+            record.timeNs = nanosecondsBetween(start, done);
+            record.latencyNs = static_cast<uint32_t>(std::min<int64_t>(latencyNs, UINT32_MAX));
+            record.angle = static_cast<float>(angle);
+            record.status = static_cast<uint8_t>(status);
+            std::memset(record.reserved, 0, sizeof(record.reserved));
+            writer.append(record);
+        }
+    }
+    results.elapsedSeconds = std::chrono::duration<double>(previousDone - start).count();
+}
+
+std::string formatRate(double hz) {
+    char text[32];
+    if (hz >= 1.0e6) {
+        std::snprintf(text, sizeof(text), "%.2f MHz", hz / 1.0e6);
+    } else if (hz >= 1.0e3) {
+        std::snprintf(text, sizeof(text), "%.2f kHz", hz / 1.0e3);
+    } else {
+        std::snprintf(text, sizeof(text), "%.1f Hz", hz);
+    }
+    return text;
+}
+
+void printPercentiles(const char* name, const NanosecondHistogram& histogram) {
+    std::printf("  %-16s p50 %9.2f  p90 %9.2f  p99 %9.2f  p99.9 %9.2f  max %9.2f  (mean %.2f, sd %.2f) us\n", name,
+                histogram.percentile(50) / 1e3, histogram.percentile(90) / 1e3, histogram.percentile(99) / 1e3,
+                histogram.percentile(99.9) / 1e3, histogram.max() / 1e3, histogram.mean() / 1e3,
+                histogram.standardDeviation() / 1e3);
+}
+
+void printSummary(const Options& options, const Results& results, const RecordWriter& writer) {
+    std::printf("lid_angle_bench: %s backend, library %s\n", LidAngleSensor::getBackend(),
+                LidAngleSensor::getVersion().c_str());
+    if (options.rateHz > 0.0) {
+        std::printf("Target:   %s\n", formatRate(options.rateHz).c_str());
+    } else {
+        std::printf("Target:   as fast as possible\n");
+    }
+    uint64_t failed = results.failures[1] + results.failures[2] + results.failures[3];
+    double rate = results.interval.mean() > 0.0 ? 1.0e9 / results.interval.mean() : 0.0;
+    std::printf("Reads:    %llu in %.3f s, %s achieved\n", static_cast<unsigned long long>(results.reads),
+                results.elapsedSeconds, formatRate(rate).c_str());
+    std::printf("Failed:   %llu", static_cast<unsigned long long>(failed));
+    for (int status = 1; status < 4; status++) {
+        if (results.failures[status]) {
+            std::printf("  %s: %llu", readStatusMessage(static_cast<ReadStatus>(status)),
+                        static_cast<unsigned long long>(results.failures[status]));
+        }
+    }
+    std::printf("\n");
+
+    std::printf("Timing:\n");
+    printPercentiles("read latency", results.latency);
+    printPercentiles("interval", results.interval);
+    if (options.rateHz > 0.0 && results.interval.count() > 0) {
+        std::printf("  jitter           mean |interval - period| %.2f us, %llu deadlines missed\n",
+                    results.sumAbsoluteError / results.interval.count() / 1e3,
+                    static_cast<unsigned long long>(results.latePeriods));
+    }
+
+    double changesPerSecond = results.elapsedSeconds > 0.0 ? results.changes / results.elapsedSeconds : 0.0;
+    std::printf("Values:   %zu distinct, %llu changes (%.1f/s, one per %.1f reads)\n", results.distinct.count(),
+                static_cast<unsigned long long>(results.changes), changesPerSecond,
+                results.changes ? static_cast<double>(results.reads) / results.changes : 0.0);
+    if (results.held.count() > 0) {
+        printPercentiles("value held", results.held);
+    } else {
+        std::printf("  (the value never changed: move the lid during the run to see how often the sensor updates)\n");
+    }
+    if (writer.stalls()) {
+        std::printf("Output:   the reading loop waited for the writer %llu times; expect gaps in the intervals\n",
+                    static_cast<unsigned long long>(writer.stalls()));
+    }
+    if (writer.failedWrites()) {
+        std::printf("Output:   %llu writes failed; the files are incomplete\n",
+                    static_cast<unsigned long long>(writer.failedWrites()));
+    }
+}
+
+void printUsage(const char* program) {
+    std::cout << "Usage: " << program << " [options]\n"
+              << "  --rate HZ       Target read rate (default: as fast as possible)\n"
+              << "  --seconds S     Run time (default 5)\n"
+              << "  --reads N       Stop after N reads instead\n"
+              << "  --csv FILE      Write every read as CSV: time_ns,latency_ns,angle,status\n"
+              << "  --binary FILE   Write every read as 24-byte records after a 16-byte LABR header\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--rate" && i + 1 < argc) {
+            options.rateHz = std::atof(argv[++i]);
+        } else if (arg == "--seconds" && i + 1 < argc) {
+            options.seconds = std::atof(argv[++i]);
+        } else if (arg == "--reads" && i + 1 < argc) {
+            options.reads = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--csv" && i + 1 < argc) {
+            options.csvPath = argv[++i];
+        } else if (arg == "--binary" && i + 1 < argc) {
+            options.binaryPath = argv[++i];
+        } else if (arg == "--help" || arg == "-h") {
+            printUsage(argv[0]);
+            return 0;
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (options.rateHz < 0.0 || (options.seconds <= 0.0 && options.reads == 0)) {
+        std::cerr << "--rate must be non-negative, and there must be a run time or read count" << std::endl;
+        return 1;
+    }
+
+    try {
+        LidAngleSensor sensor;
+        RecordWriter writer;
+        std::string error;
+        if (!writer.open(options.csvPath, options.binaryPath, options.rateHz, error)) {
+            std::cerr << "Error: " << error << std::endl;
+            return 1;
+        }
+        Results results;
+        run(sensor, options, writer, results);
+        bool written = writer.finish();
+        printSummary(options, results, writer);
+        if (!written) {
+            std::cerr << "Error: writing the output failed" << std::endl;
+            return 1;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}